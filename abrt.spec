@@ -600,6 +600,7 @@ fi
 
 %preun
 %systemd_preun abrtd.service
+%systemd_preun abrt-journal-watch.service
 
 %preun addon-ccpp
 %systemd_preun abrt-journal-core.service
@@ -621,6 +622,7 @@ fi
 
 %postun
 %systemd_postun_with_restart abrtd.service
+%systemd_postun_with_restart abrt-journal-watch.service
 
 %postun addon-ccpp
 %systemd_postun_with_restart abrt-journal-core.service
@@ -720,6 +722,7 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %files -f %{name}.lang
 %doc README.md COPYING
 %{_unitdir}/abrtd.service
+%{_unitdir}/abrt-journal-watch.service
 %{_tmpfilesdir}/abrt.conf
 %{_sbindir}/abrtd
 %{_sbindir}/abrt-server
@@ -732,6 +735,7 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %{_mandir}/man1/abrt-action-notify.1*
 %{_bindir}/abrt-action-save-package-data
 %{_bindir}/abrt-watch-log
+%{_bindir}/abrt-journal-watch
 %{_bindir}/abrt-action-analyze-python
 %{_bindir}/abrt-action-analyze-xorg
 %config(noreplace) %{_sysconfdir}/dbus-1/system.d/org.freedesktop.problems.daemon.conf
@@ -753,6 +757,7 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %{_mandir}/man1/abrt-server.1*
 %{_mandir}/man1/abrt-action-save-package-data.1*
 %{_mandir}/man1/abrt-watch-log.1*
+%{_mandir}/man1/abrt-journal-watch.1*
 %{_mandir}/man1/abrt-action-analyze-python.1*
 %{_mandir}/man1/abrt-action-analyze-xorg.1*
 %{_mandir}/man1/abrt-auto-reporting.1*
@@ -196,23 +196,90 @@ static void dup_corebt_fini(void)
     corebt = NULL;
 }
 
+/* Fills the length and the fingerprint of the crash thread of the problem's
+ * backtrace. Both are left unset if the backtrace can't be loaded.
+ */
+static void describe_backtrace(struct dump_dir *dd, struct abrt_dup_candidate *candidate, void *unused)
+{
+    candidate->frames = 0;
+    candidate->has_fingerprint = false;
+
+    const int flags = DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE;
+    g_autofree char *dd_type = dd_load_text_ext(dd, FILENAME_TYPE, flags);
+    if (dd_type == NULL)
+        return;
+
+    enum sr_report_type report_type = sr_abrt_type_from_type(dd_type);
+    if (report_type == SR_REPORT_INVALID)
+        return;
+
+    const char *filename = FILENAME_BACKTRACE;
+    if (strcmp(dd_type, "CCpp") == 0)
+        filename = FILENAME_CORE_BACKTRACE;
+
+    g_autofree char *text = dd_load_text_ext(dd, filename, flags);
+    if (text == NULL)
+        return;
+
+    char *error_message;
+    struct sr_stacktrace *stacktrace = sr_stacktrace_parse(report_type, text, &error_message);
+    if (stacktrace == NULL)
+    {
+        free(error_message);
+        return;
+    }
+
+    struct sr_thread *thread = sr_stacktrace_find_crash_thread(stacktrace);
+    if (thread != NULL)
+    {
+        const int frames = sr_thread_frame_count(thread);
+        if (frames > 0)
+        {
+            candidate->frames = frames;
+            abrt_dup_thread_fingerprint(thread, candidate->fingerprint);
+            candidate->has_fingerprint = true;
+        }
+    }
+
+    sr_stacktrace_free(stacktrace);
+}
+
+/* The distance of backtraces is the Damerau-Levenshtein distance of their
+ * crash threads divided by the length of the longer one. The distance is at
+ * least the difference of the lengths, so the candidates whose crash thread
+ * is too short or too long can't be duplicates.
+ */
+static bool corebt_length_can_be_dup(unsigned frames1, unsigned frames2)
+{
+    if (frames1 == 0 || frames2 == 0)
+        return false;
+
+    const unsigned longer = MAX(frames1, frames2);
+    const unsigned diff = longer - MIN(frames1, frames2);
+    return (float)diff / longer <= BACKTRACE_DUP_THRESHOLD;
+}
+
 /* This function is run after each post-create event is finished (there may be
  * multiple such events).
  *
  * It first checks if there is CORE_BACKTRACE or UUID item in the dump dir
  * we are processing.
  *
- * If there is a CORE_BACKTRACE, it iterates over all other dump
- * directories and computes similarity to their core backtraces (if any).
- * If one of them is similar enough to be considered duplicate, the function
- * saves the path to the dump directory in question and returns 1 to indicate
- * that we have indeed found a duplicate of currently processed dump directory.
- * No more events are processed and program prints the path to the other
- * directory and returns failure.
+ * The candidates are the processed problems of the same user, type and
+ * executable found in the duplicate index in the dump location (see
+ * abrt_dup_index_bucket()). The index is built first if it doesn't exist.
+ *
+ * If there is a CORE_BACKTRACE, it computes similarity of the core backtraces
+ * of the candidates (if any) whose crash thread length and fingerprint allow
+ * them to be similar enough. If one of them is similar enough to be considered
+ * duplicate, the function saves the path to the dump directory in question
+ * and returns 1 to indicate that we have indeed found a duplicate of
+ * currently processed dump directory. No more events are processed and
+ * program prints the path to the other directory and returns failure.
  *
- * If there is an UUID item (and no core backtrace), the function again
- * iterates over all other dump directories and compares this UUID to their
- * UUID. If there is a match, the path to the duplicate is saved and 1 is returned.
+ * If there is an UUID item (and no core backtrace), the function compares
+ * this UUID to the UUIDs of the candidates. If there is a match, the path to
+ * the duplicate is saved and 1 is returned.
  *
  * If duplicate is not found as described above, the function returns 0 and we
  * either process remaining events if there are any, or successfully terminate
@@ -234,27 +301,68 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
     dup_corebt_init(dd);
     dd_close(dd);
 
+    unsigned corebt_frames = 0;
+    uint64_t corebt_fingerprint[ABRT_DUP_FINGERPRINT_WORDS];
+    if (corebt)
+    {
+        struct sr_thread *thread = sr_stacktrace_find_crash_thread(corebt);
+        if (thread == NULL)
+        {
+            /* The same as the first comparison in core_backtrace_is_duplicate() */
+            log_notice("New stacktrace has no crash thread, disabling core stacktrace deduplicate");
+            dup_corebt_fini();
+        }
+        else
+        {
+            const int frames = sr_thread_frame_count(thread);
+            corebt_frames = frames > 0 ? frames : 0;
+            abrt_dup_thread_fingerprint(thread, corebt_fingerprint);
+        }
+    }
+
     /* dump_dir_name can be relative */
     dump_dir_name = realpath(dump_dir_name, NULL);
 
-    DIR *dir = opendir(abrt_g_settings_dump_location);
-    if (dir == NULL)
-        goto end;
+    g_autofree char *index_dir = g_build_filename(abrt_g_settings_dump_location, ABRT_DUP_INDEX_DIR_NAME, NULL);
+    if (!abrt_dup_index_is_complete(index_dir))
+        abrt_dup_index_rebuild(index_dir, abrt_g_settings_dump_location, describe_backtrace, NULL);
 
-    /* Scan crash dumps looking for a dup */
-    //TODO: explain why this is safe wrt concurrent runs
-    struct dirent *dent;
-    while ((dent = readdir(dir)) != NULL && crash_dump_dup_name == NULL)
+    g_autofree char *bucket = abrt_dup_index_bucket(uid, type, executable);
+    GList *candidates = abrt_dup_index_load_bucket(index_dir, abrt_g_settings_dump_location, bucket);
+    log_debug("Found %u duplicate candidates", g_list_length(candidates));
+
+    for (GList *iter = candidates; iter != NULL && crash_dump_dup_name == NULL; iter = g_list_next(iter))
     {
-        if (libreport_dot_or_dotdot(dent->d_name))
-            continue; /* skip "." and ".." */
-        const char *ext = strrchr(dent->d_name, '.');
-        if (ext && strcmp(ext, ".new") == 0)
-            continue; /* skip anything named "<dirname>.new" */
+        const struct abrt_dup_candidate *candidate = iter->data;
+
+        /* problems from different containers are not duplicates */
+        if (container_id != NULL && candidate->container_id != NULL
+         && strcmp(container_id, candidate->container_id) != 0)
+        {
+            continue;
+        }
+
+        /* Don't open the candidates which can't be duplicates, see
+         * dup_uuid_compare() and dup_corebt_compare() */
+        if (corebt ? !corebt_length_can_be_dup(corebt_frames, candidate->frames)
+                   : (uuid == NULL || candidate->uuid == NULL || strcmp(uuid, candidate->uuid) != 0))
+        {
+            continue;
+        }
+
+        if (corebt && candidate->has_fingerprint)
+        {
+            const unsigned distance = abrt_dup_fingerprint_distance(corebt_fingerprint, candidate->fingerprint);
+            if (distance > ABRT_DUP_FINGERPRINT_MAX_DISTANCE)
+            {
+                log_debug("Fingerprint of '%s' differs in %u bits, skipping", candidate->dirname, distance);
+                continue;
+            }
+        }
 
         dd = NULL;
 
-        char *tmp_concat_path = g_build_filename(abrt_g_settings_dump_location, dent->d_name, NULL);
+        char *tmp_concat_path = g_build_filename(abrt_g_settings_dump_location, candidate->dirname, NULL);
 
         g_autofree char *dump_dir_name2 = realpath(tmp_concat_path, NULL);
         if (libreport_g_verbose > 1 && !dump_dir_name2)
@@ -263,13 +371,13 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
         g_free(tmp_concat_path);
 
         if (!dump_dir_name2)
+        {
+            abrt_dup_index_forget_candidate(index_dir, candidate->dirname);
             continue;
-
-        g_autofree char *dd_uid = NULL, *dd_type = NULL;
-        g_autofree char *dd_executable = NULL, *dd_container_id = NULL;
+        }
 
         if (strcmp(dump_dir_name, dump_dir_name2) == 0)
-            goto next; /* we are never a dup of ourself */
+            continue; /* we are never a dup of ourself */
 
         int sv_logmode = libreport_logmode;
         /* Silently ignore any error in the silent log level. */
@@ -277,41 +385,7 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
         dd = dd_opendir(dump_dir_name2, /*flags:*/ DD_FAIL_QUIETLY_ENOENT | DD_OPEN_READONLY);
         libreport_logmode = sv_logmode;
         if (!dd)
-            goto next;
-
-        /* problems from different containers are not duplicates */
-        if (container_id != NULL)
-        {
-            dd_container_id = dd_load_text_ext(dd, FILENAME_CONTAINER_ID, DD_FAIL_QUIETLY_ENOENT);
-            if (dd_container_id != NULL && strcmp(container_id, dd_container_id) != 0)
-            {
-                goto next;
-            }
-        }
-
-        /* crashes of different users are not considered duplicates */
-        dd_uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT);
-        if (strcmp(uid, dd_uid))
-        {
-            goto next;
-        }
-
-        /* different crash types are not duplicates */
-        dd_type = dd_load_text_ext(dd, FILENAME_TYPE, DD_FAIL_QUIETLY_ENOENT);
-        if (strcmp(type, dd_type))
-        {
-            goto next;
-        }
-
-        /* different executables are not duplicates */
-        dd_executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, DD_FAIL_QUIETLY_ENOENT);
-        if (     (executable != NULL && dd_executable == NULL)
-             ||  (executable == NULL && dd_executable != NULL)
-             || ((executable != NULL && dd_executable != NULL)
-                  && strcmp(executable, dd_executable) != 0))
-        {
-            goto next;
-        }
+            continue;
 
         if (dup_uuid_compare(dd)
          || dup_corebt_compare(dd)
@@ -322,16 +396,38 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
             /* sonce crash_dump_dup_name != NULL now, we exit the loop */
         }
 
-next:
         dd_close(dd);
     }
-    closedir(dir);
+    g_list_free_full(candidates, (GDestroyNotify)abrt_dup_candidate_free);
 
-end:
     free((char*)dump_dir_name);
     return retval;
 }
 
+/* Lets the next problems find this one in the duplicate index */
+static void add_to_dup_index(const char *dump_dir_name)
+{
+    if (!abrt_dir_is_in_dump_location(dump_dir_name))
+        return;
+
+    struct dump_dir *dd = dd_opendir(dump_dir_name, DD_OPEN_READONLY);
+    if (!dd)
+        return;
+
+    g_autofree char *bucket = NULL;
+    struct abrt_dup_candidate *candidate = abrt_dup_candidate_load(dd, &bucket);
+    if (candidate != NULL)
+    {
+        describe_backtrace(dd, candidate, NULL);
+
+        g_autofree char *index_dir = g_build_filename(abrt_g_settings_dump_location, ABRT_DUP_INDEX_DIR_NAME, NULL);
+        abrt_dup_index_add_candidate(index_dir, bucket, candidate);
+        abrt_dup_candidate_free(candidate);
+    }
+
+    dd_close(dd);
+}
+
 static char *do_log(char *log_line, void *param)
 {
     /* We pipe output of events to our log.
@@ -453,6 +549,9 @@ int main(int argc, char **argv)
         if (r != 0)
             return r; /* yes */
 
+        if (post_create)
+            add_to_dup_index(dump_dir_name);
+
         dump_dir_name = NULL;
     }
 
@@ -0,0 +1,355 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "abrt-problem-catalog.h"
+#include "libabrt.h"
+
+/* Delay between a change and writing the file */
+#define CATALOG_WRITE_DELAY_MS 100
+/* Delay between attempts to load a locked problem directory */
+#define CATALOG_RETRY_DELAY_MS 1000
+/* Locked directories are then loaded by the periodic refresh only */
+#define CATALOG_MAX_RETRIES    10
+/* Problems are changed by reporters, abrt-dbus and others behind abrtd's
+ * back. The readers load the changed directories themselves, the refresh
+ * only keeps their number low. */
+#define CATALOG_REFRESH_INTERVAL_S 30
+/* See CATALOG_MTIME_GRANULARITY_NS in problem_catalog.c */
+#define CATALOG_MTIME_GRANULARITY_MS 1000
+
+struct abrt_problem_catalog
+{
+    char *dump_location;
+    /* name -> struct abrt_catalog_entry */
+    GHashTable *entries;
+    /* Starts at the time of creation to differ from previous runs */
+    uint64_t generation;
+
+    guint sync_source;
+    guint sync_delay;
+    guint refresh_source;
+    /* Attempts to load the busy and just changed directories since the last
+     * successful one */
+    unsigned retries;
+
+    /* The last written file, see catalog_is_consistent() */
+    bool written;
+    struct timespec written_mtime;
+    bool written_current;
+    /* The entries have changed since written */
+    bool dirty;
+};
+
+static bool
+timespec_equal(const struct timespec *lhs, const struct timespec *rhs)
+{
+    return lhs->tv_sec == rhs->tv_sec && lhs->tv_nsec == rhs->tv_nsec;
+}
+
+static gint64
+timespec_to_ms(const struct timespec *ts)
+{
+    return (gint64)ts->tv_sec * 1000 + ts->tv_nsec / 1000000;
+}
+
+static void
+replace_entry(struct abrt_problem_catalog *catalog, const char *name, struct abrt_catalog_entry *entry)
+{
+    const struct abrt_catalog_entry *old = g_hash_table_lookup(catalog->entries, name);
+    if (old == NULL || old->owner != entry->owner)
+        ++catalog->generation;
+
+    g_hash_table_replace(catalog->entries, g_strdup(name), entry);
+    catalog->dirty = true;
+}
+
+static bool
+remove_entry(struct abrt_problem_catalog *catalog, const char *name)
+{
+    if (!g_hash_table_remove(catalog->entries, name))
+        return false;
+
+    ++catalog->generation;
+    catalog->dirty = true;
+    return true;
+}
+
+/* Brings the entry of the directory up to date, returns false if the
+ * directory is busy or has just changed. The elements are read without locking the directory to
+ * not change its mtime.
+ */
+static bool
+sync_entry(struct abrt_problem_catalog *catalog, const char *name, const struct stat *statbuf,
+           const struct timespec *listed)
+{
+    struct abrt_catalog_entry *old = g_hash_table_lookup(catalog->entries, name);
+    if (old != NULL && timespec_equal(&old->mtime, &statbuf->st_mtim))
+    {
+        /* chown() and chmod() change only ctime */
+        if (old->owner != statbuf->st_uid)
+            ++catalog->generation;
+
+        if (old->owner != statbuf->st_uid || old->group != statbuf->st_gid || old->mode != statbuf->st_mode)
+        {
+            old->owner = statbuf->st_uid;
+            old->group = statbuf->st_gid;
+            old->mode = statbuf->st_mode;
+            catalog->dirty = true;
+        }
+
+        return true;
+    }
+
+    g_autofree char *path = g_build_filename(catalog->dump_location, name, NULL);
+    struct abrt_catalog_entry *entry = abrt_catalog_entry_read(path);
+    if (entry != NULL)
+    {
+        /* A change in the same tick would not change the mtime */
+        const bool racy = timespec_to_ms(listed) - timespec_to_ms(&entry->mtime) < CATALOG_MTIME_GRANULARITY_MS;
+        if (racy)
+            entry->mtime.tv_sec = entry->mtime.tv_nsec = 0;
+
+        replace_entry(catalog, name, entry);
+        return !racy;
+    }
+
+    /* Listed with the zero mtime, so the readers load it themselves */
+    if (old == NULL)
+        replace_entry(catalog, name, abrt_catalog_entry_new(name, statbuf));
+    else if (old->mtime.tv_sec != 0 || old->mtime.tv_nsec != 0)
+    {
+        old->mtime.tv_sec = old->mtime.tv_nsec = 0;
+        catalog->dirty = true;
+    }
+
+    return false;
+}
+
+static void schedule_sync(struct abrt_problem_catalog *catalog, guint delay);
+
+/* Lists the dump location, brings the entries of the changed directories up
+ * to date and writes the file if anything has changed.
+ */
+static void
+sync_catalog(struct abrt_problem_catalog *catalog)
+{
+    /* The time is taken first, see CATALOG_MTIME_GRANULARITY_NS */
+    struct timespec listed;
+    clock_gettime(CLOCK_REALTIME, &listed);
+
+    struct stat dump_location_stat;
+    DIR *dp = NULL;
+    if (stat(catalog->dump_location, &dump_location_stat) != 0
+     || (dp = opendir(catalog->dump_location)) == NULL)
+    {
+        perror_msg("Can't open directory '%s'", catalog->dump_location);
+        abrt_catalog_remove(catalog->dump_location);
+        catalog->written = false;
+        return;
+    }
+
+    GHashTable *found = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    unsigned busy = 0;
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        /* Skip ".", ".." and hidden entries like the catalog itself */
+        if (dent->d_name[0] == '.')
+            continue;
+
+        if (dent->d_type != DT_DIR && dent->d_type != DT_LNK && dent->d_type != DT_UNKNOWN)
+            continue;
+
+        struct stat statbuf;
+        if (fstatat(dirfd(dp), dent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0
+         || !S_ISDIR(statbuf.st_mode))
+            continue;
+
+        g_hash_table_add(found, g_strdup(dent->d_name));
+        if (!sync_entry(catalog, dent->d_name, &statbuf, &listed))
+            ++busy;
+    }
+    closedir(dp);
+
+    GHashTableIter iter;
+    g_hash_table_iter_init(&iter, catalog->entries);
+    gpointer name;
+    while (g_hash_table_iter_next(&iter, &name, NULL))
+    {
+        if (!g_hash_table_contains(found, name))
+        {
+            g_hash_table_iter_remove(&iter);
+            ++catalog->generation;
+            catalog->dirty = true;
+        }
+    }
+    g_hash_table_destroy(found);
+
+    const bool current = timespec_to_ms(&listed) - timespec_to_ms(&dump_location_stat.st_mtim)
+                         >= CATALOG_MTIME_GRANULARITY_MS;
+
+    if (catalog->dirty
+     || !catalog->written
+     || !timespec_equal(&catalog->written_mtime, &dump_location_stat.st_mtim)
+     || current != catalog->written_current)
+    {
+        GList *entries = g_hash_table_get_values(catalog->entries);
+        catalog->written = abrt_catalog_write(catalog->dump_location, entries, catalog->generation,
+                                              &dump_location_stat.st_mtim, &listed) == 0;
+        g_list_free(entries);
+
+        catalog->dirty = !catalog->written;
+        catalog->written_mtime = dump_location_stat.st_mtim;
+        catalog->written_current = current;
+    }
+
+    log_debug("Catalog of '%s' has %u problems, %u are busy",
+            catalog->dump_location, g_hash_table_size(catalog->entries), busy);
+
+    if (busy > 0)
+        catalog->retries++;
+    else
+        catalog->retries = 0;
+
+    /* Changed while it was listed */
+    struct stat after;
+    if (stat(catalog->dump_location, &after) == 0
+     && !timespec_equal(&after.st_mtim, &dump_location_stat.st_mtim))
+        schedule_sync(catalog, CATALOG_WRITE_DELAY_MS);
+    /* The readers trust the list only once the mtime is old enough */
+    else if (!current)
+        schedule_sync(catalog, CATALOG_MTIME_GRANULARITY_MS
+                               - (timespec_to_ms(&listed) - timespec_to_ms(&dump_location_stat.st_mtim)) + 1);
+    else if (busy > 0 && catalog->retries < CATALOG_MAX_RETRIES)
+        schedule_sync(catalog, CATALOG_RETRY_DELAY_MS);
+}
+
+static gboolean
+sync_catalog_cb(gpointer user_data)
+{
+    struct abrt_problem_catalog *catalog = user_data;
+    catalog->sync_source = 0;
+
+    sync_catalog(catalog);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_sync(struct abrt_problem_catalog *catalog, guint delay)
+{
+    if (catalog->sync_source != 0)
+    {
+        /* Changes must not wait for the retry of busy directories */
+        if (catalog->sync_delay <= delay)
+            return;
+
+        g_source_remove(catalog->sync_source);
+    }
+
+    catalog->sync_delay = delay;
+    catalog->sync_source = g_timeout_add(delay, sync_catalog_cb, catalog);
+}
+
+static gboolean
+refresh_catalog_cb(gpointer user_data)
+{
+    struct abrt_problem_catalog *catalog = user_data;
+
+    if (catalog->sync_source == 0)
+        sync_catalog(catalog);
+
+    return G_SOURCE_CONTINUE;
+}
+
+struct abrt_problem_catalog *
+abrt_problem_catalog_new(const char *dump_location)
+{
+    struct abrt_problem_catalog *catalog = g_new0(struct abrt_problem_catalog, 1);
+    catalog->dump_location = g_strdup(dump_location);
+    catalog->generation = (uint64_t)g_get_real_time();
+    catalog->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)abrt_catalog_entry_free);
+
+    abrt_problem_catalog_rebuild(catalog);
+
+    catalog->refresh_source = g_timeout_add_seconds(CATALOG_REFRESH_INTERVAL_S, refresh_catalog_cb, catalog);
+
+    return catalog;
+}
+
+void
+abrt_problem_catalog_free(struct abrt_problem_catalog *catalog)
+{
+    if (catalog == NULL)
+        return;
+
+    if (catalog->sync_source != 0)
+        g_source_remove(catalog->sync_source);
+    if (catalog->refresh_source != 0)
+        g_source_remove(catalog->refresh_source);
+
+    abrt_catalog_remove(catalog->dump_location);
+
+    g_hash_table_destroy(catalog->entries);
+    free(catalog->dump_location);
+    free(catalog);
+}
+
+void
+abrt_problem_catalog_rebuild(struct abrt_problem_catalog *catalog)
+{
+    log_notice("Building catalog of '%s'", catalog->dump_location);
+
+    g_hash_table_remove_all(catalog->entries);
+    ++catalog->generation;
+    catalog->dirty = true;
+    catalog->retries = 0;
+
+    /* The readers must not wait for the delayed write */
+    if (catalog->sync_source != 0)
+    {
+        g_source_remove(catalog->sync_source);
+        catalog->sync_source = 0;
+    }
+    sync_catalog(catalog);
+
+    log_info("Catalog of '%s' has %u problems",
+            catalog->dump_location, g_hash_table_size(catalog->entries));
+}
+
+void
+abrt_problem_catalog_update(struct abrt_problem_catalog *catalog, const char *name)
+{
+    if (name[0] == '.')
+        return;
+
+    /* The directory is loaded with the others, a burst of changes results
+     * in a single listing */
+    catalog->retries = 0;
+    schedule_sync(catalog, CATALOG_WRITE_DELAY_MS);
+}
+
+void
+abrt_problem_catalog_remove(struct abrt_problem_catalog *catalog, const char *name)
+{
+    if (!remove_entry(catalog, name))
+        return;
+
+    schedule_sync(catalog, CATALOG_WRITE_DELAY_MS);
+}
@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef _ABRT_PROBLEM_CATALOG_H_
+#define _ABRT_PROBLEM_CATALOG_H_
+
+/* Maintains the catalog file of the dump location (see abrt_catalog_open()).
+ *
+ * The entries are kept in memory and the dump location is listed again
+ * shortly after a change, so a burst of changes results in a single write.
+ * Only the directories whose mtime has changed are loaded again. Nothing but
+ * the dump location is watched; the problems changed behind abrtd's back are
+ * picked up by a periodic refresh and, until then, loaded by the readers
+ * themselves. The file is removed when the catalog is freed to not let the
+ * readers trust a catalog nobody maintains.
+ */
+struct abrt_problem_catalog;
+
+struct abrt_problem_catalog *
+abrt_problem_catalog_new(const char *dump_location);
+
+void
+abrt_problem_catalog_free(struct abrt_problem_catalog *catalog);
+
+/* Drops all entries, loads the dump location again and writes the file */
+void
+abrt_problem_catalog_rebuild(struct abrt_problem_catalog *catalog);
+
+/* Schedules listing of the dump location, name has been created or changed */
+void
+abrt_problem_catalog_update(struct abrt_problem_catalog *catalog, const char *name);
+
+void
+abrt_problem_catalog_remove(struct abrt_problem_catalog *catalog, const char *name);
+
+#endif /*_ABRT_PROBLEM_CATALOG_H_*/
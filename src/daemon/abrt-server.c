@@ -16,6 +16,8 @@
   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 #include <glib-unix.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include "problem_api.h"
 #include "abrt_glib.h"
 #include "libabrt.h"
@@ -28,9 +30,22 @@
 #define INPUT_BUFFER_SIZE (8*1024)
 /* We exit after this many seconds */
 #define TIMEOUT 10
+/* Maximal number of file descriptors received from one client */
+#define MAX_RECEIVED_FDS 16
+/* Maximal number of problems received in one batch */
+#define MAX_BATCH_RECORDS 1024
+/* Amount of data received from one client for a whole batch */
+#define MAX_BATCH_SIZE (4*MAX_MESSAGE_SIZE)
+/* We exit after this many seconds if the batch isn't received */
+#define BATCH_TIMEOUT (3*TIMEOUT)
+/* Length of a batch record is at most MAX_MESSAGE_SIZE */
+#define MAX_RECORD_LENGTH_DIGITS 16
 
 #define ABRT_SERVER_EVENT_ENV "ABRT_SERVER_PID"
 
+/* Known problems whose duplicates are only counted, see early_dup_key() */
+#define EARLY_DUP_INDEX_DIR VAR_RUN"/abrt/early-dups"
+
 /*
 Unix socket in ABRT daemon for creating new dump directories.
 
@@ -72,9 +87,30 @@ MANDATORY ITEMS:
    \0
 
 You can send more messages using the same KEY=value format.
+
+Several problems can be sent over one connection with "POST /batch". The body
+is a sequence of records, each record is
+-> "LENGTH\n"
+   decimal number of bytes of the record data
+-> record data
+   elements in the same format as above
+Every record is answered with its own "HTTP/1.1 CODE" status once received.
+
+Contents of an element can be passed as a file descriptor of a regular file
+(SCM_RIGHTS) instead of writing them to the socket:
+-> "KEY:fd=N"
+   N is the index of the descriptor among all descriptors sent by the client,
+   counted from 0
+   \0
+The file is copied (or cloned if the file system supports it) to the problem
+directory without reading it through the socket. Elements abrt-server needs
+(PID, EXECUTABLE, REASON, TYPE, ...) can't be passed this way. The files of
+a problem must not be bigger than a request in total unless the client is
+root, and they must be copied within the timeout of a request.
+See tests/runtests/socket-api-fd/send_fd_problem.py for a client.
 */
 
-static int g_signal_pipe[2];
+static int g_signal_pipe[2] = { -1, -1 };
 static struct ns_ids g_ns_ids;
 
 struct waiting_context
@@ -90,16 +126,31 @@ struct waiting_context
 };
 
 static unsigned total_bytes_read = 0;
+static unsigned max_bytes_read = MAX_MESSAGE_SIZE;
 
 static pid_t client_pid = (pid_t)-1L;
 static uid_t client_uid = (uid_t)-1L;
 
+/* File descriptors received from the current client */
+static int received_fds[MAX_RECEIVED_FDS];
+static unsigned received_fds_count = 0;
+
+static void close_received_fds(void)
+{
+    for (unsigned i = 0; i < received_fds_count; i++)
+        close(received_fds[i]);
+    received_fds_count = 0;
+}
+
 static void
 handle_signal(int signo)
 {
     int save_errno = errno;
     uint8_t sig_caught = signo;
-    if (write(g_signal_pipe[1], &sig_caught, 1))
+    /* A worker keeps the handler installed between requests but closes the
+     * pipe, so the descriptor number might have been reused for a client
+     * socket already. */
+    if (g_signal_pipe[1] >= 0 && write(g_signal_pipe[1], &sig_caught, 1))
         /* we ignore result, if () shuts up stupid compiler */;
     errno = save_errno;
 }
@@ -245,6 +296,15 @@ static int problem_dump_dir_was_provoked_by_abrt_event(struct dump_dir *dd, char
     return env_var != NULL;
 }
 
+/* Lets abrtd refresh its catalog of the problem whose elements were changed */
+static void
+notify_problem_updated(const char *dirname)
+{
+    const char *slash = strrchr(dirname, '/');
+    fprintf(stderr, "PROBLEM_UPDATED: %s\n", slash ? slash + 1 : dirname);
+    fflush(stderr);
+}
+
 static int
 emit_new_problem_signal(gpointer data)
 {
@@ -278,7 +338,10 @@ struct response
          return c; } while (0)
 
 
-static int run_post_create(const char *dirname, struct response *resp)
+/* dup_key is the early duplicate key of the problem, if any. The problem
+ * directory which is kept after post-create is registered under the key.
+ */
+static int run_post_create(const char *dirname, const char *dup_key, struct response *resp)
 {
     /* If doesn't start with "abrt_g_settings_dump_location/"... */
     if (!abrt_dir_is_in_dump_location(dirname))
@@ -336,11 +399,13 @@ static int run_post_create(const char *dirname, struct response *resp)
     }
 
     /*
-     * The post-create event cannot be run concurrently for more problem
-     * directories. The problem is in searching for duplicates process
-     * in case when two concurrently processed directories are duplicates
-     * of each other. Both of the directories are marked as duplicates
-     * of each other and are deleted.
+     * The post-create event cannot be run concurrently for problem
+     * directories which might be duplicates of each other. The problem is in
+     * searching for duplicates process in case when two concurrently
+     * processed directories are duplicates of each other. Both of the
+     * directories are marked as duplicates of each other and are deleted.
+     * abrtd lets us continue once no possible duplicate is being processed
+     * (see MaxParallelPostCreate in abrt.conf).
      */
     log_debug("Creating glib main loop");
     struct waiting_context context = {0};
@@ -366,6 +431,7 @@ static int run_post_create(const char *dirname, struct response *resp)
     g_main_loop_unref(context.main_loop);
     g_io_channel_unref(channel_signal);
     close(g_signal_pipe[1]);
+    g_signal_pipe[1] = -1;
 
     log_notice("Waiting finished");
 
@@ -519,6 +585,9 @@ static int run_post_create(const char *dirname, struct response *resp)
 
     dd_close(dd);
 
+    if (dup_key != NULL)
+        abrt_dup_index_add(EARLY_DUP_INDEX_DIR, dup_key, work_dir);
+
     if (!dup_of_dir)
         log_notice("New problem directory %s, processing", work_dir);
     else
@@ -527,6 +596,7 @@ static int run_post_create(const char *dirname, struct response *resp)
                     strrchr(dirname, '/') + 1,
                     strrchr(dup_of_dir, '/') + 1);
         delete_dump_dir(dirname);
+        notify_problem_updated(dup_of_dir);
     }
 
     /* Run "notify[-dup]" event */
@@ -562,36 +632,81 @@ static int run_post_create(const char *dirname, struct response *resp)
     return 0;
 }
 
-/* Create a new problem directory from client session.
- * Caller must ensure that all fields in struct client
- * are properly filled.
+/* Runs "notify-dup" on a known problem whose new occurrence has been counted
+ * by count_known_duplicate(), the same event run_post_create() runs when
+ * post-create finds a duplicate.
  */
-static int create_problem_dir(GHashTable *problem_info, unsigned pid)
+static void run_notify_dup(const char *dirname)
 {
-    /* Exit if free space is less than 1/4 of MaxCrashReportsSize */
-    if (abrt_g_settings_nMaxCrashReportsSize > 0)
+    int fd;
+    const pid_t child_pid = spawn_event_handler_child(dirname, "notify-dup", &fd);
+
+    FILE *output = fdopen(fd, "r");
+    if (output == NULL)
     {
-        if (abrt_low_free_space(abrt_g_settings_nMaxCrashReportsSize, abrt_g_settings_dump_location))
-            exit(1);
+        perror_msg("fdopen");
+        close(fd);
+    }
+    else
+    {
+        char *line;
+        while ((line = libreport_xmalloc_fgetline(output)) != NULL)
+        {
+            log_warning("%s", line);
+            free(line);
+        }
+        fclose(output);
     }
 
-    /* Create temp directory with the problem data.
-     * This directory is renamed to final directory name after
-     * all files have been stored into it.
-     */
+    int status;
+    if (libreport_safe_waitpid(child_pid, &status, 0) <= 0)
+        perror_msg("waitpid(%d)", child_pid);
+}
+
+/* The problem directory being created, deleted if abrt-server dies */
+static struct dump_dir *g_incomplete_dd;
+
+static void delete_incomplete_problem_dir(void)
+{
+    if (g_incomplete_dd == NULL)
+        return;
+
+    log_notice("Deleting incomplete problem directory '%s'", g_incomplete_dd->dd_dirname);
+    dd_delete(g_incomplete_dd);
+    g_incomplete_dd = NULL;
+}
 
+static char *problem_dir_path(GHashTable *problem_info, unsigned pid, const char *suffix)
+{
     gchar *dir_basename = g_hash_table_lookup(problem_info, "basename");
     if (!dir_basename)
         dir_basename = g_hash_table_lookup(problem_info, FILENAME_TYPE);
 
-    char *path = g_strdup_printf("%s/%s-%s-%u.new",
-                                 abrt_g_settings_dump_location,
-                                 dir_basename,
-                                 libreport_iso_date_string(NULL),
-                                 pid);
+    return g_strdup_printf("%s/%s-%s-%u%s",
+                           abrt_g_settings_dump_location,
+                           dir_basename,
+                           libreport_iso_date_string(NULL),
+                           pid,
+                           suffix);
+}
 
-    /* This item is useless, don't save it */
-    g_hash_table_remove(problem_info, "basename");
+/* Creates the temporary directory for the problem data. The directory is
+ * renamed to the final directory name after all files have been stored into
+ * it. Returns NULL if there is not enough free space or on errors.
+ */
+static struct dump_dir *create_new_problem_dir(GHashTable *problem_info, unsigned pid)
+{
+    /* Refuse if free space is less than 1/4 of MaxCrashReportsSize */
+    if (abrt_g_settings_nMaxCrashReportsSize > 0)
+    {
+        if (abrt_low_free_space(abrt_g_settings_nMaxCrashReportsSize, abrt_g_settings_dump_location))
+            return NULL;
+    }
+
+    /* A worker or a batch might create several directories in one second */
+    static unsigned created = 0;
+    g_autofree char *suffix = created++ == 0 ? g_strdup(".new") : g_strdup_printf("-%u.new", created - 1);
+    g_autofree char *path = problem_dir_path(problem_info, pid, suffix);
 
     /* No need to check the path length, as all variables used are limited,
      * and dd_create() fails if the path is too long.
@@ -599,9 +714,230 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
     struct dump_dir *dd = dd_create(path, /*fs owner*/0, DEFAULT_DUMP_DIR_MODE);
     if (!dd)
     {
-        error_msg_and_die("Error creating problem directory '%s'", path);
+        error_msg("Error creating problem directory '%s'", path);
+        return NULL;
+    }
+
+    g_incomplete_dd = dd;
+    return dd;
+}
+
+/* Values of elements bigger than this are written directly to the problem
+ * directory instead of being kept in memory.
+ */
+#define STREAM_THRESHOLD INPUT_BUFFER_SIZE
+/* Maximal length of element names */
+#define MAX_KEY_LENGTH 255
+
+/* Parser of the body of a problem creation request.
+ *
+ * The body is a sequence of "key=value\0" elements. The data read from the
+ * client are parsed in place, so the elements are never moved around in a
+ * buffer. Elements abrt-server needs or has to check are kept in
+ * problem_info. Other elements bigger than STREAM_THRESHOLD are written to
+ * files named "<key>.new" in the new problem directory as soon as the
+ * directory can be created (its name requires the type) and
+ * create_problem_dir() renames the files once all other elements are saved.
+ */
+struct body_parser
+{
+    GHashTable *problem_info;
+    enum {
+        PARSE_KEY,
+        PARSE_VALUE,
+        PARSE_STREAM,
+        PARSE_FD,
+        PARSE_SKIP,
+    } state;
+    GString *key;
+    GString *value;
+    /* File of the element being streamed */
+    int fd;
+    /* Created by the first streamed element */
+    struct dump_dir *dd;
+    bool dd_failed;
+    /* Names of the streamed elements */
+    GHashTable *streamed;
+    /* Names of the elements passed as file descriptors mapped to indexes
+     * into received_fds */
+    GHashTable *fd_elements;
+};
+
+static void body_parser_init(struct body_parser *bp, GHashTable *problem_info)
+{
+    bp->problem_info = problem_info;
+    bp->state = PARSE_KEY;
+    bp->key = g_string_new(NULL);
+    bp->value = g_string_new(NULL);
+    bp->fd = -1;
+    bp->dd = NULL;
+    bp->dd_failed = false;
+    bp->streamed = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    bp->fd_elements = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+}
+
+/* Deletes the new problem directory if it was created and lets the parser
+ * start again */
+static void body_parser_discard(struct body_parser *bp)
+{
+    if (bp->fd >= 0)
+    {
+        close(bp->fd);
+        bp->fd = -1;
+    }
+
+    if (bp->dd != NULL)
+    {
+        g_incomplete_dd = NULL;
+        dd_delete(bp->dd);
+        bp->dd = NULL;
+    }
+
+    g_hash_table_remove_all(bp->streamed);
+    g_hash_table_remove_all(bp->fd_elements);
+
+    bp->state = PARSE_KEY;
+    g_string_truncate(bp->key, 0);
+    g_string_truncate(bp->value, 0);
+    bp->dd_failed = false;
+}
+
+static void body_parser_destroy(struct body_parser *bp)
+{
+    body_parser_discard(bp);
+    g_string_free(bp->key, TRUE);
+    g_string_free(bp->value, TRUE);
+    g_hash_table_destroy(bp->streamed);
+    g_hash_table_destroy(bp->fd_elements);
+}
+
+static char *streamed_element_file_name(const char *key)
+{
+    return g_strconcat(key, ".new", NULL);
+}
+
+static void delete_streamed_element(struct body_parser *bp, const char *key)
+{
+    g_autofree char *name = streamed_element_file_name(key);
+    dd_delete_item(bp->dd, name);
+}
+
+/* Copies at most size bytes, fails if the alarm interrupts reading as
+ * the file might be on a file system the client controls. */
+static bool copy_fd_data(int src_fd, int dst_fd, off_t size)
+{
+    char buf[INPUT_BUFFER_SIZE];
+    while (size > 0)
+    {
+        const ssize_t r = read(src_fd, buf, MIN(size, (off_t)sizeof(buf)));
+        if (r < 0)
+            return false;
+        /* Truncated since fstat() */
+        if (r == 0)
+            break;
+        if (libreport_full_write(dst_fd, buf, r) != r)
+            return false;
+        size -= r;
+    }
+
+    return true;
+}
+
+/* Copies the regular file passed by client to the element. The data blocks
+ * are shared if the file system supports it, otherwise the kernel copies the
+ * data without passing it through abrt-server if possible.
+ *
+ * budget is the number of bytes all the files of the problem may still
+ * have, negative for no limit.
+ */
+static void save_element_from_fd(struct dump_dir *dd, const char *name, int src_fd,
+            off_t *budget)
+{
+    struct stat st;
+    if (fstat(src_fd, &st) != 0)
+    {
+        perror_msg("Can't stat file of element '%s'", name);
+        return;
+    }
+
+    if (!S_ISREG(st.st_mode))
+    {
+        error_msg("File of element '%s' is not a regular file", name);
+        return;
+    }
+
+    if (*budget >= 0 && st.st_size > *budget)
+    {
+        error_msg("File of element '%s' is too big", name);
+        return;
+    }
+
+    const int dst_fd = dd_open_item(dd, name, O_RDWR);
+    if (dst_fd < 0)
+        return;
+
+    bool ok = false;
+#ifdef FICLONE
+    ok = ioctl(dst_fd, FICLONE, src_fd) == 0;
+#endif
+
+    off_t off_in = 0;
+    ssize_t r = 0;
+    while (!ok && off_in < st.st_size)
+    {
+        r = copy_file_range(src_fd, &off_in, dst_fd, NULL, st.st_size - off_in, 0);
+        if (r <= 0)
+            break;
+    }
+
+    if (!ok && r < 0 && off_in == 0 && errno != EINTR)
+    {
+        /* Not supported for these files, copy the data ourselves */
+        if (lseek(src_fd, 0, SEEK_SET) == 0)
+            ok = copy_fd_data(src_fd, dst_fd, st.st_size);
+    }
+    else if (!ok)
+        ok = r >= 0;
+
+    if (close(dst_fd) != 0)
+        ok = false;
+
+    if (!ok)
+    {
+        perror_msg("Can't save element '%s'", name);
+        dd_delete_item(dd, name);
+        return;
     }
 
+    if (*budget >= 0)
+        *budget -= st.st_size;
+}
+
+/* Saves the problem data received from client to a new problem directory.
+ * Caller must ensure that all fields in struct client
+ * are properly filled.
+ *
+ * Returns the path of the new problem directory or NULL on errors.
+ */
+static char *save_problem_dir(struct body_parser *bp, unsigned pid)
+{
+    GHashTable *problem_info = bp->problem_info;
+
+    /* Create temp directory with the problem data unless some elements have
+     * been already streamed into it.
+     */
+    struct dump_dir *dd = bp->dd;
+    if (dd == NULL)
+        dd = create_new_problem_dir(problem_info, pid);
+    if (dd == NULL)
+        return NULL;
+    bp->dd = NULL;
+
+    char *path = problem_dir_path(problem_info, pid, "");
+
+    /* This item is useless, don't save it */
+    g_hash_table_remove(problem_info, "basename");
+
     const int proc_dir_fd = libreport_open_proc_pid_dir(pid);
     g_autofree char *rootdir = NULL;
 
@@ -713,21 +1049,75 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
         dd_save_text(dd, (gchar *) gpkey, (gchar *) gpvalue);
     }
 
+    /* The streamed elements override the collected data like the others */
+    g_hash_table_iter_init(&iter, bp->streamed);
+    while (g_hash_table_iter_next(&iter, &gpkey, NULL))
+    {
+        g_autofree char *name = streamed_element_file_name(gpkey);
+        if (renameat(dd->dd_fd, name, dd->dd_fd, gpkey) != 0)
+            perror_msg("Can't rename element '%s'", name);
+    }
+
+    /* The files are not read through the socket, so neither the timeout nor
+     * MAX_MESSAGE_SIZE of the request applies to them. Only root may save
+     * more than could have been sent over the socket.
+     */
+    off_t fd_budget = MAX_MESSAGE_SIZE;
+    if (client_uid == 0)
+        fd_budget = abrt_g_settings_nMaxCrashReportsSize > 0
+                    ? (off_t)abrt_g_settings_nMaxCrashReportsSize * 1024 * 1024
+                    : -1;
+
+    /* A batch keeps the timeout of the request running */
+    const unsigned request_timeout = alarm(TIMEOUT);
+    g_hash_table_iter_init(&iter, bp->fd_elements);
+    while (g_hash_table_iter_next(&iter, &gpkey, &gpvalue))
+        save_element_from_fd(dd, gpkey, received_fds[GPOINTER_TO_UINT(gpvalue)], &fd_budget);
+    alarm(request_timeout);
+
     dd_save_text(dd, FILENAME_ABRT_VERSION, VERSION);
 
+    g_autofree char *new_path = g_strdup(dd->dd_dirname);
+    g_incomplete_dd = NULL;
     dd_close(dd);
 
     /* Not needing it anymore */
-    g_hash_table_destroy(problem_info);
+    g_hash_table_remove_all(problem_info);
+    g_hash_table_remove_all(bp->streamed);
+    g_hash_table_remove_all(bp->fd_elements);
 
     /* Move the completely created problem directory
-     * to final directory.
+     * to final directory. Problems of the same process received in the same
+     * second (e.g. in one batch) are numbered.
      */
-    g_autofree char *newpath = g_strndup(path, strlen(path) - strlen(".new"));
-    if (rename(path, newpath) == 0)
-        strcpy(path, newpath);
+    g_autofree char *base_path = g_strdup(path);
+    for (unsigned i = 1; rename(new_path, path) != 0; i++)
+    {
+        g_free(path);
+        if ((errno != EEXIST && errno != ENOTEMPTY) || i > MAX_BATCH_RECORDS)
+        {
+            path = g_steal_pointer(&new_path);
+            break;
+        }
+        path = g_strdup_printf("%s-%u", base_path, i);
+    }
 
     log_notice("Saved problem directory of pid %u to '%s'", pid, path);
+    return path;
+}
+
+/* Create a new problem directory from client session.
+ *
+ * The client is answered and disconnected before the post-create event is
+ * run, hence the function returns 201 to let the caller know that no other
+ * response must be sent.
+ */
+static int create_problem_dir(struct body_parser *bp, unsigned pid, const char *dup_key)
+{
+    char *path = save_problem_dir(bp, pid);
+    if (path == NULL)
+        return 500; /* Internal Server Error */
+    close_received_fds();
 
     /* We let the peer know that problem dir was created successfully
      * _before_ we run potentially long-running post-create.
@@ -742,30 +1132,34 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
     close(STDOUT_FILENO);
     libreport_xdup2(STDERR_FILENO, STDOUT_FILENO); /* paranoia: don't leave stdout fd closed */
 
-    /* Trim old problem directories if necessary */
-    if (abrt_g_settings_nMaxCrashReportsSize > 0)
-    {
-        abrt_trim_problem_dirs(abrt_g_settings_dump_location, abrt_g_settings_nMaxCrashReportsSize * (double)(1024*1024), path);
-    }
-
-    run_post_create(path, NULL);
+    /* Old problem directories are trimmed by abrtd when it is notified about
+     * the new problem in run_post_create(). abrtd keeps an index of sizes of
+     * the problem directories, so the dump location is not traversed here.
+     */
+    run_post_create(path, dup_key, NULL);
 
-    /* free(path); */
-    exit(0);
+    g_free(path);
+    return 201; /* Created, the response has been already sent */
 }
 
-static gboolean key_value_ok(gchar *key, gchar *value)
+static gboolean key_ok(const gchar *key)
 {
-    char *i;
-
     /* check key, it has to be valid filename and will end up in the
      * bugzilla */
-    for (i = key; *i != 0; i++)
+    for (const gchar *i = key; *i != 0; i++)
     {
         if (!isalpha(*i) && (*i != '-') && (*i != '_') && (*i != ' '))
             return FALSE;
     }
 
+    return TRUE;
+}
+
+static gboolean key_value_ok(gchar *key, gchar *value)
+{
+    if (!key_ok(key))
+        return FALSE;
+
     /* check value of 'basename', it has to be valid non-hidden directory
      * name */
     if (strcmp(key, "basename") == 0
@@ -783,47 +1177,278 @@ static gboolean key_value_ok(gchar *key, gchar *value)
     return abrt_new_user_problem_entry_allowed(client_uid, key, value);
 }
 
-/* Handles a message received from client over socket. */
-static void process_message(GHashTable *problem_info, char *message)
+/* Elements abrt-server needs or whose values must be checked are never
+ * streamed to disk.
+ */
+static bool element_can_be_streamed(const char *key)
+{
+    return !problem_entry_is_post_create_condition(key)
+        && strcmp(key, FILENAME_PID) != 0
+        && strcmp(key, FILENAME_REASON) != 0
+        && strcmp(key, FILENAME_EXECUTABLE) != 0;
+}
+
+/* Checks the elements whose values abrt-server doesn't keep in memory, the
+ * streamed ones and the ones passed as file descriptors. Their values never
+ * need to be checked (see element_can_be_streamed()), so it is enough to
+ * check the same as key_value_ok() does for their names.
+ */
+static gboolean key_without_value_ok(const gchar *key)
+{
+    if (!key_ok(key) || !element_can_be_streamed(key))
+        return FALSE;
+
+    /* The value matters only for the post-create conditions */
+    return abrt_new_user_problem_entry_allowed(client_uid, key, /*value*/"");
+}
+
+static void start_element_value(struct body_parser *bp)
+{
+    g_autofree gchar *key = g_ascii_strdown(bp->key->str, bp->key->len);
+    g_string_assign(bp->key, key);
+
+    /* "KEY:fd=N" - the contents are in the N-th received file */
+    const bool passed_as_fd = g_str_has_suffix(bp->key->str, ":fd");
+    if (passed_as_fd)
+        g_string_truncate(bp->key, bp->key->len - strlen(":fd"));
+
+    if (!key_ok(bp->key->str))
+    {
+        /* should use error_msg_and_die() here? */
+        error_msg("Invalid key format: %s", bp->key->str);
+        bp->state = PARSE_SKIP;
+    }
+    else if (strcmp(bp->key->str, FILENAME_UID) == 0)
+    {
+        error_msg("Ignoring value of %s, will be determined later",
+                  FILENAME_UID);
+        bp->state = PARSE_SKIP;
+    }
+    else if (passed_as_fd && !element_can_be_streamed(bp->key->str))
+    {
+        error_msg("Element '%s' can't be passed as a file descriptor", bp->key->str);
+        bp->state = PARSE_SKIP;
+    }
+    else
+        bp->state = passed_as_fd ? PARSE_FD : PARSE_VALUE;
+}
+
+/* Switches the current element to streaming. Returns false if the element
+ * must stay in memory for now.
+ */
+static bool start_streaming(struct body_parser *bp)
+{
+    if (bp->dd == NULL)
+    {
+        /* The directory is named after the type */
+        if (bp->dd_failed || g_hash_table_lookup(bp->problem_info, FILENAME_TYPE) == NULL)
+            return false;
+
+        /* The directory is renamed in create_problem_dir(), use our pid
+         * because the pid of the crashed process might not be known yet.
+         */
+        bp->dd = create_new_problem_dir(bp->problem_info, getpid());
+        if (bp->dd == NULL)
+        {
+            bp->dd_failed = true;
+            return false;
+        }
+    }
+
+    g_autofree char *name = streamed_element_file_name(bp->key->str);
+    bp->fd = dd_open_item(bp->dd, name, O_RDWR);
+    if (bp->fd < 0)
+    {
+        bp->fd = -1;
+        return false;
+    }
+
+    log_debug("Writing element '%s' to '%s'", bp->key->str, bp->dd->dd_dirname);
+    bp->state = PARSE_STREAM;
+
+    /* What has been received so far */
+    const bool ok = libreport_full_write(bp->fd, bp->value->str, bp->value->len) == bp->value->len;
+    g_string_truncate(bp->value, 0);
+    return ok;
+}
+
+static void stop_streaming(struct body_parser *bp, bool ok)
 {
-    g_autofree gchar *key = NULL;
-    gchar *value;
+    if (close(bp->fd) != 0)
+        ok = false;
+    bp->fd = -1;
+
+    if (!ok)
+    {
+        perror_msg("Can't write element '%s'", bp->key->str);
+        delete_streamed_element(bp, bp->key->str);
+        bp->state = PARSE_SKIP;
+    }
+}
 
-    value = strchr(message, '=');
-    if (value)
+static void append_element_value(struct body_parser *bp, const char *data, size_t len)
+{
+    if (bp->state == PARSE_STREAM)
     {
-        key = g_ascii_strdown(message, value - message); /* result is malloced */
-//TODO: is it ok? it uses g_malloc, not malloc!
+        if (libreport_full_write(bp->fd, data, len) != len)
+            stop_streaming(bp, /*ok*/false);
+        return;
+    }
 
-        value++;
-        if (key_value_ok(key, value))
+    g_string_append_len(bp->value, data, len);
+
+    if (bp->state == PARSE_FD)
+    {
+        /* The index is a small number */
+        if (bp->value->len > 8)
         {
-            if (strcmp(key, FILENAME_UID) == 0)
+            error_msg("Invalid file descriptor index of element '%s'", bp->key->str);
+            bp->state = PARSE_SKIP;
+        }
+        return;
+    }
+
+    if (bp->value->len > STREAM_THRESHOLD
+     && element_can_be_streamed(bp->key->str)
+     && !start_streaming(bp)
+     && bp->fd >= 0)
+    {
+        stop_streaming(bp, /*ok*/false);
+    }
+}
+
+/* Handles a complete element received from client */
+static void finish_element(struct body_parser *bp)
+{
+    switch (bp->state)
+    {
+        case PARSE_KEY:
+            /* should use error_msg_and_die() here? */
+            error_msg("Invalid message format: '%s'", bp->key->str);
+            break;
+
+        case PARSE_VALUE:
+            if (key_value_ok(bp->key->str, bp->value->str))
             {
-                error_msg("Ignoring value of %s, will be determined later",
-                          FILENAME_UID);
+                /* The last received value wins */
+                if (g_hash_table_remove(bp->streamed, bp->key->str))
+                    delete_streamed_element(bp, bp->key->str);
+                g_hash_table_remove(bp->fd_elements, bp->key->str);
+
+                g_hash_table_insert(bp->problem_info, g_strdup(bp->key->str), g_strdup(bp->value->str));
             }
             else
             {
-                g_hash_table_insert(problem_info, key, g_strdup(value));
-                /* Prevent freeing key later: */
-                key = NULL;
+                /* should use error_msg_and_die() here? */
+                error_msg("Invalid key or value format: %s=%s", bp->key->str, bp->value->str);
+            }
+            break;
+
+        case PARSE_STREAM:
+            stop_streaming(bp, /*ok*/true);
+            if (bp->state == PARSE_STREAM && !key_without_value_ok(bp->key->str))
+            {
+                error_msg("Invalid key format: %s", bp->key->str);
+                delete_streamed_element(bp, bp->key->str);
+            }
+            else if (bp->state == PARSE_STREAM)
+            {
+                /* The last received value wins */
+                g_hash_table_remove(bp->problem_info, bp->key->str);
+                g_hash_table_remove(bp->fd_elements, bp->key->str);
+                g_hash_table_add(bp->streamed, g_strdup(bp->key->str));
+            }
+            break;
+
+        case PARSE_FD:
+        {
+            /* The descriptors are sent along with the data, so the index must
+             * refer to an already received one */
+            char *end;
+            errno = 0;
+            const unsigned long index = strtoul(bp->value->str, &end, 10);
+            if (errno || end == bp->value->str || *end != '\0' || index >= received_fds_count)
+            {
+                error_msg("Invalid file descriptor index of element '%s': '%s'",
+                          bp->key->str, bp->value->str);
+                break;
+            }
+
+            if (!key_without_value_ok(bp->key->str))
+            {
+                error_msg("Invalid key format: %s", bp->key->str);
+                break;
             }
+
+            /* The last received value wins */
+            g_hash_table_remove(bp->problem_info, bp->key->str);
+            if (g_hash_table_remove(bp->streamed, bp->key->str))
+                delete_streamed_element(bp, bp->key->str);
+            g_hash_table_insert(bp->fd_elements, g_strdup(bp->key->str), GUINT_TO_POINTER(index));
+            break;
         }
-        else
+
+        case PARSE_SKIP:
+            break;
+    }
+
+    g_string_truncate(bp->key, 0);
+    g_string_truncate(bp->value, 0);
+    bp->state = PARSE_KEY;
+}
+
+/* Parses the data received from client in place */
+static void body_parser_feed(struct body_parser *bp, const char *data, size_t len)
+{
+    const char *const end = data + len;
+    while (data < end)
+    {
+        const char *nul = memchr(data, '\0', end - data);
+        const char *chunk_end = nul != NULL ? nul : end;
+
+        if (bp->state == PARSE_KEY)
         {
-            /* should use error_msg_and_die() here? */
-            error_msg("Invalid key or value format: %s", message);
+            const char *eq = memchr(data, '=', chunk_end - data);
+            g_string_append_len(bp->key, data, (eq != NULL ? eq : chunk_end) - data);
+
+            if (bp->key->len > MAX_KEY_LENGTH)
+            {
+                error_msg("Element name is too long: '%.*s...'", 32, bp->key->str);
+                bp->state = PARSE_SKIP;
+            }
+            else if (eq != NULL)
+            {
+                start_element_value(bp);
+                data = eq + 1;
+                continue;
+            }
         }
+        else if (bp->state != PARSE_SKIP)
+            append_element_value(bp, data, chunk_end - data);
+
+        if (nul == NULL)
+            break;
+
+        finish_element(bp);
+        data = nul + 1;
     }
-    else
+}
+
+/* Drops the last element if it was not terminated */
+static void body_parser_finish(struct body_parser *bp)
+{
+    if (bp->state == PARSE_STREAM)
     {
-        /* should use error_msg_and_die() here? */
-        error_msg("Invalid message format: '%s'", message);
+        close(bp->fd);
+        bp->fd = -1;
+        delete_streamed_element(bp, bp->key->str);
     }
+
+    if (bp->state != PARSE_KEY || bp->key->len != 0)
+        log_debug("Ignoring unterminated element '%s'", bp->key->str);
 }
 
-static void die_if_data_is_missing(GHashTable *problem_info)
+static bool data_is_missing(GHashTable *problem_info)
 {
     gboolean missing_data = FALSE;
     gchar **pstring;
@@ -844,68 +1469,456 @@ static void die_if_data_is_missing(GHashTable *problem_info)
         }
     }
 
-    if (missing_data)
-        error_msg_and_die("Some data is missing, aborting");
+    return missing_data;
 }
 
 /*
  * Takes hash table, looks for key FILENAME_PID and tries to convert its value
- * to int.
+ * to int. Returns 0 if the value is missing or malformed.
  */
-unsigned convert_pid(GHashTable *problem_info)
+static unsigned parse_pid(GHashTable *problem_info)
 {
     long ret;
     gchar *pid_str = (gchar *) g_hash_table_lookup(problem_info, FILENAME_PID);
     char *err_pos;
 
     if (!pid_str)
-        error_msg_and_die("PID data is missing, aborting");
-
-    errno = 0;
+    {
+        error_msg("PID data is missing");
+        return 0;
+    }
+
+    errno = 0;
     ret = strtol(pid_str, &err_pos, 10);
     if (errno || pid_str == err_pos || *err_pos != '\0'
         || ret > UINT_MAX || ret < 1)
-        error_msg_and_die("Malformed or out-of-range PID number: '%s'", pid_str);
+    {
+        error_msg("Malformed or out-of-range PID number: '%s'", pid_str);
+        return 0;
+    }
 
     return (unsigned) ret;
 }
 
-static int perform_http_xact(struct response *rsp)
+/* The pid sent by a client running in own PID namespace is meaningless
+ * for us */
+static unsigned client_namespace_pid(unsigned pid, const struct ns_ids *client_ids)
 {
-    /* use free instead of g_free so that we can use xstr* functions from
-     * libreport/lib/xfuncs.c
-     */
+    if (client_ids->nsi_ids[PROC_NS_ID_PID] != g_ns_ids.nsi_ids[PROC_NS_ID_PID])
+    {
+        log_notice("Client is running in own PID Namespace, using PID %d instead of %d", client_pid, pid);
+        return client_pid;
+    }
+
+    return pid;
+}
+
+static bool is_repeating_crash(GHashTable *problem_info)
+{
+    char *executable = g_hash_table_lookup(problem_info, FILENAME_EXECUTABLE);
+    if (executable == NULL)
+        return false;
+
+    g_autofree char *last_file = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", "last-via-server", NULL);
+    if (!check_recent_crash_file(last_file, executable))
+        return false;
+
+    error_msg("Not saving repeating crash in '%s'", executable);
+    return true;
+}
+
+/* Identifies problems which are duplicates of each other without creating
+ * the problem directory. Only problems with a backtrace have the key because
+ * type, uid and executable alone don't tell duplicates apart. The backtrace
+ * is compared by its frames, see abrt_dup_backtrace_key(), the addresses and
+ * line numbers differ between occurrences of the same problem.
+ */
+static char *early_dup_key(struct body_parser *bp)
+{
+    const char *type = g_hash_table_lookup(bp->problem_info, FILENAME_TYPE);
+    if (type == NULL)
+        return NULL;
+
+    /* abrt-server doesn't read the backtraces passed as file descriptors */
+    g_autofree char *streamed_backtrace = NULL;
+    const char *backtrace = g_hash_table_lookup(bp->problem_info, FILENAME_BACKTRACE);
+    if (backtrace == NULL && bp->dd != NULL && g_hash_table_contains(bp->streamed, FILENAME_BACKTRACE))
+    {
+        g_autofree char *name = streamed_element_file_name(FILENAME_BACKTRACE);
+        backtrace = streamed_backtrace = dd_load_text_ext(bp->dd, name,
+                                DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    }
+
+    if (backtrace == NULL)
+        return NULL;
+
+    g_autofree char *backtrace_key = abrt_dup_backtrace_key(type, backtrace);
+    if (backtrace_key == NULL)
+        return NULL;
+
+    const char *executable = g_hash_table_lookup(bp->problem_info, FILENAME_EXECUTABLE);
+    const char *container_id = g_hash_table_lookup(bp->problem_info, FILENAME_CONTAINER_ID);
+
+    return g_strdup_printf("%s\n%lu\n%s\n%s\n%s",
+                           type,
+                           (long)client_uid,
+                           executable ? executable : "",
+                           container_id ? container_id : "",
+                           backtrace_key);
+}
+
+/* Counts the new occurrence of a known problem the same way as post-create
+ * counts duplicates. Returns the directory of the problem or NULL if the
+ * problem is not known. The caller must run_notify_dup() on the directory.
+ */
+static char *count_known_duplicate(const char *dup_key)
+{
+    g_autofree char *dirname = abrt_dup_index_lookup(EARLY_DUP_INDEX_DIR, dup_key);
+    if (dirname == NULL)
+        return NULL;
+
+    struct dump_dir *dd = NULL;
+    if (abrt_dir_is_in_dump_location(dirname))
+        dd = dd_opendir(dirname, DD_FAIL_QUIETLY_ENOENT);
+
+    if (dd == NULL)
+    {
+        log_debug("Removing stale duplicate index entry of '%s'", dirname);
+        abrt_dup_index_remove(EARLY_DUP_INDEX_DIR, dup_key, dirname);
+        return NULL;
+    }
+
+    /* The directory must have been processed by post-create */
+    char uid_str[sizeof(long) * 3 + 2];
+    sprintf(uid_str, "%lu", (long)client_uid);
+    g_autofree char *dd_uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    g_autofree char *count_str = dd_load_text_ext(dd, FILENAME_COUNT, DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    if (dd_uid == NULL || strcmp(dd_uid, uid_str) != 0 || count_str == NULL)
+    {
+        dd_close(dd);
+        return NULL;
+    }
+
+    char new_count_str[sizeof(long)*3 + 2];
+    sprintf(new_count_str, "%lu", strtoul(count_str, NULL, 10) + 1);
+    dd_save_text(dd, FILENAME_COUNT, new_count_str);
+
+    char time_str[sizeof(long)*3 + 2];
+    sprintf(time_str, "%lu", (long)time(NULL));
+    dd_save_text(dd, FILENAME_LAST_OCCURRENCE, time_str);
+
+    dd_close(dd);
+    notify_problem_updated(dirname);
+
+    log_notice("Counted duplicate of '%s' without saving it", dirname);
+    return g_steal_pointer(&dirname);
+}
+
+/* Answers the client whose problem has been counted by
+ * count_known_duplicate() and runs "notify-dup" after it has been
+ * disconnected, hence returns 201 like create_problem_dir().
+ */
+static int answer_known_duplicate(const char *dirname)
+{
+    printf("HTTP/1.1 303 \r\n\r\n");
+    fflush(NULL);
+
+    /* The same as in create_problem_dir() */
+    close(STDIN_FILENO);
+    close(STDOUT_FILENO);
+    libreport_xdup2(STDERR_FILENO, STDOUT_FILENO); /* paranoia: don't leave stdout fd closed */
+
+    run_notify_dup(dirname);
+
+    return 201; /* The response has been already sent */
+}
+
+/* Remembers the file descriptors sent by client along with data */
+static void receive_fds(struct msghdr *msg)
+{
+    if (msg->msg_flags & MSG_CTRUNC)
+        error_msg("Too many file descriptors received, some were dropped");
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        const int *fds = (const int *)CMSG_DATA(cmsg);
+        const unsigned count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (unsigned i = 0; i < count; i++)
+        {
+            if (received_fds_count < MAX_RECEIVED_FDS)
+                received_fds[received_fds_count++] = fds[i];
+            else
+            {
+                error_msg("Too many file descriptors received, dropping %d", fds[i]);
+                close(fds[i]);
+            }
+        }
+    }
+}
+
+/* HTTP status of the last failure of read_input() */
+static int input_error;
+
+/* Reads data from client, returns 0 on EOF and -1 on errors, the client is
+ * then answered with input_error */
+static int read_input(char *buf, unsigned size)
+{
+    struct iovec iov = { .iov_base = buf, .iov_len = size };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * MAX_RECEIVED_FDS)];
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+
+    int rd = recvmsg(STDIN_FILENO, &msg, MSG_CMSG_CLOEXEC);
+    if (rd < 0 && errno == ENOTSOCK)
+    {
+        /* Started by hand with a file or a pipe on stdin */
+        rd = read(STDIN_FILENO, buf, size);
+        msg.msg_controllen = 0;
+    }
+    if (rd >= 0 && msg.msg_controllen != 0)
+        receive_fds(&msg);
+
+    if (rd < 0)
+    {
+        if (errno == EINTR) /* SIGALRM? */
+        {
+            error_msg("Timed out");
+            input_error = 408; /* Request Timeout */
+        }
+        else
+        {
+            perror_msg("read");
+            input_error = 400; /* Bad Request */
+        }
+        return -1;
+    }
+    if (rd == 0)
+        return 0;
+
+    log_debug("Received %u bytes of data", rd);
+    total_bytes_read += rd;
+    if (total_bytes_read > max_bytes_read)
+    {
+        error_msg("Message is too long, aborting");
+        input_error = 413; /* Payload Too Large */
+        return -1;
+    }
+
+    return rd;
+}
+
+/* Saves one problem of a batch, returns the HTTP status of the record */
+static int save_batch_record(struct body_parser *bp, const struct ns_ids *client_ids,
+                             GPtrArray *new_dirs, GPtrArray *dup_keys, GPtrArray *dup_dirs)
+{
+    if (data_is_missing(bp->problem_info))
+        return 400; /* Bad Request */
+
+    if (is_repeating_crash(bp->problem_info)) /* Only pretend that we saved it */
+        return 200;
+
+    unsigned pid = parse_pid(bp->problem_info);
+    if (pid == 0)
+        return 400; /* Bad Request */
+    pid = client_namespace_pid(pid, client_ids);
+
+    char *dup_key = early_dup_key(bp);
+    char *dup_dir = dup_key != NULL ? count_known_duplicate(dup_key) : NULL;
+    if (dup_dir != NULL)
+    {
+        g_ptr_array_add(dup_dirs, dup_dir);
+        g_free(dup_key);
+        return 303; /* See Other */
+    }
+
+    char *path = save_problem_dir(bp, pid);
+    if (path == NULL)
+    {
+        g_free(dup_key);
+        return 500; /* Internal Server Error */
+    }
+
+    g_ptr_array_add(new_dirs, path);
+    g_ptr_array_add(dup_keys, dup_key);
+    return 201; /* Created */
+}
+
+static void answer_batch_record(int code)
+{
+    printf("HTTP/1.1 %u %s\r\n\r\n", code, code == 201 ? "Created" : "");
+    fflush(stdout);
+}
+
+/* Handles "POST /batch" whose body is a sequence of records:
+ *   "<length>\n" <length bytes in the format of the "POST /" body>
+ * Every record is checked the same way as a single problem and answered with
+ * its own status as soon as it is received. The client is disconnected before
+ * the post-create event is run for the new problem directories, hence the
+ * function returns 201 to let the caller know that no other response must be
+ * sent.
+ */
+static int perform_batch_xact(char *buf, const char *data, int len)
+{
+    /* The namespaces and credentials are the same for all records */
+    struct ns_ids client_ids;
+    if (libreport_get_ns_ids(client_pid, &client_ids) < 0)
+    {
+        error_msg("Cannot get peer's Namespaces from /proc/%d/ns", client_pid);
+        return 500; /* Internal Server Error */
+    }
+
     g_autoptr(GHashTable) problem_info = g_hash_table_new_full(g_str_hash, g_str_equal,
                                      free, free);
-    /* Read header */
+    struct body_parser bp;
+    body_parser_init(&bp, problem_info);
+    g_autoptr(GPtrArray) new_dirs = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GPtrArray) dup_keys = g_ptr_array_new_with_free_func(g_free);
+    /* Known problems counted by count_known_duplicate() */
+    g_autoptr(GPtrArray) dup_dirs = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GString) length = g_string_new(NULL);
+    unsigned long remaining = 0;
+    bool in_record = false;
+    bool failed = false;
+    unsigned records = 0;
+
+    /* The limits apply to the whole batch, not to every record, so a batch
+     * costs at most as much as a few single problems */
+    max_bytes_read = MAX_BATCH_SIZE;
+    alarm(BATCH_TIMEOUT);
+
+    /* Loop until EOF/error/timeout */
+    while (len > 0)
+    {
+        if (!in_record)
+        {
+            const char *nl = memchr(data, '\n', len);
+            const unsigned n = nl != NULL ? nl - data : len;
+            g_string_append_len(length, data, n);
+            data += n;
+            len -= n;
+            if (nl == NULL && length->len <= MAX_RECORD_LENGTH_DIGITS)
+            {
+                data = buf;
+                len = read_input(buf, INPUT_BUFFER_SIZE);
+                continue;
+            }
+
+            char *end;
+            errno = 0;
+            remaining = strtoul(length->str, &end, 10);
+            if (nl == NULL || errno || end == length->str || *end != '\0'
+             || remaining > MAX_MESSAGE_SIZE)
+            {
+                /* The rest of the body can't be split to records */
+                error_msg("Invalid length of batch record %u", records + 1);
+                answer_batch_record(400);
+                g_string_truncate(length, 0);
+                break;
+            }
+
+            /* Skip '\n' */
+            data++;
+            len--;
+            g_string_truncate(length, 0);
+            in_record = true;
+        }
+
+        const unsigned n = MIN(len, remaining);
+        body_parser_feed(&bp, data, n);
+        data += n;
+        len -= n;
+        remaining -= n;
+
+        if (remaining == 0)
+        {
+            body_parser_finish(&bp);
+            answer_batch_record(save_batch_record(&bp, &client_ids, new_dirs, dup_keys, dup_dirs));
+            body_parser_discard(&bp);
+            g_hash_table_remove_all(problem_info);
+            in_record = false;
+
+            if (++records == MAX_BATCH_RECORDS)
+            {
+                error_msg("Too many records in batch, ignoring the rest");
+                break;
+            }
+        }
+
+        if (len == 0)
+        {
+            data = buf;
+            len = read_input(buf, INPUT_BUFFER_SIZE);
+        }
+    }
+
+    /* Body received, EOF was seen. Don't let alarm to interrupt after this. */
+    alarm(0);
+
+    if (len < 0)
+    {
+        /* The problems received so far are kept */
+        answer_batch_record(input_error);
+        failed = true;
+    }
+
+    if (!failed && (in_record || length->len != 0))
+    {
+        log_warning("Premature EOF detected in batch record %u", records + 1);
+        answer_batch_record(400);
+    }
+
+    body_parser_destroy(&bp);
+    close_received_fds();
+
+    log_notice("Received %u problems in batch, saved %u", records, new_dirs->len);
+
+    /* The same as in create_problem_dir() */
+    close(STDIN_FILENO);
+    close(STDOUT_FILENO);
+    libreport_xdup2(STDERR_FILENO, STDOUT_FILENO); /* paranoia: don't leave stdout fd closed */
+
+    for (unsigned i = 0; i < new_dirs->len; i++)
+        run_post_create(g_ptr_array_index(new_dirs, i), g_ptr_array_index(dup_keys, i), NULL);
+
+    for (unsigned i = 0; i < dup_dirs->len; i++)
+        run_notify_dup(g_ptr_array_index(dup_dirs, i));
+
+    return 201; /* The responses have been already sent */
+}
+
+static int perform_http_xact(struct response *rsp)
+{
+    /* The header and the data received after it, the same buffer is then
+     * reused for reading the body.
+     */
+    char buf[INPUT_BUFFER_SIZE + 1];
     char *body_start = NULL;
-    g_autofree char *messagebuf_data = NULL;
-    unsigned messagebuf_len = 0;
+    unsigned len = 0;
     /* Loop until EOF/error/timeout/end_of_header */
-    while (1)
+    while (len < INPUT_BUFFER_SIZE)
     {
-        messagebuf_data = g_realloc(messagebuf_data, messagebuf_len + INPUT_BUFFER_SIZE);
-        char *p = messagebuf_data + messagebuf_len;
-        int rd = read(STDIN_FILENO, p, INPUT_BUFFER_SIZE);
+        char *p = buf + len;
+        const int rd = read_input(p, INPUT_BUFFER_SIZE - len);
         if (rd < 0)
-        {
-            if (errno == EINTR) /* SIGALRM? */
-                error_msg_and_die("Timed out");
-            perror_msg_and_die("read");
-        }
+            return input_error;
         if (rd == 0)
             break;
-
-        log_debug("Received %u bytes of data", rd);
-        messagebuf_len += rd;
-        total_bytes_read += rd;
-        if (total_bytes_read > MAX_MESSAGE_SIZE)
-            error_msg_and_die("Message is too long, aborting");
+        len += rd;
 
         /* Check whether we see end of header */
         /* Note: we support both [\r]\n\r\n and \n\n */
-        char *past_end = messagebuf_data + messagebuf_len;
-        if (p > messagebuf_data+1)
+        char *past_end = buf + len;
+        if (p > buf+1)
             p -= 2; /* start search from two last bytes in last read - they might be '\n\r' */
         while (p < past_end)
         {
@@ -924,11 +1937,17 @@ static int perform_http_xact(struct response *rsp)
             }
         }
     } /* while (read) */
+    if (len == INPUT_BUFFER_SIZE)
+    {
+        error_msg("Header is too long");
+        return 400; /* Bad Request */
+    }
+    buf[len] = '\0';
  found_end_of_header: ;
-    log_debug("Request: %s", messagebuf_data);
+    log_debug("Request: %s", buf);
 
     /* Sanitize and analyze header.
-     * Header now is in messagebuf_data, NUL terminated string,
+     * Header now is in buf, NUL terminated string,
      * with last empty line deleted (by placement of NUL).
      * \r\n are not (yet) converted to \n, multi-line headers also
      * not converted.
@@ -936,16 +1955,16 @@ static int perform_http_xact(struct response *rsp)
     /* First line must be "op<space>[http://host]/path<space>HTTP/n.n".
      * <space> is exactly one space char.
      */
-    if (g_str_has_prefix(messagebuf_data, "DELETE "))
+    if (g_str_has_prefix(buf, "DELETE "))
     {
-        messagebuf_data += strlen("DELETE ");
-        char *space = strchr(messagebuf_data, ' ');
+        char *dump_dir_name = buf + strlen("DELETE ");
+        char *space = strchr(dump_dir_name, ' ');
         if (!space || !g_str_has_prefix(space+1, "HTTP/"))
             return 400; /* Bad Request */
         *space = '\0';
-        //decode_url(messagebuf_data); %20 => ' '
+        //decode_url(dump_dir_name); %20 => ' '
         alarm(0);
-        return delete_path(messagebuf_data);
+        return delete_path(dump_dir_name);
     }
 
     /* We erroneously used "PUT /" to create new problems.
@@ -953,8 +1972,8 @@ static int perform_http_xact(struct response *rsp)
      * "PUT /" implies creation or replace of resource named "/"!
      * Delete PUT in 2014.
      */
-    if (!g_str_has_prefix(messagebuf_data, "PUT ")
-     && !g_str_has_prefix(messagebuf_data, "POST ")
+    if (!g_str_has_prefix(buf, "PUT ")
+     && !g_str_has_prefix(buf, "POST ")
     ) {
         return 400; /* Bad Request */
     }
@@ -962,13 +1981,16 @@ static int perform_http_xact(struct response *rsp)
     enum {
         CREATION_NOTIFICATION,
         CREATION_REQUEST,
+        CREATION_BATCH,
     };
     int url_type;
-    char *url = libreport_skip_non_whitespace(messagebuf_data) + 1; /* skip "POST " */
+    char *url = libreport_skip_non_whitespace(buf) + 1; /* skip "POST " */
     if (g_str_has_prefix(url, "/creation_notification "))
         url_type = CREATION_NOTIFICATION;
     else if (g_str_has_prefix(url, "/ "))
         url_type = CREATION_REQUEST;
+    else if (g_str_has_prefix(url, "/batch "))
+        url_type = CREATION_BATCH;
     else
         return 400; /* Bad Request */
 
@@ -979,51 +2001,50 @@ static int perform_http_xact(struct response *rsp)
         return 400; /* Bad Request */
     }
 
-    messagebuf_len -= (body_start - messagebuf_data);
-    memmove(messagebuf_data, body_start, messagebuf_len);
-    log_debug("Body so far: %u bytes, '%s'", messagebuf_len, messagebuf_data);
+    if (url_type == CREATION_BATCH)
+        return perform_batch_xact(buf, body_start, len - (body_start - buf));
+
+    /* use free instead of g_free so that we can use xstr* functions from
+     * libreport/lib/xfuncs.c
+     */
+    g_autoptr(GHashTable) problem_info = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                     free, free);
+    struct body_parser bp;
+    body_parser_init(&bp, problem_info);
+    /* Body of creation notification is a path */
+    g_autoptr(GString) notification = g_string_new(NULL);
 
+    const char *data = body_start;
+    len -= (body_start - buf);
     /* Loop until EOF/error/timeout */
-    while (1)
+    while (len > 0)
     {
         if (url_type == CREATION_REQUEST)
-        {
-            while (1)
-            {
-                unsigned len = strnlen(messagebuf_data, messagebuf_len);
-                if (len >= messagebuf_len)
-                    break;
-                /* messagebuf has at least one NUL - process the line */
-                process_message(problem_info, messagebuf_data);
-                messagebuf_len -= (len + 1);
-                memmove(messagebuf_data, messagebuf_data + len + 1, messagebuf_len);
-            }
-        }
+            body_parser_feed(&bp, data, len);
+        else
+            g_string_append_len(notification, data, len);
 
-        messagebuf_data = g_realloc(messagebuf_data, messagebuf_len + INPUT_BUFFER_SIZE + 1);
-        int rd = read(STDIN_FILENO, messagebuf_data + messagebuf_len, INPUT_BUFFER_SIZE);
+        data = buf;
+        const int rd = read_input(buf, INPUT_BUFFER_SIZE);
         if (rd < 0)
         {
-            if (errno == EINTR) /* SIGALRM? */
-                error_msg_and_die("Timed out");
-            perror_msg_and_die("read");
+            alarm(0);
+            body_parser_destroy(&bp);
+            return input_error;
         }
-        if (rd == 0)
-            break;
-
-        log_debug("Received %u bytes of data", rd);
-        messagebuf_len += rd;
-        total_bytes_read += rd;
-        if (total_bytes_read > MAX_MESSAGE_SIZE)
-            error_msg_and_die("Message is too long, aborting");
+        len = rd;
     }
 
     /* Body received, EOF was seen. Don't let alarm to interrupt after this. */
     alarm(0);
 
+    body_parser_finish(&bp);
+
     int ret = 0;
     if (url_type == CREATION_NOTIFICATION)
     {
+        body_parser_destroy(&bp);
+
         if (client_uid != 0)
         {
             error_msg("UID=%ld is not authorized to trigger post-create processing", (long)client_uid);
@@ -1031,40 +2052,220 @@ static int perform_http_xact(struct response *rsp)
             return ret;
         }
 
-        messagebuf_data[messagebuf_len] = '\0';
-        return run_post_create(messagebuf_data, rsp);
+        return run_post_create(notification->str, NULL, rsp);
     }
 
-    die_if_data_is_missing(problem_info);
+    if (data_is_missing(problem_info))
+    {
+        body_parser_destroy(&bp);
+        error_msg("Some data is missing, aborting");
+        return 400; /* Bad Request */
+    }
 
     /* Save problem dir */
-    char *executable = g_hash_table_lookup(problem_info, FILENAME_EXECUTABLE);
-    if (executable)
+    if (is_repeating_crash(problem_info)) /* Only pretend that we saved it */
     {
-        g_autofree char *last_file = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", "last-via-server", NULL);
-        int repeating_crash = check_recent_crash_file(last_file, executable);
-        if (repeating_crash) /* Only pretend that we saved it */
-        {
-            error_msg("Not saving repeating crash in '%s'", executable);
-            return ret; /* ret is 0: "success" */
-        }
+        body_parser_destroy(&bp);
+        return ret; /* ret is 0: "success" */
+    }
+
+    unsigned pid = parse_pid(problem_info);
+    if (pid == 0)
+    {
+        body_parser_destroy(&bp);
+        error_msg("Invalid PID, aborting");
+        return 400; /* Bad Request */
     }
 
-    unsigned pid = convert_pid(problem_info);
     struct ns_ids client_ids;
     if (libreport_get_ns_ids(client_pid, &client_ids) < 0)
-        error_msg_and_die("Cannot get peer's Namespaces from /proc/%d/ns", client_pid);
+    {
+        body_parser_destroy(&bp);
+        error_msg("Cannot get peer's Namespaces from /proc/%d/ns", client_pid);
+        return 500; /* Internal Server Error */
+    }
+
+    pid = client_namespace_pid(pid, &client_ids);
 
-    if (client_ids.nsi_ids[PROC_NS_ID_PID] != g_ns_ids.nsi_ids[PROC_NS_ID_PID])
+    g_autofree char *dup_key = early_dup_key(&bp);
+    g_autofree char *dup_dir = dup_key != NULL ? count_known_duplicate(dup_key) : NULL;
+    if (dup_dir != NULL)
     {
-        log_notice("Client is running in own PID Namespace, using PID %d instead of %d", client_pid, pid);
-        pid = client_pid;
+        body_parser_destroy(&bp);
+        return answer_known_duplicate(dup_dir);
+    }
+
+    ret = create_problem_dir(&bp, pid, dup_key);
+    body_parser_destroy(&bp);
+    return ret;
+}
+
+/* Serves one client connected to STDIN_FILENO and STDOUT_FILENO.
+ * Returns HTTP response code.
+ */
+static int serve_client(uid_t forced_uid)
+{
+    total_bytes_read = 0;
+    alarm(TIMEOUT);
+
+    /* Get uid of the connected client */
+    struct ucred cr;
+    socklen_t crlen = sizeof(cr);
+    if (0 != getsockopt(STDIN_FILENO, SOL_SOCKET, SO_PEERCRED, &cr, &crlen))
+    {
+        perror_msg("getsockopt(SO_PEERCRED)");
+        return 500; /* Internal Server Error */
     }
+    if (crlen != sizeof(cr))
+    {
+        error_msg("%s: bad crlen %d", "getsockopt(SO_PEERCRED)", (int)crlen);
+        return 500; /* Internal Server Error */
+    }
+
+    client_uid = (forced_uid == (uid_t)-1L) ? cr.uid : forced_uid;
+    client_pid = cr.pid;
+
+    struct response rsp = { 0 };
+    int r = perform_http_xact(&rsp);
+    if (r == 0)
+        r = 200;
+
+    /* Unless create_problem_dir() has used them already */
+    close_received_fds();
 
-    create_problem_dir(problem_info, pid);
-    /* does not return */
+    /* The client has been answered and disconnected by create_problem_dir()
+     * or answer_known_duplicate() */
+    if (r == 201)
+        return r;
 
-    return ret; /* Used as HTTP response code */
+    if (rsp.code == 0)
+        rsp.code = r;
+
+    printf("HTTP/1.1 %u \r\n\r\n", rsp.code);
+    if (rsp.message != NULL)
+    {
+        printf("%s", rsp.message);
+        free(rsp.message);
+    }
+    fflush(stdout);
+
+    return r;
+}
+
+/* Big enough for any sane abrt.conf */
+#define MAX_CONF_SNAPSHOT_SIZE (64 * 1024)
+
+/* Loads the configuration snapshot abrtd sent along with the client and
+ * passes it to our children.
+ */
+static void update_conf(const char *snapshot, bool truncated)
+{
+    const unsigned generation = abrt_g_settings_generation;
+
+    if (truncated || snapshot[0] == '\0' || abrt_load_abrt_conf_snapshot(snapshot) != 0)
+    {
+        log_warning("Invalid configuration snapshot received from abrtd, reading the configuration");
+        unsetenv(ABRT_CONF_SNAPSHOT_ENV);
+        abrt_load_abrt_conf();
+    }
+
+    if (generation != abrt_g_settings_generation)
+        setenv(ABRT_CONF_SNAPSHOT_ENV, abrt_get_abrt_conf_snapshot(), 1);
+}
+
+/* Receives a client socket passed by abrtd over the control socket.
+ * Returns -1 if abrtd closed the control socket.
+ */
+static int receive_client(int ctlfd)
+{
+    static char snapshot[MAX_CONF_SNAPSHOT_SIZE];
+    struct iovec iov = { .iov_base = snapshot, .iov_len = sizeof(snapshot) - 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+
+    ssize_t r;
+    while ((r = recvmsg(ctlfd, &msg, 0)) < 0 && errno == EINTR)
+        continue;
+    if (r < 0)
+        perror_msg_and_die("recvmsg");
+    if (r == 0)
+        return -1;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL
+     || cmsg->cmsg_level != SOL_SOCKET
+     || cmsg->cmsg_type != SCM_RIGHTS
+     || cmsg->cmsg_len != CMSG_LEN(sizeof(int)))
+    {
+        error_msg_and_die("Received malformed control message from abrtd");
+    }
+
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+
+    snapshot[r] = '\0';
+    update_conf(snapshot, msg.msg_flags & MSG_TRUNC);
+
+    return fd;
+}
+
+/* Makes the client socket our stdin and stdout, the rest of the code expects
+ * it there as in the case of a single-client abrt-server.
+ */
+static void attach_client(int fd)
+{
+    if (fd != STDIN_FILENO)
+        libreport_xdup2(fd, STDIN_FILENO);
+    libreport_xdup2(STDIN_FILENO, STDOUT_FILENO);
+    if (fd > STDERR_FILENO)
+        close(fd);
+}
+
+static void detach_client(void)
+{
+    /* create_problem_dir() might have closed STDIN_FILENO already */
+    libreport_xmove_fd(libreport_xopen("/dev/null", O_RDWR), STDIN_FILENO);
+    libreport_xdup2(STDERR_FILENO, STDOUT_FILENO);
+}
+
+/* Serves clients passed by abrtd until abrtd closes the control socket. The
+ * namespace ids are loaded only once per worker, the configuration is
+ * updated from the snapshots sent by abrtd.
+ */
+static int run_worker(int ctlfd, uid_t forced_uid)
+{
+    log_notice("Waiting for clients on control socket %d", ctlfd);
+
+    for (;;)
+    {
+        const int fd = receive_client(ctlfd);
+        if (fd < 0)
+            break;
+
+        attach_client(fd);
+        serve_client(forced_uid);
+        /* Do not let the timeout of a rejected client interrupt us */
+        alarm(0);
+        /* A failed client must not leave anything behind */
+        delete_incomplete_problem_dir();
+        close_received_fds();
+        detach_client();
+
+        /* Let abrtd know that we are ready for the next client */
+        fprintf(stderr, "WORKER_IDLE\n");
+        fflush(stderr);
+    }
+
+    log_notice("abrtd closed the control socket, exiting");
+    return 0;
 }
 
 static void dummy_handler(int sig_unused) {}
@@ -1089,13 +2290,16 @@ int main(int argc, char **argv)
         OPT_u = 1 << 1,
         OPT_s = 1 << 2,
         OPT_p = 1 << 3,
+        OPT_w = 1 << 4,
     };
+    int worker_fd = -1;
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
         OPT__VERBOSE(&libreport_g_verbose),
         OPT_INTEGER('u', NULL, &client_uid, _("Use NUM as client uid")),
         OPT_BOOL(   's', NULL, NULL       , _("Log to syslog")),
         OPT_BOOL(   'p', NULL, NULL       , _("Add program names to log")),
+        OPT_INTEGER('w', NULL, &worker_fd , _("Serve clients passed by abrtd over control socket FD")),
         OPT_END()
     };
     unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
@@ -1117,21 +2321,9 @@ int main(int argc, char **argv)
     memset(&sa, 0, sizeof(sa));
     sa.sa_handler = dummy_handler; /* pity, SIG_DFL won't do */
     sigaction(SIGALRM, &sa, NULL);
-    /* Part 2 - set the timeout per se */
-    alarm(TIMEOUT);
-
-    /* Get uid of the connected client */
-    struct ucred cr;
-    socklen_t crlen = sizeof(cr);
-    if (0 != getsockopt(STDIN_FILENO, SOL_SOCKET, SO_PEERCRED, &cr, &crlen))
-        perror_msg_and_die("getsockopt(SO_PEERCRED)");
-    if (crlen != sizeof(cr))
-        error_msg_and_die("%s: bad crlen %d", "getsockopt(SO_PEERCRED)", (int)crlen);
+    /* Part 2 - the timeout per se is set for every client in serve_client() */
 
-    if (client_uid == (uid_t)-1L)
-        client_uid = cr.uid;
-
-    client_pid = cr.pid;
+    const uid_t forced_uid = client_uid;
 
     pid_t pid = getpid();
     if (libreport_get_ns_ids(getpid(), &g_ns_ids) < 0)
@@ -1139,23 +2331,16 @@ int main(int argc, char **argv)
 
     abrt_load_abrt_conf();
 
-    struct response rsp = { 0 };
-    int r = perform_http_xact(&rsp);
-    if (r == 0)
-        r = 200;
+    /* Do not leave a partially received problem directory behind */
+    atexit(delete_incomplete_problem_dir);
 
-    if (rsp.code == 0)
-        rsp.code = r;
+    int r;
+    if (opts & OPT_w)
+        r = run_worker(worker_fd, forced_uid);
+    else
+        r = serve_client(forced_uid);
 
     abrt_free_abrt_conf_data();
 
-    printf("HTTP/1.1 %u \r\n\r\n", rsp.code);
-    if (rsp.message != NULL)
-    {
-        printf("%s", rsp.message);
-        fflush(stdout);
-        free(rsp.message);
-    }
-
     return (r >= 400); /* Error if 400+ */
 }
@@ -0,0 +1,203 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "abrt-size-index.h"
+#include "libabrt.h"
+
+struct abrt_size_index_entry
+{
+    double size;
+    time_t mtime;
+    bool is_dir;
+};
+
+struct abrt_size_index
+{
+    char *dump_location;
+    /* name -> struct abrt_size_index_entry */
+    GHashTable *entries;
+    double total;
+    time_t built;
+};
+
+/* Returns false if the entry does not exist */
+static bool
+load_entry(const struct abrt_size_index *index, const char *name, struct abrt_size_index_entry *entry)
+{
+    g_autofree char *path = g_build_filename(index->dump_location, name, NULL);
+
+    struct stat statbuf;
+    if (lstat(path, &statbuf) != 0)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't stat '%s'", path);
+        return false;
+    }
+
+    entry->mtime = statbuf.st_mtime;
+    entry->is_dir = S_ISDIR(statbuf.st_mode);
+    if (entry->is_dir)
+        entry->size = libreport_get_dirsize(path);
+    else if (S_ISREG(statbuf.st_mode))
+        entry->size = statbuf.st_size;
+    else
+        entry->size = 0;
+
+    return true;
+}
+
+struct abrt_size_index *
+abrt_size_index_new(const char *dump_location)
+{
+    struct abrt_size_index *index = g_new0(struct abrt_size_index, 1);
+    index->dump_location = g_strdup(dump_location);
+    index->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    abrt_size_index_rebuild(index);
+
+    return index;
+}
+
+void
+abrt_size_index_free(struct abrt_size_index *index)
+{
+    if (index == NULL)
+        return;
+
+    g_hash_table_destroy(index->entries);
+    g_free(index->dump_location);
+    g_free(index);
+}
+
+void
+abrt_size_index_rebuild(struct abrt_size_index *index)
+{
+    log_notice("Building size index of '%s'", index->dump_location);
+
+    g_hash_table_remove_all(index->entries);
+    index->total = 0;
+    index->built = time(NULL);
+
+    DIR *dp = opendir(index->dump_location);
+    if (dp == NULL)
+    {
+        perror_msg("Can't open directory '%s'", index->dump_location);
+        return;
+    }
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (libreport_dot_or_dotdot(dent->d_name))
+            continue;
+
+        abrt_size_index_update(index, dent->d_name);
+    }
+    closedir(dp);
+
+    log_info("Size of '%s' is %.0f bytes in %u entries",
+            index->dump_location, index->total, g_hash_table_size(index->entries));
+}
+
+void
+abrt_size_index_rebuild_if_older(struct abrt_size_index *index, time_t max_age)
+{
+    const time_t now = time(NULL);
+    /* Rebuild also if the clock went backwards */
+    if (now < index->built || now - index->built > max_age)
+        abrt_size_index_rebuild(index);
+}
+
+void
+abrt_size_index_update(struct abrt_size_index *index, const char *name)
+{
+    /* Hidden entries like the duplicate index must never be trimmed */
+    if (name[0] == '.')
+        return;
+
+    struct abrt_size_index_entry loaded;
+    if (!load_entry(index, name, &loaded))
+    {
+        abrt_size_index_remove(index, name);
+        return;
+    }
+
+    struct abrt_size_index_entry *entry = g_hash_table_lookup(index->entries, name);
+    if (entry == NULL)
+    {
+        entry = g_new(struct abrt_size_index_entry, 1);
+        g_hash_table_insert(index->entries, g_strdup(name), entry);
+    }
+    else
+        index->total -= entry->size;
+
+    *entry = loaded;
+    index->total += entry->size;
+}
+
+void
+abrt_size_index_remove(struct abrt_size_index *index, const char *name)
+{
+    struct abrt_size_index_entry *entry = g_hash_table_lookup(index->entries, name);
+    if (entry == NULL)
+        return;
+
+    index->total -= entry->size;
+    g_hash_table_remove(index->entries, name);
+}
+
+double
+abrt_size_index_total(const struct abrt_size_index *index)
+{
+    return index->total;
+}
+
+char *
+abrt_size_index_find_worst(const struct abrt_size_index *index, const char *excluded, const char *excluded2)
+{
+    const time_t cur_time = time(NULL);
+    const char *worst = NULL;
+    double max_weight = 0;
+
+    GHashTableIter iter;
+    gpointer name;
+    gpointer value;
+    g_hash_table_iter_init(&iter, index->entries);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+    {
+        const struct abrt_size_index_entry *entry = value;
+        if (!entry->is_dir
+         || (excluded != NULL && strcmp(excluded, name) == 0)
+         || (excluded2 != NULL && strcmp(excluded2, name) == 0))
+            continue;
+
+        /* Calculate "weighted" size and age w = sz_kbytes * age_mins */
+        double weight = entry->size / 1024;
+        const long age = (cur_time - entry->mtime) / 60;
+        if (age > 0)
+            weight *= age;
+
+        if (weight > max_weight)
+        {
+            max_weight = weight;
+            worst = name;
+        }
+    }
+
+    return g_strdup(worst);
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef _ABRT_SIZE_INDEX_H_
+#define _ABRT_SIZE_INDEX_H_
+
+#include <time.h>
+
+/* In-memory index of sizes of entries in the dump location.
+ *
+ * The index is built by a single scan of the dump location and then kept up
+ * to date by the callers, so the total size and the directory to be deleted
+ * can be determined without traversing the dump location again.
+ */
+struct abrt_size_index;
+
+struct abrt_size_index *
+abrt_size_index_new(const char *dump_location);
+
+void
+abrt_size_index_free(struct abrt_size_index *index);
+
+/* Drops all entries and scans the dump location again */
+void
+abrt_size_index_rebuild(struct abrt_size_index *index);
+
+/* Rebuilds the index if it was built more than max_age seconds ago */
+void
+abrt_size_index_rebuild_if_older(struct abrt_size_index *index, time_t max_age);
+
+/* Re-computes size of the entry name, removes it if it does not exist */
+void
+abrt_size_index_update(struct abrt_size_index *index, const char *name);
+
+void
+abrt_size_index_remove(struct abrt_size_index *index, const char *name);
+
+/* Returns the total size of the dump location in bytes */
+double
+abrt_size_index_total(const struct abrt_size_index *index);
+
+/* Returns malloced name of the directory that should be deleted first or NULL
+ * if there is no such directory. The directories excluded and excluded2 are
+ * never returned.
+ *
+ * The same weight as in libreport_get_dirsize_find_largest_dir() is used:
+ * size in KiB multiplied by age in minutes.
+ */
+char *
+abrt_size_index_find_worst(const struct abrt_size_index *index, const char *excluded, const char *excluded2);
+
+#endif /*_ABRT_SIZE_INDEX_H_*/
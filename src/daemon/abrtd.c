@@ -25,6 +25,8 @@
 
 #include "abrt_glib.h"
 #include "abrt-inotify.h"
+#include "abrt-problem-catalog.h"
+#include "abrt-size-index.h"
 #include "libabrt.h"
 #include "problem_api.h"
 
@@ -43,7 +45,17 @@
 /* Maximum number of simultaneously opened client connections. */
 #define MAX_CLIENT_COUNT  10
 
-#define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF)
+#define IN_CONF_DIR_FLAGS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+
+#define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF \
+                              | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+
+/* Problem directories are modified by post-create and reporting events after
+ * they appear in the dump location and inotify does not see changes in
+ * subdirectories. Re-scan the dump location from time to time to fix the
+ * accumulated error of the size index.
+ */
+#define SIZE_INDEX_MAX_AGE (60 * 60)
 
 #define ABRTD_DBUS_NAME ABRT_DBUS_NAME".daemon"
 
@@ -60,8 +72,24 @@ static unsigned s_timeout;
 static int s_timeout_src;
 static GMainLoop *s_main_loop;
 
-GList *s_processes;
-GList *s_dir_queue;
+/* pid -> struct abrt_server_proc */
+static GHashTable *s_processes;
+/* fd of abrt-server's stderr -> struct abrt_server_proc */
+static GHashTable *s_processes_by_fdout;
+/* Processes waiting for or running post-create in order of arrival */
+static GQueue s_dir_queue = G_QUEUE_INIT;
+/* dirname -> struct abrt_server_proc in s_dir_queue */
+static GHashTable *s_dir_queue_by_dirname;
+/* abrt-server workers waiting for a client (see ServerWorkers in abrt.conf) */
+static GQueue s_idle_workers = G_QUEUE_INIT;
+/* Number of clients being served by abrt-server processes */
+static unsigned s_client_count;
+/* Sizes of entries in the dump location (see queue_post_create_process) */
+static struct abrt_size_index *s_size_index;
+/* Catalog of the dump location for the listing of problems */
+static struct abrt_problem_catalog *s_catalog;
+/* Generation of abrt.conf exported to child processes */
+static unsigned s_conf_generation;
 
 static GIOChannel *channel_socket = NULL;
 static guint channel_id_socket = 0;
@@ -70,7 +98,18 @@ struct abrt_server_proc
 {
     pid_t pid;
     int fdout;
+    /* Control socket of a long-lived worker, -1 for single-client abrt-server */
+    int fdctl;
+    /* Number of clients passed to the worker */
+    unsigned served;
+    bool idle;
     char *dirname;
+    /* See load_post_create_key() */
+    char *post_create_key;
+    /* When the process was added to the post-create queue */
+    gint64 queued_time;
+    /* Link in s_dir_queue, NULL if the process is not queued */
+    GList *queue_link;
     GIOChannel *channel;
     guint watch_id;
     enum {
@@ -79,25 +118,41 @@ struct abrt_server_proc
     } type;
 };
 
-/* Returns 0 if proc's pid equals the the given pid */
-static gint abrt_server_compare_pid(struct abrt_server_proc *proc, pid_t *pid)
-{
-    return proc->pid != *pid;
-}
+/* Keys of problems being processed by post-create, see load_post_create_key() */
+static GHashTable *s_post_create_running_keys;
 
-/* Returns 0 if proc's fdout equals the the given fdout */
-static gint abrt_server_compare_fdout(struct abrt_server_proc *proc, int *fdout)
+/* Printed upon SIGUSR1 */
+static struct post_create_stats
 {
-    return proc->fdout != *fdout;
-}
+    unsigned running;
+    unsigned waiting;
+    unsigned max_waiting;
+    unsigned long started;
+    gint64 total_wait_time;
+    gint64 max_wait_time;
+} s_post_create_stats;
+
+/* Helpers */
 
-/* Returns 0 if proc's dirname equals the the given dirname */
-static gint abrt_server_compare_dirname(struct abrt_server_proc *proc, const char *dirname)
+/* abrt.conf is read only if it has changed since the last call (see
+ * handle_conf_dir_inotify_cb). The processes started by abrtd inherit the
+ * loaded configuration through the environment.
+ */
+static int load_abrt_conf(void)
 {
-    return g_strcmp0(proc->dirname, dirname);
+    /* The environment holds the snapshot exported below */
+    const int r = abrt_load_abrt_conf_file_cached();
+
+    if (s_conf_generation != abrt_g_settings_generation)
+    {
+        log_debug("Exporting configuration generation %u", abrt_g_settings_generation);
+        s_conf_generation = abrt_g_settings_generation;
+        setenv(ABRT_CONF_SNAPSHOT_ENV, abrt_get_abrt_conf_snapshot(), 1);
+    }
+
+    return r;
 }
 
-/* Helpers */
 static guint add_watch_or_die(GIOChannel *channel, unsigned condition, GIOFunc func)
 {
     errno = 0;
@@ -115,6 +170,10 @@ static void stop_abrt_server(struct abrt_server_proc *proc)
 static void dispose_abrt_server(struct abrt_server_proc *proc)
 {
     free(proc->dirname);
+    g_free(proc->post_create_key);
+
+    if (proc->fdctl >= 0)
+        close(proc->fdctl);
 
     if (proc->watch_id > 0)
         g_source_remove(proc->watch_id);
@@ -123,45 +182,171 @@ static void dispose_abrt_server(struct abrt_server_proc *proc)
         g_io_channel_unref(proc->channel);
 }
 
+/* Problems that might be duplicates of each other must not be processed
+ * concurrently, otherwise both would be marked as duplicates of each other and
+ * deleted. The key consists of the items is_crash_a_dup() in
+ * abrt-handle-event requires to be equal. A collision of keys of different
+ * problems leads only to their serialization.
+ */
+static char *load_post_create_key(const char *dirname)
+{
+    g_autofree char *path = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", dirname, NULL);
+    struct dump_dir *dd = dd_opendir(path, DD_OPEN_READONLY | DD_FAIL_QUIETLY_ENOENT);
+    if (dd == NULL)
+        /* post-create will fail on such directory, do not care about dups */
+        return g_strdup("");
+
+    g_autofree char *uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    g_autofree char *type = dd_load_text_ext(dd, FILENAME_TYPE, DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    g_autofree char *executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    dd_close(dd);
+
+    return g_strdup_printf("%s\n%s\n%s", uid ? uid : "", type ? type : "", executable ? executable : "");
+}
+
+static void post_create_enqueue(struct abrt_server_proc *proc)
+{
+    proc->queued_time = g_get_monotonic_time();
+    g_queue_push_tail(&s_dir_queue, proc);
+    proc->queue_link = g_queue_peek_tail_link(&s_dir_queue);
+    g_hash_table_insert(s_dir_queue_by_dirname, proc->dirname, proc);
+
+    if (++s_post_create_stats.waiting > s_post_create_stats.max_waiting)
+        s_post_create_stats.max_waiting = s_post_create_stats.waiting;
+}
+
+/* Removes the process from the post-create queue and releases its key */
+static void post_create_dequeue(struct abrt_server_proc *proc)
+{
+    if (proc->queue_link == NULL)
+        return;
+
+    g_queue_delete_link(&s_dir_queue, proc->queue_link);
+    proc->queue_link = NULL;
+
+    if (g_hash_table_lookup(s_dir_queue_by_dirname, proc->dirname) == proc)
+        g_hash_table_remove(s_dir_queue_by_dirname, proc->dirname);
+
+    if (proc->type == AS_POST_CREATE)
+    {
+        g_hash_table_remove(s_post_create_running_keys, proc->post_create_key);
+        --s_post_create_stats.running;
+    }
+    else
+        --s_post_create_stats.waiting;
+
+    proc->type = AS_UKNOWN;
+}
+
+static void post_create_started(struct abrt_server_proc *proc)
+{
+    proc->type = AS_POST_CREATE;
+    g_hash_table_insert(s_post_create_running_keys, proc->post_create_key, proc);
+    --s_post_create_stats.waiting;
+    ++s_post_create_stats.running;
+
+    const gint64 wait_time = g_get_monotonic_time() - proc->queued_time;
+    ++s_post_create_stats.started;
+    s_post_create_stats.total_wait_time += wait_time;
+    if (wait_time > s_post_create_stats.max_wait_time)
+        s_post_create_stats.max_wait_time = wait_time;
+
+    log_info("abrt-server(%d): processing '%s' after %.3f s in queue (%u running, %u waiting)",
+            proc->pid, proc->dirname, (double)wait_time / G_USEC_PER_SEC,
+            s_post_create_stats.running, s_post_create_stats.waiting);
+}
+
+static void print_post_create_stats(void)
+{
+    const struct post_create_stats *st = &s_post_create_stats;
+    log_warning("Post-create queue: %u running, %u waiting (max %u), %lu processed, average wait %.3f s, max wait %.3f s",
+            st->running, st->waiting, st->max_waiting, st->started,
+            st->started ? (double)st->total_wait_time / st->started / G_USEC_PER_SEC : 0.0,
+            (double)st->max_wait_time / G_USEC_PER_SEC);
+}
+
 static void notify_next_post_create_process(struct abrt_server_proc *finished)
 {
     if (finished != NULL)
-        s_dir_queue = g_list_remove(s_dir_queue, finished);
+    {
+        /* post-create usually adds a lot of data to the directory or
+         * deletes it (duplicates) */
+        if (finished->type == AS_POST_CREATE && finished->dirname != NULL)
+        {
+            abrt_size_index_update(s_size_index, finished->dirname);
+            abrt_problem_catalog_update(s_catalog, finished->dirname);
+        }
 
-    while (s_dir_queue != NULL)
+        post_create_dequeue(finished);
+    }
+
+    GList *item = g_queue_peek_head_link(&s_dir_queue);
+    while (item != NULL && s_post_create_stats.running < abrt_g_settings_max_parallel_post_create)
     {
-        struct abrt_server_proc *n = (struct abrt_server_proc *)s_dir_queue->data;
-        if (n->type == AS_POST_CREATE)
-            break;
+        GList *next = item->next;
+        struct abrt_server_proc *n = (struct abrt_server_proc *)item->data;
 
-        if (kill(n->pid, SIGUSR1) >= 0)
+        /* Already running or waiting for a possible duplicate */
+        if (n->type == AS_POST_CREATE
+         || g_hash_table_contains(s_post_create_running_keys, n->post_create_key))
         {
-            n->type = AS_POST_CREATE;
-            break;
+            item = next;
+            continue;
         }
 
-        /* This could happen only if the notified process disappeared - crashed?
-         */
-        perror_msg("Failed to send SIGUSR1 to %d", n->pid);
-        log_warning("Directory '%s' will not be processed", n->dirname);
+        if (kill(n->pid, SIGUSR1) >= 0)
+            post_create_started(n);
+        else
+        {
+            /* This could happen only if the notified process disappeared - crashed?
+             */
+            perror_msg("Failed to send SIGUSR1 to %d", n->pid);
+            log_warning("Directory '%s' will not be processed", n->dirname);
+
+            /* Remove the problematic process from the post-crate directory queue
+             * and go to try to notify another process.
+             */
+            post_create_dequeue(n);
+        }
 
-        /* Remove the problematic process from the post-crate directory queue
-         * and go to try to notify another process.
-         */
-        s_dir_queue = g_list_delete_link(s_dir_queue, s_dir_queue);
+        item = next;
     }
 }
 
+/* Removes the deleted problem directory from the duplicate index used by
+ * post-create (see abrt-handle-event).
+ */
+static void forget_dup_candidate(const char *name)
+{
+    if (name[0] == '.')
+        return;
+
+    g_autofree char *index_dir = g_build_filename(abrt_g_settings_dump_location, ABRT_DUP_INDEX_DIR_NAME, NULL);
+    abrt_dup_index_forget_candidate(index_dir, name);
+}
+
 /* Queueing the process will also lead to cleaning up the dump location.
  */
 static void queue_post_create_process(struct abrt_server_proc *proc)
 {
-    abrt_load_abrt_conf();
-    struct abrt_server_proc *running = s_dir_queue == NULL ? NULL
-                                                           : (struct abrt_server_proc *)s_dir_queue->data;
+    load_abrt_conf();
+
+    g_free(proc->post_create_key);
+    proc->post_create_key = load_post_create_key(proc->dirname);
+
+    /* List the problem before post-create finishes, the same way as the
+     * problem directory could be found before */
+    abrt_problem_catalog_update(s_catalog, proc->dirname);
+
     if (abrt_g_settings_nMaxCrashReportsSize == 0)
         goto consider_processing;
 
+    /* Never delete the oldest running directory */
+    struct abrt_server_proc *running = NULL;
+    for (GList *item = g_queue_peek_head_link(&s_dir_queue); item != NULL && running == NULL; item = item->next)
+        if (((struct abrt_server_proc *)item->data)->type == AS_POST_CREATE)
+            running = (struct abrt_server_proc *)item->data;
+
     const char *full_path_ignored = running != NULL ? running->dirname
                                                     : proc->dirname;
     const char *ignored = strrchr(full_path_ignored, '/');
@@ -172,19 +357,34 @@ static void queue_post_create_process(struct abrt_server_proc *proc)
         /* Move behind '/' */
         ++ignored;
 
+    /* The new directory is complete now, account its real size. Other
+     * changes in the dump location are tracked by the inotify watch.
+     */
+    abrt_size_index_rebuild_if_older(s_size_index, SIZE_INDEX_MAX_AGE);
+    abrt_size_index_update(s_size_index, proc->dirname);
+
     char *worst_dir = NULL;
     const double max_size = (double) abrt_g_settings_nMaxCrashReportsSize * (1024 * 1024);
-    while (libreport_get_dirsize_find_largest_dir(abrt_g_settings_dump_location, &worst_dir, ignored, proc->dirname) >= max_size
-           && worst_dir)
+    while (abrt_size_index_total(s_size_index) >= max_size
+           && (worst_dir = abrt_size_index_find_worst(s_size_index, ignored, proc->dirname)) != NULL)
     {
         const char *kind = "old";
 
-        GList *proc_of_deleted_item = NULL;
-        if ((proc_of_deleted_item = g_list_find_custom(s_dir_queue, worst_dir, (GCompareFunc)abrt_server_compare_dirname)))
+        struct abrt_server_proc *removed_proc = g_hash_table_lookup(s_dir_queue_by_dirname, worst_dir);
+        if (removed_proc != NULL)
         {
+            if (removed_proc->type == AS_POST_CREATE)
+            {
+                /* Other post-create processes may be running in parallel,
+                 * their directories must stay. Try again next time. */
+                log_warning("Size of '%s' >= %u MB (MaxCrashReportsSize), but the largest directory '%s' is being processed",
+                        abrt_g_settings_dump_location, abrt_g_settings_nMaxCrashReportsSize, worst_dir);
+                g_clear_pointer(&worst_dir, free);
+                break;
+            }
+
             kind = "unprocessed";
-            struct abrt_server_proc *removed_proc = (struct abrt_server_proc *)proc_of_deleted_item->data;
-            s_dir_queue = g_list_delete_link(s_dir_queue, proc_of_deleted_item);
+            post_create_dequeue(removed_proc);
             stop_abrt_server(removed_proc);
         }
 
@@ -193,11 +393,19 @@ static void queue_post_create_process(struct abrt_server_proc *proc)
                 kind, worst_dir);
 
         g_autofree char *deleted = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", worst_dir, NULL);
-        g_clear_pointer(&worst_dir, free);
 
         struct dump_dir *dd = dd_opendir(deleted, DD_FAIL_QUIETLY_ENOENT);
         if (dd != NULL)
             dd_delete(dd);
+
+        /* Do not wait for the inotify event, the directory would be found
+         * again in the next iteration. If the deletion failed, the
+         * directory will be accounted again when the index is rebuilt.
+         */
+        abrt_size_index_remove(s_size_index, worst_dir);
+        abrt_problem_catalog_remove(s_catalog, worst_dir);
+        forget_dup_candidate(worst_dir);
+        g_clear_pointer(&worst_dir, free);
     }
 
 consider_processing:
@@ -205,28 +413,72 @@ consider_processing:
      * post-create queue.
      */
     if (proc != NULL)
-        s_dir_queue = g_list_append(s_dir_queue, proc);
+        post_create_enqueue(proc);
 
-    /* If there were no running post-crate process before we added the
-     * currently handled process to the post-create queue, start processing of
-     * the currently handled process.
+    /* Start processing of the currently handled process if it is not a
+     * possible duplicate of a running one and the limit of parallel
+     * post-create processes has not been reached.
      */
-    if (running == NULL)
-        notify_next_post_create_process(NULL/*finished*/);
+    notify_next_post_create_process(NULL/*finished*/);
+}
+
+static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused);
+
+static void client_accepted(void)
+{
+    if (++s_client_count >= MAX_CLIENT_COUNT)
+    {
+        error_msg("Too many clients, refusing connections to '%s'", SOCKET_FILE);
+        /* To avoid infinite loop caused by the descriptor in "ready" state,
+         * the callback must be disabled.
+         */
+        g_source_remove(channel_id_socket);
+        channel_id_socket = 0;
+    }
+}
+
+static void client_finished(void)
+{
+    --s_client_count;
+
+    if (s_client_count < MAX_CLIENT_COUNT && !channel_id_socket)
+    {
+        log_info("Accepting connections on '%s'", SOCKET_FILE);
+        channel_id_socket = add_watch_or_die(channel_socket, G_IO_IN | G_IO_PRI | G_IO_HUP, server_socket_cb);
+    }
+}
+
+/* The worker finished serving its client including post-create processing */
+static void abrt_server_worker_idle(struct abrt_server_proc *proc)
+{
+    if (proc->idle)
+    {
+        log_warning("abrt-server(%d): is already idle", proc->pid);
+        return;
+    }
+
+    if (proc->type == AS_POST_CREATE)
+        notify_next_post_create_process(proc);
+    else
+        post_create_dequeue(proc);
+
+    g_clear_pointer(&proc->dirname, free);
+    proc->idle = true;
+    g_queue_push_tail(&s_idle_workers, proc);
+
+    client_finished();
 }
 
 static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition condition, gpointer user_data)
 {
     int fdout = g_io_channel_unix_get_fd(channel);
-    GList *item = g_list_find_custom(s_processes, &fdout, (GCompareFunc)abrt_server_compare_fdout);
-    if (item == NULL)
+    struct abrt_server_proc *proc = g_hash_table_lookup(s_processes_by_fdout, GINT_TO_POINTER(fdout));
+    if (proc == NULL)
     {
         log_warning("Removing an input channel fd (%d) without a process assigned", fdout);
         return FALSE;
     }
 
-    struct abrt_server_proc *proc = (struct abrt_server_proc *)item->data;
-
     if (condition & G_IO_HUP)
     {
         log_debug("abrt-server(%d) closed its pipe", proc->pid);
@@ -262,15 +514,30 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
             if (proc->dirname != NULL)
             {
                 log_warning("abrt-server(%d): already handling: %s", proc->pid, proc->dirname);
-                free(proc->dirname);
                 /* Because process can be only once in the dir queue */
-                s_dir_queue = g_list_remove(s_dir_queue, proc);
+                if (proc->type == AS_POST_CREATE)
+                    notify_next_post_create_process(proc);
+                else
+                    post_create_dequeue(proc);
+                free(proc->dirname);
             }
 
             proc->dirname = g_strdup(line + strlen("NEW_PROBLEM_DETECTED: "));
             log_notice("abrt-server(%d): handling new problem: %s", proc->pid, proc->dirname);
             queue_post_create_process(proc);
         }
+        else if (g_str_has_prefix(line, "PROBLEM_UPDATED: "))
+        {
+            /* A duplicate was counted in a known problem */
+            const char *name = line + strlen("PROBLEM_UPDATED: ");
+            log_debug("abrt-server(%d): problem updated: %s", proc->pid, name);
+            abrt_problem_catalog_update(s_catalog, name);
+        }
+        else if (proc->fdctl >= 0 && strcmp(line, "WORKER_IDLE") == 0)
+        {
+            log_debug("abrt-server(%d): waiting for next client", proc->pid);
+            abrt_server_worker_idle(proc);
+        }
         else
             log_warning("abrt-server(%d): not recognized message: '%s'", proc->pid, line);
     }
@@ -278,12 +545,18 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
     return TRUE; /* Keep this event */
 }
 
-static void add_abrt_server_proc(const pid_t pid, int fdout)
+static struct abrt_server_proc *add_abrt_server_proc(const pid_t pid, int fdout)
 {
     struct abrt_server_proc *proc = g_new(struct abrt_server_proc, 1);
     proc->pid = pid;
     proc->fdout = fdout;
+    proc->fdctl = -1;
+    proc->served = 0;
+    proc->idle = false;
     proc->dirname = NULL;
+    proc->post_create_key = NULL;
+    proc->queued_time = 0;
+    proc->queue_link = NULL;
     proc->type = AS_UKNOWN;
     proc->channel = abrt_gio_channel_unix_new(proc->fdout);
     proc->watch_id = g_io_add_watch(proc->channel,
@@ -298,16 +571,9 @@ static void add_abrt_server_proc(const pid_t pid, int fdout)
 
     g_io_channel_set_buffered(proc->channel, TRUE);
 
-    s_processes = g_list_append(s_processes, proc);
-    if (g_list_length(s_processes) >= MAX_CLIENT_COUNT)
-    {
-        error_msg("Too many clients, refusing connections to '%s'", SOCKET_FILE);
-        /* To avoid infinite loop caused by the descriptor in "ready" state,
-         * the callback must be disabled.
-         */
-        g_source_remove(channel_id_socket);
-        channel_id_socket = 0;
-    }
+    g_hash_table_insert(s_processes, GINT_TO_POINTER(pid), proc);
+    g_hash_table_insert(s_processes_by_fdout, GINT_TO_POINTER(fdout), proc);
+    return proc;
 }
 
 static void start_idle_timeout(void)
@@ -330,17 +596,16 @@ static void kill_idle_timeout(void)
 }
 
 
-static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused);
+static void start_abrt_server_worker(void);
 
 static void remove_abrt_server_proc(pid_t pid, int status)
 {
-    GList *item = g_list_find_custom(s_processes, &pid, (GCompareFunc)abrt_server_compare_pid);
-    if (item == NULL)
+    struct abrt_server_proc *proc = g_hash_table_lookup(s_processes, GINT_TO_POINTER(pid));
+    if (proc == NULL)
         return;
 
-    struct abrt_server_proc *proc = (struct abrt_server_proc *)item->data;
-    item->data = NULL;
-    s_processes = g_list_delete_link(s_processes, item);
+    g_hash_table_remove(s_processes, GINT_TO_POINTER(pid));
+    g_hash_table_remove(s_processes_by_fdout, GINT_TO_POINTER(proc->fdout));
 
     if (proc->type == AS_POST_CREATE)
         notify_next_post_create_process(proc);
@@ -348,61 +613,75 @@ static void remove_abrt_server_proc(pid_t pid, int status)
     {   /* Make sure out-of-order exited abrt-server post-create processes do
          * not stay in the post-create queue.
          */
-        s_dir_queue = g_list_remove(s_dir_queue, proc);
+        post_create_dequeue(proc);
     }
 
+    const bool worker = proc->fdctl >= 0;
+    const bool respawn = worker && proc->served > 0;
+    if (proc->idle)
+        g_queue_remove(&s_idle_workers, proc);
+    else
+        client_finished();
+
     dispose_abrt_server(proc);
     free(proc);
 
-    if (g_list_length(s_processes) < MAX_CLIENT_COUNT && !channel_id_socket)
-    {
-        log_info("Accepting connections on '%s'", SOCKET_FILE);
-        channel_id_socket = add_watch_or_die(channel_socket, G_IO_IN | G_IO_PRI | G_IO_HUP, server_socket_cb);
-    }
+    if (respawn)
+        start_abrt_server_worker();
+    else if (worker)
+        /* Do not loop in restarting a worker which cannot even start */
+        log_warning("abrt-server worker(%d) exited before serving any client, not restarting it", pid);
 }
 
-/* Callback called by glib main loop when a client connects to ABRT's socket. */
-static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused)
+/* Starts abrt-server whose stderr is connected to a pipe returned in fdout.
+ *
+ * If fdctl is negative, the new process serves the client connected to
+ * socket and exits. Otherwise, it is a long-lived worker receiving client
+ * sockets from fdctl.
+ */
+static pid_t spawn_abrt_server(int socket, int fdctl, int *fdout)
 {
-    kill_idle_timeout();
-    abrt_load_abrt_conf();
-
-    int socket = accept(g_io_channel_unix_get_fd(source), NULL, NULL);
-    if (socket == -1)
-    {
-        perror_msg("accept");
-        goto server_socket_finitio;
-    }
-
-    log_notice("New client connected");
-    fflush(NULL); /* paranoia */
-
     int pipefd[2];
     g_unix_open_pipe(pipefd, 0, NULL);
 
+    fflush(NULL); /* paranoia */
     pid_t pid = fork();
     if (pid < 0)
     {
         perror_msg("fork");
-        close(socket);
         close(pipefd[0]);
         close(pipefd[1]);
-        goto server_socket_finitio;
+        return pid;
     }
     if (pid == 0) /* child */
     {
-        libreport_xdup2(socket, STDIN_FILENO);
-        libreport_xdup2(socket, STDOUT_FILENO);
-        close(socket);
+        if (socket >= 0)
+        {
+            libreport_xdup2(socket, STDIN_FILENO);
+            libreport_xdup2(socket, STDOUT_FILENO);
+            close(socket);
+        }
+        else
+        {
+            libreport_xmove_fd(g_open("/dev/null", O_RDWR), STDIN_FILENO);
+            libreport_xdup2(STDIN_FILENO, STDOUT_FILENO);
+        }
 
         close(pipefd[0]);
         libreport_xmove_fd(pipefd[1], STDERR_FILENO);
 
-        char *argv[3];  /* abrt-server [-s] NULL */
+        char fdctl_str[sizeof(int)*3 + 2];
+        char *argv[5];  /* abrt-server [-s] [-w FD] NULL */
         char **pp = argv;
         *pp++ = (char*)"abrt-server";
         if (libreport_logmode & LOGMODE_JOURNAL)
             *pp++ = (char*)"-s";
+        if (fdctl >= 0)
+        {
+            sprintf(fdctl_str, "%d", fdctl);
+            *pp++ = (char*)"-w";
+            *pp++ = fdctl_str;
+        }
         *pp = NULL;
 
         execvp(argv[0], argv);
@@ -410,15 +689,262 @@ static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpo
     }
 
     /* parent */
-    close(socket);
     close(pipefd[1]);
-    add_abrt_server_proc(pid, pipefd[0]);
+    *fdout = pipefd[0];
+    return pid;
+}
+
+static void start_abrt_server_worker(void)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0)
+    {
+        perror_msg("socketpair");
+        return;
+    }
+    /* Other abrt-server processes must not hold our end */
+    libreport_close_on_exec_on(sv[0]);
+
+    int fdout;
+    const pid_t pid = spawn_abrt_server(/*socket*/-1, sv[1], &fdout);
+    close(sv[1]);
+    if (pid < 0)
+    {
+        close(sv[0]);
+        return;
+    }
+
+    log_info("Started abrt-server worker(%d)", pid);
+    struct abrt_server_proc *proc = add_abrt_server_proc(pid, fdout);
+    proc->fdctl = sv[0];
+    proc->idle = true;
+    g_queue_push_tail(&s_idle_workers, proc);
+}
+
+/* Passes the accepted client socket to an idle worker via SCM_RIGHTS. The
+ * message carries the current configuration snapshot, so the worker does not
+ * need to read abrt.conf.
+ */
+static int pass_client_to_worker(struct abrt_server_proc *proc, int socket)
+{
+    const char *snapshot = abrt_get_abrt_conf_snapshot();
+    if (snapshot == NULL)
+        snapshot = "";
+    struct iovec iov = { .iov_base = (char *)snapshot, .iov_len = strlen(snapshot) + 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &socket, sizeof(int));
+
+    /* MSG_NOSIGNAL: the worker might have died, do not die with it on SIGPIPE */
+    if (sendmsg(proc->fdctl, &msg, MSG_NOSIGNAL) < 0)
+    {
+        perror_msg("Can't pass client to abrt-server(%d)", proc->pid);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Callback called by glib main loop when a client connects to ABRT's socket. */
+static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused)
+{
+    kill_idle_timeout();
+    load_abrt_conf();
+
+    int socket = accept(g_io_channel_unix_get_fd(source), NULL, NULL);
+    if (socket == -1)
+    {
+        perror_msg("accept");
+        goto server_socket_finitio;
+    }
+
+    log_notice("New client connected");
+
+    struct abrt_server_proc *worker = g_queue_pop_head(&s_idle_workers);
+    if (worker != NULL)
+    {
+        worker->idle = false;
+        if (pass_client_to_worker(worker, socket) == 0)
+        {
+            log_debug("Client passed to abrt-server worker(%d)", worker->pid);
+            ++worker->served;
+            close(socket);
+            client_accepted();
+            goto server_socket_finitio;
+        }
+        /* The worker is probably dead; SIGCHLD handler removes it. It is
+         * not serving any client, so mark it idle but do not queue it. */
+        worker->idle = true;
+    }
+
+    /* All workers are busy or there are no workers at all */
+    int fdout;
+    pid_t pid = spawn_abrt_server(socket, /*fdctl*/-1, &fdout);
+    close(socket);
+    if (pid < 0)
+        goto server_socket_finitio;
+
+    add_abrt_server_proc(pid, fdout);
+    client_accepted();
 
 server_socket_finitio:
     start_idle_timeout();
     return TRUE;
 }
 
+/* Self-benchmark (-B NUM)
+ *
+ * Simulates NUM concurrent abrt-server processes announcing new problems and
+ * measures how long the main loop is blocked by the bookkeeping of the
+ * processes and of the post-create queue.
+ */
+#define BENCH_PROBE_INTERVAL_MS 1
+/* Number of processes forked in one main loop iteration */
+#define BENCH_SPAWN_BATCH 32
+
+static struct bench
+{
+    unsigned count;
+    unsigned spawned;
+    gint64 start_time;
+    gint64 probe_due;
+    gint64 total_latency;
+    gint64 max_latency;
+    unsigned long probes;
+} s_bench;
+
+/* Forks a process which behaves like abrt-server creating a new problem: it
+ * announces the problem and waits until abrtd lets it process the problem.
+ */
+static pid_t spawn_simulated_abrt_server(unsigned num, int *fdout)
+{
+    int pipefd[2];
+    g_unix_open_pipe(pipefd, 0, NULL);
+
+    /* Block the signals before fork() to not miss them in the child */
+    sigset_t set, oldset;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigaddset(&set, SIGINT);
+    sigprocmask(SIG_BLOCK, &set, &oldset);
+
+    fflush(NULL); /* paranoia */
+    pid_t pid = fork();
+    if (pid == 0) /* child */
+    {
+        close(pipefd[0]);
+
+        char line[sizeof("NEW_PROBLEM_DETECTED: abrtd-benchmark-") + sizeof(num)*3 + 1];
+        sprintf(line, "NEW_PROBLEM_DETECTED: abrtd-benchmark-%u\n", num);
+        libreport_full_write_str(pipefd[1], line);
+
+        /* SIGUSR1 - continue, SIGINT - interrupted */
+        int sig;
+        sigwait(&set, &sig);
+        _exit(0);
+    }
+
+    sigprocmask(SIG_SETMASK, &oldset, NULL);
+    close(pipefd[1]);
+
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        close(pipefd[0]);
+        return pid;
+    }
+
+    *fdout = pipefd[0];
+    return pid;
+}
+
+static gboolean bench_probe_cb(gpointer user_data)
+{
+    const gint64 now = g_get_monotonic_time();
+    const gint64 latency = now > s_bench.probe_due ? now - s_bench.probe_due : 0;
+    s_bench.total_latency += latency;
+    if (latency > s_bench.max_latency)
+        s_bench.max_latency = latency;
+    ++s_bench.probes;
+
+    for (unsigned i = 0; i < BENCH_SPAWN_BATCH && s_bench.spawned < s_bench.count; ++i)
+    {
+        int fdout;
+        pid_t pid = spawn_simulated_abrt_server(s_bench.spawned, &fdout);
+        if (pid < 0)
+        {
+            log_warning("Simulating only %u abrt-server processes", s_bench.spawned);
+            s_bench.count = s_bench.spawned;
+            break;
+        }
+
+        add_abrt_server_proc(pid, fdout);
+        /* Not client_accepted(), simulated processes must not stop
+         * accepting of real clients. */
+        ++s_client_count;
+        ++s_bench.spawned;
+    }
+
+    if (s_bench.spawned == s_bench.count && g_hash_table_size(s_processes) == 0)
+    {
+        const double elapsed = (double)(now - s_bench.start_time) / G_USEC_PER_SEC;
+        printf("Simulated %u abrt-server processes in %.3f s (%.0f processes/s)\n",
+                s_bench.count, elapsed, elapsed > 0 ? s_bench.count / elapsed : 0.0);
+        printf("Main loop latency: average %.3f ms, max %.3f ms\n",
+                (double)s_bench.total_latency / s_bench.probes / 1000,
+                (double)s_bench.max_latency / 1000);
+        fflush(stdout);
+
+        g_main_loop_quit(s_main_loop);
+        return G_SOURCE_REMOVE;
+    }
+
+    s_bench.probe_due = g_get_monotonic_time() + BENCH_PROBE_INTERVAL_MS * 1000;
+    return G_SOURCE_CONTINUE;
+}
+
+/* The benchmark must not run against real problems: the simulated processes
+ * go through the post-create queue and the trimming of the dump location.
+ */
+static bool dump_location_is_empty(const char *path)
+{
+    DIR *dp = opendir(path);
+    if (dp == NULL)
+        return errno == ENOENT;
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dent->d_name[0] != '.')
+            break; /* "." and ".." and the hidden indexes do not count */
+    }
+    closedir(dp);
+
+    return dent == NULL;
+}
+
+static void start_benchmark(void)
+{
+    log_notice("Simulating %u abrt-server processes", s_bench.count);
+    s_bench.start_time = g_get_monotonic_time();
+    s_bench.probe_due = s_bench.start_time + BENCH_PROBE_INTERVAL_MS * 1000;
+    g_timeout_add(BENCH_PROBE_INTERVAL_MS, bench_probe_cb, NULL);
+}
+
 /* Signal pipe handler */
 static gboolean handle_signal_cb(GIOChannel *gio, GIOCondition condition, gpointer ptr_unused)
 {
@@ -446,7 +972,9 @@ static gboolean handle_signal_cb(GIOChannel *gio, GIOCondition condition, gpoint
     {
         /* we did receive a signal */
         log_debug("Got signal %d through signal pipe", signo);
-        if (signo != SIGCHLD)
+        if (signo == SIGUSR1)
+            print_post_create_stats();
+        else if (signo != SIGCHLD)
             g_main_loop_quit(s_main_loop);
         else
         {
@@ -483,7 +1011,23 @@ static void sanitize_dump_dir_rights(void)
     abrt_ensure_writable_dir(VAR_RUN"/abrt", 0755, "root");
 }
 
-/* Inotify handler */
+/* Inotify handlers */
+
+static const char *get_conf_dir(void)
+{
+    const char *const env_conf_dir = getenv("ABRT_CONF_DIR");
+    return env_conf_dir ? env_conf_dir : CONF_DIR;
+}
+
+static void handle_conf_dir_inotify_cb(struct abrt_inotify_watch *watch, struct inotify_event *event, gpointer ptr_unused)
+{
+    /* Editors usually save files under temporary names, hence any change
+     * in the configuration directory invalidates the loaded abrt.conf.
+     * The file is re-read when it is needed.
+     */
+    log_debug("Configuration directory changed: '%s'", event->len > 0 ? event->name : "");
+    abrt_invalidate_abrt_conf();
+}
 
 static void handle_inotify_cb(struct abrt_inotify_watch *watch, struct inotify_event *event, gpointer ptr_unused)
 {
@@ -493,10 +1037,36 @@ static void handle_inotify_cb(struct abrt_inotify_watch *watch, struct inotify_e
     {
         log_warning("Recreating deleted dump location '%s'", abrt_g_settings_dump_location);
 
-        abrt_load_abrt_conf();
+        load_abrt_conf();
 
         sanitize_dump_dir_rights();
         abrt_inotify_watch_reset(watch, abrt_g_settings_dump_location, IN_DUMP_LOCATION_FLAGS);
+
+        /* The dump location might have been changed in the configuration */
+        abrt_size_index_free(s_size_index);
+        s_size_index = abrt_size_index_new(abrt_g_settings_dump_location);
+        abrt_problem_catalog_free(s_catalog);
+        s_catalog = abrt_problem_catalog_new(abrt_g_settings_dump_location);
+    }
+    else if (event->mask & IN_Q_OVERFLOW)
+    {
+        log_notice("Inotify queue overflowed, rebuilding size index and catalog");
+        abrt_size_index_rebuild(s_size_index);
+        abrt_problem_catalog_rebuild(s_catalog);
+    }
+    else if (event->len > 0)
+    {
+        if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            abrt_size_index_remove(s_size_index, event->name);
+            abrt_problem_catalog_remove(s_catalog, event->name);
+            forget_dup_candidate(event->name);
+        }
+        else if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        {
+            abrt_size_index_update(s_size_index, event->name);
+            abrt_problem_catalog_update(s_catalog, event->name);
+        }
     }
 
     start_idle_timeout();
@@ -645,8 +1215,8 @@ static void mark_unprocessed_dump_dirs_not_reportable(const char *path)
     struct dirent *dent;
     while ((dent = readdir(dp)) != NULL)
     {
-        if (libreport_dot_or_dotdot(dent->d_name))
-            continue; /* skip "." and ".." */
+        if (dent->d_name[0] == '.')
+            continue; /* skip ".", ".." and hidden entries like the duplicate index */
 
         g_autofree char *full_name = g_build_filename(path, dent->d_name, NULL);
 
@@ -729,6 +1299,7 @@ int main(int argc, char** argv)
 // TODO: get rid of -t NUM, it is no longer useful since dbus is moved to a separate tool
         OPT_t = 1 << 3,
         OPT_p = 1 << 4,
+        OPT_B = 1 << 5,
     };
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
@@ -737,6 +1308,7 @@ int main(int argc, char** argv)
         OPT_BOOL(   's', NULL, NULL      , _("Log to syslog even with -d")),
         OPT_INTEGER('t', NULL, &s_timeout, _("Exit after NUM seconds of inactivity")),
         OPT_BOOL(   'p', NULL, NULL      , _("Add program names to log")),
+        OPT_INTEGER('B', NULL, &s_bench.count, _("Simulate NUM concurrent abrt-server processes, print main loop latency and exit")),
         OPT_END()
     };
     unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
@@ -744,6 +1316,8 @@ int main(int argc, char** argv)
     libreport_export_abrt_envvars(opts & OPT_p);
 
     unsetenv("ABRT_SYSLOG");
+    /* abrtd is the one who reads abrt.conf */
+    unsetenv(ABRT_CONF_SNAPSHOT_ENV);
     libreport_msg_prefix = libreport_g_progname; /* for log_warning(), error_msg() and such */
 
     if (getuid() != 0)
@@ -760,17 +1334,27 @@ int main(int argc, char** argv)
     signal(SIGTERM, handle_signal);
     signal(SIGINT,  handle_signal);
     signal(SIGCHLD, handle_signal);
+    signal(SIGUSR1, handle_signal);
 
     GIOChannel* channel_signal = NULL;
     guint channel_id_signal_event = 0;
     bool pidfile_created = false;
     struct abrt_inotify_watch *aiw = NULL;
+    struct abrt_inotify_watch *conf_aiw = NULL;
     int ret = 1;
 
     /* Initialization */
     log_notice("Loading settings");
-    if (abrt_load_abrt_conf() != 0)
+    if (load_abrt_conf() != 0)
+        goto init_error;
+
+    if ((opts & OPT_B) && !dump_location_is_empty(abrt_g_settings_dump_location))
+    {
+        error_msg("Dump location '%s' is not empty, run the benchmark with "
+                  "ABRT_CONF_DIR pointing to abrt.conf with a temporary DumpLocation",
+                  abrt_g_settings_dump_location);
         goto init_error;
+    }
 
     /* Moved before daemonization because parent waits for signal from daemon
      * only for short period and time consumed by
@@ -818,12 +1402,28 @@ int main(int argc, char** argv)
     log_notice("Creating glib main loop");
     s_main_loop = g_main_loop_new(NULL, FALSE);
 
+    s_processes = g_hash_table_new(g_direct_hash, g_direct_equal);
+    s_processes_by_fdout = g_hash_table_new(g_direct_hash, g_direct_equal);
+    s_dir_queue_by_dirname = g_hash_table_new(g_str_hash, g_str_equal);
+    s_post_create_running_keys = g_hash_table_new(g_str_hash, g_str_equal);
+
     /* Watching 'abrt_g_settings_dump_location' for delete self
      * because hooks expects that the dump location exists if abrtd is running
+     * and for its entries to keep the size index up to date.
      */
     aiw = abrt_inotify_watch_init(abrt_g_settings_dump_location,
             IN_DUMP_LOCATION_FLAGS, handle_inotify_cb, /*user data*/NULL);
 
+    conf_aiw = abrt_inotify_watch_init(get_conf_dir(),
+            IN_CONF_DIR_FLAGS, handle_conf_dir_inotify_cb, /*user data*/NULL);
+    /* Do not miss a change made before the watch was added */
+    abrt_invalidate_abrt_conf();
+    load_abrt_conf();
+
+    /* Build the index after the watch is added to not miss any change */
+    s_size_index = abrt_size_index_new(abrt_g_settings_dump_location);
+    s_catalog = abrt_problem_catalog_new(abrt_g_settings_dump_location);
+
     /* Add an event source which waits for INT/TERM signal */
     log_notice("Adding signal pipe watch to glib main loop");
     channel_signal = abrt_gio_channel_unix_new(s_signal_pipe[0]);
@@ -854,6 +1454,15 @@ int main(int argc, char** argv)
     /* Only now we want signal pipe to work */
     s_signal_pipe_write = s_signal_pipe[1];
 
+    if (opts & OPT_B)
+        start_benchmark();
+    else if (abrt_g_settings_server_workers > 0)
+    {
+        log_notice("Starting %u abrt-server workers", abrt_g_settings_server_workers);
+        for (unsigned i = 0; i < abrt_g_settings_server_workers; ++i)
+            start_abrt_server_worker();
+    }
+
     /* Own a name on D-Bus */
     name_id = g_bus_own_name(G_BUS_TYPE_SYSTEM,
                              ABRTD_DBUS_NAME,
@@ -899,13 +1508,25 @@ int main(int argc, char** argv)
         g_io_channel_unref(channel_signal);
 
     abrt_inotify_watch_destroy(aiw);
+    abrt_inotify_watch_destroy(conf_aiw);
+    abrt_size_index_free(s_size_index);
+    abrt_problem_catalog_free(s_catalog);
 
     if (s_main_loop)
         g_main_loop_unref(s_main_loop);
 
+    if (s_post_create_running_keys)
+        g_hash_table_destroy(s_post_create_running_keys);
+    if (s_dir_queue_by_dirname)
+        g_hash_table_destroy(s_dir_queue_by_dirname);
+    if (s_processes_by_fdout)
+        g_hash_table_destroy(s_processes_by_fdout);
+    if (s_processes)
+        g_hash_table_destroy(s_processes);
+
     abrt_free_abrt_conf_data();
 
-    if (s_sig_caught && s_sig_caught != SIGCHLD)
+    if (s_sig_caught && s_sig_caught != SIGCHLD && s_sig_caught != SIGUSR1)
     {
         /* We use TERM to stop abrtd, so not printing out error message. */
         if (s_sig_caught != SIGTERM)
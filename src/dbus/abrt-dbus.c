@@ -21,6 +21,45 @@ static unsigned g_timeout_value = 120;
 static guint g_signal_crash;
 static guint g_signal_dup_crash;
 
+#define GETALL_ACTION "org.freedesktop.problems.getall"
+
+/* Seconds for which a polkit answer is reused for the same bus name */
+#define AUTHORIZATION_TTL 10
+
+/* The method call waits for polkit and will be dispatched again */
+#define AUTHORIZATION_PENDING ((PolkitResult)-1)
+
+/* A method call which can be suspended until polkit answers
+ */
+struct method_call
+{
+    gchar *caller;
+    gchar *method_name;
+    GVariant *parameters;
+    GDBusMethodInvocation *invocation;
+    AbrtP2Service *service;
+    uid_t caller_uid;
+
+    bool getall_checked;
+    PolkitResult getall;
+    bool suspended;
+};
+
+/* Answers of polkit, the bus names are never reused, so the entries only
+ * need to expire
+ */
+struct authorization
+{
+    PolkitResult result;
+    /* g_get_monotonic_time() based, 0 while polkit is asked */
+    gint64 expires;
+    /* struct method_call waiting for the answer */
+    GList *waiters;
+};
+
+/* "bus name\naction id" -> struct authorization */
+static GHashTable *g_authorizations;
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 static GDBusNodeInfo *introspection_data = NULL;
@@ -189,14 +228,128 @@ static void return_InvalidProblemDir_error(GDBusMethodInvocation *invocation, co
                                       msg);
 }
 
+static void dispatch_method_call(struct method_call *call);
+
+static void method_call_free(struct method_call *call)
+{
+    g_free(call->caller);
+    g_free(call->method_name);
+    g_variant_unref(call->parameters);
+    g_object_unref(call->invocation);
+    g_object_unref(call->service);
+    free(call);
+}
+
+static void authorization_free(struct authorization *auth)
+{
+    /* Never freed with waiters, they would never be answered */
+    g_assert(auth->waiters == NULL);
+    free(auth);
+}
+
+static void authorizations_prune(gint64 now)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, g_authorizations);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        struct authorization *auth = value;
+        if (auth->expires != 0 && auth->expires <= now)
+            g_hash_table_iter_remove(&iter);
+    }
+}
+
+static void authorization_done_cb(PolkitResult result, void *user_data)
+{
+    g_autofree char *key = user_data;
+
+    struct authorization *auth = g_hash_table_lookup(g_authorizations, key);
+    GList *waiters = auth->waiters;
+    auth->waiters = NULL;
+
+    /* Errors and timeouts are not remembered, the next call asks again */
+    if (result == PolkitYes || result == PolkitNo)
+    {
+        auth->result = result;
+        auth->expires = g_get_monotonic_time() + AUTHORIZATION_TTL * G_USEC_PER_SEC;
+    }
+    else
+        g_hash_table_remove(g_authorizations, key);
+
+    for (GList *iter = waiters; iter != NULL; iter = g_list_next(iter))
+    {
+        struct method_call *call = iter->data;
+
+        log_debug("Resuming '%s' of '%s'", call->method_name, call->caller);
+
+        call->getall_checked = true;
+        call->getall = result;
+        call->suspended = false;
+
+        dispatch_method_call(call);
+        if (!call->suspended)
+            method_call_free(call);
+    }
+    g_list_free(waiters);
+}
+
+/* Returns the cached answer or suspends the call and returns
+ * AUTHORIZATION_PENDING. The caller must not reply to a suspended call.
+ */
+static PolkitResult authorize_getall(struct method_call *call)
+{
+    if (call->getall_checked)
+        return call->getall;
+
+    const gint64 now = g_get_monotonic_time();
+    char *key = g_strdup_printf("%s\n%s", call->caller, GETALL_ACTION);
+
+    struct authorization *auth = g_hash_table_lookup(g_authorizations, key);
+    if (auth != NULL && auth->expires > now)
+    {
+        log_debug("Reusing authorization of '%s'", call->caller);
+        g_free(key);
+
+        call->getall_checked = true;
+        call->getall = auth->result;
+        return auth->result;
+    }
+
+    call->suspended = true;
+
+    if (auth != NULL && auth->expires == 0)
+    {
+        /* polkit has already been asked */
+        auth->waiters = g_list_append(auth->waiters, call);
+        g_free(key);
+        return AUTHORIZATION_PENDING;
+    }
+
+    authorizations_prune(now);
+
+    auth = g_new0(struct authorization, 1);
+    auth->waiters = g_list_append(auth->waiters, call);
+    g_hash_table_insert(g_authorizations, key, auth);
+
+    log_debug("Asking polkit for authorization of '%s'", call->caller);
+    polkit_check_authorization_dname_async(call->caller, GETALL_ACTION,
+                                           authorization_done_cb, g_strdup(key));
+
+    return AUTHORIZATION_PENDING;
+}
+
 enum {
     OPEN_FAIL_NO_REPLY = 1 << 0,
     OPEN_AUTH_ASK      = 1 << 1,
     OPEN_AUTH_FAIL     = 1 << 2,
 };
 
+/*
+ * Returns NULL without replying if the call has been suspended.
+ */
 static struct dump_dir *open_dump_directory(GDBusMethodInvocation *invocation,
-    const gchar *caller, uid_t caller_uid, const char *problem_dir, int dd_flags, int flags)
+    struct method_call *call, uid_t caller_uid, const char *problem_dir, int dd_flags, int flags)
 {
     if (!allowed_problem_dir(problem_dir))
     {
@@ -227,8 +380,14 @@ static struct dump_dir *open_dump_directory(GDBusMethodInvocation *invocation,
             return NULL;
         }
 
-        if (   !(flags & OPEN_AUTH_ASK)
-            || polkit_check_authorization_dname(caller, "org.freedesktop.problems.getall") != PolkitYes)
+        const PolkitResult authorized = (flags & OPEN_AUTH_ASK) ? authorize_getall(call) : PolkitNo;
+        if (authorized == AUTHORIZATION_PENDING)
+        {
+            dd_close(dd);
+            return NULL;
+        }
+
+        if (authorized != PolkitYes)
         {
             log_notice("not authorized");
             if (!(flags & OPEN_FAIL_NO_REPLY))
@@ -287,7 +446,7 @@ static struct dump_dir *open_directory_for_modification_of_element(
         }
     }
 
-    struct dump_dir *dd = open_dump_directory(invocation, /*caller*/NULL, caller_uid, problem_id,
+    struct dump_dir *dd = open_dump_directory(invocation, /*call*/NULL, caller_uid, problem_id,
                                               /*Read/Write*/0, OPEN_AUTH_FAIL);
     if (!dd)
         return NULL;
@@ -337,6 +496,22 @@ static int add_dirname_to_GList_if_matches(struct dump_dir *dd, void *arg)
     return 0;
 }
 
+static int add_dirname_to_GList_if_entry_matches(const char *dir_name, const struct abrt_catalog_entry *entry, void *arg)
+{
+    struct field_and_time_range *me = arg;
+
+    const char *field_data = abrt_catalog_entry_element(entry, me->element);
+    if (strcmp(field_data ? field_data : "", me->value) != 0)
+        return 0;
+
+    long val = entry->last_occurrence;
+    if (val < me->timestamp_from || val > me->timestamp_to)
+        return 0;
+
+    me->list = g_list_prepend(me->list, g_strdup(dir_name));
+    return 0;
+}
+
 static GList *get_problem_dirs_for_element_in_time(uid_t uid,
                 const char *element,
                 const char *value,
@@ -354,35 +529,30 @@ static GList *get_problem_dirs_for_element_in_time(uid_t uid,
         .timestamp_to = timestamp_to,
     };
 
-    for_each_problem_in_dir(abrt_g_settings_dump_location, uid, add_dirname_to_GList_if_matches, &me);
+    /* The catalog holds only the most common elements */
+    if (abrt_catalog_has_element(element))
+        for_each_problem_entry_in_dir(abrt_g_settings_dump_location, uid, FOR_EACH_PROBLEM_PARALLEL,
+                                      add_dirname_to_GList_if_entry_matches, &me);
+    else
+        for_each_problem_in_dir_ext(abrt_g_settings_dump_location, uid, FOR_EACH_PROBLEM_PARALLEL,
+                                    add_dirname_to_GList_if_matches, &me);
 
     return g_list_reverse(me.list);
 }
 
 
-static void handle_method_call(GDBusConnection *connection,
-                        const gchar *caller,
-                        const gchar *object_path,
-                        const gchar *interface_name,
-                        const gchar *method_name,
-                        GVariant    *parameters,
-                        GDBusMethodInvocation *invocation,
-                        gpointer    user_data)
+/*
+ * Can be called several times for a single call, every branch must be able to
+ * start over after it has been suspended by authorize_getall().
+ */
+static void dispatch_method_call(struct method_call *call)
 {
-    uid_t caller_uid;
+    const gchar *method_name = call->method_name;
+    GVariant *parameters = call->parameters;
+    GDBusMethodInvocation *invocation = call->invocation;
+    uid_t caller_uid = call->caller_uid;
     GVariant *response;
 
-    GError *error = NULL;
-    caller_uid = abrt_p2_service_caller_uid(ABRT_P2_SERVICE(user_data), caller, &error);
-    if (caller_uid == (uid_t) -1)
-    {
-        g_dbus_method_invocation_return_gerror(invocation, error);
-        g_error_free(error);
-        return;
-    }
-
-    log_notice("caller_uid:%ld method:'%s'", (long)caller_uid, method_name);
-
     if (g_strcmp0(method_name, "NewProblem") == 0)
     {
         g_autofree char *error = NULL;
@@ -403,7 +573,8 @@ static void handle_method_call(GDBusConnection *connection,
 
     if (g_strcmp0(method_name, "GetProblems") == 0)
     {
-        GList *dirs = get_problem_dirs_for_uid(caller_uid, abrt_g_settings_dump_location);
+        GList *dirs = get_problem_dirs_for_uid_ext(caller_uid, abrt_g_settings_dump_location,
+                                                   FOR_EACH_PROBLEM_PARALLEL);
         response = variant_from_string_list(dirs);
         g_list_free_full(dirs, free);
 
@@ -422,11 +593,16 @@ static void handle_method_call(GDBusConnection *connection,
         */
         if (caller_uid != 0)
         {
-            if (polkit_check_authorization_dname(caller, "org.freedesktop.problems.getall") == PolkitYes)
+            const PolkitResult authorized = authorize_getall(call);
+            if (authorized == AUTHORIZATION_PENDING)
+                return;
+
+            if (authorized == PolkitYes)
                 caller_uid = 0;
         }
 
-        GList *dirs = get_problem_dirs_for_uid(caller_uid, abrt_g_settings_dump_location);
+        GList *dirs = get_problem_dirs_for_uid_ext(caller_uid, abrt_g_settings_dump_location,
+                                                   FOR_EACH_PROBLEM_PARALLEL);
         response = variant_from_string_list(dirs);
 
         g_list_free_full(dirs, free);
@@ -437,7 +613,8 @@ static void handle_method_call(GDBusConnection *connection,
 
     if (g_strcmp0(method_name, "GetForeignProblems") == 0)
     {
-        GList *dirs = get_problem_dirs_not_accessible_by_uid(caller_uid, abrt_g_settings_dump_location);
+        GList *dirs = get_problem_dirs_not_accessible_by_uid_ext(caller_uid, abrt_g_settings_dump_location,
+                                                                 FOR_EACH_PROBLEM_PARALLEL);
         response = variant_from_string_list(dirs);
         g_list_free_full(dirs, free);
 
@@ -488,8 +665,14 @@ static void handle_method_call(GDBusConnection *connection,
          * method has to ensure file system ownership for the uid.
          */
 
-        if ((ddstat & DD_STAT_ACCESSIBLE_BY_UID) == 0 &&
-                polkit_check_authorization_dname(caller, "org.freedesktop.problems.getall") != PolkitYes)
+        const PolkitResult authorized = (ddstat & DD_STAT_ACCESSIBLE_BY_UID) ? PolkitYes : authorize_getall(call);
+        if (authorized == AUTHORIZATION_PENDING)
+        {
+            dd_close(dd);
+            return;
+        }
+
+        if (authorized != PolkitYes)
         {
             log_notice("not authorized");
             g_dbus_method_invocation_return_dbus_error(invocation,
@@ -536,7 +719,7 @@ static void handle_method_call(GDBusConnection *connection,
         g_variant_get_child(parameters, 0, "&s", &problem_dir);
         log_notice("problem_dir:'%s'", problem_dir);
 
-        struct dump_dir *dd = open_dump_directory(invocation, caller, caller_uid,
+        struct dump_dir *dd = open_dump_directory(invocation, call, caller_uid,
                 problem_dir, DD_OPEN_READONLY | DD_FAIL_QUIETLY_EACCES , OPEN_AUTH_ASK);
         if (!dd)
             return;
@@ -585,7 +768,7 @@ static void handle_method_call(GDBusConnection *connection,
 
         g_variant_get(parameters, "(&s)", &problem_id);
 
-        struct dump_dir *dd = open_dump_directory(invocation, caller, caller_uid,
+        struct dump_dir *dd = open_dump_directory(invocation, call, caller_uid,
                     problem_id, DD_OPEN_READONLY, OPEN_AUTH_ASK);
         if (!dd)
             return;
@@ -719,7 +902,7 @@ static void handle_method_call(GDBusConnection *connection,
         if (!allowed_problem_element(invocation, element))
             return;
 
-        struct dump_dir *dd = open_dump_directory(invocation, caller, caller_uid,
+        struct dump_dir *dd = open_dump_directory(invocation, call, caller_uid,
                 problem_id, DD_OPEN_READONLY, OPEN_AUTH_ASK);
         if (!dd)
             return;
@@ -758,16 +941,23 @@ static void handle_method_call(GDBusConnection *connection,
         {
             const char *dir_name = (const char*)l->data;
 
-            struct dump_dir *dd = open_dump_directory(invocation, caller, caller_uid,
+            struct dump_dir *dd = open_dump_directory(invocation, call, caller_uid,
                         dir_name, /*Read/Write*/0, OPEN_FAIL_NO_REPLY | OPEN_AUTH_ASK);
 
+            /* The already deleted directories are skipped when resumed */
+            if (call->suspended)
+                goto ret;
+
             if (dd)
             {
+                const uid_t owner = dd_get_owner(dd);
                 if (dd_delete(dd) != 0)
                 {
                     error_msg("Failed to delete problem directory '%s'", dir_name);
                     dd_close(dd);
                 }
+                else if (owner != (uid_t)-1)
+                    abrt_p2_service_notify_problem_removed(call->service, dir_name, owner);
             }
         }
 
@@ -794,8 +984,15 @@ static void handle_method_call(GDBusConnection *connection,
         if (!allowed_problem_element(invocation, element))
             return;
 
-        if (all && polkit_check_authorization_dname(caller, "org.freedesktop.problems.getall") == PolkitYes)
-            caller_uid = 0;
+        if (all)
+        {
+            const PolkitResult authorized = authorize_getall(call);
+            if (authorized == AUTHORIZATION_PENDING)
+                return;
+
+            if (authorized == PolkitYes)
+                caller_uid = 0;
+        }
 
         GList *dirs = get_problem_dirs_for_element_in_time(caller_uid, element, value, timestamp_from,
                                                         timestamp_to);
@@ -814,6 +1011,39 @@ static void handle_method_call(GDBusConnection *connection,
     }
 }
 
+static void handle_method_call(GDBusConnection *connection,
+                        const gchar *caller,
+                        const gchar *object_path,
+                        const gchar *interface_name,
+                        const gchar *method_name,
+                        GVariant    *parameters,
+                        GDBusMethodInvocation *invocation,
+                        gpointer    user_data)
+{
+    GError *error = NULL;
+    uid_t caller_uid = abrt_p2_service_caller_uid(ABRT_P2_SERVICE(user_data), caller, &error);
+    if (caller_uid == (uid_t) -1)
+    {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+        return;
+    }
+
+    log_notice("caller_uid:%ld method:'%s'", (long)caller_uid, method_name);
+
+    struct method_call *call = g_new0(struct method_call, 1);
+    call->caller = g_strdup(caller);
+    call->method_name = g_strdup(method_name);
+    call->parameters = g_variant_ref(parameters);
+    call->invocation = g_object_ref(invocation);
+    call->service = g_object_ref(user_data);
+    call->caller_uid = caller_uid;
+
+    dispatch_method_call(call);
+    if (!call->suspended)
+        method_call_free(call);
+}
+
 static void handle_abrtd_problem_signals(GDBusConnection *connection,
             const gchar     *sender_name,
             const gchar     *object_path,
@@ -865,6 +1095,15 @@ static void handle_abrtd_problem_signals(GDBusConnection *connection,
         return;
     }
 
+    /* The signal can be sent by anybody, the accounting ignores directories
+     * which have already been counted */
+    if (strcmp(signal_name, "ImportProblem") == 0)
+    {
+        const uid_t owner = abrt_p2_entry_get_owner(entry, NULL);
+        if (owner != (uid_t)-1)
+            abrt_p2_service_notify_problem_imported(service, dir, owner);
+    }
+
     abrt_p2_service_notify_entry_object(service, obj, &error);
     if (error)
     {
@@ -976,6 +1215,9 @@ void configure_problems2_service(AbrtP2Service *p2_service)
         {   .name = "ABRT_DBUS_NEW_PROBLEMS_BATCH",
             .setter_unsigned = abrt_p2_service_set_new_problems_batch,
         },
+        {   .name = "ABRT_DBUS_PROPERTY_CACHE_SIZE",
+            .setter_unsigned = abrt_p2_service_set_property_cache_size,
+        },
         {   .name = "ABRT_DBUS_DATA_SIZE_LIMIT",
             .setter_off_t = abrt_p2_service_set_data_size_limit,
         },
@@ -1104,11 +1346,16 @@ int main(int argc, char *argv[])
     /* initialize the abrt_g_settings_dump_location */
     abrt_load_abrt_conf();
 
+    g_authorizations = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                             g_free, (GDestroyNotify)authorization_free);
+
     loop = g_main_loop_new(NULL, FALSE);
     g_main_loop_run(loop);
 
     log_notice("Cleaning up");
 
+    abrt_p2_service_save_usage(p2_service);
+
     g_bus_unown_name(owner_id);
 
     g_dbus_node_info_unref(introspection_data);
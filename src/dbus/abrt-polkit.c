@@ -40,11 +40,40 @@ static gboolean do_cancel(GCancellable* cancellable)
 #endif
 
 #ifdef HAVE_POLKIT
+/* Takes the ownership of auth_result */
+static PolkitResult translate_result(PolkitAuthorizationResult *auth_result)
+{
+    PolkitResult result = PolkitNo;
+
+    if (!auth_result)
+        return PolkitUnknown;
+
+    if (polkit_authorization_result_get_is_challenge(auth_result))
+    {
+        /* This will normally not happen, but, if it does, check if you registered
+         * an authentication agent with Polkit, because otherwise things will
+         * break in text consoles.
+         */
+        g_warn_if_reached();
+        result = PolkitChallenge;
+        goto out;
+    }
+
+    if (polkit_authorization_result_get_is_authorized(auth_result))
+    {
+        result = PolkitYes;
+        goto out;
+    }
+
+out:
+    g_object_unref(auth_result);
+    return result;
+}
+
 static PolkitResult do_check(PolkitSubject *subject, const char *action_id)
 {
     PolkitAuthority *authority;
     PolkitAuthorizationResult *auth_result;
-    PolkitResult result = PolkitNo;
     GError *error = NULL;
     GCancellable * cancellable;
 
@@ -74,29 +103,97 @@ static PolkitResult do_check(PolkitSubject *subject, const char *action_id)
         return PolkitUnknown;
     }
 
-    if (!auth_result)
-        return PolkitUnknown;
+    return translate_result(auth_result);
+}
 
-    if (polkit_authorization_result_get_is_challenge(auth_result))
+struct async_check
+{
+    PolkitSubject *subject;
+    char *action_id;
+    GCancellable *cancellable;
+    guint cancel_timeout;
+    PolkitResultCallback callback;
+    void *user_data;
+};
+
+static gboolean async_check_cancel(gpointer user_data)
+{
+    struct async_check *check = user_data;
+
+    log_warning("Timer has expired; cancelling authorization check\n");
+    check->cancel_timeout = 0;
+    g_cancellable_cancel(check->cancellable);
+    return FALSE;
+}
+
+static void async_check_finish(struct async_check *check, PolkitResult result)
+{
+    if (check->cancel_timeout != 0)
+        g_source_remove(check->cancel_timeout);
+
+    check->callback(result, check->user_data);
+
+    g_object_unref(check->cancellable);
+    g_object_unref(check->subject);
+    free(check->action_id);
+    free(check);
+}
+
+static void async_check_authorization_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    GError *error = NULL;
+    PolkitAuthorizationResult *auth_result = polkit_authority_check_authorization_finish(
+                POLKIT_AUTHORITY(source), res, &error);
+    if (error)
     {
-        /* This will normally not happen, but, if it does, check if you registered
-         * an authentication agent with Polkit, because otherwise things will
-         * break in text consoles.
-         */
-        g_warn_if_reached();
-        result = PolkitChallenge;
-        goto out;
+        log_notice("Polkit authorization failed: %s", error->message);
+        g_error_free(error);
+        async_check_finish(user_data, PolkitUnknown);
+        return;
     }
 
-    if (polkit_authorization_result_get_is_authorized(auth_result))
+    async_check_finish(user_data, translate_result(auth_result));
+}
+
+static void async_check_authority_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    struct async_check *check = user_data;
+
+    GError *error = NULL;
+    PolkitAuthority *authority = polkit_authority_get_finish(res, &error);
+    if (authority == NULL)
     {
-        result = PolkitYes;
-        goto out;
+        log_notice("Can't get polkit Authority: %s", error->message);
+        g_error_free(error);
+        async_check_finish(check, PolkitUnknown);
+        return;
     }
 
-out:
-    g_object_unref(auth_result);
-    return result;
+    polkit_authority_check_authorization(authority,
+                check->subject,
+                check->action_id,
+                NULL,
+                POLKIT_CHECK_AUTHORIZATION_FLAGS_ALLOW_USER_INTERACTION,
+                check->cancellable,
+                async_check_authorization_cb,
+                check);
+    g_object_unref(authority);
+}
+#endif
+
+#ifndef HAVE_POLKIT
+struct async_result
+{
+    PolkitResultCallback callback;
+    void *user_data;
+};
+
+static gboolean async_result_idle_cb(gpointer user_data)
+{
+    struct async_result *result = user_data;
+    result->callback(PolkitYes, result->user_data);
+    g_free(result);
+    return G_SOURCE_REMOVE;
 }
 #endif
 
@@ -128,3 +225,33 @@ PolkitResult polkit_check_authorization_pid(pid_t pid, const char *action_id)
     return PolkitYes;
 #endif
 }
+
+void polkit_check_authorization_dname_async(const char *dbus_name,
+        const char *action_id,
+        PolkitResultCallback callback,
+        void *user_data)
+{
+#ifdef HAVE_POLKIT
+    libreport_glib_init();
+
+    struct async_check *check = g_new0(struct async_check, 1);
+    check->subject = polkit_system_bus_name_new(dbus_name);
+    check->action_id = xstrdup(action_id);
+    check->cancellable = g_cancellable_new();
+    check->callback = callback;
+    check->user_data = user_data;
+    check->cancel_timeout = g_timeout_add(POLKIT_TIMEOUT * 1000,
+                   async_check_cancel,
+                   check);
+
+    polkit_authority_get_async(check->cancellable, async_check_authority_cb, check);
+#else
+    log_warning("Polkit disabled. Everyone has access to private data");
+
+    /* The callers expect the callback after they return */
+    struct async_result *result = g_new0(struct async_result, 1);
+    result->callback = callback;
+    result->user_data = user_data;
+    g_idle_add(async_result_idle_cb, result);
+#endif
+}
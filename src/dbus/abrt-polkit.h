@@ -36,4 +36,13 @@ typedef enum {
 PolkitResult polkit_check_authorization_dname(const char *dbus_name, const char *action_id);
 PolkitResult polkit_check_authorization_pid(pid_t pid, const char *action_id);
 
+typedef void (*PolkitResultCallback)(PolkitResult result, void *user_data);
+
+/* Does not block, the callback is always called from the main loop, never
+ * before this function returns (not even without polkit support) */
+void polkit_check_authorization_dname_async(const char *dbus_name,
+        const char *action_id,
+        PolkitResultCallback callback,
+        void *user_data);
+
 #endif
@@ -0,0 +1,416 @@
+/*
+  Copyright (C) 2026  ABRT team
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "libabrt.h"
+#include "abrt_glib.h"
+#include "abrt_problems2_property_cache.h"
+
+#include <sys/inotify.h>
+
+/* Approximate memory used by the book keeping */
+#define CACHED_DIR_OVERHEAD 160
+#define CACHED_PROPERTY_OVERHEAD 64
+
+#define CACHE_INOTIFY_FLAGS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM \
+                             | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF)
+
+/* Properties computed only from the listed elements */
+static const struct cached_property
+{
+    const char *name;
+    const char *elements[6];
+} s_cached_properties[] = {
+    { "Type",            { FILENAME_TYPE, NULL } },
+    { "Executable",      { FILENAME_EXECUTABLE, NULL } },
+    { "UID",             { FILENAME_UID, NULL } },
+    { "UUID",            { FILENAME_UUID, NULL } },
+    { "Duphash",         { FILENAME_DUPHASH, NULL } },
+    { "FirstOccurrence", { FILENAME_TIME, NULL } },
+    { "Package",         { FILENAME_PACKAGE, FILENAME_PKG_EPOCH, FILENAME_PKG_NAME,
+                           FILENAME_PKG_VERSION, FILENAME_PKG_RELEASE, NULL } },
+    /* Mutable, invalidated by the inotify watch */
+    { "Count",           { FILENAME_COUNT, NULL } },
+    { "LastOccurrence",  { FILENAME_LAST_OCCURRENCE, FILENAME_TIME, NULL } },
+    { "Reports",         { FILENAME_REPORTED_TO, NULL } },
+    { "IsReported",      { FILENAME_REPORTED_TO, NULL } },
+};
+
+struct cached_dir
+{
+    char *dirname;
+    int wd;
+    /* struct cached_property * -> GVariant * */
+    GHashTable *properties;
+    gsize size;
+    GList *lru_link;
+    /* Changed whenever a cached element changes */
+    guint64 generation;
+};
+
+struct _AbrtP2PropertyCache
+{
+    int inotify_fd;
+    GIOChannel *channel;
+    guint channel_source;
+
+    /* dirname -> struct cached_dir */
+    GHashTable *dirs;
+    /* wd -> struct cached_dir */
+    GHashTable *watches;
+    /* struct cached_dir, the most recently used first */
+    GQueue lru;
+
+    gsize size;
+    gsize max_size;
+    guint64 last_generation;
+    guint64 hits;
+    guint64 misses;
+};
+
+static const struct cached_property *cached_property_find(const char *property_name)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_cached_properties); ++i)
+        if (strcmp(s_cached_properties[i].name, property_name) == 0)
+            return s_cached_properties + i;
+
+    return NULL;
+}
+
+static bool cached_property_uses_element(const struct cached_property *property,
+            const char *element)
+{
+    for (const char *const *e = property->elements; *e != NULL; ++e)
+        if (strcmp(*e, element) == 0)
+            return true;
+
+    return false;
+}
+
+static bool cached_properties_use_element(const char *element)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_cached_properties); ++i)
+        if (cached_property_uses_element(s_cached_properties + i, element))
+            return true;
+
+    return false;
+}
+
+static gsize cached_property_size(GVariant *value)
+{
+    return g_variant_get_size(value) + CACHED_PROPERTY_OVERHEAD;
+}
+
+/* Removes the directory from the cache, the watch is removed only if it
+ * still exists
+ */
+static void cached_dir_drop(AbrtP2PropertyCache *cache,
+            struct cached_dir *dir,
+            bool remove_watch)
+{
+    log_debug("Dropping cached properties of '%s'", dir->dirname);
+
+    if (remove_watch)
+        inotify_rm_watch(cache->inotify_fd, dir->wd);
+
+    g_hash_table_remove(cache->watches, GINT_TO_POINTER(dir->wd));
+    g_queue_delete_link(&(cache->lru), dir->lru_link);
+    cache->size -= dir->size;
+
+    g_hash_table_destroy(dir->properties);
+
+    /* Frees dirname */
+    g_hash_table_remove(cache->dirs, dir->dirname);
+    free(dir);
+}
+
+static void cached_dir_drop_element(AbrtP2PropertyCache *cache,
+            struct cached_dir *dir,
+            const char *element)
+{
+    /* Values being read right now must not be inserted */
+    if (cached_properties_use_element(element))
+        dir->generation = ++cache->last_generation;
+
+    GHashTableIter iter;
+    gpointer property, value;
+    g_hash_table_iter_init(&iter, dir->properties);
+    while (g_hash_table_iter_next(&iter, &property, &value))
+    {
+        if (!cached_property_uses_element(property, element))
+            continue;
+
+        log_debug("Element '%s' of '%s' changed: dropping '%s'",
+                  element, dir->dirname, ((const struct cached_property *)property)->name);
+
+        const gsize size = cached_property_size(value);
+        dir->size -= size;
+        cache->size -= size;
+        g_hash_table_iter_remove(&iter);
+    }
+}
+
+static void cache_evict(AbrtP2PropertyCache *cache)
+{
+    while (cache->size > cache->max_size && !g_queue_is_empty(&(cache->lru)))
+        cached_dir_drop(cache, g_queue_peek_tail(&(cache->lru)), true);
+}
+
+static void cache_drop_all(AbrtP2PropertyCache *cache)
+{
+    while (!g_queue_is_empty(&(cache->lru)))
+        cached_dir_drop(cache, g_queue_peek_tail(&(cache->lru)), true);
+}
+
+/* Processes the queued events, returns false if there were none */
+static bool cache_read_events(AbrtP2PropertyCache *cache)
+{
+    /* Large enough for the queued events, at least one event with the
+     * longest name fits in */
+    char buf[sizeof(struct inotify_event) + FILENAME_MAX + 1] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    const ssize_t len = read(cache->inotify_fd, buf, sizeof(buf));
+    if (len < 0)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+            perror_msg("Error reading inotify fd");
+        return false;
+    }
+
+    for (ssize_t i = 0; i < len; )
+    {
+        struct inotify_event *event = (struct inotify_event *)(buf + i);
+        i += sizeof(*event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW)
+        {
+            log_notice("Inotify queue overflow: dropping cached properties");
+            cache_drop_all(cache);
+            continue;
+        }
+
+        struct cached_dir *dir = g_hash_table_lookup(cache->watches, GINT_TO_POINTER(event->wd));
+        if (dir == NULL)
+            continue;
+
+        if (event->mask & IN_IGNORED)
+            cached_dir_drop(cache, dir, false);
+        else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+            cached_dir_drop(cache, dir, true);
+        else if (event->len != 0)
+            cached_dir_drop_element(cache, dir, event->name);
+    }
+
+    return len > 0;
+}
+
+static gboolean handle_inotify_cb(GIOChannel *gio, GIOCondition condition, gpointer user_data)
+{
+    cache_read_events(user_data);
+    return TRUE;
+}
+
+AbrtP2PropertyCache *abrt_p2_property_cache_new(gsize max_size)
+{
+    AbrtP2PropertyCache *cache = g_new0(AbrtP2PropertyCache, 1);
+    cache->max_size = max_size;
+    cache->dirs = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    cache->watches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_queue_init(&(cache->lru));
+
+    cache->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cache->inotify_fd < 0)
+    {
+        perror_msg("inotify_init failed: properties will not be cached");
+        return cache;
+    }
+
+    cache->channel = abrt_gio_channel_unix_new(cache->inotify_fd);
+    /* The events are read from the descriptor directly */
+    g_io_channel_set_buffered(cache->channel, false);
+    cache->channel_source = g_io_add_watch(cache->channel, G_IO_IN | G_IO_PRI,
+                                           handle_inotify_cb, cache);
+
+    return cache;
+}
+
+void abrt_p2_property_cache_free(AbrtP2PropertyCache *cache)
+{
+    if (cache == NULL)
+        return;
+
+    cache_drop_all(cache);
+
+    if (cache->channel_source != 0)
+        g_source_remove(cache->channel_source);
+
+    if (cache->channel != NULL)
+        g_io_channel_unref(cache->channel);
+
+    if (cache->inotify_fd >= 0)
+        close(cache->inotify_fd);
+
+    g_hash_table_destroy(cache->watches);
+    g_hash_table_destroy(cache->dirs);
+    free(cache);
+}
+
+void abrt_p2_property_cache_set_max_size(AbrtP2PropertyCache *cache,
+            gsize max_size)
+{
+    cache->max_size = max_size;
+    cache_evict(cache);
+}
+
+bool abrt_p2_property_cache_is_cacheable(const char *property_name)
+{
+    return cached_property_find(property_name) != NULL;
+}
+
+GVariant *abrt_p2_property_cache_lookup(AbrtP2PropertyCache *cache,
+            const char *dirname,
+            const char *property_name)
+{
+    const struct cached_property *property = cached_property_find(property_name);
+    if (property == NULL)
+        return NULL;
+
+    GVariant *value = NULL;
+    struct cached_dir *dir = g_hash_table_lookup(cache->dirs, dirname);
+    if (dir != NULL)
+    {
+        value = g_hash_table_lookup(dir->properties, property);
+
+        /* Keep the directory even if the property is missing, it has been
+         * used recently */
+        g_queue_unlink(&(cache->lru), dir->lru_link);
+        g_queue_push_head_link(&(cache->lru), dir->lru_link);
+    }
+
+    if (value == NULL)
+    {
+        ++cache->misses;
+        return NULL;
+    }
+
+    ++cache->hits;
+    return g_variant_ref(value);
+}
+
+guint64 abrt_p2_property_cache_watch(AbrtP2PropertyCache *cache,
+            const char *dirname)
+{
+    if (cache->inotify_fd < 0 || cache->max_size == 0)
+        return 0;
+
+    struct cached_dir *dir = g_hash_table_lookup(cache->dirs, dirname);
+    if (dir != NULL)
+        return dir->generation;
+
+    const int wd = inotify_add_watch(cache->inotify_fd, dirname, CACHE_INOTIFY_FLAGS);
+    if (wd < 0)
+    {
+        /* ENOSPC means the limit of watches is reached */
+        log_debug("Can't watch '%s': %s", dirname, strerror(errno));
+        return 0;
+    }
+
+    /* The directory may already be watched through another name */
+    struct cached_dir *other = g_hash_table_lookup(cache->watches, GINT_TO_POINTER(wd));
+    if (other != NULL)
+        cached_dir_drop(cache, other, false);
+
+    dir = g_new0(struct cached_dir, 1);
+    dir->dirname = xstrdup(dirname);
+    dir->wd = wd;
+    dir->properties = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                            NULL, (GDestroyNotify)g_variant_unref);
+    dir->size = strlen(dirname) + CACHED_DIR_OVERHEAD;
+    dir->generation = ++cache->last_generation;
+    g_queue_push_head(&(cache->lru), dir);
+    dir->lru_link = g_queue_peek_head_link(&(cache->lru));
+
+    g_hash_table_insert(cache->dirs, dir->dirname, dir);
+    g_hash_table_insert(cache->watches, GINT_TO_POINTER(wd), dir);
+    cache->size += dir->size;
+
+    return dir->generation;
+}
+
+void abrt_p2_property_cache_insert(AbrtP2PropertyCache *cache,
+            const char *dirname,
+            const char *property_name,
+            GVariant *value,
+            guint64 generation)
+{
+    /* The caller keeps its reference, a floating one becomes a full one */
+    g_variant_take_ref(value);
+
+    const struct cached_property *property = cached_property_find(property_name);
+    if (property == NULL || generation == 0)
+        return;
+
+    /* The events of changes made while the value was being read are
+     * already queued because the directory was watched before */
+    while (cache_read_events(cache))
+        ;
+
+    struct cached_dir *dir = g_hash_table_lookup(cache->dirs, dirname);
+    if (dir == NULL || dir->generation != generation)
+    {
+        log_debug("'%s' of '%s' changed while being read: not caching",
+                  property_name, dirname);
+        return;
+    }
+
+    GVariant *old = g_hash_table_lookup(dir->properties, property);
+    if (old != NULL)
+    {
+        dir->size -= cached_property_size(old);
+        cache->size -= cached_property_size(old);
+    }
+
+    g_hash_table_replace(dir->properties, (gpointer)property, g_variant_ref(value));
+
+    dir->size += cached_property_size(value);
+    cache->size += cached_property_size(value);
+
+    cache_evict(cache);
+}
+
+void abrt_p2_property_cache_invalidate(AbrtP2PropertyCache *cache,
+            const char *dirname)
+{
+    struct cached_dir *dir = g_hash_table_lookup(cache->dirs, dirname);
+    if (dir != NULL)
+        cached_dir_drop(cache, dir, true);
+}
+
+guint64 abrt_p2_property_cache_hits(AbrtP2PropertyCache *cache)
+{
+    return cache->hits;
+}
+
+guint64 abrt_p2_property_cache_misses(AbrtP2PropertyCache *cache)
+{
+    return cache->misses;
+}
+
+gsize abrt_p2_property_cache_size(AbrtP2PropertyCache *cache)
+{
+    return cache->size;
+}
@@ -0,0 +1,78 @@
+/*
+  Copyright (C) 2026  ABRT team
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+  ------------------------------------------------------------------------------
+
+  This file declares the cache of org.freedesktop.Problems2.Entry properties.
+
+  Values are cached per problem directory. Every cached directory is watched
+  by inotify and a change of an element drops the properties computed from
+  that element. The least recently used directories are dropped when the
+  cache grows over its size limit. The cache does not check permissions, the
+  callers must check them before returning a cached value.
+*/
+#ifndef ABRT_P2_PROPERTY_CACHE_H
+#define ABRT_P2_PROPERTY_CACHE_H
+
+#include <glib.h>
+#include <stdbool.h>
+
+typedef struct _AbrtP2PropertyCache AbrtP2PropertyCache;
+
+AbrtP2PropertyCache *abrt_p2_property_cache_new(gsize max_size);
+
+void abrt_p2_property_cache_free(AbrtP2PropertyCache *cache);
+
+/* Drops the least recently used directories if the limit is lower */
+void abrt_p2_property_cache_set_max_size(AbrtP2PropertyCache *cache,
+            gsize max_size);
+
+bool abrt_p2_property_cache_is_cacheable(const char *property_name);
+
+/* Returns a new reference or NULL, counts hits and misses */
+GVariant *abrt_p2_property_cache_lookup(AbrtP2PropertyCache *cache,
+            const char *dirname,
+            const char *property_name);
+
+/* Starts watching the directory, must be called before the elements are
+ * read. Returns the generation to be passed to
+ * abrt_p2_property_cache_insert() or 0 if the directory cannot be watched.
+ */
+guint64 abrt_p2_property_cache_watch(AbrtP2PropertyCache *cache,
+            const char *dirname);
+
+/* The value is not stored if an element it is computed from has changed
+ * since abrt_p2_property_cache_watch() returned the generation. A floating
+ * value is sunk, the caller owns a full reference afterwards.
+ */
+void abrt_p2_property_cache_insert(AbrtP2PropertyCache *cache,
+            const char *dirname,
+            const char *property_name,
+            GVariant *value,
+            guint64 generation);
+
+/* Drops all properties of the directory */
+void abrt_p2_property_cache_invalidate(AbrtP2PropertyCache *cache,
+            const char *dirname);
+
+guint64 abrt_p2_property_cache_hits(AbrtP2PropertyCache *cache);
+
+guint64 abrt_p2_property_cache_misses(AbrtP2PropertyCache *cache);
+
+gsize abrt_p2_property_cache_size(AbrtP2PropertyCache *cache);
+
+#endif/*ABRT_P2_PROPERTY_CACHE_H*/
@@ -32,6 +32,8 @@
 #include "abrt_problems2_task_new_problem.h"
 #include "abrt_problems2_task.h"
 #include "abrt_problems2_generated_interfaces.h"
+#include "abrt_problems2_property_cache.h"
+#include "abrt_problems2_usage.h"
 #include "abrt_problems2_service.h"
 #include "abrt_problems2_session.h"
 #include "abrt_problems2_entry.h"
@@ -107,9 +109,6 @@ static GList *problems2_object_type_get_all_objects(struct problems2_object_type
 struct user_info
 {
     GList *sessions;
-    long unsigned problems;
-    unsigned new_problems;
-    time_t new_problem_last;
 };
 
 static struct user_info *user_info_new(void)
@@ -144,6 +143,8 @@ typedef struct
     GDBusConnection *p2srv_dbus;
     GDBusProxy      *p2srv_proxy_dbus;
     GHashTable      *p2srv_connected_users;
+    GHashTable      *p2srv_caller_sessions;   ///< bus name -> Session object
+    GHashTable      *p2srv_session_tasks;     ///< Session path -> GList of Task objects
     PolkitAuthority *p2srv_pk_authority;
 
     struct problems2_object_type p2srv_p2_type;
@@ -161,6 +162,15 @@ typedef struct
     unsigned p2srv_limit_new_problems_batch;
 
     AbrtP2Object *p2srv_p2_object;
+
+    /* Entry objects are created when a client touches their paths */
+    guint p2srv_entry_subtree_regid;
+    GHashTable *p2srv_entry_dirs;          ///< Entry node -> problem directory
+    struct timespec p2srv_entry_dirs_mtime;
+    AbrtP2Usage *p2srv_usage;              ///< problems and throttling of users
+    GQueue p2srv_listings;                 ///< struct get_problems_listing, the recent first
+
+    AbrtP2PropertyCache *p2srv_property_cache;
 } AbrtP2ServicePrivate;
 
 struct _AbrtP2Service
@@ -207,8 +217,10 @@ static void abrt_p2_object_free(AbrtP2Object *obj)
 
     g_clear_handle_id(&obj->owner_watcher_id, g_bus_unwatch_name);
 
-    /* remove the destroyed object before destructing it */
-    g_hash_table_remove(obj->p2o_type->objects, obj->p2o_path);
+    /* remove the destroyed object before destructing it, the path can
+     * belong to another object if this one has never been added */
+    if (g_hash_table_lookup(obj->p2o_type->objects, obj->p2o_path) == obj)
+        g_hash_table_remove(obj->p2o_type->objects, obj->p2o_path);
 
     if (obj->destructor)
         obj->destructor(obj);
@@ -238,6 +250,13 @@ void *abrt_p2_object_get_node(AbrtP2Object *object)
 
 void abrt_p2_object_destroy(AbrtP2Object *object)
 {
+    if (object->p2o_regid == 0)
+    {
+        log_debug("Removing object: %s", object->p2o_path);
+        abrt_p2_object_free(object);
+        return;
+    }
+
     log_debug("Unregistering object: %s", object->p2o_path);
 
     g_dbus_connection_unregister_object(abrt_p2_service_dbus(object->p2o_service),
@@ -278,12 +297,11 @@ static void abrt_p2_object_emit_signal_with_destination(AbrtP2Object *object,
     }
 }
 
-static AbrtP2Object *abrt_p2_object_new(AbrtP2Service *service,
+static AbrtP2Object *abrt_p2_object_alloc(AbrtP2Service *service,
             struct problems2_object_type *type,
             char *path,
             void *node,
-            void (*destructor)(AbrtP2Object *),
-            GError **error)
+            void (*destructor)(AbrtP2Object *))
 {
     AbrtP2Object *obj = g_new0(AbrtP2Object, 1);
     obj->p2o_path = path;
@@ -292,6 +310,47 @@ static AbrtP2Object *abrt_p2_object_new(AbrtP2Service *service,
     obj->p2o_type = type;
     obj->p2o_service = service;
 
+    return obj;
+}
+
+/* Creates an object served by a registered subtree instead of its own
+ * registration
+ */
+static AbrtP2Object *abrt_p2_object_new_in_subtree(AbrtP2Service *service,
+            struct problems2_object_type *type,
+            char *path,
+            void *node,
+            void (*destructor)(AbrtP2Object *),
+            GError **error)
+{
+    AbrtP2Object *obj = abrt_p2_object_alloc(service, type, path, node, destructor);
+
+    if (g_hash_table_contains(type->objects, path))
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_OBJECT_PATH_IN_USE,
+                    "Object '%s' already exists", path);
+
+        abrt_p2_object_free(obj);
+
+        return NULL;
+    }
+
+    log_debug("Adding PATH %s iface %s", path, type->iface->name);
+
+    g_hash_table_insert(type->objects, path, obj);
+
+    return obj;
+}
+
+static AbrtP2Object *abrt_p2_object_new(AbrtP2Service *service,
+            struct problems2_object_type *type,
+            char *path,
+            void *node,
+            void (*destructor)(AbrtP2Object *),
+            GError **error)
+{
+    AbrtP2Object *obj = abrt_p2_object_alloc(service, type, path, node, destructor);
+
     /* Register the interface parsed from a XML file */
     log_debug("Registering PATH %s iface %s", path, type->iface->name);
     const guint registration_id = g_dbus_connection_register_object(abrt_p2_service_dbus(service),
@@ -480,6 +539,19 @@ static void session_object_destructor(AbrtP2Object *obj)
 
     user->sessions = g_list_remove(user->sessions, session);
 
+    AbrtP2ServicePrivate *pv = obj->p2o_service->pv;
+    const char *caller = abrt_p2_session_caller(session);
+    if (pv->p2srv_caller_sessions != NULL
+        && g_hash_table_lookup(pv->p2srv_caller_sessions, caller) == obj)
+        g_hash_table_remove(pv->p2srv_caller_sessions, caller);
+
+    /* Task objects might be destroyed later, they do not find their list */
+    if (pv->p2srv_session_tasks != NULL)
+    {
+        g_list_free(g_hash_table_lookup(pv->p2srv_session_tasks, obj->p2o_path));
+        g_hash_table_remove(pv->p2srv_session_tasks, obj->p2o_path);
+    }
+
     const guint size = g_hash_table_size(obj->p2o_type->objects);
     if (size == 0)
     {
@@ -503,16 +575,41 @@ static void session_object_on_authorization_changed(AbrtP2Session *session,
                                                 session_bus_address);
 }
 
+static void task_object_dispose(AbrtP2Object *obj);
+
+/* The watcher subscribes to NameOwnerChanged with arg0 set to the caller, so
+ * the service is not woken up by the other clients of the bus
+ */
 static void
 abrt_p2_service_on_session_owner_vanished(GDBusConnection *connection,
                                           const char      *name,
                                           void            *user_data)
 {
-    (void)connection;
-    (void)user_data;
+    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
 
-    log_debug("Name %s vanished from the bus, owned session will be dropped",
-              name);
+    AbrtP2Object *session_obj = g_hash_table_lookup(service->pv->p2srv_caller_sessions, name);
+    if (session_obj == NULL)
+        return;
+
+    log_debug("Bus '%s' disconnected: destroying session: %s", name, session_obj->p2o_path);
+
+    /* Disposing modifies the list */
+    GList *tasks = g_list_copy(g_hash_table_lookup(service->pv->p2srv_session_tasks,
+                                                   session_obj->p2o_path));
+    for (GList *iter = tasks; iter != NULL; iter = g_list_next(iter))
+    {
+        log_debug("Destroying Task of disconnected session: %s",
+                  ((AbrtP2Object *)iter->data)->p2o_path);
+
+        /* Not touching the linked task, destroying of the session object
+         * below should call abrt_p2_session_clean_tasks() which will unref
+         * all session tasks.
+         */
+        task_object_dispose(iter->data);
+    }
+    g_list_free(tasks);
+
+    abrt_p2_object_destroy(session_obj);
 }
 
 static AbrtP2Object *session_object_register(AbrtP2Service *service,
@@ -562,6 +659,11 @@ static AbrtP2Object *session_object_register(AbrtP2Service *service,
 
     user->sessions = g_list_prepend(user->sessions, session);
 
+    /* The key belongs to the session */
+    g_hash_table_replace(service->pv->p2srv_caller_sessions,
+                         (gpointer)abrt_p2_session_caller(session),
+                         obj);
+
     g_signal_emit(service,
                   service_signals[SERVICE_SIGNALS_NEW_CLIENT_CONNECTED],
                   0/*details*/);
@@ -571,7 +673,7 @@ static AbrtP2Object *session_object_register(AbrtP2Service *service,
     obj->owner_watcher_id = g_bus_watch_name_on_connection(connection, caller,
                                                            G_BUS_NAME_WATCHER_FLAGS_NONE,
                                                            NULL, abrt_p2_service_on_session_owner_vanished,
-                                                           obj, NULL);
+                                                           service, NULL);
 
     return obj;
 }
@@ -741,6 +843,7 @@ void abrt_p2_service_notify_entry_object(AbrtP2Service *service,
 
 struct entry_object_save_elements_context
 {
+    AbrtP2Service *service;
     GDBusMethodInvocation *invocation;
     GVariant *elements;
 };
@@ -754,6 +857,11 @@ static void entry_object_save_elements_cb(GObject *source_object,
 
     g_variant_unref(context->elements);
 
+    /* Do not wait for the inotify events, the client may read the
+     * properties right after the response */
+    abrt_p2_property_cache_invalidate(context->service->pv->p2srv_property_cache,
+                                      abrt_p2_entry_problem_id(entry));
+
     GError *error = NULL;
     GVariant *response = abrt_p2_entry_save_elements_finish(entry,
                                                             result,
@@ -872,6 +980,7 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
         struct entry_object_save_elements_context *context = g_new(struct entry_object_save_elements_context, 1);
 
+        context->service = service;
         context->invocation = g_object_ref(invocation);
         context->elements = g_variant_get_child_value(parameters, 0);
 
@@ -906,6 +1015,9 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
                                                  &error);
 
         g_variant_unref(elements);
+
+        abrt_p2_property_cache_invalidate(service->pv->p2srv_property_cache,
+                                          abrt_p2_entry_problem_id(entry));
     }
     else
     {
@@ -947,29 +1059,14 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
 #define GET_UINT32_PROPERTY(name, element, def) GET_INTEGER_PROPERTY(name, element, 32, def)
 
-static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
-            const gchar *caller,
-            const gchar *object_path,
-            const gchar *interface_name,
+/* Reads the property from the opened dump directory, it is safe to call it
+ * from a worker thread
+ */
+static GVariant *entry_object_dump_dir_get_property(struct dump_dir *dd,
             const gchar *property_name,
-            GError      **error,
-            gpointer    user_data)
+            GError      **error)
 {
-    log_debug("Problems2.Entry get property : %s", property_name);
-
-    AbrtP2Service *service = abrt_p2_object_service(user_data);
-    uid_t caller_uid = abrt_p2_service_caller_uid(service, caller, error);
-    if (caller_uid == (uid_t)-1)
-        return NULL;
-
     GVariant *retval;
-    AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
-    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
-                                                      caller_uid,
-                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
-                                                      error);
-    if (dd == NULL)
-        return NULL;
 
     if (strcmp("ID", property_name) == 0)
     {
@@ -996,7 +1093,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         time_t tm = dd_get_first_occurrence(dd);
         if (tm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: FirstOccurrence cannot be returned");
             return NULL;
@@ -1011,7 +1107,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         time_t ltm = dd_get_last_occurrence(dd);
         if (ltm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: LastOccurrence cannot be returned");
             return NULL;
@@ -1167,14 +1262,59 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
        goto return_property_value;
     }
 
-    dd_close(dd);
     error_msg("Unknown property %s", property_name);
     g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
             "BUG: the property getter has to be implemented");
     return NULL;
 
 return_property_value:
+    return retval;
+}
+
+static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
+            const gchar *caller,
+            const gchar *object_path,
+            const gchar *interface_name,
+            const gchar *property_name,
+            GError      **error,
+            gpointer    user_data)
+{
+    log_debug("Problems2.Entry get property : %s", property_name);
+
+    AbrtP2Service *service = abrt_p2_object_service(user_data);
+    uid_t caller_uid = abrt_p2_service_caller_uid(service, caller, error);
+    if (caller_uid == (uid_t)-1)
+        return NULL;
+
+    AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
+    const char *dirname = abrt_p2_entry_problem_id(entry);
+    AbrtP2PropertyCache *cache = service->pv->p2srv_property_cache;
+    const bool cacheable = abrt_p2_property_cache_is_cacheable(property_name);
+
+    /* The cache does not know anything about permissions */
+    if (cacheable && abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL) == 0)
+    {
+        GVariant *retval = abrt_p2_property_cache_lookup(cache, dirname, property_name);
+        if (retval != NULL)
+            return retval;
+    }
+
+    /* Changes made while the property is being read must be noticed */
+    const guint64 generation = cacheable ? abrt_p2_property_cache_watch(cache, dirname) : 0;
+
+    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
+                                                      caller_uid,
+                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
+                                                      error);
+    if (dd == NULL)
+        return NULL;
+
+    GVariant *retval = entry_object_dump_dir_get_property(dd, property_name, error);
     dd_close(dd);
+
+    if (generation != 0 && retval != NULL)
+        abrt_p2_property_cache_insert(cache, dirname, property_name, retval, generation);
+
     return retval;
 }
 
@@ -1340,14 +1480,71 @@ static char *entry_object_dir_name_to_path(const char *dd_dirname)
     return g_strdup_printf(ABRT_P2_PATH"/Entry/%s", checksum);
 }
 
-static AbrtP2Object *entry_object_register_dump_dir(AbrtP2Service *service,
-                const char *dd_dirname,
-                GError **error)
+#define ENTRY_SUBTREE_PATH ABRT_P2_PATH"/Entry"
+
+/* Survives restarts of abrt-dbus, not reboots */
+#define USAGE_FILE VAR_RUN"/abrt/abrt-dbus-usage"
+
+/* Memory for cached Entry properties, roughly 10k problems */
+#define PROPERTY_CACHE_DEFAULT_SIZE (4*1024*1024)
+
+/* Returns true if the dump location has been modified since seen and updates
+ * seen
+ */
+static bool entry_object_dump_location_changed(struct timespec *seen)
+{
+    struct stat statbuf;
+    if (stat(abrt_g_settings_dump_location, &statbuf) != 0)
+    {
+        perror_msg("Can't stat '%s'", abrt_g_settings_dump_location);
+        return true;
+    }
+
+    if (   statbuf.st_mtim.tv_sec == seen->tv_sec
+        && statbuf.st_mtim.tv_nsec == seen->tv_nsec)
+        return false;
+
+    *seen = statbuf.st_mtim;
+    return true;
+}
+
+/* Maps the Entry nodes to the problem directories, only the names are read
+ * because the objects are created on demand
+ */
+static GHashTable *entry_object_dirs(AbrtP2Service *service)
 {
-    char *const dup_dirname = g_strdup(dd_dirname);
-    AbrtP2Entry *entry = abrt_p2_entry_new(dup_dirname);
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    if (!entry_object_dump_location_changed(&(pv->p2srv_entry_dirs_mtime)))
+        return pv->p2srv_entry_dirs;
 
-    return abrt_p2_service_register_entry(service, entry, error);
+    g_hash_table_remove_all(pv->p2srv_entry_dirs);
+
+    DIR *dp = opendir(abrt_g_settings_dump_location);
+    if (dp == NULL)
+    {
+        perror_msg("Can't open directory '%s'", abrt_g_settings_dump_location);
+        return pv->p2srv_entry_dirs;
+    }
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (dent->d_name[0] == '.')
+            continue;
+
+        if (dent->d_type != DT_DIR && dent->d_type != DT_LNK && dent->d_type != DT_UNKNOWN)
+            continue;
+
+        char *dir_name = g_build_filename(abrt_g_settings_dump_location, dent->d_name, NULL);
+        char *node = g_compute_checksum_for_string(G_CHECKSUM_SHA1, dir_name, -1);
+        g_hash_table_replace(pv->p2srv_entry_dirs, node, dir_name);
+    }
+    closedir(dp);
+
+    log_debug("Problem directories: %u", g_hash_table_size(pv->p2srv_entry_dirs));
+
+    return pv->p2srv_entry_dirs;
 }
 
 AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
@@ -1358,12 +1555,12 @@ AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
     log_debug("Registering problem entry for directory: %s", dd_dirname);
     char *path = entry_object_dir_name_to_path(dd_dirname);
 
-    AbrtP2Object *obj = abrt_p2_object_new(service,
-                                           &(service->pv->p2srv_p2_entry_type),
-                                           path,
-                                           entry,
-                                           entry_object_destructor,
-                                           error);
+    AbrtP2Object *obj = abrt_p2_object_new_in_subtree(service,
+                                                      &(service->pv->p2srv_p2_entry_type),
+                                                      path,
+                                                      entry,
+                                                      entry_object_destructor,
+                                                      error);
 
     if (obj == NULL)
     {
@@ -1372,32 +1569,117 @@ AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
         return NULL;
     }
 
-    struct dump_dir *dd = dd_opendir(dd_dirname, DD_OPEN_FD_ONLY);
-    uid_t owner = dd_get_owner(dd);
-
-    if (errno != 0)
-        log_debug("Failed to get owner of dump directory: %s",
-                  strerror(errno));
+    return obj;
+}
 
-    dd_close(dd);
+/* Creates the Entry object of an existing problem directory */
+static AbrtP2Object *entry_object_materialize(AbrtP2Service *service,
+            const char *node)
+{
+    const char *dd_dirname = g_hash_table_lookup(entry_object_dirs(service), node);
+    if (dd_dirname == NULL)
+        return NULL;
 
-    struct user_info *user = abrt_p2_service_user_lookup(service, owner);
+    struct stat statbuf;
+    if (stat(dd_dirname, &statbuf) != 0 || !S_ISDIR(statbuf.st_mode))
+        return NULL;
 
-    if (user == NULL)
-        user = abrt_p2_service_user_new(service, owner);
+    AbrtP2Entry *entry = abrt_p2_entry_new(g_strdup(dd_dirname));
 
-    if (user->problems == ULONG_MAX)
+    GError *error = NULL;
+    AbrtP2Object *obj = abrt_p2_service_register_entry(service, entry, &error);
+    if (obj == NULL)
     {
-        /* Give up, we cannot recover from this. */
-        error_msg_and_die("Too many problems owned by a single user: uid=%lu",
-                          (long unsigned)owner);
+        error_msg("%s", error->message);
+        g_error_free(error);
     }
 
-    user->problems++;
+    return obj;
+}
+
+static AbrtP2Object *entry_object_lookup_node(AbrtP2Service *service,
+            const char *node)
+{
+    g_autofree char *path = g_strdup_printf(ENTRY_SUBTREE_PATH"/%s", node);
+    AbrtP2Object *obj = problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type),
+                                                         path);
+    if (obj == NULL)
+        obj = entry_object_materialize(service, node);
 
     return obj;
 }
 
+/*
+ * /org/freedesktop/Problems2/Entry subtree
+ */
+static gchar **entry_subtree_enumerate(GDBusConnection *connection,
+            const gchar *sender,
+            const gchar *object_path,
+            gpointer user_data)
+{
+    AbrtP2Service *service = user_data;
+    GHashTable *dirs = entry_object_dirs(service);
+    GHashTable *objects = service->pv->p2srv_p2_entry_type.objects;
+
+    GPtrArray *nodes = g_ptr_array_new();
+
+    GHashTableIter iter;
+    const char *node;
+    g_hash_table_iter_init(&iter, dirs);
+    while (g_hash_table_iter_next(&iter, (gpointer)&node, NULL))
+        g_ptr_array_add(nodes, g_strdup(node));
+
+    /* Entries of removed directories live until they are destroyed */
+    const char *path;
+    g_hash_table_iter_init(&iter, objects);
+    while (g_hash_table_iter_next(&iter, (gpointer)&path, NULL))
+    {
+        node = path + strlen(ENTRY_SUBTREE_PATH"/");
+        if (!g_hash_table_contains(dirs, node))
+            g_ptr_array_add(nodes, g_strdup(node));
+    }
+
+    g_ptr_array_add(nodes, NULL);
+    return (gchar **)g_ptr_array_free(nodes, FALSE);
+}
+
+static GDBusInterfaceInfo **entry_subtree_introspect(GDBusConnection *connection,
+            const gchar *sender,
+            const gchar *object_path,
+            const gchar *node,
+            gpointer user_data)
+{
+    if (node == NULL)
+        return NULL;
+
+    AbrtP2Service *service = user_data;
+    GDBusInterfaceInfo **ifaces = g_new0(GDBusInterfaceInfo *, 2);
+    ifaces[0] = g_dbus_interface_info_ref(service->pv->p2srv_p2_entry_type.iface);
+    return ifaces;
+}
+
+static const GDBusInterfaceVTable *entry_subtree_dispatch(GDBusConnection *connection,
+            const gchar *sender,
+            const gchar *object_path,
+            const gchar *interface_name,
+            const gchar *node,
+            gpointer *out_user_data,
+            gpointer user_data)
+{
+    AbrtP2Service *service = user_data;
+    struct problems2_object_type *type = &(service->pv->p2srv_p2_entry_type);
+
+    if (node == NULL || g_strcmp0(interface_name, type->iface->name) != 0)
+        return NULL;
+
+    AbrtP2Object *obj = entry_object_lookup_node(service, node);
+    if (obj == NULL)
+        return NULL;
+
+    *out_user_data = obj;
+    return type->vtable;
+}
+
 struct entry_object_save_problem_args
 {
     AbrtP2EntrySaveElementsLimits limits;
@@ -1585,8 +1867,9 @@ AbrtP2Object *abrt_p2_service_get_entry_object(AbrtP2Service *service,
             int flags,
             GError **error)
 {
-    AbrtP2Object *obj = problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type),
-                                                         entry_path);
+    AbrtP2Object *obj = NULL;
+    if (g_str_has_prefix(entry_path, ENTRY_SUBTREE_PATH"/"))
+        obj = entry_object_lookup_node(service, entry_path + strlen(ENTRY_SUBTREE_PATH"/"));
 
     if (obj == NULL && !(flags & ABRT_P2_SERVICE_ENTRY_LOOKUP_OPTIONAL))
     {
@@ -1633,6 +1916,8 @@ int abrt_p2_service_remove_problem(AbrtP2Service *service,
         return -EINVAL;
     }
 
+    const uid_t owner = abrt_p2_entry_get_owner(entry, NULL);
+
     const int ret = abrt_p2_entry_delete(entry, caller_uid, error);
     if (ret != 0)
     {
@@ -1640,6 +1925,12 @@ int abrt_p2_service_remove_problem(AbrtP2Service *service,
         return ret;
     }
 
+    abrt_p2_property_cache_invalidate(service->pv->p2srv_property_cache,
+                                      abrt_p2_entry_problem_id(entry));
+
+    if (owner != (uid_t)-1)
+        abrt_p2_service_notify_problem_removed(service, abrt_p2_entry_problem_id(entry), owner);
+
     abrt_p2_object_destroy(obj);
     return 0;
 }
@@ -1781,6 +2072,30 @@ static void task_object_on_status_changed(AbrtP2Task *task,
     }
 }
 
+static void task_object_destructor(AbrtP2Object *obj)
+{
+    /* Task paths are SESSION_PATH/Task/ID */
+    const char *task_suffix = strrchr(obj->p2o_path, '/');
+    while (task_suffix > obj->p2o_path && *(--task_suffix) != '/')
+        ;
+
+    g_autofree char *session_path = g_strndup(obj->p2o_path, task_suffix - obj->p2o_path);
+
+    GHashTable *session_tasks = obj->p2o_service->pv->p2srv_session_tasks;
+    if (session_tasks == NULL)
+        return;
+
+    GList *tasks = g_hash_table_lookup(session_tasks, session_path);
+    if (tasks == NULL)
+        return;
+
+    tasks = g_list_remove(tasks, obj);
+    if (tasks == NULL)
+        g_hash_table_remove(session_tasks, session_path);
+    else
+        g_hash_table_insert(session_tasks, g_strdup(session_path), tasks);
+}
+
 static AbrtP2Object *task_object_register(AbrtP2Service* service,
             AbrtP2Object *session_obj,
             AbrtP2Task *task,
@@ -1798,7 +2113,7 @@ static AbrtP2Object *task_object_register(AbrtP2Service* service,
                                            &(service->pv->p2srv_p2_task_type),
                                            path,
                                            task,
-                                           NULL,
+                                           task_object_destructor,
                                            error);
 
     if (obj == NULL)
@@ -1807,6 +2122,11 @@ static AbrtP2Object *task_object_register(AbrtP2Service* service,
         return NULL;
     }
 
+    GList *tasks = g_hash_table_lookup(service->pv->p2srv_session_tasks, session_path);
+    g_hash_table_insert(service->pv->p2srv_session_tasks,
+                        g_strdup(session_path),
+                        g_list_prepend(tasks, obj));
+
     g_signal_connect(task,
                      "status-changed",
                      G_CALLBACK(task_object_on_status_changed),
@@ -2068,71 +2388,858 @@ GVariant *abrt_p2_service_callers_session(AbrtP2Service *service,
     return g_variant_new("(o)", session_path);
 }
 
-GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
-                uid_t caller_uid,
-                AbrtP2ServiceGetProblemsFlags flags,
-                GVariant *options,
-                GError **error)
+/*
+ * GetProblems options
+ */
+enum get_problems_order
 {
-    unsigned int size;
-    GVariantBuilder builder;
-    GHashTableIter iter;
+    GET_PROBLEMS_ORDER_NONE,
+    GET_PROBLEMS_ORDER_NEWEST_FIRST,
+    GET_PROBLEMS_ORDER_OLDEST_FIRST,
+};
 
-    size = g_hash_table_size(service->pv->p2srv_p2_entry_type.objects);
-    if (size > 100)
-    {
-        log_warning("Large numbers of problems may result in degraded performance, consider cleaning some up (currently %u)",
-                    size);
-    }
+struct get_problems_filter
+{
+    const gchar **components;
+    const gchar **executables;
+    bool has_since;
+    gint64 since;
+    bool has_until;
+    gint64 until;
+    int reported;           ///< -1 any, 0 not reported, 1 reported
+    enum get_problems_order order;
+    guint32 limit;          ///< 0 no limit
+    const char *after;      ///< path of the last entry of the previous page
+    bool has_after_time;
+    gint64 after_time;      ///< last occurrence of the entry after
+};
 
-    g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
-    g_hash_table_iter_init(&iter, service->pv->p2srv_p2_entry_type.objects);
+static void get_problems_filter_destroy(struct get_problems_filter *filter)
+{
+    g_free(filter->components);
+    g_free(filter->executables);
+}
 
-    log_debug("Going through entries");
-    const char *entry_path;
-    AbrtP2Object *entry_obj;
-    while(g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&entry_obj))
-    {
-        bool singleout = flags == 0;
+/* The filter only refers to the strings in options */
+static int get_problems_filter_init(struct get_problems_filter *filter,
+            GVariant *options,
+            GError **error)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->reported = -1;
 
-        AbrtP2Entry *entry = abrt_p2_object_get_node(entry_obj);
-        int state = abrt_p2_entry_state(entry);
+    GVariantIter iter;
+    const gchar *name;
+    GVariant *value;
+    g_variant_iter_init(&iter, options);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        bool valid = true;
 
-        log_debug("Entry: %s", entry_path);
-        if (state == ABRT_P2_ENTRY_STATE_DELETED)
+        if (strcmp(name, "component") == 0 || strcmp(name, "executable") == 0)
         {
-            continue;
+            const gchar ***list = name[0] == 'c' ? &(filter->components) : &(filter->executables);
+            if ((valid = g_variant_is_of_type(value, G_VARIANT_TYPE_STRING_ARRAY)))
+            {
+                g_free(*list);
+                *list = g_variant_get_strv(value, NULL);
+            }
         }
-        else if (state == ABRT_P2_ENTRY_STATE_NEW)
+        else if (strcmp(name, "since") == 0)
         {
-            if (flags == 0)
-                continue;
-
-            singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_NEW);
+            if ((valid = filter->has_since = g_variant_is_of_type(value, G_VARIANT_TYPE_INT64)))
+                filter->since = g_variant_get_int64(value);
         }
-
-        if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+        else if (strcmp(name, "until") == 0)
         {
-            if (flags == 0)
-                continue;
-
-            log_debug("Entry not accessible: %s", entry_path);
+            if ((valid = filter->has_until = g_variant_is_of_type(value, G_VARIANT_TYPE_INT64)))
+                filter->until = g_variant_get_int64(value);
+        }
+        else if (strcmp(name, "reported") == 0)
+        {
+            if ((valid = g_variant_is_of_type(value, G_VARIANT_TYPE_BOOLEAN)))
+                filter->reported = g_variant_get_boolean(value);
+        }
+        else if (strcmp(name, "order") == 0)
+        {
+            const char *order = NULL;
+            if (g_variant_is_of_type(value, G_VARIANT_TYPE_STRING))
+                order = g_variant_get_string(value, NULL);
+
+            if (g_strcmp0(order, "newest-first") == 0)
+                filter->order = GET_PROBLEMS_ORDER_NEWEST_FIRST;
+            else if (g_strcmp0(order, "oldest-first") == 0)
+                filter->order = GET_PROBLEMS_ORDER_OLDEST_FIRST;
+            else
+                valid = false;
+        }
+        else if (strcmp(name, "limit") == 0)
+        {
+            if ((valid = g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)))
+                filter->limit = g_variant_get_uint32(value);
+        }
+        else if (strcmp(name, "after") == 0)
+        {
+            /* The full sort key lets the problem disappear between pages */
+            if (g_variant_is_of_type(value, G_VARIANT_TYPE("(xo)")))
+            {
+                g_variant_get(value, "(x&o)", &(filter->after_time), &(filter->after));
+                filter->has_after_time = true;
+            }
+            else if ((valid = g_variant_is_of_type(value, G_VARIANT_TYPE_OBJECT_PATH)))
+            {
+                filter->after = g_variant_get_string(value, NULL);
+                filter->has_after_time = false;
+            }
+        }
+        else
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "Unknown option '%s'", name);
+            g_variant_unref(value);
+            return -EINVAL;
+        }
+
+        if (!valid)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "Invalid value of option '%s'", name);
+            g_variant_unref(value);
+            return -EINVAL;
+        }
+
+        g_variant_unref(value);
+    }
+
+    /* Pages must not depend on the order of the hash tables */
+    if ((filter->limit != 0 || filter->after != NULL)
+        && filter->order == GET_PROBLEMS_ORDER_NONE)
+        filter->order = GET_PROBLEMS_ORDER_NEWEST_FIRST;
+
+    return 0;
+}
+
+/* Returns true if the attributes of the problems are needed */
+static bool get_problems_filter_needs_data(const struct get_problems_filter *filter)
+{
+    return filter->components != NULL
+        || filter->executables != NULL
+        || filter->has_since
+        || filter->has_until
+        || filter->reported != -1
+        || filter->order != GET_PROBLEMS_ORDER_NONE;
+}
+
+static bool get_problems_filter_matches(const struct get_problems_filter *filter,
+            const struct abrt_catalog_entry *entry)
+{
+    if (filter->components != NULL
+        && (entry->component == NULL || !g_strv_contains(filter->components, entry->component)))
+        return false;
+
+    if (filter->executables != NULL
+        && (entry->executable == NULL || !g_strv_contains(filter->executables, entry->executable)))
+        return false;
+
+    if (filter->has_since && entry->last_occurrence < filter->since)
+        return false;
+
+    if (filter->has_until && entry->last_occurrence > filter->until)
+        return false;
+
+    if (filter->reported != -1 && entry->reported != filter->reported)
+        return false;
+
+    return true;
+}
+
+struct get_problems_candidate
+{
+    char *path;
+    time_t last_occurrence;
+};
+
+static gint get_problems_candidate_cmp_newest(gconstpointer a, gconstpointer b)
+{
+    const struct get_problems_candidate *lhs = a;
+    const struct get_problems_candidate *rhs = b;
+
+    if (lhs->last_occurrence != rhs->last_occurrence)
+        return lhs->last_occurrence > rhs->last_occurrence ? -1 : 1;
+
+    /* The exact reverse of the oldest first order */
+    return strcmp(rhs->path, lhs->path);
+}
+
+static gint get_problems_candidate_cmp_oldest(gconstpointer a, gconstpointer b)
+{
+    const struct get_problems_candidate *lhs = a;
+    const struct get_problems_candidate *rhs = b;
+
+    if (lhs->last_occurrence != rhs->last_occurrence)
+        return lhs->last_occurrence < rhs->last_occurrence ? -1 : 1;
+
+    return strcmp(lhs->path, rhs->path);
+}
+
+struct get_problems_args
+{
+    AbrtP2Service *service;
+    uid_t caller_uid;
+    AbrtP2ServiceGetProblemsFlags flags;
+    const struct get_problems_filter *filter;
+    GVariantBuilder *builder;
+    GArray *candidates;     ///< struct get_problems_candidate if sorting
+    GHashTable *objects;    ///< entry path -> struct get_problems_object if filtering
+    unsigned size;
+};
+
+/* The filtered attributes of a problem with an Entry object */
+struct get_problems_object
+{
+    bool matches;
+    time_t last_occurrence;
+};
+
+static void get_problems_add_path(struct get_problems_args *args,
+            const char *entry_path,
+            time_t last_occurrence)
+{
+    if (args->candidates != NULL)
+    {
+        struct get_problems_candidate candidate = {
+            .path = g_strdup(entry_path),
+            .last_occurrence = last_occurrence,
+        };
+        g_array_append_val(args->candidates, candidate);
+        return;
+    }
+
+    log_debug("Adding entry: %s", entry_path);
+    g_variant_builder_add(args->builder, "o", entry_path);
+}
+
+static void get_problems_add(struct get_problems_args *args,
+            const char *entry_path,
+            const struct abrt_catalog_entry *entry)
+{
+    if (entry != NULL && !get_problems_filter_matches(args->filter, entry))
+        return;
+
+    get_problems_add_path(args, entry_path, entry != NULL ? entry->last_occurrence : 0);
+}
+
+/* Adds the sorted candidates following the cursor (last occurrence, path), up
+ * to the limit. The cursor is compared by the sort order, so the problem of the
+ * cursor need not be listed any more and the problems whose last occurrence
+ * changed after the previous page are neither skipped nor repeated unless
+ * they moved across the cursor.
+ */
+static int get_problems_add_page(struct get_problems_args *args,
+            GArray *candidates,
+            GError **error)
+{
+    const struct get_problems_filter *filter = args->filter;
+    const GCompareFunc cmp = filter->order == GET_PROBLEMS_ORDER_NEWEST_FIRST
+                                ? get_problems_candidate_cmp_newest
+                                : get_problems_candidate_cmp_oldest;
+
+    guint i = 0;
+    if (filter->after != NULL)
+    {
+        struct get_problems_candidate cursor = {
+            .path = (char *)filter->after,
+            .last_occurrence = (time_t)filter->after_time,
+        };
+
+        /* Only the path was passed, the listed problem gives the sort key */
+        if (!filter->has_after_time)
+        {
+            guint j = 0;
+            while (j < candidates->len
+                   && strcmp(g_array_index(candidates, struct get_problems_candidate, j).path,
+                             filter->after) != 0)
+                ++j;
+
+            if (j == candidates->len)
+            {
+                g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                            "The problem '%s' is no longer listed", filter->after);
+                return -ENOENT;
+            }
+
+            cursor.last_occurrence = g_array_index(candidates, struct get_problems_candidate, j).last_occurrence;
+        }
+
+        /* The first candidate strictly after the cursor */
+        guint end = candidates->len;
+        while (i < end)
+        {
+            const guint mid = i + (end - i) / 2;
+            if (cmp(&g_array_index(candidates, struct get_problems_candidate, mid), &cursor) <= 0)
+                i = mid + 1;
+            else
+                end = mid;
+        }
+    }
+
+    for (guint added = 0;
+         i < candidates->len && (filter->limit == 0 || added < filter->limit);
+         ++i, ++added)
+    {
+        const char *entry_path = g_array_index(candidates, struct get_problems_candidate, i).path;
+        log_debug("Adding entry: %s", entry_path);
+        g_variant_builder_add(args->builder, "o", entry_path);
+    }
+
+    return 0;
+}
+
+static void get_problems_candidate_clear(struct get_problems_candidate *candidate)
+{
+    g_free(candidate->path);
+}
+
+/* The sorted problems of a paged listing are kept for the following pages,
+ * which pass the same options with 'after'. A listing is dropped once the dump
+ * location changes, i.e. once problems are added or removed, and it is never
+ * used longer than GET_PROBLEMS_LISTING_TTL_US. The changes of the data of the
+ * problems in between are not seen by the following pages.
+ */
+#define GET_PROBLEMS_LISTINGS_MAX 8
+#define GET_PROBLEMS_LISTING_TTL_US (60 * G_USEC_PER_SEC)
+
+struct get_problems_listing
+{
+    char *key;
+    struct timespec dump_location_mtime;
+    gint64 created;
+    GArray *candidates;     ///< sorted struct get_problems_candidate
+};
+
+static void get_problems_listing_free(struct get_problems_listing *listing)
+{
+    g_free(listing->key);
+    g_array_free(listing->candidates, TRUE);
+    g_free(listing);
+}
+
+/* The pages of a listing differ only in the options 'after' and 'limit' */
+static char *get_problems_listing_key(uid_t caller_uid,
+            AbrtP2ServiceGetProblemsFlags flags,
+            GVariant *options)
+{
+    GString *key = g_string_new(NULL);
+    g_string_printf(key, "%lu %d", (unsigned long)caller_uid, (int)flags);
+
+    GVariantIter iter;
+    const gchar *name;
+    GVariant *value;
+    g_variant_iter_init(&iter, options);
+    while (g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        if (strcmp(name, "after") != 0 && strcmp(name, "limit") != 0)
+        {
+            g_autofree gchar *printed = g_variant_print(value, TRUE);
+            g_string_append_printf(key, " %s=%s", name, printed);
+        }
+        g_variant_unref(value);
+    }
+
+    return g_string_free(key, FALSE);
+}
+
+/* Never equal to the mtime of the dump location if it can't be read */
+static struct timespec get_problems_dump_location_mtime(void)
+{
+    struct stat statbuf;
+    if (stat(abrt_g_settings_dump_location, &statbuf) != 0)
+        return (struct timespec){ .tv_nsec = -1 };
+
+    return statbuf.st_mtim;
+}
+
+/* Returns the candidates of the listing and drops the outdated listings */
+static GArray *get_problems_listing_lookup(AbrtP2Service *service,
+            const char *key,
+            const struct timespec *dump_location_mtime)
+{
+    GQueue *listings = &(service->pv->p2srv_listings);
+    const gint64 now = g_get_monotonic_time();
+    GArray *candidates = NULL;
+
+    GList *next = NULL;
+    for (GList *l = listings->head; l != NULL; l = next)
+    {
+        next = l->next;
+
+        struct get_problems_listing *listing = l->data;
+        if (now - listing->created > GET_PROBLEMS_LISTING_TTL_US
+            || listing->dump_location_mtime.tv_sec != dump_location_mtime->tv_sec
+            || listing->dump_location_mtime.tv_nsec != dump_location_mtime->tv_nsec)
+        {
+            g_queue_delete_link(listings, l);
+            get_problems_listing_free(listing);
+        }
+        else if (candidates == NULL && strcmp(listing->key, key) == 0)
+            candidates = listing->candidates;
+    }
+
+    return candidates;
+}
+
+/* Takes the key and the candidates */
+static void get_problems_listing_store(AbrtP2Service *service,
+            char *key,
+            const struct timespec *dump_location_mtime,
+            GArray *candidates)
+{
+    GQueue *listings = &(service->pv->p2srv_listings);
+
+    struct get_problems_listing *listing = g_new(struct get_problems_listing, 1);
+    listing->key = key;
+    listing->dump_location_mtime = *dump_location_mtime;
+    listing->created = g_get_monotonic_time();
+    listing->candidates = candidates;
+    g_queue_push_head(listings, listing);
+
+    while (g_queue_get_length(listings) > GET_PROBLEMS_LISTINGS_MAX)
+        get_problems_listing_free(g_queue_pop_tail(listings));
+}
+
+/* Loads the attributes of a problem with an Entry object, returns NULL if the
+ * directory can't be read
+ */
+static struct abrt_catalog_entry *entry_object_load_catalog_entry(AbrtP2Entry *entry)
+{
+    struct dump_dir *dd = dd_opendir(abrt_p2_entry_problem_id(entry), DD_OPEN_READONLY
+                                                                     | DD_DONT_WAIT_FOR_LOCK
+                                                                     | DD_FAIL_QUIETLY_ENOENT
+                                                                     | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+        return NULL;
+
+    struct abrt_catalog_entry *catalog_entry = abrt_catalog_entry_load(dd);
+    dd_close(dd);
+
+    return catalog_entry;
+}
+
+/* Adds the problem directories which do not have Entry objects yet. Such
+ * problems are complete, so only the foreign ones are interesting if any
+ * flags are set. The problems with Entry objects are filtered by the same
+ * data, so all problems are filtered by the catalog if there is one.
+ */
+static int get_problems_add_dump_dir(const char *dir_name,
+            const struct abrt_catalog_entry *entry,
+            void *call_args)
+{
+    struct get_problems_args *args = call_args;
+    g_autofree char *entry_path = entry_object_dir_name_to_path(dir_name);
+
+    if (problems2_object_type_get_object(&(args->service->pv->p2srv_p2_entry_type),
+                                         entry_path) != NULL)
+    {
+        if (args->objects != NULL)
+        {
+            struct get_problems_object *object = g_new(struct get_problems_object, 1);
+            object->matches = get_problems_filter_matches(args->filter, entry);
+            object->last_occurrence = entry->last_occurrence;
+            g_hash_table_replace(args->objects, g_steal_pointer(&entry_path), object);
+        }
+
+        return 0;
+    }
+
+    ++args->size;
+
+    if (args->flags != 0
+        && ((args->flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN) == 0
+            || dump_dir_accessible_by_uid(dir_name, args->caller_uid)))
+        return 0;
+
+    get_problems_add(args, entry_path, entry);
+
+    return 0;
+}
+
+GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
+                uid_t caller_uid,
+                AbrtP2ServiceGetProblemsFlags flags,
+                GVariant *options,
+                GError **error)
+{
+    GVariantBuilder builder;
+    GHashTableIter iter;
+
+    struct get_problems_filter filter;
+    if (get_problems_filter_init(&filter, options, error) != 0)
+    {
+        get_problems_filter_destroy(&filter);
+        return NULL;
+    }
+
+    const bool needs_data = get_problems_filter_needs_data(&filter);
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
+    g_hash_table_iter_init(&iter, service->pv->p2srv_p2_entry_type.objects);
+
+    struct get_problems_args args = {
+        .service = service,
+        .caller_uid = caller_uid,
+        .flags = flags,
+        .filter = &filter,
+        .builder = &builder,
+        .size = g_hash_table_size(service->pv->p2srv_p2_entry_type.objects),
+    };
+
+    int r = 0;
+    g_autofree char *listing_key = NULL;
+    /* Taken before the scan, the changes during the scan drop the listing */
+    struct timespec listing_mtime = { 0 };
+    if (filter.order != GET_PROBLEMS_ORDER_NONE)
+    {
+        listing_key = get_problems_listing_key(caller_uid, flags, options);
+        listing_mtime = get_problems_dump_location_mtime();
+
+        /* The following pages of a listing */
+        GArray *listed = filter.after == NULL ? NULL
+                         : get_problems_listing_lookup(service, listing_key, &listing_mtime);
+        if (listed != NULL)
+        {
+            log_debug("Using the listing of the previous page");
+            r = get_problems_add_page(&args, listed, error);
+            goto finish;
+        }
+
+        args.candidates = g_array_new(FALSE, FALSE, sizeof(struct get_problems_candidate));
+        g_array_set_clear_func(args.candidates, (GDestroyNotify)get_problems_candidate_clear);
+    }
+
+    if (needs_data)
+        args.objects = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    /* Goes through the directories first to collect the data of the
+     * problems with Entry objects too. Only the pages following the first
+     * one reuse the listing, see get_problems_listing_lookup(). */
+    log_debug("Going through problem directories");
+    const uid_t scan_uid = (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN) ? (uid_t)-1 : caller_uid;
+    if (flags == 0 || scan_uid == (uid_t)-1 || needs_data)
+        for_each_problem_entry_in_dir(abrt_g_settings_dump_location, scan_uid, FOR_EACH_PROBLEM_PARALLEL,
+                                      get_problems_add_dump_dir, &args);
+
+    log_debug("Going through entries");
+    const char *entry_path;
+    AbrtP2Object *entry_obj;
+    while(g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&entry_obj))
+    {
+        bool singleout = flags == 0;
+
+        AbrtP2Entry *entry = abrt_p2_object_get_node(entry_obj);
+        int state = abrt_p2_entry_state(entry);
+
+        log_debug("Entry: %s", entry_path);
+        if (state == ABRT_P2_ENTRY_STATE_DELETED)
+        {
+            continue;
+        }
+        else if (state == ABRT_P2_ENTRY_STATE_NEW)
+        {
+            if (flags == 0)
+                continue;
+
+            singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_NEW);
+        }
+
+        if (0 != abrt_p2_entry_accessible_by_uid(entry, caller_uid, NULL))
+        {
+            if (flags == 0)
+                continue;
+
+            log_debug("Entry not accessible: %s", entry_path);
             singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN);
         }
 
-        if (singleout)
+        if (!singleout)
+            continue;
+
+        if (!needs_data)
+        {
+            get_problems_add(&args, entry_path, NULL);
+            continue;
+        }
+
+        const struct get_problems_object *object = g_hash_table_lookup(args.objects, entry_path);
+        if (object != NULL)
+        {
+            if (object->matches)
+                get_problems_add_path(&args, entry_path, object->last_occurrence);
+            continue;
+        }
+
+        /* New problems are not listed in the dump location yet. Problems
+         * which can't be read don't match any filter. */
+        struct abrt_catalog_entry *catalog_entry = entry_object_load_catalog_entry(entry);
+        if (catalog_entry != NULL)
+            get_problems_add(&args, entry_path, catalog_entry);
+        abrt_catalog_entry_free(catalog_entry);
+    }
+
+    if (args.objects != NULL)
+        g_hash_table_destroy(args.objects);
+
+    if (args.size > 100)
+    {
+        log_warning("Large numbers of problems may result in degraded performance, consider cleaning some up (currently %u)",
+                    args.size);
+    }
+
+    if (args.candidates != NULL)
+    {
+        g_array_sort(args.candidates, filter.order == GET_PROBLEMS_ORDER_NEWEST_FIRST
+                                        ? get_problems_candidate_cmp_newest
+                                        : get_problems_candidate_cmp_oldest);
+        r = get_problems_add_page(&args, args.candidates, error);
+        get_problems_listing_store(service, g_steal_pointer(&listing_key), &listing_mtime, args.candidates);
+    }
+
+finish:
+    get_problems_filter_destroy(&filter);
+
+    if (r != 0)
+    {
+        g_variant_builder_clear(&builder);
+        return NULL;
+    }
+
+    GVariant *retval_body[1];
+    retval_body[0] = g_variant_builder_end(&builder);
+    return  g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+}
+
+
+/*
+ * GetProblemsProperties
+ */
+
+/* Requests for more entries are served by a worker thread */
+#define PROBLEMS_PROPERTIES_SYNC_ENTRIES 16
+
+struct problems_properties_entry
+{
+    char *path;
+    char *dirname;
+};
+
+typedef struct
+{
+    GArray *entries;        ///< struct problems_properties_entry
+    gchar **properties;
+    uid_t caller_uid;
+    gsize max_size;
+} AbrtP2ServiceProblemsPropertiesData;
+
+static void problems_properties_entry_clear(struct problems_properties_entry *item)
+{
+    g_free(item->path);
+    g_free(item->dirname);
+}
+
+static void abrt_p2_service_problems_properties_data_free(AbrtP2ServiceProblemsPropertiesData *data)
+{
+    g_array_free(data->entries, TRUE);
+    g_strfreev(data->properties);
+    free(data);
+}
+
+/* Opens the dump directory like abrt_p2_entry_open_dump_dir() without an Entry */
+static struct dump_dir *problems_properties_open_dump_dir(const char *dirname,
+            uid_t caller_uid)
+{
+    struct dump_dir *dd = dd_opendir(dirname, DD_OPEN_FD_ONLY
+                                              | DD_FAIL_QUIETLY_ENOENT
+                                              | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+        return NULL;
+
+    if (!dd_accessible_by_uid(dd, caller_uid))
+    {
+        dd_close(dd);
+        return NULL;
+    }
+
+    return dd_fdopendir(dd, DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY);
+}
+
+/* Opens every dump directory once and reads all the properties. Inaccessible
+ * entries and properties which can't be read are left out.
+ */
+static GVariant *abrt_p2_service_problems_properties_read(AbrtP2ServiceProblemsPropertiesData *data,
+            GCancellable *cancellable,
+            GError **error)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{oa{sv}}"));
+
+    for (guint i = 0; i < data->entries->len; ++i)
+    {
+        if (g_cancellable_set_error_if_cancelled(cancellable, error))
+        {
+            g_variant_builder_clear(&builder);
+            return NULL;
+        }
+
+        struct problems_properties_entry *item = &g_array_index(data->entries,
+                                                                struct problems_properties_entry,
+                                                                i);
+
+        struct dump_dir *dd = problems_properties_open_dump_dir(item->dirname, data->caller_uid);
+        if (dd == NULL)
+        {
+            log_debug("Skipping inaccessible entry '%s'", item->path);
+            continue;
+        }
+
+        GError *local_error = NULL;
+        g_variant_builder_open(&builder, G_VARIANT_TYPE("{oa{sv}}"));
+        g_variant_builder_add(&builder, "o", item->path);
+        g_variant_builder_open(&builder, G_VARIANT_TYPE("a{sv}"));
+
+        for (gchar **property = data->properties; *property != NULL; ++property)
         {
-            log_debug("Adding entry: %s", entry_path);
-            g_variant_builder_add(&builder, "o", entry_path);
+            GVariant *value = entry_object_dump_dir_get_property(dd, *property, &local_error);
+            if (value == NULL)
+            {
+                log_debug("Skipping property '%s' of '%s': %s",
+                          *property, item->path, local_error->message);
+                g_clear_error(&local_error);
+                continue;
+            }
+
+            g_variant_builder_add(&builder, "{sv}", *property, value);
         }
+
+        g_variant_builder_close(&builder);
+        g_variant_builder_close(&builder);
+
+        dd_close(dd);
     }
 
+    GVariant *response = g_variant_ref_sink(g_variant_new("(a{oa{sv}})", &builder));
+    if (data->max_size != 0 && g_variant_get_size(response) > data->max_size)
+    {
+        g_variant_unref(response);
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_LIMITS_EXCEEDED,
+                    "The response would be too large, request fewer entries or properties");
+        return NULL;
+    }
 
-    GVariant *retval_body[1];
-    retval_body[0] = g_variant_builder_end(&builder);
-    return  g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+    return response;
+}
+
+static void abrt_p2_service_problems_properties_async_task(GTask *task,
+            gpointer source_object,
+            gpointer task_data,
+            GCancellable *cancellable)
+{
+    GError *error = NULL;
+    GVariant *response = abrt_p2_service_problems_properties_read(task_data,
+                                                                  cancellable,
+                                                                  &error);
+    if (error == NULL)
+        g_task_return_pointer(task, response, (GDestroyNotify)g_variant_unref);
+    else
+        g_task_return_error(task, error);
+}
+
+void abrt_p2_service_get_problems_properties_async(AbrtP2Service *service,
+            GVariant *entries,
+            GVariant *properties,
+            uid_t caller_uid,
+            GCancellable *cancellable,
+            GAsyncReadyCallback callback,
+            gpointer user_data)
+{
+    GTask *task = g_task_new(service, cancellable, callback, user_data);
+
+    /* Unknown properties are errors, unlike problems which disappeared */
+    GDBusInterfaceInfo *iface = service->pv->p2srv_p2_entry_type.iface;
+    gchar **names = g_variant_dup_strv(properties, NULL);
+    for (gchar **name = names; *name != NULL; ++name)
+    {
+        if (g_dbus_interface_info_lookup_property(iface, *name) == NULL)
+        {
+            g_task_return_new_error(task, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                                    "Unknown property '%s'", *name);
+            g_strfreev(names);
+            g_object_unref(task);
+            return;
+        }
+    }
+
+    AbrtP2ServiceProblemsPropertiesData *data = g_new0(AbrtP2ServiceProblemsPropertiesData, 1);
+    data->properties = names;
+    data->caller_uid = caller_uid;
+    data->max_size = service->pv->p2srv_max_message_size;
+    data->entries = g_array_sized_new(FALSE, FALSE,
+                                      sizeof(struct problems_properties_entry),
+                                      g_variant_n_children(entries));
+    g_array_set_clear_func(data->entries, (GDestroyNotify)problems_properties_entry_clear);
+
+    /* The directories are looked up here because the tables are not thread
+     * safe. Entry objects are not created for the problems without them, a
+     * listing of all problems would register an object for each one. */
+    GVariantIter iter;
+    const char *entry_path;
+    g_variant_iter_init(&iter, entries);
+    while (g_variant_iter_next(&iter, "&o", &entry_path))
+    {
+        if (!g_str_has_prefix(entry_path, ENTRY_SUBTREE_PATH"/"))
+            continue;
+
+        const char *dirname = NULL;
+        AbrtP2Object *obj = problems2_object_type_get_object(&(service->pv->p2srv_p2_entry_type),
+                                                             entry_path);
+        if (obj != NULL)
+        {
+            AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+            if (abrt_p2_entry_state(entry) == ABRT_P2_ENTRY_STATE_DELETED)
+                continue;
+
+            dirname = abrt_p2_entry_problem_id(entry);
+        }
+        else
+            dirname = g_hash_table_lookup(entry_object_dirs(service),
+                                          entry_path + strlen(ENTRY_SUBTREE_PATH"/"));
+
+        if (dirname == NULL)
+            continue;
+
+        struct problems_properties_entry item = {
+            .path = g_strdup(entry_path),
+            .dirname = g_strdup(dirname),
+        };
+        g_array_append_val(data->entries, item);
+    }
+
+    g_task_set_task_data(task, data, (GDestroyNotify)abrt_p2_service_problems_properties_data_free);
+
+    if (data->entries->len <= PROBLEMS_PROPERTIES_SYNC_ENTRIES)
+        abrt_p2_service_problems_properties_async_task(task, service, data, cancellable);
+    else
+        g_task_run_in_thread(task, abrt_p2_service_problems_properties_async_task);
+
+    g_object_unref(task);
 }
 
+GVariant *abrt_p2_service_get_problems_properties_finish(AbrtP2Service *service,
+            GAsyncResult *result,
+            GError **error)
+{
+    g_return_val_if_fail(g_task_is_valid(result, service), NULL);
+
+    return g_task_propagate_pointer(G_TASK(result), error);
+}
 
 GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
                 GVariant *entries,
@@ -2160,6 +3267,30 @@ GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
     return NULL;
 }
 
+static void p2_object_get_problems_properties_cb(GObject *source_object,
+            GAsyncResult *result,
+            gpointer user_data)
+{
+    GDBusMethodInvocation *invocation = user_data;
+
+    GError *error = NULL;
+    GVariant *response = abrt_p2_service_get_problems_properties_finish(ABRT_P2_SERVICE(source_object),
+                                                                        result,
+                                                                        &error);
+    if (error == NULL)
+    {
+        g_dbus_method_invocation_return_value(invocation, response);
+        g_variant_unref(response);
+    }
+    else
+    {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+    }
+
+    g_object_unref(invocation);
+}
+
 /* D-Bus method handler
  */
 static void p2_object_dbus_method_call(GDBusConnection *connection,
@@ -2245,12 +3376,35 @@ static void p2_object_dbus_method_call(GDBusConnection *connection,
                                                       caller_uid,
                                                       &error);
     }
+    else if (strcmp("GetProblemsProperties", method_name) == 0)
+    {
+        GVariant *entries = g_variant_get_child_value(parameters, 0);
+        GVariant *properties = g_variant_get_child_value(parameters, 1);
+
+        abrt_p2_service_get_problems_properties_async(service,
+                                                      entries,
+                                                      properties,
+                                                      caller_uid,
+                                                      /*cancellable*/NULL,
+                                                      p2_object_get_problems_properties_cb,
+                                                      g_object_ref(invocation));
+
+        g_variant_unref(properties);
+        g_variant_unref(entries);
+        return;
+    }
     else if (strcmp("DeleteProblems", method_name) == 0)
     {
         GVariant *array = g_variant_get_child_value(parameters, 0);
         response = abrt_p2_service_delete_problems(service, array, caller_uid, &error);
         g_variant_unref(array);
     }
+    else if (strcmp("GetUsage", method_name) == 0)
+    {
+        GVariant *options = g_variant_get_child_value(parameters, 0);
+        response = abrt_p2_service_user_usage(service, caller_uid, options, &error);
+        g_variant_unref(options);
+    }
     else
     {
         error_msg("BUG: org.freedesktop.Problems2 does not have method: %s",
@@ -2284,11 +3438,44 @@ static void abrt_p2_service_private_destroy(AbrtP2ServicePrivate *pv)
         pv->p2srv_connected_users = NULL;
     }
 
+    if (pv->p2srv_caller_sessions != NULL)
+    {
+        g_hash_table_destroy(pv->p2srv_caller_sessions);
+        pv->p2srv_caller_sessions = NULL;
+    }
+
+    if (pv->p2srv_session_tasks != NULL)
+    {
+        GHashTableIter iter;
+        gpointer tasks;
+        g_hash_table_iter_init(&iter, pv->p2srv_session_tasks);
+        while (g_hash_table_iter_next(&iter, NULL, &tasks))
+            g_list_free(tasks);
+
+        g_hash_table_destroy(pv->p2srv_session_tasks);
+        pv->p2srv_session_tasks = NULL;
+    }
+
     problems2_object_type_destroy(&(pv->p2srv_p2_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_session_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_entry_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_task_type));
 
+    if (pv->p2srv_entry_dirs != NULL)
+    {
+        g_hash_table_destroy(pv->p2srv_entry_dirs);
+        pv->p2srv_entry_dirs = NULL;
+    }
+
+    g_queue_free_full(&(pv->p2srv_listings), (GDestroyNotify)get_problems_listing_free);
+    g_queue_init(&(pv->p2srv_listings));
+
+    abrt_p2_usage_free(pv->p2srv_usage);
+    pv->p2srv_usage = NULL;
+
+    abrt_p2_property_cache_free(pv->p2srv_property_cache);
+    pv->p2srv_property_cache = NULL;
+
     if (pv->p2srv_proxy_dbus != NULL)
     {
         g_object_unref(pv->p2srv_proxy_dbus);
@@ -2314,6 +3501,38 @@ static void abrt_p2_service_private_destroy(AbrtP2ServicePrivate *pv)
     }
 }
 
+static GVariant *p2_object_dbus_get_property(GDBusConnection *connection,
+            const gchar *caller,
+            const gchar *object_path,
+            const gchar *interface_name,
+            const gchar *property_name,
+            GError      **error,
+            gpointer    user_data)
+{
+    log_debug("Problems2 get property : %s", property_name);
+
+    if (strcmp(interface_name, "org.freedesktop.Problems2") != 0)
+    {
+        error_msg("Unsupported interface %s", interface_name);
+        return NULL;
+    }
+
+    AbrtP2Service *service = abrt_p2_object_service(user_data);
+    AbrtP2PropertyCache *cache = service->pv->p2srv_property_cache;
+
+    if (strcmp("PropertyCacheHits", property_name) == 0)
+        return g_variant_new_uint64(abrt_p2_property_cache_hits(cache));
+
+    if (strcmp("PropertyCacheMisses", property_name) == 0)
+        return g_variant_new_uint64(abrt_p2_property_cache_misses(cache));
+
+    if (strcmp("PropertyCacheSize", property_name) == 0)
+        return g_variant_new_uint64(abrt_p2_property_cache_size(cache));
+
+    error_msg("Unsupported property %s", property_name);
+    return NULL;
+}
+
 static int abrt_p2_service_private_init(AbrtP2ServicePrivate *pv,
             GError **unused)
 {
@@ -2327,11 +3546,13 @@ static int abrt_p2_service_private_init(AbrtP2ServicePrivate *pv,
     pv->p2srv_limit_new_problem_throttling_magnitude = 4;
     pv->p2srv_limit_new_problems_batch = 10;
 
+    pv->p2srv_property_cache = abrt_p2_property_cache_new(PROPERTY_CACHE_DEFAULT_SIZE);
+
     int r = 0;
     {
         static GDBusInterfaceVTable p2_object_vtable = {
             .method_call = p2_object_dbus_method_call,
-            .get_property = NULL,
+            .get_property = p2_object_dbus_get_property,
             .set_property = NULL,
         };
 
@@ -2396,11 +3617,26 @@ static int abrt_p2_service_private_init(AbrtP2ServicePrivate *pv,
         }
     }
 
+    /* Never equal to the mtime of the dump location */
+    pv->p2srv_entry_dirs_mtime.tv_nsec = -1;
+    pv->p2srv_entry_dirs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    g_queue_init(&(pv->p2srv_listings));
+
+    /* Loaded on the first use, the dump location is not known yet */
+    pv->p2srv_usage = abrt_p2_usage_new(USAGE_FILE);
+
     pv->p2srv_connected_users = g_hash_table_new_full(g_direct_hash,
                                                       g_direct_equal,
                                                       NULL,
                                                       (GDestroyNotify)user_info_free);
 
+    pv->p2srv_caller_sessions = g_hash_table_new(g_str_hash, g_str_equal);
+    /* The lists are replaced in place, they are freed by hand */
+    pv->p2srv_session_tasks = g_hash_table_new_full(g_str_hash,
+                                                    g_str_equal,
+                                                    g_free,
+                                                    NULL);
+
     if (g_polkit_authority != NULL)
     {
         ++g_polkit_authority_refs;
@@ -2513,82 +3749,6 @@ static GDBusConnection *abrt_p2_service_dbus(AbrtP2Service *service)
     return service->pv->p2srv_dbus;
 }
 
-struct bridge_call_args
-{
-    AbrtP2Service *service;
-    GError **error;
-};
-
-static int bridge_register_dump_dir_entry_node(struct dump_dir *dd,
-            void *call_args)
-{
-    struct bridge_call_args *args = call_args;
-    return NULL == entry_object_register_dump_dir(args->service,
-                                                  dd->dd_dirname,
-                                                  args->error);
-}
-
-static void on_g_signal(GDBusProxy *proxy,
-            gchar      *sender_name,
-            gchar      *signal_name,
-            GVariant   *parameters,
-            gpointer    user_data)
-{
-    if (0 != strcmp(signal_name, "NameOwnerChanged"))
-        return;
-
-    const gchar *bus_name = NULL;
-    const gchar *old_owner = NULL;
-    const gchar *new_owner = NULL;
-
-    g_variant_get(parameters, "(&s&s&s)", &bus_name, &old_owner, &new_owner);
-
-    if (bus_name[0] == '\0' || old_owner[0] == '\0' || new_owner[0] != '\0')
-        return;
-
-    AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, service->pv->p2srv_p2_session_type.objects);
-
-    const char *session_path;
-    AbrtP2Object *session_obj;
-    while(g_hash_table_iter_next(&iter, (gpointer)&session_path, (gpointer)&session_obj))
-    {
-        AbrtP2Session *session = abrt_p2_object_get_node(session_obj);
-        const char *session_caller = abrt_p2_session_caller(session);
-        if (strcmp(bus_name, session_caller) != 0)
-            continue;
-
-        log_debug("Bus '%s' disconnected: destroying session: %s", bus_name, session_path);
-
-        GHashTableIter task_iter;
-        g_hash_table_iter_init(&task_iter, service->pv->p2srv_p2_task_type.objects);
-
-        const char *task_path;
-        AbrtP2Object *task_obj;
-        const size_t session_path_len = strlen(session_path);
-        while(g_hash_table_iter_next(&task_iter, (gpointer)&task_path, (gpointer)&task_obj))
-        {
-            if (strncmp(task_path, session_path, session_path_len) != 0)
-                continue;
-
-            if (strncmp(task_path + session_path_len, "/Task/", strlen("/Task/")) != 0)
-                continue;
-
-            log_debug("Destroying Task of disconnected session: %s", task_path);
-
-            /* Not touching the linked task, destroying of the session object
-             * below should call abrt_p2_session_clean_tasks() which will unref
-             * all session tasks.
-             */
-            task_object_dispose(task_obj);
-        }
-
-        /* session_path belongs to session_obj */
-        abrt_p2_object_destroy(session_obj);
-    }
-}
-
 int abrt_p2_service_register_objects(AbrtP2Service *service, GDBusConnection *connection, GError **error)
 {
     if (service->pv->p2srv_dbus != NULL)
@@ -2613,21 +3773,35 @@ int abrt_p2_service_register_objects(AbrtP2Service *service, GDBusConnection *co
         return -1;
     }
 
-    struct bridge_call_args args;
-    args.service = service;
-    args.error = error;
+    static GDBusSubtreeVTable entry_subtree_vtable = {
+        .enumerate = entry_subtree_enumerate,
+        .introspect = entry_subtree_introspect,
+        .dispatch = entry_subtree_dispatch,
+    };
 
-    for_each_problem_in_dir(abrt_g_settings_dump_location, (uid_t)-1, bridge_register_dump_dir_entry_node, &args);
+    /* The nodes are resolved in the dispatch function, enumerating all
+     * problems on every call is not necessary */
+    service->pv->p2srv_entry_subtree_regid = g_dbus_connection_register_subtree(connection,
+                                                      ENTRY_SUBTREE_PATH,
+                                                      &entry_subtree_vtable,
+                                                      G_DBUS_SUBTREE_FLAGS_DISPATCH_TO_UNENUMERATED_NODES,
+                                                      service,
+                                                      /*user data destructor*/NULL,
+                                                      error);
 
-    if (*args.error != NULL)
+    if (service->pv->p2srv_entry_subtree_regid == 0)
     {
         g_prefix_error(error, "Failed to register Problems objects: ");
         return -1;
     }
 
+    /* Only used for method calls, subscribing to the signals of the bus
+     * would wake the service for every client connecting to the bus. The
+     * Session objects watch the names of their owners */
     GError *local_error = NULL;
     service->pv->p2srv_proxy_dbus = g_dbus_proxy_new_sync(connection,
-                                                          G_DBUS_PROXY_FLAGS_NONE,
+                                                          G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES
+                                                          | G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
                                                           NULL,
                                                           "org.freedesktop.DBus",
                                                           "/org/freedesktop/DBus",
@@ -2636,14 +3810,7 @@ int abrt_p2_service_register_objects(AbrtP2Service *service, GDBusConnection *co
                                                           &local_error);
 
 
-    if (local_error == NULL)
-    {
-        g_signal_connect(service->pv->p2srv_proxy_dbus,
-                         "g-signal",
-                         G_CALLBACK(on_g_signal),
-                         service);
-    }
-    else
+    if (local_error != NULL)
     {
         error_msg("Failed to initialize proxy to DBus: %s",
                   local_error->message);
@@ -2755,6 +3922,51 @@ void abrt_p2_service_set_new_problems_batch(AbrtP2Service *service,
     service->pv->p2srv_limit_new_problems_batch = limit;
 }
 
+void abrt_p2_service_set_property_cache_size(AbrtP2Service *service,
+            uid_t uid,
+            unsigned size)
+{
+    abrt_p2_property_cache_set_max_size(service->pv->p2srv_property_cache, size);
+}
+
+/* Refills the batch of new problems, does not consume it */
+static unsigned abrt_p2_service_user_new_problems(AbrtP2Service *service,
+            uid_t uid,
+            struct abrt_p2_user_usage *usage,
+            time_t current)
+{
+    if (current < usage->new_problem_last)
+        return 0;
+
+    /* Allows Y new problems to be created in a batch but then allow only 1 new
+     * problem per Xs.
+     *
+     *  number of problems = minimum( ((last ts - current ts) / (2^magnitude)),
+     *                                (configured number))
+     */
+    const long unsigned off = current - usage->new_problem_last;
+    const unsigned throttling = abrt_p2_service_new_problem_throttling_magnitude(service, uid);
+    const long unsigned incr = (off >> throttling);
+
+    const unsigned npb = abrt_p2_service_new_problems_batch(service, uid);
+    /* Avoid overflow. Beware of adding operation inside the condition! */
+    unsigned new_problems = usage->new_problems;
+    if (   incr > npb
+        || (new_problems += incr) > npb)
+        new_problems = npb;
+
+    log_debug("NewProblem limit: last %lu, "
+              "current %lu, "
+              "increment %lu, "
+              "remaining %u",
+              (long unsigned)usage->new_problem_last,
+              (long unsigned)current,
+              incr,
+              new_problems);
+
+    return new_problems;
+}
+
 int abrt_p2_service_user_can_create_new_problem(AbrtP2Service *service,
             uid_t uid)
 {
@@ -2776,45 +3988,112 @@ int abrt_p2_service_user_can_create_new_problem(AbrtP2Service *service,
         return -1;
     }
 
+    AbrtP2Usage *usage = service->pv->p2srv_usage;
+    struct abrt_p2_user_usage *user_usage = abrt_p2_usage_get(usage, uid);
+
     const unsigned upl = abrt_p2_service_user_problems_limit(service, uid);
-    if (upl != 0 && user->problems >= upl)
-        return -E2BIG;
+    if (upl != 0 && user_usage->problems >= upl)
+    {
+        /* Problems removed behind the back of the service are not noticed,
+         * count them before refusing the user */
+        abrt_p2_usage_sync(usage);
+        if (user_usage->problems >= upl)
+            return -E2BIG;
+    }
 
-    if (current < user->new_problem_last)
+    if (current < user_usage->new_problem_last)
     {
         error_msg("The last problem was created in future: uid=%lu",
                   (long unsigned)uid);
         return -1;
     }
 
-    /* Allows Y new problems to be created in a batch but then allow only 1 new
-     * problem per Xs.
-     *
-     *  number of problems = minimum( ((last ts - current ts) / (2^magnitude)),
-     *                                (configured number))
-     */
-    const long unsigned off = current - user->new_problem_last;
-    const unsigned throttling = abrt_p2_service_new_problem_throttling_magnitude(service, uid);
-    const long unsigned incr = (off >> throttling);
+    user_usage->new_problems = abrt_p2_service_user_new_problems(service, uid, user_usage, current);
+    if (user_usage->new_problems == 0)
+        return 0;
 
-    const unsigned npb = abrt_p2_service_new_problems_batch(service, uid);
-    /* Avoid overflow. Beware of adding operation inside the condition! */
-    if (   incr > npb
-        || (user->new_problems += incr) > npb)
-        user->new_problems = npb;
+    user_usage->new_problem_last = current;
+    const unsigned remaining = user_usage->new_problems--;
+    abrt_p2_usage_save(usage);
 
-    log_debug("NewProblem limit: last %lu, "
-              "current %lu, "
-              "increment %lu, "
-              "remaining %u",
-              (long unsigned)user->new_problem_last,
-              (long unsigned)current,
-              incr,
-              user->new_problems);
+    return remaining;
+}
 
-    if (user->new_problems == 0)
-        return 0;
+GVariant *abrt_p2_service_user_usage(AbrtP2Service *service,
+            uid_t caller_uid,
+            GVariant *options,
+            GError **error)
+{
+    uid_t uid = caller_uid;
+
+    GVariantIter iter;
+    const gchar *key;
+    GVariant *value;
+    g_variant_iter_init(&iter, options);
+    while (g_variant_iter_loop(&iter, "{&sv}", &key, &value))
+    {
+        if (strcmp(key, "uid") != 0)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "Unknown option '%s'", key);
+            g_variant_unref(value);
+            return NULL;
+        }
+
+        if (!g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32))
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                        "Option 'uid' must be of type 'u'");
+            g_variant_unref(value);
+            return NULL;
+        }
+
+        uid = g_variant_get_uint32(value);
+    }
+
+    if (caller_uid != 0 && uid != caller_uid)
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                    "You are not authorized to read usage of other users");
+        return NULL;
+    }
+
+    time_t current = time(NULL);
+    struct abrt_p2_user_usage *usage = abrt_p2_usage_get(service->pv->p2srv_usage, uid);
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&builder, "{sv}", "problems",
+                          g_variant_new_uint32(usage->problems));
+    g_variant_builder_add(&builder, "{sv}", "problems_limit",
+                          g_variant_new_uint32(abrt_p2_service_user_problems_limit(service, uid)));
+    g_variant_builder_add(&builder, "{sv}", "new_problems",
+                          g_variant_new_uint32(uid == 0
+                                ? abrt_p2_service_new_problems_batch(service, uid)
+                                : abrt_p2_service_user_new_problems(service, uid, usage, current)));
+    g_variant_builder_add(&builder, "{sv}", "new_problems_batch",
+                          g_variant_new_uint32(abrt_p2_service_new_problems_batch(service, uid)));
+    g_variant_builder_add(&builder, "{sv}", "new_problem_throttling_magnitude",
+                          g_variant_new_uint32(abrt_p2_service_new_problem_throttling_magnitude(service, uid)));
+
+    return g_variant_new("(a{sv})", &builder);
+}
+
+void abrt_p2_service_notify_problem_imported(AbrtP2Service *service,
+            const char *dirname,
+            uid_t owner)
+{
+    abrt_p2_usage_problem_imported(service->pv->p2srv_usage, dirname, owner);
+}
 
-    user->new_problem_last = current;
-    return user->new_problems--;
+void abrt_p2_service_notify_problem_removed(AbrtP2Service *service,
+            const char *dirname,
+            uid_t owner)
+{
+    abrt_p2_usage_problem_removed(service->pv->p2srv_usage, dirname, owner);
+}
+
+void abrt_p2_service_save_usage(AbrtP2Service *service)
+{
+    abrt_p2_usage_flush(service->pv->p2srv_usage);
 }
@@ -105,6 +105,25 @@ void abrt_p2_service_notify_entry_object(AbrtP2Service *service,
             AbrtP2Object *obj,
             GError **error);
 
+/* Returns (a{sv}) with the problems and limits of the user, only authorized
+ * callers can read usage of other users */
+GVariant *abrt_p2_service_user_usage(AbrtP2Service *service,
+            uid_t caller_uid,
+            GVariant *options,
+            GError **error);
+
+/* Updates the problem counters of users */
+void abrt_p2_service_notify_problem_imported(AbrtP2Service *service,
+            const char *dirname,
+            uid_t owner);
+
+void abrt_p2_service_notify_problem_removed(AbrtP2Service *service,
+            const char *dirname,
+            uid_t owner);
+
+/* Writes the problem counters which are otherwise written in a while */
+void abrt_p2_service_save_usage(AbrtP2Service *service);
+
 int abrt_p2_service_user_can_create_new_problem(AbrtP2Service *service,
             uid_t uid);
 
@@ -149,6 +168,19 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             GVariant *options,
             GError **error);
 
+/* Reads the properties of the entries, opens every problem directory once */
+void abrt_p2_service_get_problems_properties_async(AbrtP2Service *service,
+            GVariant *entries,
+            GVariant *properties,
+            uid_t caller_uid,
+            GCancellable *cancellable,
+            GAsyncReadyCallback callback,
+            gpointer user_data);
+
+GVariant *abrt_p2_service_get_problems_properties_finish(AbrtP2Service *service,
+            GAsyncResult *result,
+            GError **error);
+
 GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
             GVariant *entries,
             uid_t caller_uid,
@@ -220,4 +252,10 @@ void abrt_p2_service_set_new_problems_batch(AbrtP2Service *service,
             uid_t uid,
             unsigned limit);
 
+/* Configuration option: memory for cached Entry properties, 0 disables
+ * the cache */
+void abrt_p2_service_set_property_cache_size(AbrtP2Service *service,
+            uid_t uid,
+            unsigned size);
+
 #endif/*ABRT_PROBLEMS2_SERVICE_H*/
@@ -0,0 +1,373 @@
+/*
+  Copyright (C) 2026  ABRT team
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "libabrt.h"
+#include "problem_api.h"
+#include "abrt_problems2_usage.h"
+
+#define USAGE_FILE_VERSION 2
+/* The counters change with every new problem, a crash of the service loses
+ * at most this many seconds of the throttling state */
+#define USAGE_SAVE_DELAY_S 30
+
+struct _AbrtP2Usage
+{
+    char *file_name;
+    bool loaded;
+
+    /* uid -> struct abrt_p2_user_usage */
+    GHashTable *users;
+
+    /* mtime of the dump location when the problems were counted, all
+     * problem directories changed before are included in the counters */
+    struct timespec synced;
+
+    /* Directories imported since the problems were counted */
+    GHashTable *imported;
+
+    /* Generation of the catalog read at the dump location mtime
+     * generation_mtime, see catalog_generation() */
+    bool has_generation;
+    uint64_t generation;
+    struct timespec generation_mtime;
+
+    /* The counters have changed since they were written */
+    bool dirty;
+    guint save_source;
+};
+
+static int timespec_cmp(const struct timespec *a, const struct timespec *b)
+{
+    if (a->tv_sec != b->tv_sec)
+        return a->tv_sec < b->tv_sec ? -1 : 1;
+
+    if (a->tv_nsec != b->tv_nsec)
+        return a->tv_nsec < b->tv_nsec ? -1 : 1;
+
+    return 0;
+}
+
+static int dump_location_mtime(struct timespec *mtime)
+{
+    struct stat statbuf;
+    if (stat(abrt_g_settings_dump_location, &statbuf) != 0)
+    {
+        perror_msg("Can't stat '%s'", abrt_g_settings_dump_location);
+        return -errno;
+    }
+
+    *mtime = statbuf.st_mtim;
+    return 0;
+}
+
+/* The saved counters are checked against the generation of the catalog which
+ * changes only if problems are added, removed or change owner, but also when
+ * abrtd restarts. Only the header of the catalog is read and the generation is
+ * read again only after the dump location has changed. A stale generation
+ * makes the counters be counted again on the next start, never trusted.
+ */
+static bool catalog_generation(AbrtP2Usage *usage, uint64_t *generation)
+{
+    struct timespec mtime;
+    if (dump_location_mtime(&mtime) != 0)
+        return false;
+
+    if (!usage->has_generation || timespec_cmp(&mtime, &(usage->generation_mtime)) != 0)
+    {
+        usage->has_generation = abrt_catalog_read_generation(abrt_g_settings_dump_location,
+                                                             &(usage->generation));
+        usage->generation_mtime = mtime;
+    }
+
+    *generation = usage->generation;
+    return usage->has_generation;
+}
+
+static struct abrt_p2_user_usage *usage_user(AbrtP2Usage *usage,
+            uid_t uid)
+{
+    gpointer key = GUINT_TO_POINTER((guint)uid);
+    struct abrt_p2_user_usage *user = g_hash_table_lookup(usage->users, key);
+    if (user == NULL)
+    {
+        user = g_new0(struct abrt_p2_user_usage, 1);
+        g_hash_table_insert(usage->users, key, user);
+    }
+
+    return user;
+}
+
+/* Returns true if the problem counters describe the current dump location,
+ * never without the current generation of the catalog */
+static bool usage_load_file(AbrtP2Usage *usage,
+            const uint64_t *current)
+{
+    FILE *fp = fopen(usage->file_name, "r");
+    if (fp == NULL)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't open '%s'", usage->file_name);
+        return false;
+    }
+
+    bool valid = true;
+    bool version = false;
+    bool generation = false;
+    char line[PATH_MAX + 32];
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        strchrnul(line, '\n')[0] = '\0';
+
+        int ver;
+        unsigned long long saved;
+        unsigned uid, problems, new_problems;
+        long long new_problem_last;
+
+        if (sscanf(line, "version %d", &ver) == 1)
+        {
+            if (ver != USAGE_FILE_VERSION)
+                break;
+            version = true;
+        }
+        else if (!version)
+            break;
+        else if (strncmp(line, "location ", strlen("location ")) == 0)
+        {
+            /* The throttling state does not depend on the dump location */
+            if (strcmp(line + strlen("location "), abrt_g_settings_dump_location) != 0)
+                valid = false;
+        }
+        else if (sscanf(line, "generation %llu", &saved) == 1)
+        {
+            generation = true;
+            if (current == NULL || saved != *current)
+                valid = false;
+        }
+        else if (sscanf(line, "user %u %u %u %lld", &uid, &problems,
+                        &new_problems, &new_problem_last) == 4)
+        {
+            struct abrt_p2_user_usage *user = usage_user(usage, (uid_t)uid);
+            user->problems = problems;
+            user->new_problems = new_problems;
+            user->new_problem_last = (time_t)new_problem_last;
+        }
+        else
+            log_notice("Ignoring malformed line in '%s': %s", usage->file_name, line);
+    }
+    fclose(fp);
+
+    if (!version)
+    {
+        log_notice("Ignoring '%s' with unsupported version", usage->file_name);
+        return false;
+    }
+
+    return valid && generation;
+}
+
+static void usage_load(AbrtP2Usage *usage)
+{
+    if (usage->loaded)
+        return;
+
+    usage->loaded = true;
+
+    /* The throttling state is loaded even if the problems are counted again */
+    uint64_t current;
+    const bool has_generation = catalog_generation(usage, &current);
+    if (usage_load_file(usage, has_generation ? &current : NULL)
+     && dump_location_mtime(&(usage->synced)) == 0)
+    {
+        log_debug("Using saved problem counters");
+        return;
+    }
+
+    log_info("Dump location has changed, counting problems of users");
+    abrt_p2_usage_sync(usage);
+}
+
+AbrtP2Usage *abrt_p2_usage_new(const char *file_name)
+{
+    AbrtP2Usage *usage = g_new0(AbrtP2Usage, 1);
+    usage->file_name = xstrdup(file_name);
+    usage->users = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free);
+    usage->imported = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+    return usage;
+}
+
+void abrt_p2_usage_free(AbrtP2Usage *usage)
+{
+    if (usage == NULL)
+        return;
+
+    abrt_p2_usage_flush(usage);
+
+    g_hash_table_destroy(usage->imported);
+    g_hash_table_destroy(usage->users);
+    free(usage->file_name);
+    free(usage);
+}
+
+struct abrt_p2_user_usage *abrt_p2_usage_get(AbrtP2Usage *usage,
+            uid_t uid)
+{
+    usage_load(usage);
+    return usage_user(usage, uid);
+}
+
+static int count_user_problem(const char *dir_name,
+            const struct abrt_catalog_entry *entry,
+            void *usage)
+{
+    usage_user(usage, entry->owner)->problems += 1;
+    return 0;
+}
+
+void abrt_p2_usage_sync(AbrtP2Usage *usage)
+{
+    usage->loaded = true;
+
+    /* Directories created while counting are counted when imported */
+    if (dump_location_mtime(&(usage->synced)) != 0)
+        return;
+
+    GHashTableIter iter;
+    gpointer user;
+    g_hash_table_iter_init(&iter, usage->users);
+    while (g_hash_table_iter_next(&iter, NULL, &user))
+        ((struct abrt_p2_user_usage *)user)->problems = 0;
+
+    g_hash_table_remove_all(usage->imported);
+
+    for_each_problem_entry_in_dir(abrt_g_settings_dump_location, (uid_t)-1, FOR_EACH_PROBLEM_PARALLEL,
+                                  count_user_problem, usage);
+
+    abrt_p2_usage_save(usage);
+}
+
+void abrt_p2_usage_problem_imported(AbrtP2Usage *usage,
+            const char *dirname,
+            uid_t owner)
+{
+    usage_load(usage);
+
+    if (g_hash_table_contains(usage->imported, dirname))
+        return;
+
+    struct stat statbuf;
+    if (stat(dirname, &statbuf) != 0 || !S_ISDIR(statbuf.st_mode))
+        return;
+
+    /* Moved to the dump location before the problems were counted */
+    if (timespec_cmp(&(statbuf.st_ctim), &(usage->synced)) <= 0)
+        return;
+
+    g_hash_table_add(usage->imported, xstrdup(dirname));
+    usage_user(usage, owner)->problems += 1;
+
+    abrt_p2_usage_save(usage);
+}
+
+void abrt_p2_usage_problem_removed(AbrtP2Usage *usage,
+            const char *dirname,
+            uid_t owner)
+{
+    usage_load(usage);
+
+    g_hash_table_remove(usage->imported, dirname);
+
+    struct abrt_p2_user_usage *user = usage_user(usage, owner);
+    if (user->problems > 0)
+        user->problems -= 1;
+
+    abrt_p2_usage_save(usage);
+}
+
+static void usage_write(AbrtP2Usage *usage)
+{
+    g_autofree char *tmp_name = g_strdup_printf("%s.new", usage->file_name);
+    FILE *fp = fopen(tmp_name, "w");
+    if (fp == NULL)
+    {
+        perror_msg("Can't open '%s'", tmp_name);
+        return;
+    }
+
+    fprintf(fp, "version %d\n", USAGE_FILE_VERSION);
+    fprintf(fp, "location %s\n", abrt_g_settings_dump_location);
+    /* Without the catalog the problems are counted again on the next start */
+    uint64_t current;
+    if (catalog_generation(usage, &current))
+        fprintf(fp, "generation %llu\n", (unsigned long long)current);
+
+    GHashTableIter iter;
+    gpointer uid, value;
+    g_hash_table_iter_init(&iter, usage->users);
+    while (g_hash_table_iter_next(&iter, &uid, &value))
+    {
+        const struct abrt_p2_user_usage *user = value;
+        fprintf(fp, "user %u %u %u %lld\n", GPOINTER_TO_UINT(uid), user->problems,
+                user->new_problems, (long long)user->new_problem_last);
+    }
+
+    if (ferror(fp) | fclose(fp))
+    {
+        perror_msg("Can't write '%s'", tmp_name);
+        unlink(tmp_name);
+        return;
+    }
+
+    if (rename(tmp_name, usage->file_name) != 0)
+    {
+        perror_msg("Can't rename '%s' to '%s'", tmp_name, usage->file_name);
+        unlink(tmp_name);
+    }
+}
+
+static gboolean usage_save_cb(gpointer user_data)
+{
+    AbrtP2Usage *usage = user_data;
+    usage->save_source = 0;
+
+    abrt_p2_usage_flush(usage);
+
+    return G_SOURCE_REMOVE;
+}
+
+void abrt_p2_usage_save(AbrtP2Usage *usage)
+{
+    usage->dirty = true;
+
+    if (usage->save_source == 0)
+        usage->save_source = g_timeout_add_seconds(USAGE_SAVE_DELAY_S, usage_save_cb, usage);
+}
+
+void abrt_p2_usage_flush(AbrtP2Usage *usage)
+{
+    if (usage->save_source != 0)
+    {
+        g_source_remove(usage->save_source);
+        usage->save_source = 0;
+    }
+
+    if (!usage->dirty)
+        return;
+
+    usage_write(usage);
+    usage->dirty = false;
+}
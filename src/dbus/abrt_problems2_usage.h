@@ -0,0 +1,73 @@
+/*
+  Copyright (C) 2026  ABRT team
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+  ------------------------------------------------------------------------------
+
+  This file declares the per-user accounting used by the Problems2 limits.
+
+  The number of owned problems and the new problem throttling state are kept
+  in a file which survives restarts of abrt-dbus. The problems are counted
+  again only if the generation of the catalog maintained by abrtd has changed
+  while abrt-dbus was not running, or if there is no catalog. Otherwise the
+  counters are updated from the events of the service (imported and deleted
+  problems).
+*/
+#ifndef ABRT_P2_USAGE_H
+#define ABRT_P2_USAGE_H
+
+#include <glib.h>
+#include <sys/types.h>
+#include <time.h>
+
+typedef struct _AbrtP2Usage AbrtP2Usage;
+
+struct abrt_p2_user_usage
+{
+    unsigned problems;
+    unsigned new_problems;
+    time_t new_problem_last;
+};
+
+AbrtP2Usage *abrt_p2_usage_new(const char *file_name);
+
+void abrt_p2_usage_free(AbrtP2Usage *usage);
+
+/* Loads the counters on the first call, never returns NULL */
+struct abrt_p2_user_usage *abrt_p2_usage_get(AbrtP2Usage *usage,
+            uid_t uid);
+
+/* Counts the problems in the dump location again */
+void abrt_p2_usage_sync(AbrtP2Usage *usage);
+
+/* A problem directory has been created, repeated notifications of the same
+ * directory are ignored */
+void abrt_p2_usage_problem_imported(AbrtP2Usage *usage,
+            const char *dirname,
+            uid_t owner);
+
+void abrt_p2_usage_problem_removed(AbrtP2Usage *usage,
+            const char *dirname,
+            uid_t owner);
+
+/* Writes the counters in a while, must be called after the throttling state
+ * changes */
+void abrt_p2_usage_save(AbrtP2Usage *usage);
+
+/* Writes the changed counters now, called also when usage is freed */
+void abrt_p2_usage_flush(AbrtP2Usage *usage);
+
+#endif/*ABRT_P2_USAGE_H*/
@@ -64,9 +64,34 @@ extern char *        abrt_g_settings_autoreporting_event;
 extern bool          abrt_g_settings_shortenedreporting;
 extern bool          abrt_g_settings_explorechroots;
 extern unsigned int  abrt_g_settings_debug_level;
+extern unsigned int  abrt_g_settings_server_workers;
+extern unsigned int  abrt_g_settings_max_parallel_post_create;
+extern unsigned int  abrt_g_settings_problem_scan_threads;
+/* Incremented whenever abrt.conf is read, inherited with the snapshot */
+extern unsigned int  abrt_g_settings_generation;
 
+/* Environment variable holding the snapshot of abrt.conf loaded by abrtd */
+#define ABRT_CONF_SNAPSHOT_ENV "ABRT_CONF_SNAPSHOT"
 
+/* Loads the snapshot from ABRT_CONF_SNAPSHOT_ENV if the variable is set,
+ * otherwise reads abrt.conf.
+ */
 int abrt_load_abrt_conf(void);
+/* Calls abrt_load_abrt_conf() only if the configuration has not been loaded
+ * yet or has been invalidated by abrt_invalidate_abrt_conf().
+ */
+int abrt_load_abrt_conf_cached(void);
+/* The same as abrt_load_abrt_conf_cached() but always reads abrt.conf, for
+ * abrtd which exports the snapshot to its own environment.
+ */
+int abrt_load_abrt_conf_file_cached(void);
+void abrt_invalidate_abrt_conf(void);
+/* Returns the loaded configuration in a form accepted by
+ * abrt_load_abrt_conf_snapshot() or NULL if nothing is loaded.
+ */
+const char *abrt_get_abrt_conf_snapshot(void);
+/* Does nothing if the snapshot of the same generation is already loaded */
+int abrt_load_abrt_conf_snapshot(const char *snapshot);
 void abrt_free_abrt_conf_data(void);
 
 int abrt_load_abrt_conf_file(const char *file, GHashTable *settings);
@@ -82,6 +107,141 @@ void migrate_to_xdg_dirs(void);
 
 int check_recent_crash_file(const char *filename, const char *executable);
 
+/* Index of known problems keyed by strings identifying duplicates, stored as
+ * a directory of symbolic links.
+ */
+/* Returns the problem directory of the key or NULL. */
+char *abrt_dup_index_lookup(const char *index_dir, const char *key);
+int abrt_dup_index_add(const char *index_dir, const char *key, const char *problem_dir);
+/* Removes the entry of the key only if it still points to problem_dir */
+void abrt_dup_index_remove(const char *index_dir, const char *key, const char *problem_dir);
+
+/* Index of the processed problems in the dump location used by post-create to
+ * find duplicates without opening every problem directory. The problems are
+ * grouped into buckets by uid, type and executable.
+ */
+#define ABRT_DUP_INDEX_DIR_NAME ".dup-index"
+
+/* Number of 64bit words of a backtrace fingerprint */
+#define ABRT_DUP_FINGERPRINT_WORDS 4
+/* The candidates whose fingerprint differs in more bits are not compared.
+ * Backtraces sr_distance() considers duplicates share at least 70 % of their
+ * frames and their fingerprints differ in far fewer bits (about a quarter of
+ * them when 30 % of the frames differ), so the limit leaves a wide margin.
+ */
+#define ABRT_DUP_FINGERPRINT_MAX_DISTANCE (ABRT_DUP_FINGERPRINT_WORDS * 64 * 3 / 8)
+
+struct abrt_dup_candidate
+{
+    char *dirname;      /* base name of the problem directory */
+    char *uuid;
+    char *container_id;
+    unsigned frames;    /* length of the crash thread, 0 if unknown */
+    /* Locality-sensitive hash of the crash thread, similar backtraces
+     * differ in few bits */
+    bool has_fingerprint;
+    uint64_t fingerprint[ABRT_DUP_FINGERPRINT_WORDS];
+};
+
+/* Fills the backtrace properties (frames and fingerprint) of the candidate */
+typedef void (*abrt_dup_index_describe_fn)(struct dump_dir *dd, struct abrt_dup_candidate *candidate, void *arg);
+
+struct sr_thread;
+/* Computes the SimHash of the frames of the thread from the frame properties
+ * sr_distance() compares */
+void abrt_dup_thread_fingerprint(struct sr_thread *thread, uint64_t *fingerprint);
+/* Returns the number of different bits */
+unsigned abrt_dup_fingerprint_distance(const uint64_t *fingerprint1, const uint64_t *fingerprint2);
+/* Returns the SHA-1 of the frame properties of the crash thread, the same for
+ * backtraces differing only in addresses or line numbers, or NULL if the
+ * backtrace of the problem type can't be parsed */
+char *abrt_dup_backtrace_key(const char *type, const char *backtrace);
+
+char *abrt_dup_index_bucket(const char *uid, const char *type, const char *executable);
+/* Loads everything but the backtrace properties, returns NULL if uid or type
+ * are missing */
+struct abrt_dup_candidate *abrt_dup_candidate_load(struct dump_dir *dd, char **bucket);
+void abrt_dup_candidate_free(struct abrt_dup_candidate *candidate);
+/* Returns a list of struct abrt_dup_candidate, the candidates whose directory
+ * no longer exists in dump_location are dropped from the index */
+GList *abrt_dup_index_load_bucket(const char *index_dir, const char *dump_location,
+                                  const char *bucket);
+int abrt_dup_index_add_candidate(const char *index_dir, const char *bucket,
+                                 const struct abrt_dup_candidate *candidate);
+/* Does not wait if the index is being written by someone else, the removal
+ * is then queued and carried out by the next writer. */
+void abrt_dup_index_forget_candidate(const char *index_dir, const char *dirname);
+bool abrt_dup_index_is_complete(const char *index_dir);
+/* Indexes all processed problems in the dump location */
+int abrt_dup_index_rebuild(const char *index_dir, const char *dump_location,
+                           abrt_dup_index_describe_fn describe, void *arg);
+
+/* Catalog of the problems in the dump location maintained by abrtd. The
+ * catalog is a memory mapped file holding a fixed size record per problem
+ * directory, so the problems can be listed and filtered without opening the
+ * directories. The readers do not trust the catalog if the dump location has
+ * been modified since abrtd listed it and load the entries of the directories
+ * modified since they were catalogued again.
+ */
+#define ABRT_CATALOG_DIR_NAME ".catalog.d"
+#define ABRT_CATALOG_FILE_NAME "catalog"
+
+struct abrt_catalog;
+
+struct abrt_catalog_entry
+{
+    const char *dirname;    /* base name of the problem directory */
+    /* The elements, NULL if missing */
+    const char *type;
+    const char *executable;
+    const char *component;
+    const char *duphash;
+    uid_t uid;              /* the uid element, -1 if missing */
+    /* The problem directory */
+    uid_t owner;
+    gid_t group;
+    mode_t mode;
+    time_t first_occurrence;
+    time_t last_occurrence;
+    unsigned count;
+    bool reported;
+    /* The mtime of the directory when the elements were read */
+    struct timespec mtime;
+};
+
+/* Entries with allocated strings used to write the catalog */
+struct abrt_catalog_entry *abrt_catalog_entry_new(const char *dirname, const struct stat *statbuf);
+/* Returns NULL if the directory is locked or changes while it is read */
+struct abrt_catalog_entry *abrt_catalog_entry_load(struct dump_dir *dd);
+/* Loads the entry without locking the directory */
+struct abrt_catalog_entry *abrt_catalog_entry_read(const char *dirname);
+void abrt_catalog_entry_free(struct abrt_catalog_entry *entry);
+/* Returns the value of the element stored in the catalog */
+const char *abrt_catalog_entry_element(const struct abrt_catalog_entry *entry, const char *name);
+bool abrt_catalog_has_element(const char *name);
+
+/* Replaces the catalog, entries is a list of struct abrt_catalog_entry. The
+ * entries must be the directories found in the dump location after its mtime
+ * dump_location_mtime was read at the time listed.
+ */
+int abrt_catalog_write(const char *dump_location, GList *entries, uint64_t generation,
+                       const struct timespec *dump_location_mtime, const struct timespec *listed);
+void abrt_catalog_remove(const char *dump_location);
+
+/* Returns NULL if the catalog doesn't exist or can't be trusted */
+struct abrt_catalog *abrt_catalog_open(const char *dump_location);
+void abrt_catalog_close(struct abrt_catalog *catalog);
+unsigned abrt_catalog_count(const struct abrt_catalog *catalog);
+/* Changes whenever a problem directory is added or removed or changes its
+ * owner, also when abrtd is restarted. Other changes of the entries keep it.
+ */
+uint64_t abrt_catalog_generation(const struct abrt_catalog *catalog);
+/* Reads the generation without opening the whole catalog, the records are not
+ * checked. Returns false if the catalog doesn't exist or isn't current. */
+bool abrt_catalog_read_generation(const char *dump_location, uint64_t *generation);
+/* Fills entry with pointers to the mapped catalog valid until it is closed */
+void abrt_catalog_get(const struct abrt_catalog *catalog, unsigned i, struct abrt_catalog_entry *entry);
+
 /* Returns 1 if abrtd daemon is running, 0 otherwise. */
 int abrt_daemon_is_ok(void);
 
@@ -102,12 +262,25 @@ wait for the reply
 */
 int abrt_notify_new_path_with_response(const char *path, char **message);
 
+/* A set of strings searched in a single pass over the data, the cost does not
+ * depend on the number of the strings. The data match if they contain any of
+ * the strings and none of the blacklisted strings. The strings are not needed
+ * after the set is created.
+ */
+struct abrt_pattern_set;
+struct abrt_pattern_set *abrt_pattern_set_new(GList *strings, GList *blacklisted_strings);
+void abrt_pattern_set_free(struct abrt_pattern_set *set);
+bool abrt_pattern_set_match(const struct abrt_pattern_set *set, const char *data, size_t length);
+bool abrt_pattern_set_match_str(const struct abrt_pattern_set *set, const char *str);
+
 /* Note: should be public since unit tests need to call it */
 char *abrt_koops_extract_version(const char *line);
 char *abrt_kernel_tainted_short(const char *kernel_bt);
 char *abrt_kernel_tainted_long(const char *tainted_short);
 char *abrt_koops_hash_str_ext(const char *oops_buf, int frame_count, int duphas_flags);
 char *abrt_koops_hash_str(const char *oops_buf);
+/* Returns true if the line can be a part of a call trace */
+bool abrt_koops_line_is_call_trace(const char *line);
 
 
 int abrt_koops_line_skip_level(const char **c);
@@ -45,6 +45,54 @@ int for_each_problem_in_dir(const char *path,
                         for_each_problem_in_dir_callback callback,
                         void *arg);
 
+/*
+ * Opens and checks the dump directories on a pool of threads (see
+ * ProblemScanThreads in abrt.conf). @callback is still called on the calling
+ * thread and in the same order as without the flag.
+ */
+#define FOR_EACH_PROBLEM_PARALLEL (1 << 0)
+
+/*
+ * The same as @for_each_problem_in_dir with FOR_EACH_PROBLEM_* @flags.
+ */
+int for_each_problem_in_dir_ext(const char *path,
+                        uid_t caller_uid,
+                        int flags,
+                        for_each_problem_in_dir_callback callback,
+                        void *arg);
+
+/*
+ * Function called for each problem in @for_each_problem_entry_in_dir
+ *
+ * @param dir_name Full path to the problem directory
+ * @param entry Catalog entry of the problem, valid only during the call
+ * @param arg User's arguments
+ * @returns 0 if everything is OK, a non zero value in order to break the iterator
+ */
+typedef int (* for_each_problem_entry_in_dir_callback)(const char *dir_name,
+                        const struct abrt_catalog_entry *entry,
+                        void *arg);
+
+/*
+ * Iterates over the entries of the catalog of @path maintained by abrtd (see
+ * abrt_catalog_open()) and calls @callback without opening the problem
+ * directories. If the catalog is not available, the entries are loaded from
+ * the dump directories the same way as @for_each_problem_in_dir does.
+ *
+ * @param path Dump directories location
+ * @param caller_uid UID for access check. -1 for disabling this check
+ * @param flags FOR_EACH_PROBLEM_* flags used when reading the directories
+ * @param callback Called for each applicable problem. Non zero
+ * value returned from @callback will breaks the iteration.
+ * @param arg User's arguments passed to @callback
+ * @returns 0 or the first non zero value returned from @callback
+ */
+int for_each_problem_entry_in_dir(const char *path,
+                        uid_t caller_uid,
+                        int flags,
+                        for_each_problem_entry_in_dir_callback callback,
+                        void *arg);
+
 /* Retrieves the list of directories currently used as a problem storage
  * The result must be freed by caller
  * @returns List of strings representing the full path to dirs
@@ -52,6 +100,11 @@ int for_each_problem_in_dir(const char *path,
 GList *get_problem_storages(void);
 GList *get_problem_dirs_for_uid(uid_t uid, const char *dump_location);
 
+/*
+ * The same as @get_problem_dirs_for_uid with FOR_EACH_PROBLEM_* @flags.
+ */
+GList *get_problem_dirs_for_uid_ext(uid_t uid, const char *dump_location, int flags);
+
 /*
  * Gets list of problem directories not accessible by user
  *
@@ -61,6 +114,12 @@ GList *get_problem_dirs_for_uid(uid_t uid, const char *dump_location);
  */
 GList *get_problem_dirs_not_accessible_by_uid(uid_t uid, const char *dump_location);
 
+/*
+ * The same as @get_problem_dirs_not_accessible_by_uid with
+ * FOR_EACH_PROBLEM_* @flags.
+ */
+GList *get_problem_dirs_not_accessible_by_uid_ext(uid_t uid, const char *dump_location, int flags);
+
 
 /*
  * Checks if problem dump directory contains all necessary data
@@ -29,9 +29,25 @@ char *        abrt_g_settings_autoreporting_event = NULL;
 bool          abrt_g_settings_shortenedreporting = 0;
 bool          abrt_g_settings_explorechroots = 0;
 unsigned int  abrt_g_settings_debug_level = 0;
+unsigned int  abrt_g_settings_server_workers = 0;
+unsigned int  abrt_g_settings_max_parallel_post_create = 1;
+unsigned int  abrt_g_settings_problem_scan_threads = 0;
+unsigned int  abrt_g_settings_generation = 0;
+
+/* The loaded settings serialized by settings_to_snapshot() */
+static char *s_abrt_conf_snapshot;
+/* The snapshot was loaded by abrt_load_abrt_conf_snapshot() */
+static bool s_abrt_conf_from_snapshot;
+/* See abrt_load_abrt_conf_cached() */
+static bool s_abrt_conf_stale = true;
 
 void abrt_free_abrt_conf_data()
 {
+    free(s_abrt_conf_snapshot);
+    s_abrt_conf_snapshot = NULL;
+    s_abrt_conf_from_snapshot = false;
+    s_abrt_conf_stale = true;
+
     free(abrt_g_settings_sWatchCrashdumpArchiveDir);
     abrt_g_settings_sWatchCrashdumpArchiveDir = NULL;
 
@@ -156,6 +172,45 @@ static void ParseCommon(GHashTable *settings, const char *conf_filename)
         g_hash_table_remove(settings, "DebugLevel");
     }
 
+    value = g_hash_table_lookup(settings, "ServerWorkers");
+    if (value)
+    {
+        char *end;
+        errno = 0;
+        unsigned long ul = strtoul((char *)value, &end, 10);
+        if (errno || end == value || *end != '\0' || ul > INT_MAX)
+            error_msg("Error parsing %s setting: '%s'", "ServerWorkers", (char *)value);
+        else
+            abrt_g_settings_server_workers = ul;
+        g_hash_table_remove(settings, "ServerWorkers");
+    }
+
+    value = g_hash_table_lookup(settings, "MaxParallelPostCreate");
+    if (value)
+    {
+        char *end;
+        errno = 0;
+        unsigned long ul = strtoul((char *)value, &end, 10);
+        if (errno || end == value || *end != '\0' || ul > INT_MAX || ul == 0)
+            error_msg("Error parsing %s setting: '%s'", "MaxParallelPostCreate", (char *)value);
+        else
+            abrt_g_settings_max_parallel_post_create = ul;
+        g_hash_table_remove(settings, "MaxParallelPostCreate");
+    }
+
+    value = g_hash_table_lookup(settings, "ProblemScanThreads");
+    if (value)
+    {
+        char *end;
+        errno = 0;
+        unsigned long ul = strtoul((char *)value, &end, 10);
+        if (errno || end == value || *end != '\0' || ul > INT_MAX)
+            error_msg("Error parsing %s setting: '%s'", "ProblemScanThreads", (char *)value);
+        else
+            abrt_g_settings_problem_scan_threads = ul;
+        g_hash_table_remove(settings, "ProblemScanThreads");
+    }
+
     GHashTableIter iter;
     gpointer name;
     g_hash_table_iter_init(&iter, settings);
@@ -171,7 +226,28 @@ static const char *get_abrt_conf_file_name(void)
     return abrt_conf == NULL ? ABRT_CONF : abrt_conf;
 }
 
-int abrt_load_abrt_conf()
+/* The snapshot format is:
+ *   GENERATION\n
+ *   NAME=VALUE\n
+ *   ...
+ * Values of abrt.conf cannot contain new lines.
+ */
+static char *settings_to_snapshot(unsigned generation, GHashTable *settings)
+{
+    GString *snapshot = g_string_new(NULL);
+    g_string_append_printf(snapshot, "%u\n", generation);
+
+    GHashTableIter iter;
+    gpointer name;
+    gpointer value;
+    g_hash_table_iter_init(&iter, settings);
+    while (g_hash_table_iter_next(&iter, &name, &value))
+        g_string_append_printf(snapshot, "%s=%s\n", (char *)name, (char *)value);
+
+    return g_string_free(snapshot, FALSE);
+}
+
+static int load_abrt_conf_from_file(void)
 {
     abrt_free_abrt_conf_data();
 
@@ -180,11 +256,98 @@ int abrt_load_abrt_conf()
     if (!abrt_load_abrt_conf_file(abrt_conf, settings))
         perror_msg("Can't load '%s'", abrt_conf);
 
+    ++abrt_g_settings_generation;
+    /* Before ParseCommon() because it removes the recognized settings */
+    s_abrt_conf_snapshot = settings_to_snapshot(abrt_g_settings_generation, settings);
+    s_abrt_conf_stale = false;
+
     ParseCommon(settings, abrt_conf);
 
     return 0;
 }
 
+int abrt_load_abrt_conf()
+{
+    /* Processes started by abrtd inherit its configuration */
+    const char *const snapshot = getenv(ABRT_CONF_SNAPSHOT_ENV);
+    if (snapshot != NULL && abrt_load_abrt_conf_snapshot(snapshot) == 0)
+        return 0;
+
+    return load_abrt_conf_from_file();
+}
+
+int abrt_load_abrt_conf_cached(void)
+{
+    if (!s_abrt_conf_stale)
+        return 0;
+
+    return abrt_load_abrt_conf();
+}
+
+int abrt_load_abrt_conf_file_cached(void)
+{
+    if (!s_abrt_conf_stale && !s_abrt_conf_from_snapshot)
+        return 0;
+
+    return load_abrt_conf_from_file();
+}
+
+void abrt_invalidate_abrt_conf(void)
+{
+    s_abrt_conf_stale = true;
+}
+
+const char *abrt_get_abrt_conf_snapshot(void)
+{
+    return s_abrt_conf_snapshot;
+}
+
+int abrt_load_abrt_conf_snapshot(const char *snapshot)
+{
+    char *end;
+    errno = 0;
+    unsigned long generation = strtoul(snapshot, &end, 10);
+    if (errno || end == snapshot || *end != '\n' || generation > UINT_MAX)
+    {
+        error_msg("Malformed configuration snapshot");
+        return -1;
+    }
+
+    if (s_abrt_conf_from_snapshot && !s_abrt_conf_stale && generation == abrt_g_settings_generation)
+    {
+        log_debug("Configuration generation %lu is already loaded", generation);
+        return 0;
+    }
+
+    g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    for (const char *line = end + 1; *line != '\0'; )
+    {
+        const char *eol = strchrnul(line, '\n');
+        const char *eq = memchr(line, '=', eol - line);
+        if (eq == NULL)
+        {
+            error_msg("Malformed configuration snapshot");
+            return -1;
+        }
+
+        g_hash_table_replace(settings, g_strndup(line, eq - line), g_strndup(eq + 1, eol - eq - 1));
+        line = *eol != '\0' ? eol + 1 : eol;
+    }
+
+    /* The snapshot might be the one returned by abrt_get_abrt_conf_snapshot() */
+    char *const copy = g_strdup(snapshot);
+    abrt_free_abrt_conf_data();
+
+    abrt_g_settings_generation = generation;
+    s_abrt_conf_snapshot = copy;
+    s_abrt_conf_from_snapshot = true;
+    s_abrt_conf_stale = false;
+
+    ParseCommon(settings, "configuration snapshot");
+
+    return 0;
+}
+
 int abrt_load_abrt_conf_file(const char *file, GHashTable *settings)
 {
     const char *env_conf_dir = getenv("ABRT_CONF_DIR");
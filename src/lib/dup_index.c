@@ -0,0 +1,727 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <inttypes.h>
+#include <sys/file.h>
+#include <satyr/abrt.h>
+#include <satyr/frame.h>
+#include <satyr/stacktrace.h>
+#include <satyr/thread.h>
+#include <satyr/core/frame.h>
+#include <satyr/java/frame.h>
+#include <satyr/koops/frame.h>
+#include <satyr/python/frame.h>
+#include <satyr/ruby/frame.h>
+#include "libabrt.h"
+#include "problem_api.h"
+
+/* The index is a directory of symbolic links named after the SHA-1 of the
+ * key and pointing to the problem directory. The links are replaced
+ * atomically, hence readers never see a half written entry and nothing has
+ * to be repaired if a writer dies.
+ */
+
+/* Replaces path with a symbolic link to target */
+static int replace_symlink(const char *target, const char *path)
+{
+    g_autofree char *tmp_path = g_strdup_printf("%s.%d.new", path, (int)getpid());
+
+    unlink(tmp_path);
+    if (symlink(target, tmp_path) != 0)
+    {
+        perror_msg("Can't create '%s'", tmp_path);
+        return -1;
+    }
+
+    if (rename(tmp_path, path) != 0)
+    {
+        perror_msg("Can't rename '%s' to '%s'", tmp_path, path);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static char *dup_index_entry_path(const char *index_dir, const char *key)
+{
+    g_autofree char *name = g_compute_checksum_for_string(G_CHECKSUM_SHA1, key, -1);
+    return g_build_filename(index_dir, name, NULL);
+}
+
+char *abrt_dup_index_lookup(const char *index_dir, const char *key)
+{
+    g_autofree char *path = dup_index_entry_path(index_dir, key);
+    return g_file_read_link(path, NULL);
+}
+
+int abrt_dup_index_add(const char *index_dir, const char *key, const char *problem_dir)
+{
+    if (g_mkdir_with_parents(index_dir, 0700) != 0)
+    {
+        perror_msg("Can't create directory '%s'", index_dir);
+        return -1;
+    }
+
+    g_autofree char *path = dup_index_entry_path(index_dir, key);
+    return replace_symlink(problem_dir, path);
+}
+
+void abrt_dup_index_remove(const char *index_dir, const char *key, const char *problem_dir)
+{
+    g_autofree char *path = dup_index_entry_path(index_dir, key);
+
+    /* Someone might have replaced the entry in the meantime */
+    g_autofree char *target = g_file_read_link(path, NULL);
+    if (target == NULL || strcmp(target, problem_dir) != 0)
+        return;
+
+    if (unlink(path) != 0 && errno != ENOENT)
+        perror_msg("Can't remove '%s'", path);
+}
+
+/* The index of duplicate candidates used by post-create has this layout:
+ *   buckets/<SHA-1 of uid, type and executable>/<problem directory>
+ *                                               - key file with uuid,
+ *                                                 container_id, frames and
+ *                                                 fingerprint
+ *   dirs/<problem directory>                    - link to its bucket
+ *   forgotten/<problem directory>               - removal waiting for the
+ *                                                 lock
+ *   complete                                    - format version, written
+ *                                                 once the index is built
+ *   lock                                        - serializes the writers
+ * Adding or removing a candidate touches only its own file, however many
+ * candidates the bucket has. Readers don't take the lock, the candidate files
+ * are replaced atomically and their temporary names start with a dot. They
+ * drop the candidates whose directory no longer exists, so an index
+ * missing some removals never makes post-create open a deleted directory.
+ */
+#define DUP_INDEX_VERSION  "4"
+#define DUP_INDEX_BUCKETS  "buckets"
+#define DUP_INDEX_DIRS     "dirs"
+#define DUP_INDEX_FORGOTTEN "forgotten"
+#define DUP_INDEX_COMPLETE "complete"
+#define DUP_INDEX_LOCK     "lock"
+#define DUP_INDEX_CANDIDATE_GROUP "candidate"
+
+/* Returns the descriptor holding the lock or -1 */
+static int lock_dup_index(const char *index_dir, bool wait)
+{
+    g_autofree char *buckets = g_build_filename(index_dir, DUP_INDEX_BUCKETS, NULL);
+    g_autofree char *dirs = g_build_filename(index_dir, DUP_INDEX_DIRS, NULL);
+    g_autofree char *forgotten = g_build_filename(index_dir, DUP_INDEX_FORGOTTEN, NULL);
+    if (g_mkdir_with_parents(buckets, 0700) != 0 || g_mkdir_with_parents(dirs, 0700) != 0
+     || g_mkdir_with_parents(forgotten, 0700) != 0)
+    {
+        perror_msg("Can't create directory '%s'", index_dir);
+        return -1;
+    }
+
+    g_autofree char *path = g_build_filename(index_dir, DUP_INDEX_LOCK, NULL);
+    const int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        perror_msg("Can't open '%s'", path);
+        return -1;
+    }
+
+    if (flock(fd, LOCK_EX | (wait ? 0 : LOCK_NB)) != 0)
+    {
+        if (wait || errno != EWOULDBLOCK)
+            perror_msg("Can't lock '%s'", path);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void unlock_dup_index(int lock_fd)
+{
+    close(lock_fd);
+}
+
+static char *bucket_path(const char *index_dir, const char *bucket)
+{
+    return g_build_filename(index_dir, DUP_INDEX_BUCKETS, bucket, NULL);
+}
+
+static char *candidate_path(const char *index_dir, const char *bucket, const char *dirname)
+{
+    return g_build_filename(index_dir, DUP_INDEX_BUCKETS, bucket, dirname, NULL);
+}
+
+static void set_candidate(GKeyFile *kf, const struct abrt_dup_candidate *candidate)
+{
+    g_key_file_set_integer(kf, DUP_INDEX_CANDIDATE_GROUP, "frames", candidate->frames);
+    if (candidate->uuid != NULL)
+        g_key_file_set_string(kf, DUP_INDEX_CANDIDATE_GROUP, "uuid", candidate->uuid);
+    if (candidate->container_id != NULL)
+        g_key_file_set_string(kf, DUP_INDEX_CANDIDATE_GROUP, "container_id", candidate->container_id);
+    if (candidate->has_fingerprint)
+    {
+        char hex[ABRT_DUP_FINGERPRINT_WORDS * 16 + 1];
+        for (unsigned i = 0; i < ABRT_DUP_FINGERPRINT_WORDS; i++)
+            sprintf(hex + i * 16, "%016"PRIx64, candidate->fingerprint[i]);
+        g_key_file_set_string(kf, DUP_INDEX_CANDIDATE_GROUP, "fingerprint", hex);
+    }
+}
+
+/* Writes the key file of the candidate, the lock must be held */
+static int save_candidate(const char *index_dir, const char *bucket,
+                          const struct abrt_dup_candidate *candidate)
+{
+    g_autofree char *bucket_dir = bucket_path(index_dir, bucket);
+    if (g_mkdir_with_parents(bucket_dir, 0700) != 0)
+    {
+        perror_msg("Can't create directory '%s'", bucket_dir);
+        return -1;
+    }
+
+    g_autoptr(GKeyFile) kf = g_key_file_new();
+    set_candidate(kf, candidate);
+    gsize len = 0;
+    g_autofree char *data = g_key_file_to_data(kf, &len, NULL);
+
+    /* Hidden from the readers until renamed */
+    g_autofree char *tmp_name = g_strdup_printf(".%s.%d.new", candidate->dirname, (int)getpid());
+    g_autofree char *tmp_path = g_build_filename(bucket_dir, tmp_name, NULL);
+    g_autofree char *path = g_build_filename(bucket_dir, candidate->dirname, NULL);
+    GError *error = NULL;
+    if (!g_file_set_contents(tmp_path, data, len, &error))
+    {
+        error_msg("Can't save '%s': %s", tmp_path, error->message);
+        g_error_free(error);
+        return -1;
+    }
+
+    if (rename(tmp_path, path) != 0)
+    {
+        perror_msg("Can't rename '%s' to '%s'", tmp_path, path);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static bool parse_fingerprint(const char *hex, uint64_t *fingerprint)
+{
+    if (hex == NULL || strlen(hex) != ABRT_DUP_FINGERPRINT_WORDS * 16)
+        return false;
+
+    for (unsigned i = 0; i < ABRT_DUP_FINGERPRINT_WORDS; i++)
+    {
+        char word[17];
+        memcpy(word, hex + i * 16, 16);
+        word[16] = '\0';
+
+        char *end;
+        fingerprint[i] = g_ascii_strtoull(word, &end, 16);
+        if (*end != '\0')
+            return false;
+    }
+
+    return true;
+}
+
+static struct abrt_dup_candidate *load_candidate(const char *index_dir, const char *bucket,
+                                                 const char *dirname)
+{
+    g_autofree char *path = candidate_path(index_dir, bucket, dirname);
+    g_autoptr(GKeyFile) kf = g_key_file_new();
+    /* Removed in the meantime */
+    if (!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL))
+        return NULL;
+
+    struct abrt_dup_candidate *candidate = g_new0(struct abrt_dup_candidate, 1);
+    candidate->dirname = g_strdup(dirname);
+    candidate->uuid = g_key_file_get_string(kf, DUP_INDEX_CANDIDATE_GROUP, "uuid", NULL);
+    candidate->container_id = g_key_file_get_string(kf, DUP_INDEX_CANDIDATE_GROUP, "container_id", NULL);
+    const int frames = g_key_file_get_integer(kf, DUP_INDEX_CANDIDATE_GROUP, "frames", NULL);
+    candidate->frames = frames > 0 ? frames : 0;
+    g_autofree char *fingerprint = g_key_file_get_string(kf, DUP_INDEX_CANDIDATE_GROUP, "fingerprint", NULL);
+    candidate->has_fingerprint = parse_fingerprint(fingerprint, candidate->fingerprint);
+    return candidate;
+}
+
+static uint64_t hash_frame(const char *str, uint64_t seed)
+{
+    /* FNV-1a */
+    uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+    for (; *str != '\0'; ++str)
+    {
+        hash ^= (unsigned char)*str;
+        hash *= 0x100000001b3ULL;
+    }
+
+    /* FNV doesn't mix the high bits well, finish with the splitmix64 mixer */
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+/* The frame types frame_key() knows */
+static bool frame_type_is_known(enum sr_report_type type)
+{
+    switch (type)
+    {
+        case SR_REPORT_CORE:
+        case SR_REPORT_PYTHON:
+        case SR_REPORT_KERNELOOPS:
+        case SR_REPORT_JAVA:
+        case SR_REPORT_RUBY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Builds the string hashed for the frame from what sr_frame_cmp_distance()
+ * compares, frames equal for sr_distance() must get the same string. The
+ * addresses and line numbers shown by sr_frame_append_to_str() differ
+ * between occurrences of the same problem and are left out. All frames of
+ * the types not known here get the same string, which lets every candidate
+ * through the filter.
+ */
+static void frame_key(struct sr_frame *frame, GString *key)
+{
+    const char *function_name = NULL;
+    switch (frame->type)
+    {
+        case SR_REPORT_CORE:
+        {
+            struct sr_core_frame *core_frame = (struct sr_core_frame *)frame;
+            /* Frames without the function name are compared by the place in
+             * the binary */
+            if (core_frame->function_name == NULL)
+            {
+                g_string_printf(key, "b:%s+%"PRIx64,
+                                core_frame->build_id ? core_frame->build_id : "",
+                                core_frame->build_id_offset);
+                return;
+            }
+            function_name = core_frame->function_name;
+            break;
+        }
+        case SR_REPORT_PYTHON:
+            function_name = ((struct sr_python_frame *)frame)->function_name;
+            break;
+        case SR_REPORT_KERNELOOPS:
+            function_name = ((struct sr_koops_frame *)frame)->function_name;
+            break;
+        case SR_REPORT_JAVA:
+            function_name = ((struct sr_java_frame *)frame)->name;
+            break;
+        case SR_REPORT_RUBY:
+            function_name = ((struct sr_ruby_frame *)frame)->function_name;
+            break;
+        default:
+            break;
+    }
+
+    g_string_printf(key, "f:%s", function_name ? function_name : "");
+}
+
+/* SimHash of the frames of the thread: every frame votes for every bit of the
+ * fingerprint by the corresponding bit of its hash, so the fingerprints of
+ * threads sharing most of their frames differ in few bits.
+ */
+void abrt_dup_thread_fingerprint(struct sr_thread *thread, uint64_t *fingerprint)
+{
+    static const uint64_t seeds[ABRT_DUP_FINGERPRINT_WORDS] = {
+        0x0, 0x9e3779b97f4a7c15ULL, 0x3c6ef372fe94f82aULL, 0xdaa66d2c7ddf743fULL,
+    };
+
+    int votes[ABRT_DUP_FINGERPRINT_WORDS * 64] = { 0 };
+    g_autoptr(GString) key = g_string_new(NULL);
+
+    for (struct sr_frame *frame = sr_thread_frames(thread); frame != NULL; frame = sr_frame_next(frame))
+    {
+        frame_key(frame, key);
+
+        for (unsigned word = 0; word < ABRT_DUP_FINGERPRINT_WORDS; word++)
+        {
+            const uint64_t hash = hash_frame(key->str, seeds[word]);
+            for (unsigned bit = 0; bit < 64; bit++)
+                votes[word * 64 + bit] += (hash >> bit) & 1 ? 1 : -1;
+        }
+    }
+
+    for (unsigned word = 0; word < ABRT_DUP_FINGERPRINT_WORDS; word++)
+    {
+        fingerprint[word] = 0;
+        for (unsigned bit = 0; bit < 64; bit++)
+            if (votes[word * 64 + bit] > 0)
+                fingerprint[word] |= 1ULL << bit;
+    }
+}
+
+char *abrt_dup_backtrace_key(const char *type, const char *backtrace)
+{
+    /* The frames of the other types would all get the same key */
+    const enum sr_report_type report_type = sr_abrt_type_from_type(type);
+    if (!frame_type_is_known(report_type))
+        return NULL;
+
+    char *error_message;
+    struct sr_stacktrace *stacktrace = sr_stacktrace_parse(report_type, backtrace, &error_message);
+    if (stacktrace == NULL)
+    {
+        log_debug("Can't parse the backtrace: %s", error_message);
+        free(error_message);
+        return NULL;
+    }
+
+    char *retval = NULL;
+    struct sr_thread *thread = sr_stacktrace_find_crash_thread(stacktrace);
+    if (thread != NULL && sr_thread_frames(thread) != NULL)
+    {
+        GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA1);
+        g_autoptr(GString) key = g_string_new(NULL);
+        for (struct sr_frame *frame = sr_thread_frames(thread); frame != NULL; frame = sr_frame_next(frame))
+        {
+            frame_key(frame, key);
+            /* Including the terminating zero as the separator */
+            g_checksum_update(checksum, (const guchar *)key->str, key->len + 1);
+        }
+
+        retval = g_strdup(g_checksum_get_string(checksum));
+        g_checksum_free(checksum);
+    }
+
+    sr_stacktrace_free(stacktrace);
+    return retval;
+}
+
+unsigned abrt_dup_fingerprint_distance(const uint64_t *fingerprint1, const uint64_t *fingerprint2)
+{
+    /* Compiled to the popcount instruction where available */
+    unsigned distance = 0;
+    for (unsigned i = 0; i < ABRT_DUP_FINGERPRINT_WORDS; i++)
+        distance += __builtin_popcountll(fingerprint1[i] ^ fingerprint2[i]);
+
+    return distance;
+}
+
+static int link_candidate(const char *index_dir, const char *bucket, const char *dirname)
+{
+    g_autofree char *path = g_build_filename(index_dir, DUP_INDEX_DIRS, dirname, NULL);
+    return replace_symlink(bucket, path);
+}
+
+char *abrt_dup_index_bucket(const char *uid, const char *type, const char *executable)
+{
+    /* A problem without executable is never a duplicate of one with it */
+    g_autofree char *key = g_strdup_printf("%s\n%s\n%c%s",
+                                           uid, type,
+                                           executable != NULL ? '+' : '-',
+                                           executable != NULL ? executable : "");
+    return g_compute_checksum_for_string(G_CHECKSUM_SHA1, key, -1);
+}
+
+struct abrt_dup_candidate *abrt_dup_candidate_load(struct dump_dir *dd, char **bucket)
+{
+    const int flags = DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE;
+    g_autofree char *uid = dd_load_text_ext(dd, FILENAME_UID, flags);
+    g_autofree char *type = dd_load_text_ext(dd, FILENAME_TYPE, flags);
+    if (uid == NULL || type == NULL)
+        return NULL;
+
+    g_autofree char *executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, flags);
+    *bucket = abrt_dup_index_bucket(uid, type, executable);
+
+    struct abrt_dup_candidate *candidate = g_new0(struct abrt_dup_candidate, 1);
+    candidate->dirname = g_path_get_basename(dd->dd_dirname);
+    candidate->uuid = dd_load_text_ext(dd, FILENAME_UUID, flags);
+    candidate->container_id = dd_load_text_ext(dd, FILENAME_CONTAINER_ID, flags);
+    return candidate;
+}
+
+void abrt_dup_candidate_free(struct abrt_dup_candidate *candidate)
+{
+    if (candidate == NULL)
+        return;
+
+    free(candidate->dirname);
+    free(candidate->uuid);
+    free(candidate->container_id);
+    free(candidate);
+}
+
+GList *abrt_dup_index_load_bucket(const char *index_dir, const char *dump_location,
+                                  const char *bucket)
+{
+    g_autofree char *bucket_dir = bucket_path(index_dir, bucket);
+    /* A missing bucket is empty */
+    DIR *dp = opendir(bucket_dir);
+    if (dp == NULL)
+        return NULL;
+
+    GList *candidates = NULL;
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        /* Skip ".", ".." and the files being written */
+        if (dent->d_name[0] == '.')
+            continue;
+
+        /* The removal of a deleted directory might have been missed */
+        g_autofree char *path = g_build_filename(dump_location, dent->d_name, NULL);
+        struct stat st;
+        if (lstat(path, &st) != 0 && errno == ENOENT)
+        {
+            log_debug("Dropping stale duplicate candidate '%s'", dent->d_name);
+            abrt_dup_index_forget_candidate(index_dir, dent->d_name);
+            continue;
+        }
+
+        struct abrt_dup_candidate *candidate = load_candidate(index_dir, bucket, dent->d_name);
+        if (candidate != NULL)
+            candidates = g_list_prepend(candidates, candidate);
+    }
+    closedir(dp);
+
+    return g_list_reverse(candidates);
+}
+
+/* Removes the candidate from its bucket, the lock must be held */
+static void remove_candidate(const char *index_dir, const char *dirname)
+{
+    g_autofree char *link_path = g_build_filename(index_dir, DUP_INDEX_DIRS, dirname, NULL);
+    g_autofree char *bucket = g_file_read_link(link_path, NULL);
+    if (bucket == NULL)
+        return;
+
+    g_autofree char *path = candidate_path(index_dir, bucket, dirname);
+    if (unlink(path) != 0 && errno != ENOENT)
+        perror_msg("Can't remove '%s'", path);
+
+    /* Fails if other candidates are left */
+    g_autofree char *bucket_dir = bucket_path(index_dir, bucket);
+    rmdir(bucket_dir);
+
+    unlink(link_path);
+}
+
+/* Carries out the removals queued while someone else held the lock, the lock
+ * must be held */
+static void remove_forgotten_candidates(const char *index_dir)
+{
+    g_autofree char *path = g_build_filename(index_dir, DUP_INDEX_FORGOTTEN, NULL);
+    DIR *dp = opendir(path);
+    if (dp == NULL)
+        return;
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (libreport_dot_or_dotdot(dent->d_name))
+            continue;
+
+        remove_candidate(index_dir, dent->d_name);
+        unlinkat(dirfd(dp), dent->d_name, 0);
+    }
+    closedir(dp);
+}
+
+int abrt_dup_index_add_candidate(const char *index_dir, const char *bucket,
+                                 const struct abrt_dup_candidate *candidate)
+{
+    const int lock_fd = lock_dup_index(index_dir, /*wait*/true);
+    if (lock_fd < 0)
+        return -1;
+
+    /* Before adding, the problem directory might have got the name of a
+     * deleted one */
+    remove_forgotten_candidates(index_dir);
+
+    int r = save_candidate(index_dir, bucket, candidate);
+    if (r == 0)
+        r = link_candidate(index_dir, bucket, candidate->dirname);
+
+    unlock_dup_index(lock_fd);
+    return r;
+}
+
+void abrt_dup_index_forget_candidate(const char *index_dir, const char *dirname)
+{
+    g_autofree char *link_path = g_build_filename(index_dir, DUP_INDEX_DIRS, dirname, NULL);
+
+    /* Most of the deleted directories are not in the index */
+    g_autofree char *bucket = g_file_read_link(link_path, NULL);
+    if (bucket == NULL)
+        return;
+
+    /* Don't wait for a rebuild, leave the removal to the holder of the lock
+     * instead */
+    int lock_fd = lock_dup_index(index_dir, /*wait*/false);
+    if (lock_fd < 0)
+    {
+        g_autofree char *path = g_build_filename(index_dir, DUP_INDEX_FORGOTTEN, dirname, NULL);
+        const int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0)
+        {
+            perror_msg("Can't queue removal of '%s' from the duplicate index", dirname);
+            return;
+        }
+        close(fd);
+
+        /* The holder might have finished before seeing the queued removal */
+        lock_fd = lock_dup_index(index_dir, /*wait*/false);
+        if (lock_fd < 0)
+            return;
+    }
+    else
+        remove_candidate(index_dir, dirname);
+
+    remove_forgotten_candidates(index_dir);
+    unlock_dup_index(lock_fd);
+}
+
+bool abrt_dup_index_is_complete(const char *index_dir)
+{
+    g_autofree char *path = g_build_filename(index_dir, DUP_INDEX_COMPLETE, NULL);
+    g_autofree char *version = NULL;
+    if (!g_file_get_contents(path, &version, NULL, NULL))
+        return false;
+
+    return strcmp(version, DUP_INDEX_VERSION) == 0;
+}
+
+static void remove_dir_entries(const char *path)
+{
+    DIR *dp = opendir(path);
+    if (dp == NULL)
+        return;
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        if (libreport_dot_or_dotdot(dent->d_name))
+            continue;
+
+        /* The bucket directories */
+        if (unlinkat(dirfd(dp), dent->d_name, 0) != 0 && (errno == EISDIR || errno == EPERM))
+        {
+            g_autofree char *subdir = g_build_filename(path, dent->d_name, NULL);
+            remove_dir_entries(subdir);
+            unlinkat(dirfd(dp), dent->d_name, AT_REMOVEDIR);
+        }
+    }
+    closedir(dp);
+}
+
+int abrt_dup_index_rebuild(const char *index_dir, const char *dump_location,
+                           abrt_dup_index_describe_fn describe, void *arg)
+{
+    const int lock_fd = lock_dup_index(index_dir, /*wait*/true);
+    if (lock_fd < 0)
+        return -1;
+
+    /* Someone else might have been rebuilding the index while we waited */
+    if (abrt_dup_index_is_complete(index_dir))
+    {
+        unlock_dup_index(lock_fd);
+        return 0;
+    }
+
+    log_notice("Building duplicate index of '%s'", dump_location);
+
+    g_autofree char *buckets_dir = g_build_filename(index_dir, DUP_INDEX_BUCKETS, NULL);
+    g_autofree char *dirs_dir = g_build_filename(index_dir, DUP_INDEX_DIRS, NULL);
+    g_autofree char *forgotten_dir = g_build_filename(index_dir, DUP_INDEX_FORGOTTEN, NULL);
+    remove_dir_entries(buckets_dir);
+    remove_dir_entries(dirs_dir);
+    /* Only the existing directories get to the new index */
+    remove_dir_entries(forgotten_dir);
+
+    DIR *dp = opendir(dump_location);
+    if (dp == NULL)
+    {
+        perror_msg("Can't open directory '%s'", dump_location);
+        unlock_dup_index(lock_fd);
+        return -1;
+    }
+
+    g_autoptr(GHashTable) buckets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    int r = 0;
+    unsigned count = 0;
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+    {
+        /* Skip ".", "..", the index itself and "<dirname>.new" */
+        if (dent->d_name[0] == '.' || g_str_has_suffix(dent->d_name, ".new"))
+            continue;
+
+        g_autofree char *path = g_build_filename(dump_location, dent->d_name, NULL);
+
+        int sv_logmode = libreport_logmode;
+        /* Silently ignore any error in the silent log level. */
+        libreport_logmode = libreport_g_verbose == 0 ? 0 : sv_logmode;
+        struct dump_dir *dd = dd_opendir(path, DD_FAIL_QUIETLY_ENOENT | DD_OPEN_READONLY);
+        libreport_logmode = sv_logmode;
+        if (dd == NULL)
+            continue;
+
+        /* Only the processed problems can be duplicates */
+        g_autofree char *bucket = NULL;
+        struct abrt_dup_candidate *candidate = NULL;
+        if (problem_dump_dir_is_complete(dd))
+            candidate = abrt_dup_candidate_load(dd, &bucket);
+
+        if (candidate != NULL)
+        {
+            describe(dd, candidate, arg);
+
+            if (save_candidate(index_dir, bucket, candidate) == 0)
+            {
+                link_candidate(index_dir, bucket, candidate->dirname);
+                g_hash_table_add(buckets, g_steal_pointer(&bucket));
+                ++count;
+            }
+            else
+                r = -1;
+
+            abrt_dup_candidate_free(candidate);
+        }
+
+        dd_close(dd);
+    }
+    closedir(dp);
+
+    if (r == 0)
+    {
+        g_autofree char *path = g_build_filename(index_dir, DUP_INDEX_COMPLETE, NULL);
+        if (!g_file_set_contents(path, DUP_INDEX_VERSION, -1, NULL))
+        {
+            perror_msg("Can't save '%s'", path);
+            r = -1;
+        }
+    }
+
+    log_info("Duplicate index of '%s' has %u problems in %u buckets",
+             dump_location, count, g_hash_table_size(buckets));
+
+    unlock_dup_index(lock_fd);
+    return r;
+}
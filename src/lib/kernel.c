@@ -161,20 +161,19 @@ static const char *const s_koops_suspicious_strings_blacklist[] = {
 
 static bool suspicious_line(const char *line)
 {
-    const char *const *str = s_koops_suspicious_strings;
-    for ( ; *str; ++str)
-        if (strstr(line, *str))
-            break;
+    static struct abrt_pattern_set *patterns;
+    if (g_once_init_enter(&patterns))
+    {
+        GList *strings = abrt_koops_suspicious_strings_list();
+        GList *blacklist = abrt_koops_suspicious_strings_blacklist();
 
-    if (!*str)
-        return false;
+        g_once_init_leave(&patterns, abrt_pattern_set_new(strings, blacklist));
 
-    str = s_koops_suspicious_strings_blacklist;
-    for ( ; *str; ++str)
-        if (strstr(line, *str))
-           break;
+        g_list_free(blacklist);
+        g_list_free(strings);
+    }
 
-    return !*str;
+    return abrt_pattern_set_match_str(patterns, line);
 }
 
 void abrt_koops_print_suspicious_strings(void)
@@ -390,6 +389,201 @@ next_line:
     g_free(lines_info);
 }
 
+/*
+ * Call trace line classifier
+ *
+ * The functions below used to be POSIX regular expressions compiled on every
+ * call of abrt_koops_extract_oopses_from_lines(). Every function matches the
+ * same lines as the regular expression in its comment does in the C locale.
+ */
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool is_hex_digit(char c)
+{
+    return is_digit(c) || (c >= 'a' && c <= 'f');
+}
+
+/* Returns the first character of the run of hex digits ending at end */
+static const char *skip_hex_digits_backwards(const char *begin, const char *end)
+{
+    while (end > begin && is_hex_digit(end[-1]))
+        --end;
+
+    return end;
+}
+
+/* Skips the optional "[<[0-9a-f]\+>] " prefix */
+static const char *skip_trace_address(const char *line)
+{
+    if (line[0] != '[' || line[1] != '<' || !is_hex_digit(line[2]))
+        return line;
+
+    const char *c = line + 3;
+    while (is_hex_digit(*c))
+        ++c;
+
+    return (c[0] == '>' && c[1] == ']' && c[2] == ' ') ? c + 3 : line;
+}
+
+/* "r[[:digit:]]{1,}:[a-f[:digit:]]{8}" (ARM registers, r7:df912310) */
+static bool is_arm_register(const char *line)
+{
+    for (const char *r = strchr(line, 'r'); r != NULL; r = strchr(r + 1, 'r'))
+    {
+        const char *c = r + 1;
+        if (!is_digit(*c))
+            continue;
+
+        while (is_digit(*c))
+            ++c;
+
+        if (*c++ != ':')
+            continue;
+
+        int digits = 0;
+        while (digits < 8 && is_hex_digit(c[digits]))
+            ++digits;
+
+        if (digits == 8)
+            return true;
+    }
+
+    return false;
+}
+
+/* ".\++0x[0-9a-f]\+/0x[0-9a-f]\+$" for the characters from line to end */
+static bool is_function_offset(const char *line, const char *end)
+{
+    const char *c = skip_hex_digits_backwards(line, end);
+    if (c == end || c - line < 3 || strncmp(c - 3, "/0x", 3) != 0)
+        return false;
+
+    end = c - 3;
+    c = skip_hex_digits_backwards(line, end);
+    /* At least one character precedes "+0x" */
+    return c != end && c - line >= 4 && strncmp(c - 3, "+0x", 3) == 0;
+}
+
+/*
+ * "^\(\[<[0-9a-f]\+>\] \)\?.\++0x[0-9a-f]\+/0x[0-9a-f]\+\( \[.\+\]\)\?$"
+ * ([<ffffffff810a4567>] foo+0x16/0x41 [module])
+ *
+ * The address is consumed by ".\+" if it is there, so it does not matter.
+ */
+static bool is_trace_frame(const char *line, size_t length)
+{
+    const char *const end = line + length;
+    if (is_function_offset(line, end))
+        return true;
+
+    if (length == 0 || end[-1] != ']')
+        return false;
+
+    /* The module name may contain anything, try every " [" */
+    for (const char *c = line; (c = strstr(c, " [")) != NULL && c + 2 < end - 1; ++c)
+        if (is_function_offset(line, c))
+            return true;
+
+    return false;
+}
+
+/*
+ * "^(\(\[<[0-9a-f]\+>\] \)\?.\+\(+0x[0-9a-f]\+/0x[0-9a-f]\+\)\?\( \[.\+\]\)\?)$"
+ * (s390: "([<000000000011c2b8>] foo+0x16/0x41)")
+ *
+ * Everything between the parentheses is consumed by ".\+".
+ */
+static bool is_parenthesized_trace_frame(const char *line, size_t length)
+{
+    return length >= 3 && line[0] == '(' && line[length - 1] == ')';
+}
+
+/* "^\(\[<[0-9a-f]\+>\] \)\?\(? \)\?0x[0-9a-f]\+$" ("[<ffff0000>] ? 0xffffffffa0000c16") */
+static bool is_trace_address(const char *line)
+{
+    const char *c = skip_trace_address(line);
+    if (c[0] == '?' && c[1] == ' ')
+        c += 2;
+
+    if (c[0] != '0' || c[1] != 'x' || !is_hex_digit(c[2]))
+        return false;
+
+    c += 3;
+    while (is_hex_digit(*c))
+        ++c;
+
+    return *c == '\0';
+}
+
+/* "^\(R[ABCD]X\|R[SD]I\|RBP\|R[0-9]\{2\}\): [0-9a-f]\+ .\+" (x86 registers) */
+static bool is_x86_register(const char *line)
+{
+    if (line[0] != 'R')
+        return false;
+
+    if (!((strchr("ABCD", line[1]) && line[1] != '\0' && line[2] == 'X')
+       || (strchr("SD", line[1]) && line[1] != '\0' && line[2] == 'I')
+       || (line[1] == 'B' && line[2] == 'P')
+       || (is_digit(line[1]) && is_digit(line[2]))))
+        return false;
+
+    if (line[3] != ':' || line[4] != ' ' || !is_hex_digit(line[5]))
+        return false;
+
+    const char *c = line + 6;
+    while (is_hex_digit(*c))
+        ++c;
+
+    return c[0] == ' ' && c[1] != '\0';
+}
+
+bool abrt_koops_line_is_call_trace(const char *line)
+{
+    static struct abrt_pattern_set *markers;
+    if (g_once_init_enter(&markers))
+    {
+        static const char *const strings[] = {
+            "--- Exception",
+            "LR =",
+            "<#DF>",
+            "<IRQ>",
+            "<EOI>",
+            "<NMI>",
+            "<<EOE>>",
+            "Comm:",
+            "Hardware name:",
+            "Backtrace:",
+        };
+
+        GList *list = NULL;
+        for (size_t i = 0; i < ARRAY_SIZE(strings); ++i)
+            list = g_list_prepend(list, (gpointer)strings[i]);
+
+        g_once_init_leave(&markers, abrt_pattern_set_new(list, NULL));
+        g_list_free(list);
+    }
+
+    const size_t length = strlen(line);
+
+    return abrt_pattern_set_match(markers, line, length)
+        || strncmp(line, "Code: ", 6) == 0
+        || strncmp(line, "RIP: ", 5) == 0
+        || strncmp(line, "RSP: ", 5) == 0
+        /* s390 Call Trace ends with 'Last Breaking-Event-Address:'
+         * which is followed by a single frame */
+        || strncmp(line, "Last Breaking-Event-Address:", strlen("Last Breaking-Event-Address:")) == 0
+        /* ARM dumps registers intertwined with the backtrace */
+        || is_arm_register(line)
+        || is_trace_frame(line, length)
+        || is_parenthesized_trace_frame(line, length)
+        || is_trace_address(line)
+        || is_x86_register(line);
+}
+
 void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size)
 {
     /* Analyze lines */
@@ -398,24 +592,6 @@ void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_k
     char prevlevel = 0;
     int oopsstart = -1;
     int inbacktrace = 0;
-    regex_t arm_regex;
-    regex_t trace_regex;
-    regex_t trace_regex2;
-    regex_t trace_regex3;
-    regex_t register_regex;
-    int arm_regex_rc = 0;
-    int trace_regex_rc = 0;
-    int trace_regex2_rc = 0;
-    int trace_regex3_rc = 0;
-    int register_regex_rc = 0;
-
-    /* ARM backtrace regex, match a string similar to r7:df912310 */
-    arm_regex_rc = regcomp(&arm_regex, "r[[:digit:]]{1,}:[a-f[:digit:]]{8}", REG_EXTENDED | REG_NOSUB);
-    trace_regex_rc = regcomp(&trace_regex, "^\\(\\[<[0-9a-f]\\+>\\] \\)\\?.\\++0x[0-9a-f]\\+/0x[0-9a-f]\\+\\( \\[.\\+\\]\\)\\?$", REG_NOSUB);
-    trace_regex2_rc = regcomp(&trace_regex2, "^(\\(\\[<[0-9a-f]\\+>\\] \\)\\?.\\+\\(+0x[0-9a-f]\\+/0x[0-9a-f]\\+\\)\\?\\( \\[.\\+\\]\\)\\?)$", REG_NOSUB);
-    trace_regex3_rc = regcomp(&trace_regex3, "^\\(\\[<[0-9a-f]\\+>\\] \\)\\?\\(? \\)\\?0x[0-9a-f]\\+$", REG_NOSUB);
-    /* Registers usually(?) come listed three per line in a call trace but let's play it safe and list them all */
-    register_regex_rc = regcomp(&register_regex, "^\\(R[ABCD]X\\|R[SD]I\\|RBP\\|R[0-9]\\{2\\}\\): [0-9a-f]\\+ .\\+", REG_NOSUB);
 
     i = 0;
     while (i < lines_info_size)
@@ -491,31 +667,8 @@ void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_k
             /* line needs to start with "[" or have "] [" if it is still a call trace */
             /* example: "[<ffffffffa006c156>] radeon_get_ring_head+0x16/0x41 [radeon]" */
             /* example s390: "([<ffffffffa006c156>] 0xdeadbeaf)" */
-            if (!strstr(curline, "--- Exception")
-             && !strstr(curline, "LR =")
-             && !strstr(curline, "<#DF>")
-             && !strstr(curline, "<IRQ>")
-             && !strstr(curline, "<EOI>")
-             && !strstr(curline, "<NMI>")
-             && !strstr(curline, "<<EOE>>")
-             && !strstr(curline, "Comm:")
-             && !strstr(curline, "Hardware name:")
-             && !strstr(curline, "Backtrace:")
-             && strncmp(curline, "Code: ", 6) != 0
-             && strncmp(curline, "RIP: ", 5) != 0
-             && strncmp(curline, "RSP: ", 5) != 0
-             /* s390 Call Trace ends with 'Last Breaking-Event-Address:'
-              * which is followed by a single frame */
-             && strncmp(curline, "Last Breaking-Event-Address:", strlen("Last Breaking-Event-Address:")) != 0
-             /* ARM dumps registers intertwined with the backtrace */
-             && (arm_regex_rc == 0 ? regexec(&arm_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-             && (trace_regex_rc == 0 ? regexec(&trace_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-             && (trace_regex2_rc == 0 ? regexec(&trace_regex2, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-             && (trace_regex3_rc == 0 ? regexec(&trace_regex3, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-             && (register_regex_rc == 0 ? regexec(&register_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-            ) {
+            if (!abrt_koops_line_is_call_trace(curline))
                 oopsend = i-1; /* not a call trace line */
-            }
             /* oops lines are always more than 8 chars long */
             else if (strnlen(curline, 8) < 8)
                 oopsend = i-1;
@@ -569,12 +722,6 @@ void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_k
         }
     } /* while (i < lines_info_size) */
 
-    regfree(&arm_regex);
-    regfree(&trace_regex);
-    regfree(&trace_regex2);
-    regfree(&trace_regex3);
-    regfree(&register_regex);
-
     /* process last oops if we have one */
     if (oopsstart >= 0)
     {
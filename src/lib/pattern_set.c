@@ -0,0 +1,212 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <stdint.h>
+#include "libabrt.h"
+
+/* The strings are compiled into an Aho-Corasick automaton turned into a
+ * deterministic one, so every byte of the searched data costs one table
+ * lookup regardless of the number of strings. Bytes not occurring in any
+ * string share one column of the table to keep it small.
+ */
+
+#define PATTERN_FOUND       (1 << 0)
+#define PATTERN_BLACKLISTED (1 << 1)
+
+struct abrt_pattern_set
+{
+    /* Byte -> column of the transition table */
+    uint16_t column[256];
+    unsigned columns;
+
+    /* states x columns, the initial state is 0 */
+    uint32_t *next;
+    /* PATTERN_* flags of strings ending in the state */
+    uint8_t *output;
+    unsigned states;
+
+    bool has_blacklisted;
+};
+
+static void pattern_set_assign_columns(struct abrt_pattern_set *set, GList *strings)
+{
+    for (GList *l = strings; l != NULL; l = l->next)
+        for (const unsigned char *c = l->data; *c != '\0'; ++c)
+            if (set->column[*c] == 0)
+                set->column[*c] = set->columns++;
+}
+
+static uint32_t pattern_set_new_state(struct abrt_pattern_set *set, unsigned *allocated)
+{
+    if (set->states == *allocated)
+    {
+        *allocated *= 2;
+        set->next = g_renew(uint32_t, set->next, (gsize)*allocated * set->columns);
+        set->output = g_renew(uint8_t, set->output, *allocated);
+    }
+
+    const uint32_t state = set->states++;
+    /* UINT32_MAX marks missing transitions of the trie */
+    memset(set->next + (gsize)state * set->columns, 0xFF, set->columns * sizeof(*set->next));
+    set->output[state] = 0;
+
+    return state;
+}
+
+static void pattern_set_add(struct abrt_pattern_set *set, unsigned *allocated,
+            const char *string, uint8_t flag)
+{
+    uint32_t state = 0;
+    for (const unsigned char *c = (const unsigned char *)string; *c != '\0'; ++c)
+    {
+        uint32_t *next = set->next + (gsize)state * set->columns + set->column[*c];
+        if (*next == UINT32_MAX)
+        {
+            const uint32_t new_state = pattern_set_new_state(set, allocated);
+            /* The table might have been reallocated */
+            set->next[(gsize)state * set->columns + set->column[*c]] = new_state;
+            state = new_state;
+        }
+        else
+            state = *next;
+    }
+
+    set->output[state] |= flag;
+}
+
+/* Completes the trie with the failure transitions in breadth-first order */
+static void pattern_set_compile(struct abrt_pattern_set *set)
+{
+    uint32_t *fail = g_new(uint32_t, set->states);
+    uint32_t *queue = g_new(uint32_t, set->states);
+    unsigned head = 0, tail = 0;
+
+    for (unsigned c = 0; c < set->columns; ++c)
+    {
+        uint32_t *next = set->next + c;
+        if (*next == UINT32_MAX)
+            *next = 0;
+        else
+        {
+            fail[*next] = 0;
+            queue[tail++] = *next;
+        }
+    }
+
+    while (head < tail)
+    {
+        const uint32_t state = queue[head++];
+        set->output[state] |= set->output[fail[state]];
+
+        uint32_t *next = set->next + (gsize)state * set->columns;
+        const uint32_t *fail_next = set->next + (gsize)fail[state] * set->columns;
+        for (unsigned c = 0; c < set->columns; ++c)
+        {
+            if (next[c] == UINT32_MAX)
+                next[c] = fail_next[c];
+            else
+            {
+                fail[next[c]] = fail_next[c];
+                queue[tail++] = next[c];
+            }
+        }
+    }
+
+    g_free(queue);
+    g_free(fail);
+}
+
+struct abrt_pattern_set *abrt_pattern_set_new(GList *strings, GList *blacklisted_strings)
+{
+    struct abrt_pattern_set *set = g_new0(struct abrt_pattern_set, 1);
+
+    /* Column 0 belongs to the bytes not found in the strings */
+    set->columns = 1;
+    pattern_set_assign_columns(set, strings);
+    pattern_set_assign_columns(set, blacklisted_strings);
+
+    unsigned allocated = 64;
+    set->next = g_new(uint32_t, (gsize)allocated * set->columns);
+    set->output = g_new(uint8_t, allocated);
+    pattern_set_new_state(set, &allocated);
+
+    for (GList *l = strings; l != NULL; l = l->next)
+        pattern_set_add(set, &allocated, l->data, PATTERN_FOUND);
+
+    for (GList *l = blacklisted_strings; l != NULL; l = l->next)
+        pattern_set_add(set, &allocated, l->data, PATTERN_BLACKLISTED);
+
+    set->has_blacklisted = (blacklisted_strings != NULL);
+
+    pattern_set_compile(set);
+
+    log_debug("Compiled %u strings into %u states of %u columns",
+              g_list_length(strings) + g_list_length(blacklisted_strings),
+              set->states, set->columns);
+
+    return set;
+}
+
+void abrt_pattern_set_free(struct abrt_pattern_set *set)
+{
+    if (set == NULL)
+        return;
+
+    g_free(set->output);
+    g_free(set->next);
+    g_free(set);
+}
+
+bool abrt_pattern_set_match(const struct abrt_pattern_set *set, const char *data, size_t length)
+{
+    const uint32_t *const next = set->next;
+    const uint8_t *const output = set->output;
+    const unsigned columns = set->columns;
+
+    /* An empty string is found everywhere */
+    unsigned found = output[0];
+    if (found & PATTERN_BLACKLISTED)
+        return false;
+
+    if ((found & PATTERN_FOUND) && !set->has_blacklisted)
+        return true;
+
+    uint32_t state = 0;
+    const unsigned char *c = (const unsigned char *)data;
+    const unsigned char *const end = c + length;
+    for (; c < end; ++c)
+    {
+        state = next[(gsize)state * columns + set->column[*c]];
+        if (output[state] == 0)
+            continue;
+
+        found |= output[state];
+        if (found & PATTERN_BLACKLISTED)
+            return false;
+
+        /* Nothing can change the result anymore */
+        if (!set->has_blacklisted)
+            return true;
+    }
+
+    return (found & PATTERN_FOUND);
+}
+
+bool abrt_pattern_set_match_str(const struct abrt_pattern_set *set, const char *str)
+{
+    return abrt_pattern_set_match(set, str, strlen(str));
+}
@@ -19,18 +19,68 @@
 
 #include <glib.h>
 #include <sys/time.h>
+#include <grp.h>
+#include <sys/syscall.h>
 #include "problem_api.h"
 
+/* Upper limit of ProblemScanThreads */
+#define MAX_PROBLEM_SCAN_THREADS 16
+/* Number of problem directories opened ahead of the callback per thread */
+#define PROBLEM_SCAN_WINDOW_PER_THREAD 4
+
+/* Loads data from the opened problem directory before the callback is
+ * called, on the worker threads in the parallel scan. */
+typedef void *(*problem_dir_load_fn)(struct dump_dir *dd);
+/* Called in the order of directory entries */
+typedef int (*problem_dir_emit_fn)(struct dump_dir *dd, void *loaded, void *arg);
+
+struct problem_dir_scan
+{
+    const char *path;
+    uid_t caller_uid;
+    problem_dir_load_fn load;
+    GDestroyNotify free_loaded;
+    problem_dir_emit_fn emit;
+    void *arg;
+};
+
 /*
- * Goes through all problems and for problems accessible by caller_uid
- * calls callback. If callback returns non-0, returns that value.
+ * Opens the problem directory for reading if it is accessible by caller_uid.
  */
-int for_each_problem_in_dir(const char *path,
-                        uid_t caller_uid,
-                        int (*callback)(struct dump_dir *dd, void *arg),
-                        void *arg)
+static struct dump_dir *open_accessible_problem_dir(const char *path, const char *name,
+                        uid_t caller_uid)
 {
-    DIR *dp = opendir(path);
+    g_autofree char *full_name = g_build_filename(path, name, NULL);
+
+    struct dump_dir *dd = dd_opendir(full_name,   DD_OPEN_FD_ONLY
+                                                | DD_FAIL_QUIETLY_ENOENT
+                                                | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+    {
+        VERB2 perror_msg("can't open problem directory '%s'", full_name);
+        return NULL;
+    }
+
+    if (caller_uid != -1 && !dd_accessible_by_uid(dd, caller_uid))
+    {
+        dd_close(dd);
+        return NULL;
+    }
+
+    /* Directories which are locked, removed or are not problem directories
+     * are skipped quietly. We saw "lock file is locked by process PID" error
+     * when we raced with wizard. The global log mode is not touched, the
+     * function runs on the worker threads of the parallel scan.
+     */
+    return dd_fdopendir(dd, DD_OPEN_READONLY
+                          | DD_DONT_WAIT_FOR_LOCK
+                          | DD_FAIL_QUIETLY_ENOENT
+                          | DD_FAIL_QUIETLY_EACCES);
+}
+
+static int scan_problem_dirs_serially(const struct problem_dir_scan *scan)
+{
+    DIR *dp = opendir(scan->path);
     if (!dp)
     {
         /* We don't want to yell if, say, $XDG_CACHE_DIR/abrt/spool doesn't exist */
@@ -40,73 +90,426 @@ int for_each_problem_in_dir(const char *path,
 
     int brk = 0;
     struct dirent *dent;
-    while ((dent = readdir(dp)) != NULL)
+    while ((dent = readdir(dp)) != NULL && brk == 0)
+    {
+        if (dent->d_name[0] == '.')
+            continue; /* skip ".", ".." and hidden entries like the duplicate index */
+
+        struct dump_dir *dd = open_accessible_problem_dir(scan->path, dent->d_name, scan->caller_uid);
+        if (dd == NULL)
+            continue;
+
+        void *loaded = scan->load ? scan->load(dd) : NULL;
+        if (scan->load == NULL || loaded != NULL)
+            brk = scan->emit(dd, loaded, scan->arg);
+
+        if (loaded != NULL)
+            scan->free_loaded(loaded);
+        dd_close(dd);
+    }
+    closedir(dp);
+
+    return brk;
+}
+
+struct linux_dirent64
+{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+/* Reads the names of the possible problem directories in large batches */
+static GPtrArray *read_problem_dir_names(int dir_fd)
+{
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+
+    const size_t buf_size = 64 * 1024;
+    g_autofree char *buf = g_malloc(buf_size);
+    for (;;)
+    {
+        const long len = syscall(SYS_getdents64, dir_fd, buf, buf_size);
+        if (len < 0)
+        {
+            perror_msg("Can't read directory entries");
+            break;
+        }
+
+        if (len == 0)
+            break;
+
+        for (long pos = 0; pos < len; )
+        {
+            const struct linux_dirent64 *dent = (const struct linux_dirent64 *)(buf + pos);
+            pos += dent->d_reclen;
+
+            if (dent->d_name[0] == '.')
+                continue; /* skip ".", ".." and hidden entries like the duplicate index */
+
+            /* Files can't be problem directories, symbolic links and unknown
+             * types are left to dd_opendir() */
+            if (dent->d_type != DT_DIR && dent->d_type != DT_LNK && dent->d_type != DT_UNKNOWN)
+                continue;
+
+            g_ptr_array_add(names, g_strdup(dent->d_name));
+        }
+    }
+
+    return names;
+}
+
+struct problem_dir_job
+{
+    struct dump_dir *dd;
+    void *loaded;
+    bool done;
+};
+
+struct parallel_problem_dir_scan
+{
+    const struct problem_dir_scan *scan;
+    GPtrArray *names;
+    struct problem_dir_job *jobs;
+    GMutex lock;
+    GCond job_done;
+    /* Set once a callback breaks the iteration */
+    gint stop;
+};
+
+static void run_problem_dir_job(gpointer data, gpointer user_data)
+{
+    struct parallel_problem_dir_scan *pscan = user_data;
+    const struct problem_dir_scan *scan = pscan->scan;
+    /* The indexes are pushed shifted by one because NULL can't be pushed */
+    const guint i = GPOINTER_TO_UINT(data) - 1;
+
+    struct dump_dir *dd = NULL;
+    void *loaded = NULL;
+    if (!g_atomic_int_get(&pscan->stop))
     {
-        if (libreport_dot_or_dotdot(dent->d_name))
-            continue; /* skip "." and ".." */
+        dd = open_accessible_problem_dir(scan->path, pscan->names->pdata[i], scan->caller_uid);
+        if (dd != NULL && scan->load != NULL)
+        {
+            loaded = scan->load(dd);
+            if (loaded == NULL)
+            {
+                dd_close(dd);
+                dd = NULL;
+            }
+        }
+    }
+
+    g_mutex_lock(&pscan->lock);
+    pscan->jobs[i].dd = dd;
+    pscan->jobs[i].loaded = loaded;
+    pscan->jobs[i].done = true;
+    g_cond_broadcast(&pscan->job_done);
+    g_mutex_unlock(&pscan->lock);
+}
 
-        g_autofree char *full_name = g_build_filename(path, dent->d_name, NULL);
+static unsigned problem_scan_threads(void)
+{
+    unsigned threads = abrt_g_settings_problem_scan_threads;
+    if (threads == 0)
+        threads = g_get_num_processors();
+
+    return MIN(threads, MAX_PROBLEM_SCAN_THREADS);
+}
+
+/* Opens and loads the problem directories on a pool of threads and calls the
+ * callbacks on the calling thread in the order of the directory entries, so
+ * the callbacks see the same sequence as in the serial scan.
+ */
+static int scan_problem_dirs_in_parallel(const struct problem_dir_scan *scan)
+{
+    int dir_fd = open(scan->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0)
+        return 0;
+
+    struct parallel_problem_dir_scan pscan = {
+        .scan = scan,
+        .names = read_problem_dir_names(dir_fd),
+        .stop = 0,
+    };
+    close(dir_fd);
+
+    const guint count = pscan.names->len;
+    const unsigned threads = problem_scan_threads();
+    GError *error = NULL;
+    GThreadPool *pool = count > 1 && threads > 1
+        ? g_thread_pool_new(run_problem_dir_job, &pscan, threads, TRUE, &error)
+        : NULL;
+    if (pool == NULL)
+    {
+        if (error != NULL)
+        {
+            log_notice("Can't start problem scan threads: %s", error->message);
+            g_error_free(error);
+        }
+        g_ptr_array_free(pscan.names, TRUE);
+        return scan_problem_dirs_serially(scan);
+    }
+
+    pscan.jobs = g_new0(struct problem_dir_job, count);
+    g_mutex_init(&pscan.lock);
+    g_cond_init(&pscan.job_done);
+
+    /* Bound the number of open (and locked) directories */
+    const guint window = threads * PROBLEM_SCAN_WINDOW_PER_THREAD;
+    guint pushed = 0;
+    for (; pushed < count && pushed < window; ++pushed)
+        g_thread_pool_push(pool, GUINT_TO_POINTER(pushed + 1), NULL);
+
+    int brk = 0;
+    for (guint i = 0; i < count && brk == 0; ++i)
+    {
+        g_mutex_lock(&pscan.lock);
+        while (!pscan.jobs[i].done)
+            g_cond_wait(&pscan.job_done, &pscan.lock);
+        struct dump_dir *dd = pscan.jobs[i].dd;
+        void *loaded = pscan.jobs[i].loaded;
+        pscan.jobs[i].dd = NULL;
+        pscan.jobs[i].loaded = NULL;
+        g_mutex_unlock(&pscan.lock);
+
+        if (pushed < count)
+        {
+            g_thread_pool_push(pool, GUINT_TO_POINTER(pushed + 1), NULL);
+            ++pushed;
+        }
 
-        struct dump_dir *dd = dd_opendir(full_name,   DD_OPEN_FD_ONLY
-                                                    | DD_FAIL_QUIETLY_ENOENT
-                                                    | DD_FAIL_QUIETLY_EACCES);
         if (dd == NULL)
+            continue;
+
+        brk = scan->emit(dd, loaded, scan->arg);
+
+        if (loaded != NULL)
+            scan->free_loaded(loaded);
+        dd_close(dd);
+    }
+
+    /* Let the remaining jobs finish without opening anything */
+    g_atomic_int_set(&pscan.stop, 1);
+    g_thread_pool_free(pool, /*immediate*/FALSE, /*wait*/TRUE);
+
+    for (guint i = 0; i < count; ++i)
+    {
+        if (pscan.jobs[i].loaded != NULL)
+            scan->free_loaded(pscan.jobs[i].loaded);
+        if (pscan.jobs[i].dd != NULL)
+            dd_close(pscan.jobs[i].dd);
+    }
+
+    g_cond_clear(&pscan.job_done);
+    g_mutex_clear(&pscan.lock);
+    g_free(pscan.jobs);
+    g_ptr_array_free(pscan.names, TRUE);
+
+    return brk;
+}
+
+static int scan_problem_dirs(const struct problem_dir_scan *scan, int flags)
+{
+    if (flags & FOR_EACH_PROBLEM_PARALLEL)
+        return scan_problem_dirs_in_parallel(scan);
+
+    return scan_problem_dirs_serially(scan);
+}
+
+struct emit_dump_dir_args
+{
+    for_each_problem_in_dir_callback callback;
+    void *arg;
+};
+
+static int emit_dump_dir(struct dump_dir *dd, void *loaded, void *arg)
+{
+    struct emit_dump_dir_args *args = arg;
+    return args->callback ? args->callback(dd, args->arg) : 0;
+}
+
+/*
+ * Goes through all problems and for problems accessible by caller_uid
+ * calls callback. If callback returns non-0, returns that value.
+ */
+int for_each_problem_in_dir_ext(const char *path,
+                        uid_t caller_uid,
+                        int flags,
+                        for_each_problem_in_dir_callback callback,
+                        void *arg)
+{
+    struct emit_dump_dir_args args = {
+        .callback = callback,
+        .arg = arg,
+    };
+    const struct problem_dir_scan scan = {
+        .path = path,
+        .caller_uid = caller_uid,
+        .emit = emit_dump_dir,
+        .arg = &args,
+    };
+
+    return scan_problem_dirs(&scan, flags);
+}
+
+int for_each_problem_in_dir(const char *path,
+                        uid_t caller_uid,
+                        int (*callback)(struct dump_dir *dd, void *arg),
+                        void *arg)
+{
+    return for_each_problem_in_dir_ext(path, caller_uid, /*flags*/0, callback, arg);
+}
+
+/* for_each_problem_entry_in_dir and its helpers */
+
+struct emit_loaded_entry_args
+{
+    for_each_problem_entry_in_dir_callback callback;
+    void *arg;
+};
+
+static void *load_entry(struct dump_dir *dd)
+{
+    return abrt_catalog_entry_load(dd);
+}
+
+static int emit_loaded_entry(struct dump_dir *dd, void *loaded, void *arg)
+{
+    struct emit_loaded_entry_args *args = arg;
+    return args->callback ? args->callback(dd->dd_dirname, loaded, args->arg) : 0;
+}
+
+/* The same result as dump_dir_accessible_by_uid() but root and world readable
+ * directories are recognized without another stat(), the owner and mode of
+ * the entry must be up to date */
+static bool entry_accessible_by_uid(const char *dir_name, const struct abrt_catalog_entry *entry, uid_t uid)
+{
+    if (uid == 0 || (entry->mode & S_IROTH))
+        return true;
+
+    return dump_dir_accessible_by_uid(dir_name, uid);
+}
+
+int for_each_problem_entry_in_dir(const char *path,
+                        uid_t caller_uid,
+                        int flags,
+                        for_each_problem_entry_in_dir_callback callback,
+                        void *arg)
+{
+    struct abrt_catalog *catalog = abrt_catalog_open(path);
+    if (catalog == NULL)
+    {
+        log_debug("No usable catalog in '%s', reading problem directories", path);
+
+        struct emit_loaded_entry_args args = {
+            .callback = callback,
+            .arg = arg,
+        };
+        const struct problem_dir_scan scan = {
+            .path = path,
+            .caller_uid = caller_uid,
+            .load = load_entry,
+            .free_loaded = (GDestroyNotify)abrt_catalog_entry_free,
+            .emit = emit_loaded_entry,
+            .arg = &args,
+        };
+        return scan_problem_dirs(&scan, flags);
+    }
+
+    int brk = 0;
+    const unsigned count = abrt_catalog_count(catalog);
+    for (unsigned i = 0; i < count && brk == 0; ++i)
+    {
+        struct abrt_catalog_entry entry;
+        abrt_catalog_get(catalog, i, &entry);
+
+        g_autofree char *full_name = g_build_filename(path, entry.dirname, NULL);
+
+        /* Permissions are never decided by the catalog, the directory
+         * might have been changed since the catalog was written */
+        struct stat statbuf;
+        if (lstat(full_name, &statbuf) != 0)
         {
-            VERB2 perror_msg("can't open problem directory '%s'", full_name);
+            log_debug("Problem '%s' is gone", full_name);
             continue;
         }
+        entry.owner = statbuf.st_uid;
+        entry.group = statbuf.st_gid;
+        entry.mode = statbuf.st_mode;
 
-        if (caller_uid == -1 || dd_accessible_by_uid(dd, caller_uid))
+        if (caller_uid != -1 && !entry_accessible_by_uid(full_name, &entry, caller_uid))
+            continue;
+
+        /* The elements changed after abrtd read them, the catalogued entry
+         * is used only if the directory is busy */
+        struct abrt_catalog_entry *current = NULL;
+        if (statbuf.st_mtim.tv_sec != entry.mtime.tv_sec
+         || statbuf.st_mtim.tv_nsec != entry.mtime.tv_nsec)
         {
-            /* Silently ignore *any* errors, not only EACCES.
-             * We saw "lock file is locked by process PID" error
-             * when we raced with wizard.
-             */
-            int sv_logmode = libreport_logmode;
-            /* Silently ignore errors only in the silent log level. */
-            libreport_logmode = libreport_g_verbose == 0 ? 0: sv_logmode;
-            dd = dd_fdopendir(dd, DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK);
-            libreport_logmode = sv_logmode;
-            if (dd)
-                brk = callback ? callback(dd, arg) : 0;
+            log_debug("Problem '%s' changed since it was catalogued", full_name);
+            current = abrt_catalog_entry_read(full_name);
         }
 
-        if (dd)
-            dd_close(dd);
-
-        if (brk)
-            break;
+        brk = callback ? callback(full_name, current != NULL ? current : &entry, arg) : 0;
+        abrt_catalog_entry_free(current);
     }
-    closedir(dp);
+    abrt_catalog_close(catalog);
 
     return brk;
 }
 
 /* get_problem_dirs_for_uid and its helpers */
 
-static int add_dirname_to_GList(struct dump_dir *dd, void *arg)
+struct add_dirname_to_GList_args
 {
-    if (!abrt_dir_has_correct_permissions(dd->dd_dirname, DD_PERM_DAEMONS))
+    gid_t abrt_gid;
+    GList *list;
+};
+
+static int add_dirname_to_GList(const char *dir_name, const struct abrt_catalog_entry *entry, void *args)
+{
+    struct add_dirname_to_GList_args *param = args;
+
+    /* The same check as abrt_dir_has_correct_permissions(DD_PERM_DAEMONS) */
+    if (!S_ISDIR(entry->mode) || (entry->group != 0 && entry->group != param->abrt_gid))
     {
-        log_warning("Ignoring '%s': invalid owner, group or mode", dd->dd_dirname);
+        log_warning("Ignoring '%s': invalid owner, group or mode", dir_name);
         /*Do not break*/
         return 0;
     }
 
-    GList **list = arg;
-    *list = g_list_prepend(*list, g_strdup(dd->dd_dirname));
+    param->list = g_list_prepend(param->list, g_strdup(dir_name));
     return 0;
 }
 
 GList *get_problem_dirs_for_uid(uid_t uid, const char *dump_location)
 {
-    GList *list = NULL;
-    for_each_problem_in_dir(dump_location, uid, add_dirname_to_GList, &list);
+    return get_problem_dirs_for_uid_ext(uid, dump_location, /*flags*/0);
+}
+
+GList *get_problem_dirs_for_uid_ext(uid_t uid, const char *dump_location, int flags)
+{
+    /* Get ABRT's group id */
+    struct group *gr = getgrnam("abrt");
+    if (!gr)
+    {
+        error_msg("The group 'abrt' does not exist");
+        return NULL;
+    }
+
+    struct add_dirname_to_GList_args args = {
+        .abrt_gid = gr->gr_gid,
+        .list = NULL,
+    };
+
+    for_each_problem_entry_in_dir(dump_location, uid, flags, add_dirname_to_GList, &args);
     /*
      * Why reverse?
      * Because N*prepend+reverse is faster than N*append
      */
-    return g_list_reverse(list);
+    return g_list_reverse(args.list);
 }
 
 /* get_problem_dirs_not_accessible_by_uid and its helpers */
@@ -116,24 +519,30 @@ struct add_dirname_to_GList_if_not_accessible_args
     GList *list;
 };
 
-static int add_dirname_to_GList_if_not_accessible(struct dump_dir *dd, void *args)
+static int add_dirname_to_GList_if_not_accessible(const char *dir_name, const struct abrt_catalog_entry *entry, void *args)
 {
     struct add_dirname_to_GList_if_not_accessible_args *param = (struct add_dirname_to_GList_if_not_accessible_args *)args;
     /* Append if not accessible */
-    if (!dump_dir_accessible_by_uid(dd->dd_dirname, param->uid))
-        param->list = g_list_prepend(param->list, g_strdup(dd->dd_dirname));
+    if (!entry_accessible_by_uid(dir_name, entry, param->uid))
+        param->list = g_list_prepend(param->list, g_strdup(dir_name));
 
     return 0;
 }
 
 GList *get_problem_dirs_not_accessible_by_uid(uid_t uid, const char *dump_location)
+{
+    return get_problem_dirs_not_accessible_by_uid_ext(uid, dump_location, /*flags*/0);
+}
+
+GList *get_problem_dirs_not_accessible_by_uid_ext(uid_t uid, const char *dump_location, int flags)
 {
     struct add_dirname_to_GList_if_not_accessible_args args = {
         .uid = uid,
         .list = NULL,
     };
 
-    for_each_problem_in_dir(dump_location, /*disable default uid check*/-1, add_dirname_to_GList_if_not_accessible, &args);
+    for_each_problem_entry_in_dir(dump_location, /*disable default uid check*/-1, flags,
+                                  add_dirname_to_GList_if_not_accessible, &args);
     return g_list_reverse(args.list);
 }
 
@@ -0,0 +1,571 @@
+/*
+    Copyright (C) 2026  RedHat inc.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <signal.h>
+#include <sys/mman.h>
+#include "libabrt.h"
+
+/* The catalog file consists of a header, a table of fixed size records and
+ * an arena of NUL terminated strings referenced from the records by their
+ * offsets. The offset 0 points to an empty string which stands for a missing
+ * element.
+ *
+ * The file is never modified in place; abrtd writes a new file and renames it
+ * over the old one, so the readers' mappings stay valid. The file lives in a
+ * subdirectory, so writing it does not change the mtime of the dump location
+ * which tells the readers whether the list of problems is current.
+ */
+
+#define CATALOG_MAGIC    "ABRTCAT"
+#define CATALOG_VERSION  3
+
+/* The list of problems is trusted only if the dump location has not been
+ * modified since abrtd read it. A modification made in the same tick of the
+ * file system clock leaves the mtime as it was, hence the mtime must be older
+ * than the listing by more than the coarsest granularity of timestamps.
+ */
+#define CATALOG_MTIME_GRANULARITY_NS 1000000000LL
+
+/* The lock file libreport creates in a locked problem directory */
+#define DUMP_DIR_LOCK_FILE ".lock"
+
+#define CATALOG_FLAG_REPORTED (1 << 0)
+
+struct catalog_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    /* The dump location the catalog was built for */
+    uint64_t dev;
+    uint64_t ino;
+    /* abrtd which maintains the catalog */
+    uint32_t writer_pid;
+    uint32_t count;
+    uint32_t arena_size;
+    uint32_t reserved;
+    /* FNV-1a of the records and the arena */
+    uint64_t checksum;
+    /* See abrt_catalog_generation() */
+    uint64_t generation;
+    /* The mtime of the dump location when abrtd listed it and the time of
+     * the listing, in nanoseconds */
+    int64_t dump_location_mtime;
+    int64_t listed;
+};
+
+struct catalog_record
+{
+    uint32_t dirname;
+    uint32_t type;
+    uint32_t executable;
+    uint32_t component;
+    uint32_t duphash;
+    uint32_t uid;
+    uint32_t owner;
+    uint32_t group;
+    uint32_t mode;
+    uint32_t count;
+    uint32_t flags;
+    uint32_t reserved;
+    int64_t first_occurrence;
+    int64_t last_occurrence;
+    /* The mtime of the directory the elements were read at, nanoseconds */
+    int64_t mtime;
+};
+
+struct abrt_catalog
+{
+    void *map;
+    size_t size;
+    const struct catalog_header *header;
+    const struct catalog_record *records;
+    const char *arena;
+};
+
+static uint64_t checksum_update(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+#define CHECKSUM_INIT 0xcbf29ce484222325ULL
+
+static char *catalog_path(const char *dump_location)
+{
+    return g_build_filename(dump_location, ABRT_CATALOG_DIR_NAME, ABRT_CATALOG_FILE_NAME, NULL);
+}
+
+static int64_t timespec_to_ns(const struct timespec *ts)
+{
+    return (int64_t)ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+static struct timespec timespec_from_ns(int64_t ns)
+{
+    struct timespec ts = { .tv_sec = ns / 1000000000LL, .tv_nsec = ns % 1000000000LL };
+    return ts;
+}
+
+static time_t load_time(struct dump_dir *dd, const char *name)
+{
+    g_autofree char *str = dd_load_text_ext(dd, name, DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+    return str != NULL ? (time_t)strtoll(str, NULL, 10) : 0;
+}
+
+struct abrt_catalog_entry *abrt_catalog_entry_new(const char *dirname, const struct stat *statbuf)
+{
+    struct abrt_catalog_entry *entry = g_new0(struct abrt_catalog_entry, 1);
+    entry->dirname = g_strdup(dirname);
+    entry->uid = (uid_t)-1;
+    entry->owner = statbuf->st_uid;
+    entry->group = statbuf->st_gid;
+    entry->mode = statbuf->st_mode;
+
+    return entry;
+}
+
+struct abrt_catalog_entry *abrt_catalog_entry_load(struct dump_dir *dd)
+{
+    struct stat statbuf;
+    if (fstat(dd->dd_fd, &statbuf) != 0)
+    {
+        perror_msg("Can't stat '%s'", dd->dd_dirname);
+        return NULL;
+    }
+
+    /* Nobody may write the elements while they are read without the lock */
+    struct stat lockbuf;
+    if (!dd->locked && fstatat(dd->dd_fd, DUMP_DIR_LOCK_FILE, &lockbuf, AT_SYMLINK_NOFOLLOW) == 0)
+    {
+        log_debug("'%s' is locked", dd->dd_dirname);
+        return NULL;
+    }
+
+    const char *slash = strrchr(dd->dd_dirname, '/');
+    struct abrt_catalog_entry *entry = abrt_catalog_entry_new(slash ? slash + 1 : dd->dd_dirname, &statbuf);
+
+    const int flags = DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE;
+    g_autofree char *uid = dd_load_text_ext(dd, FILENAME_UID, flags);
+    if (uid != NULL)
+        entry->uid = (uid_t)strtoul(uid, NULL, 10);
+
+    entry->type = dd_load_text_ext(dd, FILENAME_TYPE, flags);
+    entry->executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, flags);
+    entry->component = dd_load_text_ext(dd, FILENAME_COMPONENT, flags);
+    entry->duphash = dd_load_text_ext(dd, FILENAME_DUPHASH, flags);
+    entry->first_occurrence = load_time(dd, FILENAME_TIME);
+    entry->last_occurrence = load_time(dd, FILENAME_LAST_OCCURRENCE);
+
+    g_autofree char *count = dd_load_text_ext(dd, FILENAME_COUNT, flags);
+    entry->count = count != NULL ? strtoul(count, NULL, 10) : 0;
+    entry->reported = dd_exist(dd, FILENAME_REPORTED_TO);
+
+    struct stat after;
+    if (!dd->locked && (fstat(dd->dd_fd, &after) != 0
+                        || timespec_to_ns(&after.st_mtim) != timespec_to_ns(&statbuf.st_mtim)))
+    {
+        log_debug("'%s' changed while it was read", dd->dd_dirname);
+        abrt_catalog_entry_free(entry);
+        return NULL;
+    }
+    entry->mtime = statbuf.st_mtim;
+
+    return entry;
+}
+
+struct abrt_catalog_entry *abrt_catalog_entry_read(const char *dirname)
+{
+    struct dump_dir *dd = dd_opendir(dirname, DD_OPEN_FD_ONLY
+                                            | DD_FAIL_QUIETLY_ENOENT
+                                            | DD_FAIL_QUIETLY_EACCES);
+    if (dd == NULL)
+        return NULL;
+
+    struct abrt_catalog_entry *entry = abrt_catalog_entry_load(dd);
+    dd_close(dd);
+
+    return entry;
+}
+
+void abrt_catalog_entry_free(struct abrt_catalog_entry *entry)
+{
+    if (entry == NULL)
+        return;
+
+    free((char *)entry->dirname);
+    free((char *)entry->type);
+    free((char *)entry->executable);
+    free((char *)entry->component);
+    free((char *)entry->duphash);
+    free(entry);
+}
+
+/* Returns the offset of str in the arena, equal strings are stored once */
+static uint32_t arena_add(GString *arena, GHashTable *offsets, const char *str)
+{
+    if (str == NULL || str[0] == '\0')
+        return 0;
+
+    gpointer offset;
+    if (g_hash_table_lookup_extended(offsets, str, NULL, &offset))
+        return GPOINTER_TO_UINT(offset);
+
+    const uint32_t new_offset = arena->len;
+    g_string_append_len(arena, str, strlen(str) + 1);
+    g_hash_table_insert(offsets, (gpointer)str, GUINT_TO_POINTER(new_offset));
+
+    return new_offset;
+}
+
+int abrt_catalog_write(const char *dump_location, GList *entries, uint64_t generation,
+            const struct timespec *dump_location_mtime, const struct timespec *listed)
+{
+    struct stat dump_location_stat;
+    if (stat(dump_location, &dump_location_stat) != 0)
+    {
+        perror_msg("Can't stat '%s'", dump_location);
+        return -1;
+    }
+
+    GArray *records = g_array_new(FALSE, TRUE, sizeof(struct catalog_record));
+    GString *arena = g_string_new(NULL);
+    /* The offset 0 is the empty string */
+    g_string_append_c(arena, '\0');
+    GHashTable *offsets = g_hash_table_new(g_str_hash, g_str_equal);
+
+    for (GList *iter = entries; iter != NULL; iter = g_list_next(iter))
+    {
+        const struct abrt_catalog_entry *entry = iter->data;
+
+        struct catalog_record record = {
+            .dirname = arena_add(arena, offsets, entry->dirname),
+            .type = arena_add(arena, offsets, entry->type),
+            .executable = arena_add(arena, offsets, entry->executable),
+            .component = arena_add(arena, offsets, entry->component),
+            .duphash = arena_add(arena, offsets, entry->duphash),
+            .uid = entry->uid,
+            .owner = entry->owner,
+            .group = entry->group,
+            .mode = entry->mode,
+            .count = entry->count,
+            .flags = entry->reported ? CATALOG_FLAG_REPORTED : 0,
+            .first_occurrence = entry->first_occurrence,
+            .last_occurrence = entry->last_occurrence,
+            .mtime = timespec_to_ns(&entry->mtime),
+        };
+        g_array_append_val(records, record);
+    }
+    g_hash_table_destroy(offsets);
+
+    const size_t records_size = records->len * sizeof(struct catalog_record);
+
+    struct catalog_header header = {
+        .magic = CATALOG_MAGIC,
+        .version = CATALOG_VERSION,
+        .record_size = sizeof(struct catalog_record),
+        .dev = dump_location_stat.st_dev,
+        .ino = dump_location_stat.st_ino,
+        .writer_pid = getpid(),
+        .count = records->len,
+        .arena_size = arena->len,
+        .generation = generation,
+        .dump_location_mtime = timespec_to_ns(dump_location_mtime),
+        .listed = timespec_to_ns(listed),
+    };
+    header.checksum = checksum_update(CHECKSUM_INIT, records->data, records_size);
+    header.checksum = checksum_update(header.checksum, arena->str, arena->len);
+
+    int retval = -1;
+    g_autofree char *dir = g_build_filename(dump_location, ABRT_CATALOG_DIR_NAME, NULL);
+    g_autofree char *path = catalog_path(dump_location);
+    g_autofree char *tmp_path = g_strdup_printf("%s.new", path);
+
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST)
+    {
+        perror_msg("Can't create '%s'", dir);
+        goto ret;
+    }
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0)
+    {
+        perror_msg("Can't create '%s'", tmp_path);
+        goto ret;
+    }
+
+    const bool written = libreport_full_write(fd, &header, sizeof(header)) == sizeof(header)
+                      && libreport_full_write(fd, records->data, records_size) == records_size
+                      && libreport_full_write(fd, arena->str, arena->len) == arena->len;
+    close(fd);
+
+    if (!written)
+    {
+        perror_msg("Can't write '%s'", tmp_path);
+        unlink(tmp_path);
+        goto ret;
+    }
+
+    if (rename(tmp_path, path) != 0)
+    {
+        perror_msg("Can't rename '%s' to '%s'", tmp_path, path);
+        unlink(tmp_path);
+        goto ret;
+    }
+
+    log_debug("Written catalog of %u problems (%zu bytes of strings)", records->len, arena->len);
+    retval = 0;
+
+ret:
+    g_array_free(records, TRUE);
+    g_string_free(arena, TRUE);
+    return retval;
+}
+
+void abrt_catalog_remove(const char *dump_location)
+{
+    g_autofree char *path = catalog_path(dump_location);
+    if (unlink(path) != 0 && errno != ENOENT)
+        perror_msg("Can't remove '%s'", path);
+}
+
+/* Checks that the catalog belongs to the dump location, is maintained by a
+ * running abrtd and lists the current problem directories. Nothing but the
+ * header is read.
+ */
+static bool catalog_header_is_current(const struct catalog_header *header, const char *dump_location)
+{
+    if (memcmp(header->magic, CATALOG_MAGIC, sizeof(header->magic)) != 0
+     || header->version != CATALOG_VERSION
+     || header->record_size != sizeof(struct catalog_record))
+    {
+        log_debug("Catalog has unknown format");
+        return false;
+    }
+
+    struct stat statbuf;
+    if (stat(dump_location, &statbuf) != 0
+     || statbuf.st_dev != header->dev || statbuf.st_ino != header->ino)
+    {
+        log_debug("Catalog was built for another dump location");
+        return false;
+    }
+
+    if (timespec_to_ns(&statbuf.st_mtim) != header->dump_location_mtime
+     || header->listed - header->dump_location_mtime < CATALOG_MTIME_GRANULARITY_NS)
+    {
+        log_debug("Catalog does not list the current problem directories");
+        return false;
+    }
+
+    if (header->writer_pid == 0 || (kill(header->writer_pid, 0) != 0 && errno != EPERM))
+    {
+        log_debug("Catalog is not maintained by any process");
+        return false;
+    }
+
+    return true;
+}
+
+/* Checks that the mapped file is complete and current. The entries of the
+ * directories changed since are not checked here.
+ */
+static bool catalog_is_consistent(const struct abrt_catalog *catalog, const char *dump_location)
+{
+    const struct catalog_header *header = catalog->header;
+
+    if (!catalog_header_is_current(header, dump_location))
+        return false;
+
+    const uint64_t expected_size = sizeof(*header)
+                                 + (uint64_t)header->count * sizeof(struct catalog_record)
+                                 + header->arena_size;
+    if (catalog->size != expected_size || header->arena_size == 0)
+    {
+        log_debug("Catalog is truncated");
+        return false;
+    }
+
+    uint64_t checksum = checksum_update(CHECKSUM_INIT, catalog->records,
+                                        header->count * sizeof(struct catalog_record));
+    checksum = checksum_update(checksum, catalog->arena, header->arena_size);
+    if (checksum != header->checksum)
+    {
+        log_debug("Catalog checksum mismatch");
+        return false;
+    }
+
+    if (catalog->arena[0] != '\0' || catalog->arena[header->arena_size - 1] != '\0')
+    {
+        log_debug("Catalog has corrupted strings");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header->count; i++)
+    {
+        const struct catalog_record *record = catalog->records + i;
+        if (record->dirname == 0
+         || record->dirname >= header->arena_size
+         || record->type >= header->arena_size
+         || record->executable >= header->arena_size
+         || record->component >= header->arena_size
+         || record->duphash >= header->arena_size)
+        {
+            log_debug("Catalog record %u is corrupted", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+struct abrt_catalog *abrt_catalog_open(const char *dump_location)
+{
+    g_autofree char *path = catalog_path(dump_location);
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't open '%s'", path);
+        return NULL;
+    }
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0 || !S_ISREG(statbuf.st_mode)
+     || statbuf.st_size < (off_t)sizeof(struct catalog_header))
+    {
+        log_debug("'%s' is not a catalog", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror_msg("Can't map '%s'", path);
+        return NULL;
+    }
+
+    struct abrt_catalog *catalog = g_new0(struct abrt_catalog, 1);
+    catalog->map = map;
+    catalog->size = statbuf.st_size;
+    catalog->header = map;
+    catalog->records = (const struct catalog_record *)(catalog->header + 1);
+    catalog->arena = (const char *)(catalog->records + catalog->header->count);
+
+    if (!catalog_is_consistent(catalog, dump_location))
+    {
+        abrt_catalog_close(catalog);
+        return NULL;
+    }
+
+    return catalog;
+}
+
+void abrt_catalog_close(struct abrt_catalog *catalog)
+{
+    if (catalog == NULL)
+        return;
+
+    munmap(catalog->map, catalog->size);
+    free(catalog);
+}
+
+unsigned abrt_catalog_count(const struct abrt_catalog *catalog)
+{
+    return catalog->header->count;
+}
+
+uint64_t abrt_catalog_generation(const struct abrt_catalog *catalog)
+{
+    return catalog->header->generation;
+}
+
+bool abrt_catalog_read_generation(const char *dump_location, uint64_t *generation)
+{
+    g_autofree char *path = catalog_path(dump_location);
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0)
+    {
+        if (errno != ENOENT)
+            perror_msg("Can't open '%s'", path);
+        return false;
+    }
+
+    struct catalog_header header;
+    const ssize_t rd = pread(fd, &header, sizeof(header), 0);
+    close(fd);
+    if (rd != sizeof(header) || !catalog_header_is_current(&header, dump_location))
+        return false;
+
+    *generation = header.generation;
+    return true;
+}
+
+static const char *arena_string(const struct abrt_catalog *catalog, uint32_t offset)
+{
+    return offset != 0 ? catalog->arena + offset : NULL;
+}
+
+void abrt_catalog_get(const struct abrt_catalog *catalog, unsigned i, struct abrt_catalog_entry *entry)
+{
+    const struct catalog_record *record = catalog->records + i;
+
+    entry->dirname = arena_string(catalog, record->dirname);
+    entry->type = arena_string(catalog, record->type);
+    entry->executable = arena_string(catalog, record->executable);
+    entry->component = arena_string(catalog, record->component);
+    entry->duphash = arena_string(catalog, record->duphash);
+    entry->uid = record->uid;
+    entry->owner = record->owner;
+    entry->group = record->group;
+    entry->mode = record->mode;
+    entry->count = record->count;
+    entry->reported = record->flags & CATALOG_FLAG_REPORTED;
+    entry->first_occurrence = record->first_occurrence;
+    entry->last_occurrence = record->last_occurrence;
+    entry->mtime = timespec_from_ns(record->mtime);
+}
+
+const char *abrt_catalog_entry_element(const struct abrt_catalog_entry *entry, const char *name)
+{
+    if (strcmp(name, FILENAME_TYPE) == 0)
+        return entry->type;
+    if (strcmp(name, FILENAME_EXECUTABLE) == 0)
+        return entry->executable;
+    if (strcmp(name, FILENAME_COMPONENT) == 0)
+        return entry->component;
+    if (strcmp(name, FILENAME_DUPHASH) == 0)
+        return entry->duphash;
+
+    return NULL;
+}
+
+bool abrt_catalog_has_element(const char *name)
+{
+    return strcmp(name, FILENAME_TYPE) == 0
+        || strcmp(name, FILENAME_EXECUTABLE) == 0
+        || strcmp(name, FILENAME_COMPONENT) == 0
+        || strcmp(name, FILENAME_DUPHASH) == 0;
+}
@@ -15,97 +15,18 @@
 #include "libabrt.h"
 #include "abrt-journal.h"
 #include "xorg-utils.h"
-#define ABRT_JOURNAL_XORG_WATCH_STATE_FILE VAR_STATE"/abrt-dump-journal-xorg.state"
-#define XORG_CONF "xorg.conf"
+#include "journal-xorg-utils.h"
+#define ABRT_JOURNAL_XORG_WATCH_STATE_FILE ABRT_JOURNAL_XORG_STATE_FILE
 #define XORG_CONF_PATH PLUGINS_CONF_DIR XORG_CONF
-#define XORG_DEFAULT_JOURNAL_FILTERS "_COMM=gdm-x-session, _COMM=gnome-shell"
-
-static void
-abrt_xorg_process_list_of_crashes(GList *crashes, const char *dump_location, int flags)
-{
-    if (crashes == NULL)
-        return;
-
-    GList *list;
-    for (list = crashes; list != NULL; list = list->next)
-    {
-        xorg_crash_info_create_dump_dir(list->data, dump_location, (flags & ABRT_XORG_WORLD_READABLE));
-
-        if (flags & ABRT_XORG_PRINT_STDOUT)
-            xorg_crash_info_print_crash(list->data);
-
-        if (flags & ABRT_XORG_THROTTLE_CREATION)
-            if (abrt_xorg_signaled_sleep(1) > 0)
-                break;
-    }
-
-    return;
-}
-
-static GList *abrt_journal_extract_xorg_crashes(abrt_journal_t *journal)
-{
-    GList *crash_info_list = NULL;
-
-    do
-    {
-        g_autofree char *line = abrt_journal_get_log_line(journal);
-        if (line == NULL)
-            error_msg_and_die(_("Cannot read journal data."));
-
-        char *p = skip_pfx(line);
-        if (strcmp(p, XORG_SEARCH_STRING) == 0)
-        {
-            struct xorg_crash_info *crash_info = process_xorg_bt(&abrt_journal_get_next_log_line, journal);
-            if (crash_info)
-                crash_info_list = g_list_append(crash_info_list, crash_info);
-            else
-                log_warning(_("Failed to parse Backtrace from journal"));
-        }
-    }
-    while (abrt_journal_next(journal) > 0);
-
-    log_warning("Found crashes: %d", g_list_length(crash_info_list));
-
-    return crash_info_list;
-}
-
-struct watch_journald_xorg_settings
-{
-    const char *dump_location;
-    int xorg_utils_flags;
-};
-
-static void abrt_journal_watch_extract_xorg_crashes(abrt_journal_watch_t *watch, void *data)
-{
-    const struct watch_journald_xorg_settings *conf = (const struct watch_journald_xorg_settings *)data;
-
-    abrt_journal_t *journal = abrt_journal_watch_get_journal(watch);
-
-    /* Give systemd-journal one second to suck in all crash strings */
-    if (abrt_xorg_signaled_sleep(1) > 0)
-    {
-        abrt_journal_watch_stop(watch);
-        return;
-    }
-
-    GList *crashes = abrt_journal_extract_xorg_crashes(journal);
-    abrt_xorg_process_list_of_crashes(crashes, conf->dump_location, conf->xorg_utils_flags);
-    g_list_free_full(crashes, (GDestroyNotify)xorg_crash_info_free);
-
-    /* In case of disaster, lets make sure we won't read the journal messages */
-    /* again. */
-    abrt_journal_save_current_position(journal, ABRT_JOURNAL_XORG_WATCH_STATE_FILE);
-
-    if (g_abrt_xorg_sleep_woke_up_on_signal > 0)
-        abrt_journal_watch_stop(watch);
-}
 
 static void watch_journald(abrt_journal_t *journal, const char *dump_location, int flags)
 {
     GList *xorg_strings = NULL;
     xorg_strings = g_list_prepend(xorg_strings, (gpointer)XORG_SEARCH_STRING);
 
-    struct watch_journald_xorg_settings watch_conf = {
+    struct abrt_pattern_set *xorg_patterns = abrt_pattern_set_new(xorg_strings, NULL);
+
+    struct abrt_journal_xorg_watch_settings watch_conf = {
         .dump_location = dump_location,
         .xorg_utils_flags = flags,
     };
@@ -113,8 +34,7 @@ static void watch_journald(abrt_journal_t *journal, const char *dump_location, i
     struct abrt_journal_watch_notify_strings notify_strings_conf = {
         .decorated_cb = abrt_journal_watch_extract_xorg_crashes,
         .decorated_cb_data = &watch_conf,
-        .strings = xorg_strings,
-        .blacklisted_strings = NULL,
+        .patterns = xorg_patterns,
     };
 
     abrt_journal_watch_t *watch = NULL;
@@ -124,6 +44,7 @@ static void watch_journald(abrt_journal_t *journal, const char *dump_location, i
     abrt_journal_watch_run_sync(watch);
     abrt_journal_watch_free(watch);
 
+    abrt_pattern_set_free(xorg_patterns);
     g_list_free(xorg_strings);
 }
 
@@ -235,37 +156,8 @@ int main(int argc, char *argv[])
         xorg_utils_flags |= ABRT_XORG_PRINT_STDOUT;
 
     /* get journal filters */
-    const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_XORG_DEBUG_FILTER");
-    bool free_filter_list_data = false;
-    GList *xorg_journal_filter = NULL;
-    if (env_journal_filter != NULL)
-    {
-        xorg_journal_filter = g_list_append(xorg_journal_filter, (gpointer)env_journal_filter);
-        log_debug("Using journal filter from environment variable");
-    }
-    else if (journal_filters != NULL)
-    {
-        xorg_journal_filter = journal_filters;
-        log_debug("Using journal filter passed by parameter -j");
-    }
-    else
-    {
-        g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
-        log_notice("Loading settings from '%s'", XORG_CONF);
-        abrt_load_abrt_plugin_conf_file(XORG_CONF, settings);
-        log_debug("Loaded '%s'", XORG_CONF);
-
-        const char *conf_journal_filters = g_hash_table_lookup(settings, "JournalFilters");
-        if (!conf_journal_filters) {
-            conf_journal_filters = XORG_DEFAULT_JOURNAL_FILTERS;
-        }
-
-        xorg_journal_filter = libreport_parse_delimited_list(conf_journal_filters, ",");
-        /* list data will be free by g_list_free_full */
-        free_filter_list_data = true;
-        if (xorg_journal_filter)
-            log_debug("Using journal filter from conf file %s", XORG_CONF);
-    }
+    GList *xorg_journal_filter = abrt_journal_xorg_journal_filter(journal_filters);
+    g_list_free(journal_filters);
 
     if (xorg_journal_filter == NULL)
         error_msg_and_die(_("Journal filter must be specified either by parameter -j or stored in /etc/abrt/plugins/xorg.conf file"));
@@ -284,14 +176,12 @@ int main(int argc, char *argv[])
             error_msg_and_die(_("Cannot open systemd-journal"));
     }
 
+    abrt_journal_set_data_threshold(journal, ABRT_JOURNAL_XORG_DATA_THRESHOLD);
+
     if (abrt_journal_set_journal_filter(journal, xorg_journal_filter) < 0)
         error_msg_and_die(_("Cannot filter systemd-journal to Xorg data only"));
 
-    /* free filter list */
-    if (free_filter_list_data)
-        g_list_free_full(xorg_journal_filter, free);
-    else
-        g_list_free(xorg_journal_filter);
+    g_list_free_full(xorg_journal_filter, free);
 
     if ((opts & OPT_e) && abrt_journal_seek_tail(journal) < 0)
         error_msg_and_die(_("Cannot seek to the end of journal"));
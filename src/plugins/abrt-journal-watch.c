@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ * Copyright (C) 2026  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "libabrt.h"
+#include "abrt-journal.h"
+#include "journal-core-utils.h"
+#include "journal-oops-utils.h"
+#include "journal-xorg-utils.h"
+
+/*
+ * A source of problems found in systemd-journal
+ *
+ * All sources share a single journal opened with a group of matches for every
+ * source. A message is passed to the call back of every source whose filter
+ * the message satisfies. The call back may read more messages but it sees
+ * only messages of its source (see abrt_journal_set_view()) and the journal is
+ * moved back to the dispatched message afterwards.
+ */
+struct journal_source
+{
+    const char *js_name;
+    const char *js_state_file;
+    /* Start at the end of journal if the last seen position is not available */
+    bool js_tail_by_default;
+
+    GList *js_filter;
+    /* Longest field the call back needs complete, 0 means no limit */
+    size_t js_data_threshold;
+    abrt_journal_watch_callback js_callback;
+    void *js_callback_data;
+
+    /* Seeks to the last seen position, NULL for the plain state file */
+    int (*js_restore_position)(struct journal_source *source, abrt_journal_t *journal);
+
+    /* Messages of the source up to this position have been processed
+     * already, either in the previous run or by the call back which read
+     * more messages */
+    char *js_seen_cursor;
+    uint64_t js_seen_realtime;
+};
+
+static void journal_source_forget_seen(struct journal_source *source)
+{
+    g_free(source->js_seen_cursor);
+    source->js_seen_cursor = NULL;
+}
+
+static void journal_source_set_seen(struct journal_source *source, abrt_journal_t *journal)
+{
+    journal_source_forget_seen(source);
+
+    if (abrt_journal_get_cursor(journal, &(source->js_seen_cursor)) < 0)
+        return;
+
+    if (abrt_journal_get_realtime(journal, &(source->js_seen_realtime)) < 0)
+        journal_source_forget_seen(source);
+}
+
+/* Returns true if the current message has been processed already */
+static bool journal_source_seen(struct journal_source *source, abrt_journal_t *journal, uint64_t realtime)
+{
+    if (source->js_seen_cursor == NULL)
+        return false;
+
+    if (abrt_journal_test_cursor(journal, source->js_seen_cursor) > 0)
+    {
+        journal_source_forget_seen(source);
+        return true;
+    }
+
+    /* The message at the cursor may have been vacuumed or may belong to
+     * another source, the time stamp ensures the source does not remain
+     * muted forever */
+    if (realtime <= source->js_seen_realtime)
+        return true;
+
+    journal_source_forget_seen(source);
+    return false;
+}
+
+static void dispatch_message(abrt_journal_watch_t *watch, void *data)
+{
+    GList *sources = (GList *)data;
+    abrt_journal_t *journal = abrt_journal_watch_get_journal(watch);
+
+    uint64_t realtime = 0;
+    abrt_journal_get_realtime(journal, &realtime);
+
+    for (GList *l = sources; l != NULL; l = l->next)
+    {
+        struct journal_source *source = l->data;
+
+        if (!abrt_journal_test_filter(journal, source->js_filter))
+            continue;
+
+        if (journal_source_seen(source, journal, realtime))
+        {
+            log_debug("Skipping %s message processed already", source->js_name);
+            continue;
+        }
+
+        g_autofree char *cursor = NULL;
+        if (abrt_journal_get_cursor(journal, &cursor) < 0)
+            return;
+
+        abrt_journal_set_view(journal, source->js_filter);
+        source->js_callback(watch, source->js_callback_data);
+        abrt_journal_set_view(journal, NULL);
+
+        if (abrt_journal_test_cursor(journal, cursor) > 0)
+            continue;
+
+        /* The call back has read more messages, do not pass them to the
+         * source again */
+        journal_source_set_seen(source, journal);
+
+        if (abrt_journal_set_cursor(journal, cursor) < 0 || abrt_journal_next(journal) <= 0)
+            error_msg_and_die(_("Cannot return to journal message '%s'"), cursor);
+    }
+}
+
+static int restore_core_position(struct journal_source *source, abrt_journal_t *journal)
+{
+    const abrt_watch_core_conf_t *conf = (const abrt_watch_core_conf_t *)source->js_callback_data;
+
+    return abrt_journal_core_restore_position(journal,
+            (conf->awc_run_flags & ABRT_CORE_PRINT_STDOUT) ? NULL : conf->awc_dump_location);
+}
+
+static int restore_position(struct journal_source *source, abrt_journal_t *journal)
+{
+    if (source->js_restore_position != NULL)
+        return source->js_restore_position(source, journal);
+
+    return abrt_journal_restore_position(journal, source->js_state_file);
+}
+
+/*
+ * Moves every source to its last seen position and then moves the journal to
+ * the oldest of them.
+ */
+static void restore_positions(abrt_journal_t *journal, GList *sources, bool from_tail)
+{
+    bool from_head = false;
+    struct journal_source *oldest = NULL;
+
+    for (GList *l = sources; l != NULL; l = l->next)
+    {
+        struct journal_source *source = l->data;
+
+        if (!from_tail
+            && restore_position(source, journal) == 0
+            && abrt_journal_next(journal) > 0)
+        {
+            journal_source_set_seen(source, journal);
+        }
+        else if (from_tail || source->js_tail_by_default)
+        {
+            if (abrt_journal_seek_tail(journal) < 0)
+                error_msg_and_die(_("Cannot seek to the end of journal"));
+
+            journal_source_set_seen(source, journal);
+        }
+
+        if (source->js_seen_cursor == NULL)
+            from_head = true;
+        else if (oldest == NULL || source->js_seen_realtime < oldest->js_seen_realtime)
+            oldest = source;
+    }
+
+    if (from_head || oldest == NULL)
+    {
+        if (abrt_journal_seek_head(journal) < 0)
+            error_msg_and_die(_("Cannot seek to the beginning of journal"));
+    }
+    else
+    {
+        log_debug("Starting at the last seen %s message", oldest->js_name);
+
+        /* The watch moves to the message and skips it as seen */
+        if (abrt_journal_set_cursor(journal, oldest->js_seen_cursor) < 0)
+            error_msg_and_die(_("Failed to set systemd-journal cursor '%s'"), oldest->js_seen_cursor);
+    }
+}
+
+static void save_positions(abrt_journal_t *journal, GList *sources)
+{
+    for (GList *l = sources; l != NULL; l = l->next)
+    {
+        struct journal_source *source = l->data;
+
+        /* The source saved a later position when it read more messages */
+        if (source->js_seen_cursor == NULL)
+            abrt_journal_save_current_position(journal, source->js_state_file);
+
+        journal_source_forget_seen(source);
+    }
+}
+
+static bool source_enabled(GList *names, const char *name)
+{
+    return names == NULL || g_list_find_custom(names, name, (GCompareFunc)strcmp) != NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    /* I18n */
+    setlocale(LC_ALL, "");
+#if ENABLE_NLS
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+#endif
+
+    abrt_init(argv);
+
+    /* Can't keep these strings/structs static: _() doesn't support that */
+    const char *program_usage_string = _(
+        "& [-vsoxt] [-e] [-T INT] [-S SOURCE]... [-d DIR]/[-D]\n"
+        "\n"
+        "Follow systemd-journal and extract coredumps, oopses and Xorg crashes\n"
+        "\n"
+        "The journal is opened only once for all sources. Every source starts\n"
+        "at its last seen position which is shared with abrt-dump-journal-core,\n"
+        "abrt-dump-journal-oops and abrt-dump-journal-xorg.\n"
+        "\n"
+        "SOURCE is one of core, oops and xorg. All sources are followed by default.\n"
+    );
+    enum {
+        OPT_v = 1 << 0,
+        OPT_s = 1 << 1,
+        OPT_o = 1 << 2,
+        OPT_d = 1 << 3,
+        OPT_D = 1 << 4,
+        OPT_x = 1 << 5,
+        OPT_t = 1 << 6,
+        OPT_T = 1 << 7,
+        OPT_e = 1 << 8,
+        OPT_a = 1 << 9,
+        OPT_J = 1 << 10,
+        OPT_S = 1 << 11,
+    };
+
+    char *dump_location = NULL;
+    char *journal_dir = NULL;
+    int core_throttle = 0;
+    GList *source_names = NULL;
+
+    /* Keep enum above and order of options below in sync! */
+    struct options program_options[] = {
+        OPT__VERBOSE(&libreport_g_verbose),
+        OPT_BOOL(  's', NULL, NULL, _("Log to syslog")),
+        OPT_BOOL(  'o', NULL, NULL, _("Print found problems on standard output")),
+        OPT_STRING('d', NULL, &dump_location, "DIR", _("Create new problem directory in DIR for every problem found")),
+        OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
+        OPT_BOOL(  'x', NULL, NULL, _("Make the oops and Xorg problem directories world readable")),
+        OPT_BOOL(  't', NULL, NULL, _("Throttle oops and Xorg problem directory creation to 1 per second")),
+        OPT_INTEGER('T', NULL, &core_throttle, _("Throttle coredump problem directory creation to 1 per INT second")),
+        OPT_BOOL(  'e', NULL, NULL, _("Start reading systemd-journal from the end")),
+        OPT_BOOL(  'a', NULL, NULL, _("Read journal files from all machines")),
+        OPT_STRING('J', NULL, &journal_dir,  "PATH", _("Read all journal files from directory at PATH")),
+        OPT_LIST(  'S', NULL, &source_names, "SOURCE", _("Follow only SOURCE (may be given many times)")),
+        OPT_END()
+    };
+    unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
+
+    libreport_export_abrt_envvars(0);
+
+    libreport_msg_prefix = libreport_g_progname;
+    if ((opts & OPT_s) || getenv("ABRT_SYSLOG"))
+    {
+        libreport_logmode = LOGMODE_JOURNAL;
+    }
+
+    for (GList *l = source_names; l != NULL; l = l->next)
+    {
+        if (strcmp(l->data, "core") != 0 && strcmp(l->data, "oops") != 0 && strcmp(l->data, "xorg") != 0)
+            error_msg_and_die(_("Unknown source '%s'"), (const char *)l->data);
+    }
+
+    if (opts & OPT_D)
+    {
+        if (opts & OPT_d)
+            libreport_show_usage_and_die(program_usage_string, program_options);
+        abrt_load_abrt_conf();
+        dump_location = abrt_g_settings_dump_location;
+        abrt_g_settings_dump_location = NULL;
+        abrt_free_abrt_conf_data();
+    }
+
+    GList *sources = NULL;
+
+    /* Coredumps */
+    abrt_watch_core_conf_t core_conf = {
+        .awc_dump_location = dump_location,
+        .awc_throttle = core_throttle,
+        .awc_run_flags = (opts & OPT_o) ? ABRT_CORE_PRINT_STDOUT : 0,
+        .awc_checkpoint = abrt_journal_checkpoint_new(ABRT_JOURNAL_CORE_STATE_FILE,
+                ABRT_JOURNAL_CHECKPOINT_MAX_MESSAGES, ABRT_JOURNAL_CHECKPOINT_MAX_DELAY_MS),
+    };
+
+    struct journal_source core_source = {
+        .js_name = "core",
+        .js_state_file = ABRT_JOURNAL_CORE_STATE_FILE,
+        .js_tail_by_default = true,
+        .js_filter = abrt_journal_core_journal_filter(),
+        .js_data_threshold = ABRT_JOURNAL_CORE_DATA_THRESHOLD,
+        .js_callback = abrt_journal_watch_cores,
+        .js_callback_data = &core_conf,
+        .js_restore_position = restore_core_position,
+    };
+
+    if (source_enabled(source_names, core_source.js_name))
+        sources = g_list_append(sources, &core_source);
+
+    /* Oopses */
+    struct abrt_pattern_set *oops_patterns = NULL;
+    struct abrt_journal_oops_watch_settings oops_conf = {
+        .dump_location = dump_location,
+        .oops_utils_flags = ((opts & OPT_x) ? ABRT_OOPS_WORLD_READABLE : 0)
+                          | ((opts & OPT_t) ? ABRT_OOPS_THROTTLE_CREATION : 0)
+                          | ((opts & OPT_o) ? ABRT_OOPS_PRINT_STDOUT : 0),
+    };
+
+    struct abrt_journal_watch_notify_strings oops_notify_conf = {
+        .decorated_cb = abrt_journal_watch_extract_kernel_oops,
+        .decorated_cb_data = &oops_conf,
+        .patterns = NULL,
+    };
+
+    struct journal_source oops_source = {
+        .js_name = "oops",
+        .js_state_file = ABRT_JOURNAL_OOPS_STATE_FILE,
+        .js_tail_by_default = true,
+        .js_filter = abrt_journal_oops_journal_filter(),
+        .js_data_threshold = ABRT_JOURNAL_OOPS_DATA_THRESHOLD,
+        .js_callback = abrt_journal_watch_notify_strings,
+        .js_callback_data = &oops_notify_conf,
+    };
+
+    if (source_enabled(source_names, oops_source.js_name))
+    {
+        GList *koops_strings = abrt_journal_oops_suspicious_strings();
+        GList *koops_strings_blacklist = abrt_koops_suspicious_strings_blacklist();
+        oops_notify_conf.patterns = oops_patterns = abrt_pattern_set_new(koops_strings, koops_strings_blacklist);
+        g_list_free(koops_strings_blacklist);
+        g_list_free(koops_strings);
+        sources = g_list_append(sources, &oops_source);
+    }
+
+    /* Xorg crashes */
+    struct abrt_journal_xorg_watch_settings xorg_conf = {
+        .dump_location = dump_location,
+        .xorg_utils_flags = ((opts & OPT_x) ? ABRT_XORG_WORLD_READABLE : 0)
+                          | ((opts & OPT_t) ? ABRT_XORG_THROTTLE_CREATION : 0)
+                          | ((opts & OPT_o) ? ABRT_XORG_PRINT_STDOUT : 0),
+    };
+
+    GList *xorg_strings = g_list_prepend(NULL, (gpointer)XORG_SEARCH_STRING);
+    struct abrt_pattern_set *xorg_patterns = abrt_pattern_set_new(xorg_strings, NULL);
+    g_list_free(xorg_strings);
+
+    struct abrt_journal_watch_notify_strings xorg_notify_conf = {
+        .decorated_cb = abrt_journal_watch_extract_xorg_crashes,
+        .decorated_cb_data = &xorg_conf,
+        .patterns = xorg_patterns,
+    };
+
+    struct journal_source xorg_source = {
+        .js_name = "xorg",
+        .js_state_file = ABRT_JOURNAL_XORG_STATE_FILE,
+        .js_tail_by_default = false,
+        .js_filter = NULL,
+        .js_data_threshold = ABRT_JOURNAL_XORG_DATA_THRESHOLD,
+        .js_callback = abrt_journal_watch_notify_strings,
+        .js_callback_data = &xorg_notify_conf,
+    };
+
+    if (source_enabled(source_names, xorg_source.js_name))
+    {
+        xorg_source.js_filter = abrt_journal_xorg_journal_filter(NULL);
+        if (xorg_source.js_filter != NULL)
+            sources = g_list_append(sources, &xorg_source);
+        else
+            error_msg(_("Not following Xorg crashes: journal filter is not specified in %s"), XORG_CONF);
+    }
+
+    if (sources == NULL)
+        error_msg_and_die(_("Nothing to follow"));
+
+    abrt_journal_t *journal = NULL;
+    if ((opts & OPT_J))
+    {
+        log_debug("Using journal files from directory '%s'", journal_dir);
+
+        if (abrt_journal_open_directory(&journal, journal_dir))
+            error_msg_and_die(_("Cannot initialize systemd-journal in directory '%s'"), journal_dir);
+    }
+    else
+    {
+        if (((opts & OPT_a) ? abrt_journal_new_merged : abrt_journal_new)(&journal))
+            error_msg_and_die(_("Cannot open systemd-journal"));
+    }
+
+    /* The journal is shared, so use the threshold of the most demanding source */
+    size_t data_threshold = 1;
+    for (GList *l = sources; l != NULL; l = l->next)
+    {
+        struct journal_source *source = l->data;
+        if (abrt_journal_add_journal_filter_group(journal, source->js_filter) < 0)
+            error_msg_and_die(_("Cannot filter systemd-journal to %s data"), source->js_name);
+
+        if (data_threshold != 0 && (source->js_data_threshold == 0 || source->js_data_threshold > data_threshold))
+            data_threshold = source->js_data_threshold;
+    }
+
+    abrt_journal_set_data_threshold(journal, data_threshold);
+
+    restore_positions(journal, sources, (opts & OPT_e));
+
+    abrt_journal_watch_t *watch = NULL;
+    if (abrt_journal_watch_new(&watch, journal, dispatch_message, sources) < 0)
+        error_msg_and_die(_("Failed to initialize systemd-journal watch"));
+
+    abrt_journal_watch_add_checkpoint(watch, core_conf.awc_checkpoint);
+
+    abrt_journal_watch_run_sync(watch);
+    abrt_journal_watch_free(watch);
+
+    save_positions(journal, sources);
+
+    abrt_journal_free(journal);
+
+    abrt_journal_checkpoint_free(core_conf.awc_checkpoint);
+    g_list_free(sources);
+    g_list_free(core_source.js_filter);
+    g_list_free(oops_source.js_filter);
+    abrt_pattern_set_free(oops_patterns);
+    g_list_free_full(xorg_source.js_filter, free);
+    abrt_pattern_set_free(xorg_patterns);
+
+    return EXIT_SUCCESS;
+}
@@ -17,6 +17,7 @@
 #include <poll.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "abrt-journal.h"
 #include "libabrt.h"
@@ -24,10 +25,10 @@
 #include <systemd/sd-journal.h>
 
 /*
- * http://www.freedesktop.org/software/systemd/man/sd_journal_get_data.html
- * sd_journal_set_data_threshold() : This threshold defaults to 64K by default.
+ * http://www.freedesktop.org/software/systemd/man/systemd.journal-fields.html
+ * Field names are at most 64 characters long.
  */
-#define JOURNALD_MAX_FIELD_SIZE (64*1024)
+#define JOURNALD_MAX_FIELD_NAME_SIZE 64
 
 #define ABRT_JOURNAL_WATCH_STATE_FILE_MODE 0600
 #define ABRT_JOURNAL_WATCH_STATE_FILE_MAX_SZ (4 * 1024)
@@ -36,6 +37,9 @@ struct abrt_journal
 {
     sd_journal *j;
     int fd;
+
+    /* abrt_journal_next() skips messages not satisfying this filter */
+    GList *view;
 };
 
 static int abrt_journal_new_flags(abrt_journal_t **journal, int flags)
@@ -113,6 +117,86 @@ int abrt_journal_set_journal_filter(abrt_journal_t *journal, GList *journal_filt
     return 0;
 }
 
+int abrt_journal_set_data_threshold(abrt_journal_t *journal, size_t threshold)
+{
+    const int r = sd_journal_set_data_threshold(journal->j, threshold);
+    if (r < 0)
+        log_notice("Failed to set journal data threshold: %s", strerror(-r));
+
+    return r;
+}
+
+int abrt_journal_add_journal_filter_group(abrt_journal_t *journal, GList *journal_filter_list)
+{
+    int r = abrt_journal_set_journal_filter(journal, journal_filter_list);
+    if (r < 0)
+        return r;
+
+    r = sd_journal_add_disjunction(journal->j);
+    if (r < 0)
+    {
+        log_notice("Failed to add journal filter disjunction: %s", strerror(-r));
+        return r;
+    }
+
+    return 0;
+}
+
+/*
+ * Evaluates the filter in the same way as systemd-journal evaluates matches:
+ * matches of the same field are OR-ed and matches of different fields are
+ * AND-ed.
+ */
+bool abrt_journal_test_filter(abrt_journal_t *journal, GList *journal_filter_list)
+{
+    for (GList *l = journal_filter_list; l != NULL; l = l->next)
+    {
+        const char *match = l->data;
+        const char *eq = strchr(match, '=');
+        if (eq == NULL || eq - match > JOURNALD_MAX_FIELD_NAME_SIZE)
+            return false;
+
+        const size_t pfx_len = eq - match + 1;
+
+        /* All matches of a field are tested at its first match */
+        GList *p = journal_filter_list;
+        while (p != l && strncmp(p->data, match, pfx_len) != 0)
+            p = p->next;
+
+        if (p != l)
+            continue;
+
+        char field[JOURNALD_MAX_FIELD_NAME_SIZE + 1];
+        memcpy(field, match, pfx_len - 1);
+        field[pfx_len - 1] = '\0';
+
+        /* The data are prefixed with 'FIELD=' */
+        const void *data;
+        size_t data_len;
+        if (sd_journal_get_data(journal->j, field, &data, &data_len) < 0)
+            return false;
+
+        for (; p != NULL; p = p->next)
+        {
+            const char *value = p->data;
+            if (strncmp(value, match, pfx_len) == 0
+                && strlen(value) == data_len
+                && memcmp(value, data, data_len) == 0)
+                break;
+        }
+
+        if (p == NULL)
+            return false;
+    }
+
+    return true;
+}
+
+void abrt_journal_set_view(abrt_journal_t *journal, GList *journal_filter_list)
+{
+    journal->view = journal_filter_list;
+}
+
 int abrt_journal_get_field(abrt_journal_t *journal, const char *field, const void **value, size_t *value_len)
 {
     const int r = sd_journal_get_data(journal->j, field, value, value_len);
@@ -135,43 +219,83 @@ int abrt_journal_get_field(abrt_journal_t *journal, const char *field, const voi
     return 0;
 }
 
-static long int abrt_journal_get_long(abrt_journal_t *journal,
-                                      const char     *key,
-                                      long int       *value)
+int abrt_journal_get_field_view(abrt_journal_t *journal, const char *field, abrt_journal_field_view_t *view)
 {
     const void *data;
-    size_t data_length;
-    int retval;
-    g_autofree char *data_string = NULL;
-    char *end;
+    const int r = abrt_journal_get_field(journal, field, &data, &(view->length));
+    if (r < 0)
+        return r;
+
+    view->data = data;
+    return 0;
+}
+
+/*
+ * Parses a decimal number in the same way as strtol(), but the data need not
+ * be NUL terminated. The whole data must be the number.
+ */
+static int parse_long(const char *data, size_t length, long int *value)
+{
+    const char *const end = data + length;
+    while (data < end && isspace((unsigned char)*data))
+        ++data;
 
-    retval = abrt_journal_get_field(journal, key, &data, &data_length);
-    if (retval < 0)
+    bool negative = false;
+    if (data < end && (*data == '-' || *data == '+'))
+        negative = (*(data++) == '-');
+
+    if (data == end)
+        return -EINVAL;
+
+    /* Accumulate negatively, LONG_MIN has no positive counterpart */
+    long int result = 0;
+    for (; data < end; ++data)
     {
-        return false;
-    }
-    data_string = g_strndup(data, data_length);
+        if (*data < '0' || *data > '9')
+            return -EINVAL;
 
-    errno = 0;
+        const int digit = *data - '0';
+        if (result < (LONG_MIN + digit) / 10)
+            return -ERANGE;
 
-    *value = strtol(data_string, &end, 10);
+        result = result * 10 - digit;
+    }
 
-    if (0 != errno)
+    if (!negative)
     {
-        char *error_message;
+        if (result == LONG_MIN)
+            return -ERANGE;
+
+        result = -result;
+    }
+
+    *value = result;
+    return 0;
+}
 
-        error_message = strerror(errno);
+static long int abrt_journal_get_long(abrt_journal_t *journal,
+                                      const char     *key,
+                                      long int       *value)
+{
+    abrt_journal_field_view_t view;
+    if (abrt_journal_get_field_view(journal, key, &view) < 0)
+    {
+        return false;
+    }
 
-        error_msg("Converting field “%s” value “%s” to integer failed: %s",
-                  key, data_string, error_message);
+    const int r = parse_long(view.data, view.length, value);
+    if (r == -ERANGE)
+    {
+        error_msg("Converting field “%s” value “%.*s” to integer failed: %s",
+                  key, (int)view.length, view.data, strerror(-r));
 
         return false;
     }
     /* No data or garbage after numeric data */
-    if (end == data_string || '\0' != *end)
+    if (r < 0)
     {
-        error_msg("Journal message field “%s” value “%s” is empty or not a number",
-                  key, data_string);
+        error_msg("Journal message field “%s” value “%.*s” is empty or not a number",
+                  key, (int)view.length, view.data);
         return false;
     }
 
@@ -294,9 +418,41 @@ int abrt_journal_seek_tail(abrt_journal_t *journal)
     return 0;
 }
 
+int abrt_journal_seek_head(abrt_journal_t *journal)
+{
+    const int r = sd_journal_seek_head(journal->j);
+    if (r < 0)
+    {
+        log_notice("Failed to seek journal to the beginning: %s\n", strerror(-r));
+        return r;
+    }
+
+    return 0;
+}
+
+int abrt_journal_test_cursor(abrt_journal_t *journal, const char *cursor)
+{
+    const int r = sd_journal_test_cursor(journal->j, cursor);
+    if (r < 0)
+        log_notice("Failed to test journal cursor '%s': %s", cursor, strerror(-r));
+    return r;
+}
+
+int abrt_journal_get_realtime(abrt_journal_t *journal, uint64_t *usec)
+{
+    const int r = sd_journal_get_realtime_usec(journal->j, usec);
+    if (r < 0)
+        log_notice("Failed to get the time of journal message: %s", strerror(-r));
+    return r;
+}
+
 int abrt_journal_next(abrt_journal_t *journal)
 {
-    const int r = sd_journal_next(journal->j);
+    int r;
+    do
+        r = sd_journal_next(journal->j);
+    while (r > 0 && journal->view != NULL && !abrt_journal_test_filter(journal, journal->view));
+
     if (r < 0)
         log_notice("Failed to iterate to next entry: %s", strerror(-r));
     return r;
@@ -314,19 +470,36 @@ int abrt_journal_save_current_position(abrt_journal_t *journal, const char *file
         return r;
     }
 
-    int state_fd = open(file_name,
+    /* Write a new file and rename it over the old one so that the old
+     * position survives a crash in the middle of writing */
+    g_autofree char *tmp_file_name = g_strdup_printf("%s.new", file_name);
+    int state_fd = open(tmp_file_name,
             O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
             ABRT_JOURNAL_WATCH_STATE_FILE_MODE);
 
     if (state_fd < 0)
     {
-        perror_msg(_("Cannot save journal watch's position: open('%s')"), file_name);
+        perror_msg(_("Cannot save journal watch's position: open('%s')"), tmp_file_name);
+        return -1;
+    }
+
+    if (libreport_full_write_str(state_fd, crsr) != (ssize_t)strlen(crsr) || fsync(state_fd) < 0)
+    {
+        perror_msg(_("Cannot save journal watch's position: write('%s')"), tmp_file_name);
+        close(state_fd);
+        unlink(tmp_file_name);
         return -1;
     }
 
-    libreport_full_write_str(state_fd, crsr);
     close(state_fd);
 
+    if (rename(tmp_file_name, file_name) < 0)
+    {
+        perror_msg(_("Cannot save journal watch's position: rename('%s', '%s')"), tmp_file_name, file_name);
+        unlink(tmp_file_name);
+        return -1;
+    }
+
     return 0;
 }
 
@@ -392,6 +565,86 @@ int abrt_journal_restore_position(abrt_journal_t *journal, const char *file_name
  * ABRT systemd-journal wrapper end
  */
 
+struct abrt_journal_checkpoint
+{
+    char *file_name;
+    unsigned max_messages;
+    unsigned max_delay_ms;
+
+    /* Processed messages since the last save */
+    unsigned pending;
+    /* Monotonic time of the first of them */
+    int64_t pending_since_ms;
+};
+
+static int64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+abrt_journal_checkpoint_t *abrt_journal_checkpoint_new(const char *file_name,
+        unsigned max_messages, unsigned max_delay_ms)
+{
+    abrt_journal_checkpoint_t *checkpoint = g_malloc0(sizeof(*checkpoint));
+    checkpoint->file_name = g_strdup(file_name);
+    checkpoint->max_messages = max_messages;
+    checkpoint->max_delay_ms = max_delay_ms;
+
+    return checkpoint;
+}
+
+void abrt_journal_checkpoint_free(abrt_journal_checkpoint_t *checkpoint)
+{
+    if (checkpoint == NULL)
+        return;
+
+    g_free(checkpoint->file_name);
+    g_free(checkpoint);
+}
+
+int abrt_journal_checkpoint_save(abrt_journal_checkpoint_t *checkpoint, abrt_journal_t *journal)
+{
+    checkpoint->pending = 0;
+    return abrt_journal_save_current_position(journal, checkpoint->file_name);
+}
+
+int abrt_journal_checkpoint_processed(abrt_journal_checkpoint_t *checkpoint, abrt_journal_t *journal)
+{
+    const int64_t now = monotonic_ms();
+    if (checkpoint->pending++ == 0)
+        checkpoint->pending_since_ms = now;
+
+    if (checkpoint->pending < checkpoint->max_messages
+        && now - checkpoint->pending_since_ms < checkpoint->max_delay_ms)
+        return 0;
+
+    return abrt_journal_checkpoint_save(checkpoint, journal);
+}
+
+int abrt_journal_checkpoint_flush(abrt_journal_checkpoint_t *checkpoint, abrt_journal_t *journal)
+{
+    if (checkpoint->pending == 0)
+        return 0;
+
+    log_debug("Saving position of %u processed messages", checkpoint->pending);
+    return abrt_journal_checkpoint_save(checkpoint, journal);
+}
+
+int abrt_journal_checkpoint_timeout(abrt_journal_checkpoint_t *checkpoint)
+{
+    if (checkpoint->pending == 0)
+        return -1;
+
+    const int64_t elapsed = monotonic_ms() - checkpoint->pending_since_ms;
+    return elapsed >= checkpoint->max_delay_ms ? 0 : (int)(checkpoint->max_delay_ms - elapsed);
+}
+
+/*
+ * ABRT systemd-journal checkpoint end
+ */
+
 static volatile int s_loop_terminated;
 void signal_loop_to_terminate(int signum)
 {
@@ -412,6 +665,9 @@ struct abrt_journal_watch
 
     abrt_journal_watch_callback callback;
     void *callback_data;
+
+    /* abrt_journal_checkpoint_t, flushed when their delay expires */
+    GList *checkpoints;
 };
 
 int abrt_journal_watch_new(abrt_journal_watch_t **watch, abrt_journal_t *journal, abrt_journal_watch_callback callback, void *callback_data)
@@ -428,10 +684,37 @@ int abrt_journal_watch_new(abrt_journal_watch_t **watch, abrt_journal_t *journal
 
 void abrt_journal_watch_free(abrt_journal_watch_t *watch)
 {
+    g_list_free(watch->checkpoints);
     watch->j = (void *)0xDEADBEAF;
     g_free(watch);
 }
 
+void abrt_journal_watch_add_checkpoint(abrt_journal_watch_t *watch, abrt_journal_checkpoint_t *checkpoint)
+{
+    watch->checkpoints = g_list_append(watch->checkpoints, checkpoint);
+}
+
+/* Returns the time to the nearest checkpoint delay expiry in ms or -1 */
+static int abrt_journal_watch_checkpoints_timeout(abrt_journal_watch_t *watch)
+{
+    int timeout = -1;
+    for (GList *l = watch->checkpoints; l != NULL; l = l->next)
+    {
+        const int t = abrt_journal_checkpoint_timeout(l->data);
+        if (t >= 0 && (timeout < 0 || t < timeout))
+            timeout = t;
+    }
+
+    return timeout;
+}
+
+static void abrt_journal_watch_flush_expired_checkpoints(abrt_journal_watch_t *watch)
+{
+    for (GList *l = watch->checkpoints; l != NULL; l = l->next)
+        if (abrt_journal_checkpoint_timeout(l->data) == 0)
+            abrt_journal_checkpoint_flush(l->data, watch->j);
+}
+
 abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch)
 {
     return watch->j;
@@ -471,7 +754,16 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
         }
         else if (r == 0)
         {
-            ppoll(&pollfd, 1, NULL, &mask);
+            /* Wake up to save positions of processed messages in time */
+            const int timeout = abrt_journal_watch_checkpoints_timeout(watch);
+            struct timespec timeout_ts = {
+                .tv_sec = timeout / 1000,
+                .tv_nsec = (timeout % 1000) * 1000000L,
+            };
+
+            ppoll(&pollfd, 1, timeout < 0 ? NULL : &timeout_ts, &mask);
+            abrt_journal_watch_flush_expired_checkpoints(watch);
+
             r = sd_journal_process(watch->j->j);
             if (r < 0)
             {
@@ -500,26 +792,15 @@ void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data)
 {
     struct abrt_journal_watch_notify_strings *conf = (struct abrt_journal_watch_notify_strings *)data;
 
-    char message[JOURNALD_MAX_FIELD_SIZE + 1] = "\0";
-
-    if (abrt_journal_get_string_field(abrt_journal_watch_get_journal(watch), "MESSAGE", (char *)message) == NULL)
+    /* Searched directly in the data of systemd-journal */
+    abrt_journal_field_view_t message;
+    if (abrt_journal_get_field_view(abrt_journal_watch_get_journal(watch), "MESSAGE", &message) < 0)
     {
         error_msg("Cannot read journal data, skipping.");
         return;
     }
 
-    GList *cur = conf->strings;
-    for (; cur; cur = g_list_next(cur))
-        if (strstr(message, cur->data) != NULL)
-            break;
-
-    GList *blacklist_cur = conf->blacklisted_strings;
-    if (cur)
-        for (; blacklist_cur; blacklist_cur = g_list_next(blacklist_cur))
-            if (strstr(message, blacklist_cur->data) != NULL)
-                break;
-
-    if (cur && !blacklist_cur)
+    if (abrt_pattern_set_match(conf->patterns, message.data, message.length))
         conf->decorated_cb(watch, conf->decorated_cb_data);
 }
 
@@ -17,6 +17,7 @@
 
 #include <glib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,10 +49,48 @@ void abrt_journal_free(abrt_journal_t *journal);
 int abrt_journal_set_journal_filter(abrt_journal_t *journal,
                                     GList *journal_filter_list);
 
+/* Fields longer than the threshold might be truncated, 0 means no limit.
+ * systemd-journal uses 64KiB by default.
+ */
+int abrt_journal_set_data_threshold(abrt_journal_t *journal,
+                                    size_t threshold);
+
+/* Adds the filter as a new group of matches. Messages satisfying any of the
+ * groups are read.
+ */
+int abrt_journal_add_journal_filter_group(abrt_journal_t *journal,
+                                          GList *journal_filter_list);
+
+/* Returns true if the current message satisfies the filter.
+ */
+bool abrt_journal_test_filter(abrt_journal_t *journal,
+                              GList *journal_filter_list);
+
+/* abrt_journal_next() skips messages not satisfying the filter, NULL shows
+ * all messages again. The list is not copied.
+ */
+void abrt_journal_set_view(abrt_journal_t *journal,
+                           GList *journal_filter_list);
+
 int abrt_journal_get_field(abrt_journal_t *journal,
                            const char *field,
                            const void **value,
                            size_t *value_len);
+
+/* A field of the current message without the 'FIELD=' prefix. The data are
+ * not NUL terminated and are owned by systemd-journal, so the view is valid
+ * only until the journal is moved to another message.
+ */
+typedef struct
+{
+    const char *data;
+    size_t length;
+} abrt_journal_field_view_t;
+
+int abrt_journal_get_field_view(abrt_journal_t *journal,
+                                const char *field,
+                                abrt_journal_field_view_t *view);
+
 bool abrt_journal_get_int(abrt_journal_t *journal,
                           const char *key,
                           int *value);
@@ -78,14 +117,58 @@ int abrt_journal_set_cursor(abrt_journal_t *journal, const char *cursor);
 
 int abrt_journal_seek_tail(abrt_journal_t *journal);
 
+int abrt_journal_seek_head(abrt_journal_t *journal);
+
+/* Returns a positive number if the current message is at the cursor */
+int abrt_journal_test_cursor(abrt_journal_t *journal, const char *cursor);
+
+int abrt_journal_get_realtime(abrt_journal_t *journal, uint64_t *usec);
+
 int abrt_journal_next(abrt_journal_t *journal);
 
+/* The file is replaced atomically, either the old or the new position is
+ * found there after a crash */
 int abrt_journal_save_current_position(abrt_journal_t *journal,
                                        const char *file_name);
 
 int abrt_journal_restore_position(abrt_journal_t *journal,
                                   const char *file_name);
 
+/*
+ * Batched saving of the journal position
+ *
+ * The position is saved when max_messages messages have been processed or
+ * max_delay_ms milliseconds after the first processed message which has not
+ * been saved yet. abrt_journal_checkpoint_save() shall be called when the
+ * position must not be lost, e.g. after creating a problem directory.
+ */
+#define ABRT_JOURNAL_CHECKPOINT_MAX_MESSAGES 100
+#define ABRT_JOURNAL_CHECKPOINT_MAX_DELAY_MS 1000
+
+struct abrt_journal_checkpoint;
+typedef struct abrt_journal_checkpoint abrt_journal_checkpoint_t;
+
+abrt_journal_checkpoint_t *abrt_journal_checkpoint_new(const char *file_name,
+                                                       unsigned max_messages,
+                                                       unsigned max_delay_ms);
+
+void abrt_journal_checkpoint_free(abrt_journal_checkpoint_t *checkpoint);
+
+/* The current message has been processed */
+int abrt_journal_checkpoint_processed(abrt_journal_checkpoint_t *checkpoint,
+                                      abrt_journal_t *journal);
+
+/* Saves the current position immediately */
+int abrt_journal_checkpoint_save(abrt_journal_checkpoint_t *checkpoint,
+                                 abrt_journal_t *journal);
+
+/* Saves the current position if any processed message has not been saved */
+int abrt_journal_checkpoint_flush(abrt_journal_checkpoint_t *checkpoint,
+                                  abrt_journal_t *journal);
+
+/* Returns milliseconds to the delay expiry or -1 if nothing is pending */
+int abrt_journal_checkpoint_timeout(abrt_journal_checkpoint_t *checkpoint);
+
 /*
  * A systemd-journal listener which waits for new messages a loop and notifies
  * them via a call back
@@ -103,6 +186,13 @@ int abrt_journal_watch_new(abrt_journal_watch_t **watch,
 
 void abrt_journal_watch_free(abrt_journal_watch_t *watch);
 
+/*
+ * The watch flushes the checkpoint while waiting for new messages when the
+ * delay of the checkpoint expires. The checkpoint is not freed by the watch.
+ */
+void abrt_journal_watch_add_checkpoint(abrt_journal_watch_t *watch,
+                                       abrt_journal_checkpoint_t *checkpoint);
+
 /*
  * Returns the watched journal.
  */
@@ -124,14 +214,17 @@ void abrt_journal_watch_stop(abrt_journal_watch_t *watch);
 /*
  * A decorator for abrt_journal_watch call backs which calls the decorated call
  * back in case where journal message contains a string from the interested
- * list.
+ * list and no blacklisted string.
+ *
+ * The strings are compiled by abrt_pattern_set_new().
  */
+struct abrt_pattern_set;
+
 struct abrt_journal_watch_notify_strings
 {
     abrt_journal_watch_callback decorated_cb;
     void *decorated_cb_data;
-    GList *strings;
-    GList *blacklisted_strings;
+    const struct abrt_pattern_set *patterns;
 };
 
 void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data);
@@ -26,27 +26,7 @@
 extern char **environ;
 static unsigned page_size;
 
-static bool memstr(void *buf, unsigned size, const char *str)
-{
-    int len = strlen(str);
-    while ((int)size >= len)
-    {
-        //log_warning("LOOKING FOR:'%s'", str);
-        char *first = memchr(buf, (unsigned char)str[0], size - len + 1);
-        if (!first)
-            break;
-        //log_warning("FOUND:'%.66s'", first);
-        first++;
-        if (len <= 1 || strncmp(first, str + 1, len - 1) == 0)
-            return true;
-        size -= (first - (char*)buf);
-        //log_warning("SKIP TO:'%.66s' %d chars", first, (int)(first - (char*)buf));
-        buf = first;
-    }
-    return false;
-}
-
-static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, char **prog)
+static void run_scanner_prog(int fd, struct stat *statbuf, const struct abrt_pattern_set *match_set, char **prog)
 {
     pid_t pid;
     int err;
@@ -72,7 +52,7 @@ static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, ch
         (long long)(cur_pos),
         (long long)(statbuf->st_size));
 
-    if (match_list && (statbuf->st_size - cur_pos) < MAX_SCAN_BLOCK)
+    if (match_set && (statbuf->st_size - cur_pos) < MAX_SCAN_BLOCK)
     {
         size_t length = statbuf->st_size - cur_pos;
 
@@ -83,17 +63,11 @@ static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, ch
         if (map != MAP_FAILED)
         {
             char *start = (char*)map + (cur_pos & (page_size - 1));
-            for (GList *l = match_list; l; l = l->next)
+            log_debug("Searching in '%.*s'", length > 20 ? 20 : (int)length, start);
+            if (abrt_pattern_set_match(match_set, start, length))
             {
-                log_debug("Searching for '%s' in '%.*s'",
-                                (char*)l->data,
-                                length > 20 ? 20 : (int)length, start
-                );
-                if (memstr(start, length, (char*)l->data))
-                {
-                    log_debug("FOUND:'%s'", (char*)l->data);
-                    goto found;
-                }
+                log_debug("FOUND");
+                goto found;
             }
             /* None of the strings are found */
             log_debug("NOT FOUND");
@@ -209,6 +183,11 @@ int main(int argc, char **argv)
         l = g_list_append(l, eol); /* in fact, always returns unchanged l */
     }
 
+    /* Searched in one pass over the new data */
+    struct abrt_pattern_set *match_set = NULL;
+    if (match_list)
+        match_set = abrt_pattern_set_new(match_list, NULL);
+
     const char *filename = *argv++;
 
     int inotify_fd = inotify_init();
@@ -228,7 +207,7 @@ int main(int argc, char **argv)
             memset(&statbuf, 0, sizeof(statbuf));
             if (fstat(file_fd, &statbuf) != 0)
                 goto close_fd;
-            run_scanner_prog(file_fd, &statbuf, match_list, argv);
+            run_scanner_prog(file_fd, &statbuf, match_set, argv);
 
             /* Was file deleted or replaced? */
             ino_t fd_ino = statbuf.st_ino;
@@ -276,7 +255,7 @@ int main(int argc, char **argv)
                     /* Note that statbuf is filled by fstat by now,
                      * run_scanner_prog needs that
                      */
-                    run_scanner_prog(file_fd, &statbuf, match_list, argv);
+                    run_scanner_prog(file_fd, &statbuf, match_set, argv);
                 }
             }
         }
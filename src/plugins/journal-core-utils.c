@@ -0,0 +1,603 @@
+/*
+ * Copyright (C) 2014  ABRT team
+ * Copyright (C) 2014  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "journal-core-utils.h"
+
+#define FILENAME_JOURNALD_CURSOR "journald_cursor"
+
+/*
+ * A journal message is a set of key value pairs in the following format:
+ *   FIELD_NAME=${binary data}
+ *
+ * A journal message contains many fields useful in syslog but ABRT doesn't
+ * need all of them. So the following list defines mapping between journal
+ * fields and ABRT problem items.
+ *
+ * ABRT goes through the list and for each item reads journal field called
+ * 'item.name' and saves its contents in $DUMP_DIRECTORY/'item.file'.
+ */
+static struct field_mapping {
+    const char *name;
+    const char *file;
+} s_fields [] = {
+    { .name = "COREDUMP_EXE",               .file = FILENAME_EXECUTABLE, },
+    { .name = "COREDUMP_CMDLINE",           .file = FILENAME_CMDLINE, },
+    { .name = "COREDUMP_PROC_STATUS",       .file = FILENAME_PROC_PID_STATUS, },
+    { .name = "COREDUMP_PROC_MAPS",         .file = FILENAME_MAPS, },
+    { .name = "COREDUMP_PROC_LIMITS",       .file = FILENAME_LIMITS, },
+    { .name = "COREDUMP_PROC_CGROUP",       .file = FILENAME_CGROUP, },
+    { .name = "COREDUMP_ENVIRON",           .file = FILENAME_ENVIRON, },
+    { .name = "COREDUMP_CWD",               .file = FILENAME_PWD, },
+    { .name = "COREDUMP_ROOT",              .file = FILENAME_ROOTDIR, },
+    { .name = "COREDUMP_OPEN_FDS",          .file = FILENAME_OPEN_FDS, },
+    { .name = "COREDUMP_UID",               .file = FILENAME_UID, },
+    //{ .name = "COREDUMP_GID",               .file = FILENAME_GID, },
+    { .name = "COREDUMP_PID",               .file = FILENAME_PID, },
+    { .name = "COREDUMP_PROC_MOUNTINFO",    .file = FILENAME_MOUNTINFO, },
+};
+
+/*
+ * Something like 'struct problem_data' but optimized for copying data from
+ * journald to ABRT.
+ *
+ * 'struct problem_data' allocates a new memory for every single item and I
+ * found that very inefficient in this case.
+ *
+ * The following structure holds data that we already retreived from journald
+ * so we won't need to retrieve the data again.
+ *
+ * Why we retrieve data before we store them? Because we do some checking
+ * before we start saving data in ABRT. We check whether the signal is one of
+ * those we are interested in or whether the executable crashes too often to
+ * ignore the current crash ...
+ */
+struct crash_info
+{
+    abrt_journal_t *ci_journal;
+
+    int ci_signal_no;
+    const char *ci_signal_name;
+    char *ci_executable_path;          ///< /full/path/to/executable
+    const char *ci_executable_name;    ///< executable
+    uid_t ci_uid;
+    pid_t ci_pid;
+
+    struct field_mapping *ci_mapping;
+    size_t ci_mapping_items;
+};
+
+
+/*
+ * A helper structured holding executable name and its last occurrence time.
+ *
+ * It is rather an array than a queue. Ii uses statically allocated array and
+ * the head member points the next position for creating a new entry (the next
+ * position may be already occupied and in such case the data shall be released).
+ */
+struct occurrence_queue
+{
+    int oq_head;       ///< the first empty index
+    unsigned oq_size;  ///< size of the queue
+
+    struct last_occurrence
+    {
+        time_t oqlc_stamp;
+        char *oqlc_executable;
+    } oq_occurrences[8];
+
+} s_queue = {
+    .oq_head = -1,
+    .oq_size = 8,
+};
+
+static time_t
+abrt_journal_get_last_occurrence(const char *executable)
+{
+    if (s_queue.oq_head < 0)
+        return 0;
+
+    unsigned index = s_queue.oq_head == 0 ? s_queue.oq_size - 1 : s_queue.oq_head - 1;
+    for (unsigned i = 0; i < s_queue.oq_size; ++i)
+    {
+        if (s_queue.oq_occurrences[index].oqlc_executable == NULL)
+            break;
+
+        if (strcmp(executable, s_queue.oq_occurrences[index].oqlc_executable) == 0)
+            return s_queue.oq_occurrences[index].oqlc_stamp;
+
+        if (index-- == 0)
+            index = s_queue.oq_size - 1;
+    }
+
+    return 0;
+}
+
+static void
+abrt_journal_update_occurrence(const char *executable, time_t ts)
+{
+    if (s_queue.oq_head < 0)
+        s_queue.oq_head = 0;
+    else
+    {
+        unsigned index = s_queue.oq_head == 0 ? s_queue.oq_size - 1 : s_queue.oq_head - 1;
+        for (unsigned i = 0; i < s_queue.oq_size; ++i)
+        {
+            if (s_queue.oq_occurrences[index].oqlc_executable == NULL)
+                break;
+
+            if (strcmp(executable, s_queue.oq_occurrences[index].oqlc_executable) == 0)
+            {
+                /* Enhancement: move this entry right behind head */
+                s_queue.oq_occurrences[index].oqlc_stamp = ts;
+                return;
+            }
+
+            if (index-- == 0)
+                index = s_queue.oq_size - 1;
+        }
+    }
+
+    s_queue.oq_occurrences[s_queue.oq_head].oqlc_stamp = ts;
+    free(s_queue.oq_occurrences[s_queue.oq_head].oqlc_executable);
+    s_queue.oq_occurrences[s_queue.oq_head].oqlc_executable = g_strdup(executable);
+
+    if (++s_queue.oq_head >= s_queue.oq_size)
+        s_queue.oq_head = 0;
+
+    return;
+}
+
+/*
+ * Converts a journal message into an intermediate ABRT problem (struct crash_info).
+ *
+ * Refuses to create the problem in the following cases:
+ * - the crashed executable has 'abrt' prefix
+ * - the signals is not fatal (see signal_is_fatal())
+ * - the journal message misses one of the following fields
+ *   - COREDUMP_SIGNAL
+ *   - COREDUMP_EXE
+ *   - COREDUMP_UID
+ *   - COREDUMP_PROC_STATUS
+ * - if any data does not have an expected format
+ */
+static int
+abrt_journal_core_retrieve_information(abrt_journal_t *journal, struct crash_info *info)
+{
+    if (!abrt_journal_get_int(journal, "COREDUMP_SIGNAL", &info->ci_signal_no) != 0)
+    {
+        log_info("Failed to get signal number from journal message");
+        return -EINVAL;
+    }
+
+    if (!signal_is_fatal(info->ci_signal_no, &(info->ci_signal_name)))
+    {
+        log_info("Signal '%d' is not fatal: ignoring crash", info->ci_signal_no);
+        return 1;
+    }
+
+    info->ci_executable_path = abrt_journal_get_string_field(journal, "COREDUMP_EXE", NULL);
+    if (info->ci_executable_path == NULL)
+    {
+        log_notice("Could not get crashed 'executable'.");
+        return -ENOENT;
+    }
+
+    info->ci_executable_name = strrchr(info->ci_executable_path, '/');
+    if (info->ci_executable_name == NULL)
+    {
+        info->ci_executable_name = info->ci_executable_path;
+    }
+    else if(strncmp(++(info->ci_executable_name), "abrt", 4) == 0)
+    {
+        error_msg("Ignoring crash of ABRT executable '%s'", info->ci_executable_path);
+        return 1;
+    }
+
+    if (!abrt_journal_get_uid(journal, "COREDUMP_UID", &info->ci_uid))
+    {
+        log_info("Failed to get UID from journal message");
+        return -EINVAL;
+    }
+
+    /* This is not fatal, the pid is used only in dumpdir name */
+    if (!abrt_journal_get_pid(journal, "COREDUMP_PID", &info->ci_pid))
+    {
+        log_notice("Failed to get PID from journal message.");
+        info->ci_pid = getpid();
+    }
+
+    char *proc_status = abrt_journal_get_string_field(journal, "COREDUMP_PROC_STATUS", NULL);
+    if (proc_status == NULL)
+    {
+        log_info("Failed to get /proc/[pid]/status from journal message");
+        return -ENOENT;
+    }
+
+    int tmp_fsuid = libreport_get_fsuid(proc_status);
+    if (tmp_fsuid < 0)
+        return -EINVAL;
+
+    if ((uid_t)tmp_fsuid != info->ci_uid)
+    {
+        /* use root for suided apps unless it's explicitly set to UNSAFE */
+        info->ci_uid = (dump_suid_policy() != DUMP_SUID_UNSAFE) ? 0 : tmp_fsuid;
+    }
+
+    return 0;
+}
+
+/*
+ * Initializes ABRT problem directory and save the relevant journal message
+ * fileds in that directory.
+ */
+static int
+save_systemd_coredump_in_dump_directory(struct dump_dir *dd, struct crash_info *info)
+{
+    abrt_journal_field_view_t coredump_file = { .length = 0 };
+    if (abrt_journal_get_field_view(info->ci_journal, "COREDUMP_FILENAME", &coredump_file) < 0)
+        log_debug("Processing coredumpctl entry without a real file");
+
+    if (coredump_file.length > 0)
+    {
+        g_autofree char *coredump_path = g_strndup(coredump_file.data, coredump_file.length);
+
+        // Copy the likely compressed coredump file to the problem directory
+        const char *dd_coredump_filename = FILENAME_COREDUMP;
+        g_autofree char *filename_with_extension = NULL;
+
+        const char *file_extension = strrchr(coredump_path, '.');
+
+        if (file_extension && file_extension != coredump_path) {
+            filename_with_extension = g_strconcat(FILENAME_COREDUMP, file_extension, NULL);
+            dd_coredump_filename = filename_with_extension;
+        }
+        if (dd_copy_file(dd, dd_coredump_filename, coredump_path))
+            return -1;
+    }
+    else
+    {
+        const char *data = NULL;
+        size_t data_len = 0;
+        int r = abrt_journal_get_field(info->ci_journal, "COREDUMP", (const void **)&data, &data_len);
+        if (r < 0)
+        {
+            log_info("Ignoring coredumpctl entry without core dump file.");
+            return -1;
+        }
+
+        dd_save_binary(dd, FILENAME_COREDUMP, data, data_len);
+    }
+
+    dd_save_text(dd, FILENAME_ABRT_VERSION, VERSION);
+    dd_save_text(dd, FILENAME_TYPE, "CCpp");
+    dd_save_text(dd, FILENAME_ANALYZER, "abrt-journal-core");
+
+    g_autofree char *reason = NULL;
+    if (info->ci_signal_name == NULL)
+        reason = g_strdup_printf("%s killed by signal %d", info->ci_executable_name, info->ci_signal_no);
+    else
+        reason = g_strdup_printf("%s killed by SIG%s", info->ci_executable_name, info->ci_signal_name);
+
+    dd_save_text(dd, FILENAME_REASON, reason);
+
+    g_autofree char *cursor = NULL;
+    if (abrt_journal_get_cursor(info->ci_journal, &cursor) == 0)
+        dd_save_text(dd, FILENAME_JOURNALD_CURSOR, cursor);
+
+    const char *data = NULL;
+    size_t data_len = 0;
+
+    /* This journal field is not present most of the time, because it is
+     * created only for coredumps from processes running in a container.
+     *
+     * Printing out the log message would be confusing hence.
+     *
+     * If we find more similar fields, we should not add more if statements
+     * but encode this in the struct field_mapping.
+     *
+     * For now, it would be just vasting of memory and time.
+     */
+    if (!abrt_journal_get_field(info->ci_journal, "COREDUMP_CONTAINER_CMDLINE", (const void **)&data, &data_len))
+    {
+        dd_save_binary(dd, FILENAME_CONTAINER_CMDLINE, data, data_len);
+    }
+
+    for (size_t i = 0; i < info->ci_mapping_items; ++i)
+    {
+        const char *data;
+        size_t data_len;
+        struct field_mapping *f = info->ci_mapping + i;
+
+        if (abrt_journal_get_field(info->ci_journal, f->name, (const void **)&data, &data_len))
+        {
+            log_info("systemd-coredump journald message misses field: '%s'", f->name);
+            continue;
+        }
+
+        dd_save_binary(dd, f->file, data, data_len);
+    }
+
+    return 0;
+}
+
+static int
+abrt_journal_core_to_abrt_problem(struct crash_info *info, const char *dump_location)
+{
+    struct dump_dir *dd = create_dump_dir_ext(dump_location, "ccpp", info->ci_pid, /*fs owner*/0,
+            (save_data_call_back)save_systemd_coredump_in_dump_directory, info);
+
+    if (dd != NULL)
+    {
+        g_autofree char *path = g_strdup(dd->dd_dirname);
+        dd_close(dd);
+        abrt_notify_new_path(path);
+        log_debug("ABRT daemon has been notified about directory: '%s'", path);
+    }
+
+    return dd == NULL;
+}
+
+/*
+ * Prints a core info to stdout.
+ */
+static int
+abrt_journal_core_to_stdout(struct crash_info *info)
+{
+    printf(_("UID=%9i; SIG=%2i (%4s); EXE=%s\n"),
+           info->ci_uid,
+           info->ci_signal_no,
+           info->ci_signal_name,
+           info->ci_executable_path);
+    return 0;
+}
+
+/*
+ * Creates an abrt problem from a journal message
+ */
+int
+abrt_journal_dump_core(abrt_journal_t *journal, const char *dump_location, int run_flags)
+{
+    struct crash_info info = { 0 };
+    info.ci_journal = journal;
+    info.ci_mapping = s_fields;
+    info.ci_mapping_items = sizeof(s_fields)/sizeof(*s_fields);
+
+    /* Compatibility hack, a watch's callback gets the journal already moved
+     * to a next message. */
+    abrt_journal_next(journal);
+
+    /* This the watch call back mentioned in the comment above. We use the
+     * following function also in abrt_journal_watch_cores(). */
+    int r = abrt_journal_core_retrieve_information(journal, &info);
+    if (r != 0)
+    {
+        if (r < 0)
+            error_msg(_("Failed to obtain all required information from journald"));
+
+        goto dump_cleanup;
+    }
+
+    if ((run_flags & ABRT_CORE_PRINT_STDOUT))
+        r = abrt_journal_core_to_stdout(&info);
+    else
+        r = abrt_journal_core_to_abrt_problem(&info, dump_location);
+
+dump_cleanup:
+    if (info.ci_executable_path != NULL)
+        g_free(info.ci_executable_path);
+
+    return r;
+}
+
+/*
+ * A function called when a new journal core is detected.
+ *
+ * The function retrieves information from journal, checks the last occurrence
+ * time of the crashed executable and if there was no recent occurrence creates
+ * an ABRT problem from the journal message. Finally updates the last occurrence
+ * time.
+ */
+void
+abrt_journal_watch_cores(abrt_journal_watch_t *watch, void *user_data)
+{
+    const abrt_watch_core_conf_t *conf = (const abrt_watch_core_conf_t *)user_data;
+
+    bool saved = false;
+    struct crash_info info = { 0 };
+    info.ci_journal = abrt_journal_watch_get_journal(watch);
+    info.ci_mapping = s_fields;
+    info.ci_mapping_items = sizeof(s_fields)/sizeof(*s_fields);
+
+    int r = abrt_journal_core_retrieve_information(abrt_journal_watch_get_journal(watch), &info);
+    if (r)
+    {
+        if (r < 0)
+            error_msg(_("Failed to obtain all required information from journald"));
+
+        goto watch_cleanup;
+    }
+
+    // do not dump too often
+    //   ignore crashes of a single executable appearing in THROTTLE s (keep last 10 executable)
+    const time_t current = time(NULL);
+    const time_t last = abrt_journal_get_last_occurrence(info.ci_executable_path);
+
+    if (current < last)
+    {
+        error_msg("BUG: current time stamp lower than an old one");
+
+        if (libreport_g_verbose > 2)
+            abort();
+
+        goto watch_cleanup;
+    }
+
+    const double sub = difftime(current, last);
+    if (sub < conf->awc_throttle)
+    {
+        /* We don't want to update the counter here. */
+        error_msg(_("Not saving repeating crash after %.0fs (limit is %ds)"), sub, conf->awc_throttle);
+        goto watch_cleanup;
+    }
+
+    if ((conf->awc_run_flags & ABRT_CORE_PRINT_STDOUT))
+    {
+        if (abrt_journal_core_to_stdout(&info))
+        {
+            error_msg(_("Failed to print detect problem data to stdout"));
+            goto watch_cleanup;
+        }
+    }
+    else
+    {
+        if (abrt_journal_core_to_abrt_problem(&info, conf->awc_dump_location))
+        {
+            error_msg(_("Failed to save detect problem data in abrt database"));
+            goto watch_cleanup;
+        }
+    }
+
+    abrt_journal_update_occurrence(info.ci_executable_path, current);
+
+    /* Do not create the problem directory again after a restart */
+    if (!(conf->awc_run_flags & ABRT_CORE_PRINT_STDOUT))
+    {
+        abrt_journal_checkpoint_save(conf->awc_checkpoint, info.ci_journal);
+        saved = true;
+    }
+
+watch_cleanup:
+    if (!saved)
+        abrt_journal_checkpoint_processed(conf->awc_checkpoint, info.ci_journal);
+
+    if (info.ci_executable_path != NULL)
+        g_free(info.ci_executable_path);
+
+    return;
+}
+
+GList *
+abrt_journal_core_journal_filter(void)
+{
+    /* systemd-coredump creates journal messages with SYSLOG_IDENTIFIER equals
+     * 'systemd-coredump' and we are interested only in the systemd-coredump
+     * messages.
+     *
+     * Of cores, it is possible to override this when need while debugging.
+     */
+    const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_CORE_DEBUG_FILTER");
+    GList *coredump_journal_filter = NULL;
+    coredump_journal_filter = g_list_append(coredump_journal_filter,
+           (env_journal_filter ? (gpointer)env_journal_filter : (gpointer)"SYSLOG_IDENTIFIER=systemd-coredump"));
+
+    if (!env_journal_filter)
+    {
+        /* Filter on trusted fields (set by the kernel, not spoofable) to
+         * ensure we only process genuine systemd-coredump entries.
+         * "systemd-coredum" is not a typo — the kernel truncates _COMM to 15 chars. */
+        coredump_journal_filter = g_list_append(coredump_journal_filter, (gpointer)"_EXE=/usr/lib/systemd/systemd-coredump");
+        coredump_journal_filter = g_list_append(coredump_journal_filter, (gpointer)"_COMM=systemd-coredum");
+    }
+
+    return coredump_journal_filter;
+}
+
+/*
+ * Returns the realtime of the message at the cursor
+ */
+static int
+abrt_journal_core_cursor_realtime(abrt_journal_t *journal, const char *cursor, uint64_t *usec)
+{
+    if (abrt_journal_set_cursor(journal, cursor) < 0
+        || abrt_journal_next(journal) <= 0
+        || abrt_journal_test_cursor(journal, cursor) <= 0)
+        return -ENOENT;
+
+    return abrt_journal_get_realtime(journal, usec);
+}
+
+int
+abrt_journal_core_restore_position(abrt_journal_t *journal, const char *dump_location)
+{
+    const int r = abrt_journal_restore_position(journal, ABRT_JOURNAL_CORE_STATE_FILE);
+    if (r < 0 || dump_location == NULL)
+        return r;
+
+    /* The position is saved right after a problem directory is created but
+     * the process might have crashed in between. The directories store the
+     * cursor of their message, so look for a directory newer than the state
+     * file which belongs to a later message than the saved position. */
+    struct stat state_stat;
+    if (stat(ABRT_JOURNAL_CORE_STATE_FILE, &state_stat) < 0)
+        return r;
+
+    DIR *dir = opendir(dump_location);
+    if (dir == NULL)
+        return r;
+
+    /* abrt_journal_restore_position() only seeks, move to the message */
+    uint64_t saved_realtime = 0;
+    if (abrt_journal_next(journal) <= 0
+        || abrt_journal_get_realtime(journal, &saved_realtime) < 0)
+    {
+        closedir(dir);
+        return abrt_journal_restore_position(journal, ABRT_JOURNAL_CORE_STATE_FILE);
+    }
+
+    g_autofree char *latest_cursor = NULL;
+    uint64_t latest_realtime = saved_realtime;
+
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL)
+    {
+        if (libreport_dot_or_dotdot(dent->d_name))
+            continue;
+
+        g_autofree char *path = g_build_filename(dump_location, dent->d_name, NULL);
+        struct stat dir_stat;
+        if (lstat(path, &dir_stat) < 0 || !S_ISDIR(dir_stat.st_mode)
+            || dir_stat.st_mtime < state_stat.st_mtime)
+            continue;
+
+        struct dump_dir *dd = dd_opendir(path, DD_OPEN_READONLY | DD_FAIL_QUIETLY_ENOENT | DD_FAIL_QUIETLY_EACCES);
+        if (dd == NULL)
+            continue;
+
+        g_autofree char *analyzer = dd_load_text_ext(dd, FILENAME_ANALYZER,
+                DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+        g_autofree char *cursor = dd_load_text_ext(dd, FILENAME_JOURNALD_CURSOR,
+                DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+        dd_close(dd);
+
+        if (analyzer == NULL || strcmp(analyzer, "abrt-journal-core") != 0 || cursor == NULL)
+            continue;
+
+        uint64_t realtime;
+        if (abrt_journal_core_cursor_realtime(journal, cursor, &realtime) < 0 || realtime <= latest_realtime)
+            continue;
+
+        g_free(latest_cursor);
+        latest_cursor = g_steal_pointer(&cursor);
+        latest_realtime = realtime;
+    }
+    closedir(dir);
+
+    if (latest_cursor != NULL)
+    {
+        log_notice("Problem directory of message '%s' has been created after the position was saved", latest_cursor);
+        return abrt_journal_set_cursor(journal, latest_cursor);
+    }
+
+    return abrt_journal_restore_position(journal, ABRT_JOURNAL_CORE_STATE_FILE);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014  ABRT team
+ * Copyright (C) 2014  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_JOURNAL_CORE_UTILS_H_
+#define _ABRT_JOURNAL_CORE_UTILS_H_
+
+#include "libabrt.h"
+#include "abrt-journal.h"
+
+#define ABRT_JOURNAL_CORE_STATE_FILE VAR_STATE"/abrt-dump-journal-core.state"
+
+/* The COREDUMP field holds the whole core dump, it must not be truncated */
+#define ABRT_JOURNAL_CORE_DATA_THRESHOLD 0
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    ABRT_CORE_PRINT_STDOUT = 1 << 0,
+};
+
+/*
+ * ABRT watch core configuration
+ */
+typedef struct
+{
+    const char *awc_dump_location;
+    int awc_throttle;
+    int awc_run_flags;
+    abrt_journal_checkpoint_t *awc_checkpoint;
+}
+abrt_watch_core_conf_t;
+
+/*
+ * Returns the journal filter selecting systemd-coredump messages. The list
+ * must be released with g_list_free().
+ */
+GList *abrt_journal_core_journal_filter(void);
+
+/*
+ * Restores the position saved in ABRT_JOURNAL_CORE_STATE_FILE. If a problem
+ * directory in dump_location was created from a later message, the journal
+ * is moved to that message instead. The journal is only sought, the caller
+ * must move to the next message.
+ */
+int abrt_journal_core_restore_position(abrt_journal_t *journal, const char *dump_location);
+
+/*
+ * Creates an abrt problem from the next journal message
+ */
+int abrt_journal_dump_core(abrt_journal_t *journal, const char *dump_location, int run_flags);
+
+/*
+ * abrt_journal_watch call back, user_data must be abrt_watch_core_conf_t
+ */
+void abrt_journal_watch_cores(abrt_journal_watch_t *watch, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_JOURNAL_CORE_UTILS_H_*/
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2014  ABRT team
+ * Copyright (C) 2014  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "journal-oops-utils.h"
+
+/*
+ * Koops extractor
+ */
+
+GList* abrt_journal_extract_kernel_oops(abrt_journal_t *journal)
+{
+    size_t lines_info_count = 0;
+    size_t lines_info_size = 32;
+    struct abrt_koops_line_info *lines_info = g_malloc(lines_info_size * sizeof(lines_info[0]));
+
+    do
+    {
+        char *line = abrt_journal_get_log_line(journal);
+        if (line == NULL)
+            error_msg_and_die(_("Cannot read journal data."));
+
+        if (lines_info_count == lines_info_size)
+        {
+            lines_info_size *= 2;
+            lines_info = g_realloc(lines_info, lines_info_size * sizeof(lines_info[0]));
+        }
+
+        char *orig_line = line;
+        lines_info[lines_info_count].level = abrt_koops_line_skip_level((const char **)&line);
+        abrt_koops_line_skip_jiffies((const char **)&line);
+
+        memmove(orig_line, line, strlen(line) + 1);
+
+        lines_info[lines_info_count].ptr = orig_line;
+
+        ++lines_info_count;
+    }
+    while (lines_info_count < ABRT_JOURNAL_MAX_READ_LINES
+            && abrt_journal_next(journal) > 0);
+
+    GList *oops_list = NULL;
+    abrt_koops_extract_oopses_from_lines(&oops_list, lines_info, lines_info_count);
+
+    log_debug("Extracted: %d oopses", g_list_length(oops_list));
+
+    for (size_t i = 0; i < lines_info_count; ++i)
+        free(lines_info[i].ptr);
+
+    g_free(lines_info);
+
+    return oops_list;
+}
+
+/*
+ * An adatapter of abrt_journal_extract_kernel_oops for abrt_journal_watch_callback
+ */
+void abrt_journal_watch_extract_kernel_oops(abrt_journal_watch_t *watch, void *data)
+{
+    const struct abrt_journal_oops_watch_settings *conf = (const struct abrt_journal_oops_watch_settings *)data;
+
+    abrt_journal_t *journal = abrt_journal_watch_get_journal(watch);
+
+    /* Give systemd-journal one second to suck in all kernel's strings */
+    if (abrt_oops_signaled_sleep(1) > 0)
+    {
+        abrt_journal_watch_stop(watch);
+        return;
+    }
+
+    GList *oopses = abrt_journal_extract_kernel_oops(journal);
+    abrt_oops_process_list(oopses, conf->dump_location,
+                           ABRT_JOURNAL_KOOPS_ANALYZER, conf->oops_utils_flags);
+
+    g_list_free_full(oopses, (GDestroyNotify)free);
+
+    /* Skip stuff which appeared while processing oops as it is not necessary */
+    /* to catch all consecutive oopses (anyway such oopses are almost */
+    /* certainly duplicates of the already extracted ones) */
+    if (abrt_journal_seek_tail(journal) < 0)
+        error_msg_and_die(_("Cannot seek to the end of journal"));
+
+    /* In case of disaster, lets make sure we won't read the journal messages */
+    /* again. */
+    abrt_journal_save_current_position(journal, ABRT_JOURNAL_OOPS_STATE_FILE);
+
+    if (g_abrt_oops_sleep_woke_up_on_signal > 0)
+        abrt_journal_watch_stop(watch);
+}
+
+GList *abrt_journal_oops_journal_filter(void)
+{
+    const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_OOPS_DEBUG_FILTER");
+    GList *kernel_journal_filter = NULL;
+    kernel_journal_filter = g_list_append(kernel_journal_filter,
+            (env_journal_filter ? (gpointer)env_journal_filter : (gpointer)"SYSLOG_IDENTIFIER=kernel"));
+
+    if (!env_journal_filter)
+        kernel_journal_filter = g_list_append(kernel_journal_filter, (gpointer)"_TRANSPORT=kernel");
+
+    return kernel_journal_filter;
+}
+
+GList *abrt_journal_oops_suspicious_strings(void)
+{
+    GList *koops_strings = abrt_koops_suspicious_strings_list();
+
+    g_autofree char *oops_string_filter_regex = abrt_oops_string_filter_regex();
+    if (oops_string_filter_regex)
+    {
+        regex_t filter_re;
+        if (regcomp(&filter_re, oops_string_filter_regex, REG_NOSUB) != 0)
+            perror_msg_and_die(_("Failed to compile regex"));
+
+        GList *iter = koops_strings;
+        while(iter != NULL)
+        {
+            GList *next = g_list_next(iter);
+
+            const int reti = regexec(&filter_re, (const char *)iter->data, 0, NULL, 0);
+            if (reti == 0)
+                koops_strings = g_list_delete_link(koops_strings, iter);
+            else if (reti != REG_NOMATCH)
+            {
+                char msgbuf[100];
+                regerror(reti, &filter_re, msgbuf, sizeof(msgbuf));
+                error_msg_and_die("Regex match failed: %s", msgbuf);
+            }
+
+            iter = next;
+        }
+
+        regfree(&filter_re);
+    }
+
+    return koops_strings;
+}
+
+/*
+ * Koops extractor end
+ */
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2014  ABRT team
+ * Copyright (C) 2014  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_JOURNAL_OOPS_UTILS_H_
+#define _ABRT_JOURNAL_OOPS_UTILS_H_
+
+#include "libabrt.h"
+#include "abrt-journal.h"
+#include "oops-utils.h"
+
+#define ABRT_JOURNAL_OOPS_STATE_FILE VAR_STATE"/abrt-dump-journal-oops.state"
+
+/* Limit number of buffered lines */
+#define ABRT_JOURNAL_MAX_READ_LINES (1024 * 1024)
+
+#define ABRT_JOURNAL_KOOPS_ANALYZER "abrt-journal-koops"
+
+/* Kernel log lines are at most 1KiB long, there is no need to decompress
+ * longer messages completely */
+#define ABRT_JOURNAL_OOPS_DATA_THRESHOLD (8 * 1024)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct abrt_journal_oops_watch_settings
+{
+    const char *dump_location;
+    int oops_utils_flags;
+};
+
+/*
+ * Returns the journal filter selecting kernel messages. The list must be
+ * released with g_list_free().
+ */
+GList *abrt_journal_oops_journal_filter(void);
+
+/*
+ * Returns the suspicious strings without those filtered out in oops.conf.
+ * The list must be released with g_list_free().
+ */
+GList *abrt_journal_oops_suspicious_strings(void);
+
+/*
+ * Reads journal messages from the current one to the end and extracts oopses
+ */
+GList *abrt_journal_extract_kernel_oops(abrt_journal_t *journal);
+
+/*
+ * abrt_journal_watch call back, data must be
+ * struct abrt_journal_oops_watch_settings
+ */
+void abrt_journal_watch_extract_kernel_oops(abrt_journal_watch_t *watch, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_JOURNAL_OOPS_UTILS_H_*/
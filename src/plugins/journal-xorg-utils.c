@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2015  ABRT team
+ * Copyright (C) 2015  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "journal-xorg-utils.h"
+
+void
+abrt_xorg_process_list_of_crashes(GList *crashes, const char *dump_location, int flags)
+{
+    if (crashes == NULL)
+        return;
+
+    GList *list;
+    for (list = crashes; list != NULL; list = list->next)
+    {
+        xorg_crash_info_create_dump_dir(list->data, dump_location, (flags & ABRT_XORG_WORLD_READABLE));
+
+        if (flags & ABRT_XORG_PRINT_STDOUT)
+            xorg_crash_info_print_crash(list->data);
+
+        if (flags & ABRT_XORG_THROTTLE_CREATION)
+            if (abrt_xorg_signaled_sleep(1) > 0)
+                break;
+    }
+
+    return;
+}
+
+GList *abrt_journal_extract_xorg_crashes(abrt_journal_t *journal)
+{
+    GList *crash_info_list = NULL;
+
+    do
+    {
+        g_autofree char *line = abrt_journal_get_log_line(journal);
+        if (line == NULL)
+            error_msg_and_die(_("Cannot read journal data."));
+
+        char *p = skip_pfx(line);
+        if (strcmp(p, XORG_SEARCH_STRING) == 0)
+        {
+            struct xorg_crash_info *crash_info = process_xorg_bt(&abrt_journal_get_next_log_line, journal);
+            if (crash_info)
+                crash_info_list = g_list_append(crash_info_list, crash_info);
+            else
+                log_warning(_("Failed to parse Backtrace from journal"));
+        }
+    }
+    while (abrt_journal_next(journal) > 0);
+
+    log_warning("Found crashes: %d", g_list_length(crash_info_list));
+
+    return crash_info_list;
+}
+
+void abrt_journal_watch_extract_xorg_crashes(abrt_journal_watch_t *watch, void *data)
+{
+    const struct abrt_journal_xorg_watch_settings *conf = (const struct abrt_journal_xorg_watch_settings *)data;
+
+    abrt_journal_t *journal = abrt_journal_watch_get_journal(watch);
+
+    /* Give systemd-journal one second to suck in all crash strings */
+    if (abrt_xorg_signaled_sleep(1) > 0)
+    {
+        abrt_journal_watch_stop(watch);
+        return;
+    }
+
+    GList *crashes = abrt_journal_extract_xorg_crashes(journal);
+    abrt_xorg_process_list_of_crashes(crashes, conf->dump_location, conf->xorg_utils_flags);
+    g_list_free_full(crashes, (GDestroyNotify)xorg_crash_info_free);
+
+    /* In case of disaster, lets make sure we won't read the journal messages */
+    /* again. */
+    abrt_journal_save_current_position(journal, ABRT_JOURNAL_XORG_STATE_FILE);
+
+    if (g_abrt_xorg_sleep_woke_up_on_signal > 0)
+        abrt_journal_watch_stop(watch);
+}
+
+GList *abrt_journal_xorg_journal_filter(GList *journal_filters)
+{
+    GList *xorg_journal_filter = NULL;
+
+    const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_XORG_DEBUG_FILTER");
+    if (env_journal_filter != NULL)
+    {
+        xorg_journal_filter = g_list_append(xorg_journal_filter, g_strdup(env_journal_filter));
+        log_debug("Using journal filter from environment variable");
+    }
+    else if (journal_filters != NULL)
+    {
+        for (GList *l = journal_filters; l != NULL; l = l->next)
+            xorg_journal_filter = g_list_append(xorg_journal_filter, g_strdup(l->data));
+        log_debug("Using journal filter passed by parameter -j");
+    }
+    else
+    {
+        g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        log_notice("Loading settings from '%s'", XORG_CONF);
+        abrt_load_abrt_plugin_conf_file(XORG_CONF, settings);
+        log_debug("Loaded '%s'", XORG_CONF);
+
+        const char *conf_journal_filters = g_hash_table_lookup(settings, "JournalFilters");
+        if (!conf_journal_filters) {
+            conf_journal_filters = XORG_DEFAULT_JOURNAL_FILTERS;
+        }
+
+        xorg_journal_filter = libreport_parse_delimited_list(conf_journal_filters, ",");
+        if (xorg_journal_filter)
+            log_debug("Using journal filter from conf file %s", XORG_CONF);
+    }
+
+    return xorg_journal_filter;
+}
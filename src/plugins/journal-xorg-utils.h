@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015  ABRT team
+ * Copyright (C) 2015  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_JOURNAL_XORG_UTILS_H_
+#define _ABRT_JOURNAL_XORG_UTILS_H_
+
+#include "libabrt.h"
+#include "abrt-journal.h"
+#include "xorg-utils.h"
+
+#define ABRT_JOURNAL_XORG_STATE_FILE VAR_STATE"/abrt-dump-journal-xorg.state"
+#define XORG_CONF "xorg.conf"
+#define XORG_DEFAULT_JOURNAL_FILTERS "_COMM=gdm-x-session, _COMM=gnome-shell"
+
+/* Only log lines of Xorg are read */
+#define ABRT_JOURNAL_XORG_DATA_THRESHOLD (8 * 1024)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct abrt_journal_xorg_watch_settings
+{
+    const char *dump_location;
+    int xorg_utils_flags;
+};
+
+/*
+ * Returns the journal filter selecting Xorg messages. The filter is taken
+ * from the environment, journal_filters or xorg.conf in this order. The list
+ * must be released with g_list_free_full(list, free).
+ */
+GList *abrt_journal_xorg_journal_filter(GList *journal_filters);
+
+void abrt_xorg_process_list_of_crashes(GList *crashes, const char *dump_location, int flags);
+
+/*
+ * Reads journal messages from the current one to the end and extracts crashes
+ */
+GList *abrt_journal_extract_xorg_crashes(abrt_journal_t *journal);
+
+/*
+ * abrt_journal_watch call back, data must be
+ * struct abrt_journal_xorg_watch_settings
+ */
+void abrt_journal_watch_extract_xorg_crashes(abrt_journal_watch_t *watch, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_JOURNAL_XORG_UTILS_H_*/
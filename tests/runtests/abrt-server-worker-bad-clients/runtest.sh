@@ -0,0 +1,138 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of abrt-server-worker-bad-clients
+#   Description: tests that an abrt-server worker keeps serving after
+#                malformed requests
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="abrt-server-worker-bad-clients"
+PACKAGE="abrt"
+
+ABRT_CONF="/etc/abrt/abrt.conf"
+
+function send_request() {
+    rlRun "python3 send_request.py $1 > response.log" 0 "Sent '$1' request"
+    rlAssertGrep "^($2)$" response.log -E
+    # the worker reports itself idle after the response
+    sleep 1
+    rlAssertEquals "The worker survived '$1' request" "_$(pgrep -f 'abrt-server.* -w ')" "_$WORKER_PID"
+    rlAssertEquals "No problem directory was left behind" "_$(ls -d $ABRT_CONF_DUMP_LOCATION/Python3-* 2>/dev/null)" "_"
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        rlFileBackup $ABRT_CONF
+        rlRun "augtool set /files${ABRT_CONF}/ServerWorkers 1" 0
+        rlServiceStart abrtd
+        # let abrtd start the worker
+        sleep 1
+        WORKER_PID=$(pgrep -f 'abrt-server.* -w ')
+        rlAssertNotEquals "abrtd started one worker" "_$WORKER_PID" "_"
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+
+        cat > send_request.py <<PYEOF
+import socket
+import sys
+import time
+
+def element(key, value):
+    return ("%s=%s\0" % (key, value)).encode()
+
+VALID = (element("type", "Python3") + element("analyzer", "Python3")
+         + element("pid", "1") + element("executable", "/usr/bin/worker-test")
+         + element("reason", "worker test") + element("backtrace", "b" * 100000))
+
+kind = sys.argv[1]
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect("/var/run/abrt/abrt.socket")
+s.sendall(b"POST / HTTP/1.1\r\n\r\n")
+if kind == "valid":
+    s.sendall(VALID)
+elif kind == "missing":
+    # no reason
+    s.sendall(element("type", "Python3") + element("pid", "1") + element("backtrace", "b" * 100000))
+elif kind == "pid":
+    s.sendall(VALID.replace(b"pid=1\0", b"pid=-1\0"))
+elif kind == "long":
+    # more than MAX_MESSAGE_SIZE, the worker stops reading at some point
+    try:
+        s.sendall(element("type", "Python3") + element("backtrace", "b" * 8 * 1024 * 1024))
+    except BrokenPipeError:
+        pass
+elif kind == "slow":
+    # a streamed element and then nothing till the timeout
+    s.sendall(element("type", "Python3") + element("pid", "1") + b"backtrace=" + b"b" * 100000)
+    time.sleep(15)
+try:
+    s.shutdown(socket.SHUT_WR)
+except OSError:
+    pass
+
+resp = b""
+while True:
+    try:
+        buf = s.recv(256)
+    except ConnectionResetError:
+        break
+    if not buf:
+        break
+    resp += buf
+print(resp.split()[1].decode() if resp else "none")
+PYEOF
+    rlPhaseEnd
+
+    rlPhaseStartTest "Malformed requests"
+        send_request missing 400
+        send_request pid 400
+        # the response might be lost if the client is still sending
+        send_request long "413|none"
+        send_request slow 408
+    rlPhaseEnd
+
+    rlPhaseStartTest "Valid request"
+        rlRun "python3 send_request.py valid > response.log" 0 "Sent a valid request"
+        rlAssertGrep "^201$" response.log
+        wait_for_hooks
+        rlAssertEquals "The problem was created" "_$(abrt status --bare)" "_1"
+        rlAssertEquals "The same worker served it" "_$(pgrep -f 'abrt-server.* -w ')" "_$WORKER_PID"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlRun "rm -rf $ABRT_CONF_DUMP_LOCATION/Python3-*" 0 "Remove the problem directories"
+        popd #TmpDir
+        rm -rf $TmpDir
+        rlFileRestore # ABRT_CONF
+        rlServiceRestore abrtd
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
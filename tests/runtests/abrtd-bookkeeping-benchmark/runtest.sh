@@ -0,0 +1,70 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of abrtd-bookkeeping-benchmark
+#   Description: Measures abrtd main loop latency with many concurrent
+#                abrt-server processes
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   This program is free software: you can redistribute it and/or
+#   modify it under the terms of the GNU General Public License as
+#   published by the Free Software Foundation, either version 3 of
+#   the License, or (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE.  See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program. If not, see http://www.gnu.org/licenses/.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="abrtd-bookkeeping-benchmark"
+PACKAGE="abrt"
+
+rlJournalStart
+    rlPhaseStartSetup
+        rlServiceStop abrtd
+
+        # The simulated problems must not get near the real dump location
+        TmpDir=$(mktemp -d)
+        mkdir -p $TmpDir/conf $TmpDir/spool
+        echo "DumpLocation = $TmpDir/spool" > $TmpDir/conf/abrt.conf
+        export ABRT_CONF_DIR=$TmpDir/conf
+        pushd $TmpDir
+    rlPhaseEnd
+
+    rlPhaseStartTest "Refuses a non-empty dump location"
+        mkdir $TmpDir/spool/Python3-real-problem
+        rlRun "abrtd -d -B 10 > refused.log 2>&1" 1 "Do not run the self-benchmark"
+        rlAssertGrep "is not empty" refused.log
+        rlAssertExists $TmpDir/spool/Python3-real-problem
+        rmdir $TmpDir/spool/Python3-real-problem
+    rlPhaseEnd
+
+    # Every simulated process holds a pipe open in abrtd, stay below the limit
+    # of open files
+    for PROCESSES in 100 500 900; do
+        rlPhaseStartTest "$PROCESSES simulated abrt-server processes"
+            rlRun "abrtd -d -B $PROCESSES > bench.log 2>&1" 0 "Run abrtd self-benchmark"
+            rlAssertGrep "Simulated $PROCESSES abrt-server processes" bench.log
+            rlLog "$(grep -e '^Simulated' -e '^Main loop' bench.log)"
+        rlPhaseEnd
+    done
+
+    rlPhaseStartCleanup
+        unset ABRT_CONF_DIR
+        popd # TmpDir
+        rm -rf $TmpDir
+        rlServiceRestore abrtd
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,141 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of abrtd-parallel-post-create
+#   Description: tests that abrtd runs post-create of queued problems in
+#                parallel up to MaxParallelPostCreate and processes each
+#                problem once
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="abrtd-parallel-post-create"
+PACKAGE="abrt"
+
+ABRT_CONF="/etc/abrt/abrt.conf"
+EVENT_CONF="/etc/libreport/events.d/${TEST}.conf"
+
+MAX_PARALLEL=3
+PROBLEMS=10
+
+# Marks of the running post-create events, the processed problems and the
+# number of the events seen running by each of them
+RUNNING_DIR="/var/tmp/${TEST}.running"
+PROCESSED_LOG="/var/tmp/${TEST}.processed"
+RUNNING_LOG="/var/tmp/${TEST}.concurrency"
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+
+        rlFileBackup $ABRT_CONF
+        sed '/^\s*MaxParallelPostCreate\s*=/d' -i $ABRT_CONF
+        echo "MaxParallelPostCreate = $MAX_PARALLEL" >> $ABRT_CONF
+
+        rm -rf $RUNNING_DIR $PROCESSED_LOG $RUNNING_LOG
+        mkdir -p $RUNNING_DIR
+
+        # Every event runs long enough to overlap with the others
+        cat > $EVENT_CONF <<EOF
+EVENT=post-create type=${TEST}
+    touch $RUNNING_DIR/\$(basename \$DUMP_DIR)
+    ls $RUNNING_DIR | wc -l >> $RUNNING_LOG
+    sleep 2
+    rm -f $RUNNING_DIR/\$(basename \$DUMP_DIR)
+    basename \$DUMP_DIR >> $PROCESSED_LOG
+EOF
+
+        # The problems differ in the executable, otherwise abrtd would
+        # process them one after another as possible duplicates
+        cat > send_problems.py <<PYEOF
+import socket
+
+for i in range($PROBLEMS):
+    # Distinct pids, the directories are named after the pid and time
+    data = ("type=$TEST\0analyzer=$TEST\0pid=%d\0"
+            "component=$TEST\0reason=parallel post-create test\0"
+            "executable=/usr/bin/$TEST-%d\0" % (1000 + i, i)).encode()
+
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect("/var/run/abrt/abrt.socket")
+    s.sendall(b"POST / HTTP/1.1\r\n\r\n" + data)
+    s.shutdown(socket.SHUT_WR)
+
+    resp = b""
+    while True:
+        buf = s.recv(256)
+        if not buf:
+            break
+        resp += buf
+    print(resp.split()[1].decode())
+PYEOF
+
+        rlServiceStop abrtd
+        rlServiceStart abrtd
+    rlPhaseEnd
+
+    rlPhaseStartTest "More problems than MaxParallelPostCreate"
+        rlRun "python3 send_problems.py > responses.log" 0 "Sent $PROBLEMS problems"
+        rlAssertEquals "All problems were accepted" "_$(grep -c '^201$' responses.log)" "_$PROBLEMS"
+
+        c=0
+        while [ "$(cat $PROCESSED_LOG 2>/dev/null | wc -l)" -lt $PROBLEMS ]; do
+            sleep 1
+            c=$((c+1))
+            if [ $c -gt 120 ]; then
+                rlFail "The problems were not processed in 120s"
+                break
+            fi
+        done
+        # Nothing is processed twice later
+        sleep 3
+
+        rlLog "Processed: $(sort $PROCESSED_LOG | tr '\n' ' ')"
+        rlLog "Seen running: $(cat $RUNNING_LOG | tr '\n' ' ')"
+
+        rlAssertEquals "Every problem was processed" "_$(sort -u $PROCESSED_LOG | wc -l)" "_$PROBLEMS"
+        rlAssertEquals "No problem was processed twice" "_$(sort $PROCESSED_LOG | uniq -d | wc -l)" "_0"
+
+        max_running=$(sort -n $RUNNING_LOG | tail -n 1)
+        rlAssertGreaterOrEqual "At most $MAX_PARALLEL events ran at once" $MAX_PARALLEL $max_running
+        rlAssertGreater "The events ran in parallel" $max_running 1
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlBundleLogs abrt *.log $PROCESSED_LOG $RUNNING_LOG
+        rlFileRestore
+        rlServiceRestore abrtd
+        rm -f $EVENT_CONF
+        rm -rf $RUNNING_DIR $PROCESSED_LOG $RUNNING_LOG
+        rm -rf $ABRT_CONF_DUMP_LOCATION/${TEST}-*
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
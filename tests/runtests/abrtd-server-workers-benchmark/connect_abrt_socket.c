@@ -0,0 +1,68 @@
+/*
+ * Opens COUNT connections to abrt.socket one after another, sends a request
+ * which is refused without touching the dump location, waits for the response
+ * and prints the number of served connections per second.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SOCKET_FILE "/var/run/abrt/abrt.socket"
+#define REQUEST "DELETE /abrtd-server-workers-benchmark HTTP/1.1\r\n\r\n"
+
+static int one_request(void)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    strcpy(sa.sun_path, SOCKET_FILE);
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+        goto fail;
+
+    if (write(fd, REQUEST, strlen(REQUEST)) != (ssize_t)strlen(REQUEST))
+        goto fail;
+    shutdown(fd, SHUT_WR);
+
+    char buf[256];
+    ssize_t r;
+    ssize_t total = 0;
+    while ((r = read(fd, buf, sizeof(buf))) > 0)
+        total += r;
+
+    close(fd);
+    return total > 0 ? 0 : -1;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    const long count = argc > 1 ? strtol(argv[1], NULL, 10) : 1000;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    long failed = 0;
+    for (long i = 0; i < count; ++i)
+        if (one_request() != 0)
+            ++failed;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    fprintf(stderr, "%ld connections, %ld failed, %.3f s\n", count, failed, elapsed);
+    printf("%.0f\n", (count - failed) / elapsed);
+
+    return failed != 0;
+}
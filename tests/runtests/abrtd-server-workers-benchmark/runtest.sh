@@ -0,0 +1,84 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of abrtd-server-workers-benchmark
+#   Description: Compares connections/sec on abrt.socket with and without
+#                abrt-server workers
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   This program is free software: you can redistribute it and/or
+#   modify it under the terms of the GNU General Public License as
+#   published by the Free Software Foundation, either version 3 of
+#   the License, or (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE.  See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program. If not, see http://www.gnu.org/licenses/.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="abrtd-server-workers-benchmark"
+PACKAGE="abrt"
+
+ABRT_CONF="/etc/abrt/abrt.conf"
+TEST_APP="connect_abrt_socket"
+CONNECTIONS=2000
+
+function measure() {
+    rlRun "augtool set /files${ABRT_CONF}/ServerWorkers $1" 0
+    rlServiceStart abrtd
+    # let abrtd start the workers
+    sleep 1
+
+    RATE=$(./$TEST_APP $CONNECTIONS)
+    rlAssert0 "All $CONNECTIONS connections were served" $?
+    rlLog "ServerWorkers = $1: $RATE connections/sec"
+
+    rlServiceStop abrtd
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        rlFileBackup $ABRT_CONF
+
+        TmpDir=$(mktemp -d)
+        cp $TEST_APP.c $TmpDir
+        pushd $TmpDir
+        rlRun "gcc -O2 $TEST_APP.c -o $TEST_APP" 0 "Compile the benchmark client"
+
+        rlServiceStop abrtd
+    rlPhaseEnd
+
+    rlPhaseStartTest "Single-client abrt-server"
+        measure 0
+        ONE_SHOT_RATE=$RATE
+    rlPhaseEnd
+
+    rlPhaseStartTest "abrt-server workers"
+        measure 4
+        WORKERS_RATE=$RATE
+    rlPhaseEnd
+
+    rlPhaseStartTest "Compare"
+        rlLog "Speedup: $(echo "scale=2; $WORKERS_RATE/$ONE_SHOT_RATE" | bc)x"
+        rlAssertGreater "Workers serve more connections/sec" $WORKERS_RATE $ONE_SHOT_RATE
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        popd # TmpDir
+        rm -rf $TmpDir
+        rlFileRestore # ABRT_CONF
+        rlServiceRestore abrtd
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
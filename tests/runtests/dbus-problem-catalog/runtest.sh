@@ -0,0 +1,136 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of dbus-problem-catalog
+#   Description: Checks that problems are listed from the catalog maintained by abrtd and without it
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="dbus-problem-catalog"
+PACKAGE="abrt"
+
+function get_problems() {
+    dbus-send --system --type=method_call --print-reply \
+        --dest=org.freedesktop.problems /org/freedesktop/problems \
+        org.freedesktop.problems.GetProblems
+}
+
+function find_by_element() {
+    dbus-send --system --type=method_call --print-reply \
+        --dest=org.freedesktop.problems /org/freedesktop/problems \
+        org.freedesktop.problems.FindProblemByElementInTimeRange \
+        string:$1 string:$2 int64:$3 int64:$(date +%s) boolean:true
+}
+
+function find_by_executable() {
+    find_by_element executable $1 $2
+}
+
+# Replaces the element like libreport does, the directory's mtime changes
+function replace_element() {
+    echo -n $3 > $1/.$2.new && mv -f $1/.$2.new $1/$2
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+        CATALOG=$ABRT_CONF_DUMP_LOCATION/.catalog.d/catalog
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+    rlPhaseEnd
+
+    rlPhaseStartTest "listing from catalog"
+        time_from=$(date +%s)
+        generate_crash
+        wait_for_hooks
+        get_crash_path
+        executable=$(cat $crash_PATH/executable)
+        # The catalog is written shortly after post-create
+        sleep 1
+
+        rlAssertExists $CATALOG
+        rlAssertGrep "$(basename $crash_PATH)" $CATALOG
+
+        rlRun "get_problems &> catalog_reply.log"
+        rlAssertGrep "$crash_PATH" catalog_reply.log
+
+        rlRun "find_by_executable $executable $time_from &> catalog_find.log"
+        rlAssertGrep "$crash_PATH" catalog_find.log
+    rlPhaseEnd
+
+    rlPhaseStartTest "changed problem"
+        # Elements written after post-create, e.g. by reporters, are seen
+        # immediately although abrtd catalogues them later
+        rlRun "replace_element $crash_PATH component problem-catalog-changed"
+        rlRun "find_by_element component problem-catalog-changed $time_from &> changed_find.log"
+        rlAssertGrep "$crash_PATH" changed_find.log
+
+        # The catalogued elements are used while the directory is locked
+        rlRun "ln -s $$ $crash_PATH/.lock"
+        rlRun "replace_element $crash_PATH component problem-catalog-locked"
+        rlRun "find_by_element component problem-catalog-locked $time_from &> locked_find.log"
+        rlAssertNotGrep "$crash_PATH" locked_find.log
+        rlRun "rm -f $crash_PATH/.lock"
+        rlRun "find_by_element component problem-catalog-locked $time_from &> unlocked_find.log"
+        rlAssertGrep "$crash_PATH" unlocked_find.log
+    rlPhaseEnd
+
+    rlPhaseStartTest "listing without catalog"
+        # A damaged catalog must not be trusted
+        rlRun "truncate -s 16 $CATALOG"
+        rlRun "get_problems &> damaged_reply.log"
+        rlAssertGrep "$crash_PATH" damaged_reply.log
+
+        rlRun "find_by_executable $executable $time_from &> damaged_find.log"
+        rlAssertGrep "$crash_PATH" damaged_find.log
+    rlPhaseEnd
+
+    rlPhaseStartTest "rebuild"
+        rlRun "systemctl stop abrtd.service" 0 "Stop abrtd"
+        rlAssertNotExists $CATALOG
+
+        rlRun "systemctl start abrtd.service" 0 "Start abrtd"
+        rlAssertExists $CATALOG
+        rlRun "get_problems &> rebuilt_reply.log"
+        rlAssertGrep "$crash_PATH" rebuilt_reply.log
+    rlPhaseEnd
+
+    rlPhaseStartTest "deletion"
+        remove_problem_directory
+        sleep 1
+        rlAssertNotGrep "$(basename $crash_PATH)" $CATALOG
+        rlRun "get_problems &> deleted_reply.log"
+        rlAssertNotGrep "$crash_PATH" deleted_reply.log
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlBundleLogs abrt *.log
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
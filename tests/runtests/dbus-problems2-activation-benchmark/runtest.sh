@@ -0,0 +1,152 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of dbus-problems2-activation-benchmark
+#   Description: Measures abrt-dbus activation with 10k problems in the dump location
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="dbus-problems2-activation-benchmark"
+PACKAGE="abrt-dbus"
+
+PROBLEMS=10000
+P2_PATH=/org/freedesktop/Problems2
+
+function create_problem() {
+    local dir=$1
+    mkdir $dir
+    echo $(date +%s) > $dir/time
+    echo $(date +%s) > $dir/last_occurrence
+    echo CCpp > $dir/type
+    echo 0 > $dir/uid
+    echo /usr/bin/p2-bench > $dir/executable
+    echo 1 > $dir/count
+}
+
+function p2_call() {
+    busctl --system call org.freedesktop.problems $P2_PATH org.freedesktop.Problems2 "$@"
+}
+
+function elapsed_ms() {
+    echo $(( ($(date +%s%N) - $1) / 1000000 ))
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+
+        rlLog "Creating $PROBLEMS problem directories"
+        for i in $(seq $PROBLEMS); do
+            create_problem $ABRT_CONF_DUMP_LOCATION/ccpp-p2-bench-$i
+        done
+        # Let abrtd catch up with the new directories
+        sleep 5
+    rlPhaseEnd
+
+    rlPhaseStartTest "activation"
+        killall abrt-dbus &> /dev/null
+        wait_for_process abrt-dbus
+
+        start=$(date +%s%N)
+        rlRun "p2_call GetSession &> session.log" 0 "Activate abrt-dbus"
+        rlLog "Activation took $(elapsed_ms $start) ms"
+
+        start=$(date +%s%N)
+        rlRun "p2_call GetProblems 'ia{sv}' 0 0 > problems.log" 0 "List problems"
+        rlLog "Listing took $(elapsed_ms $start) ms"
+        rlAssertGrep "$P2_PATH/Entry/" problems.log
+    rlPhaseEnd
+
+    # Every listing without a cursor goes through the dump location again
+    rlPhaseStartTest "repeated listing"
+        for run in 1 2 3; do
+            start=$(date +%s%N)
+            rlRun "p2_call GetProblems 'ia{sv}' 0 0 > problems-$run.log" 0 "List problems again"
+            rlLog "Listing run $run took $(elapsed_ms $start) ms"
+            rlAssertNotDiffer problems.log problems-$run.log
+        done
+    rlPhaseEnd
+
+    # The following pages reuse the listing of the first one
+    rlPhaseStartTest "paged listing"
+        cat > paged_listing.py <<PYEOF
+import time
+import dbus
+
+bus = dbus.SystemBus()
+p2 = dbus.Interface(bus.get_object("org.freedesktop.problems", "$P2_PATH"),
+                    "org.freedesktop.Problems2")
+
+options = {"limit": dbus.UInt32(1000)}
+entries = []
+total = time.monotonic()
+while True:
+    start = time.monotonic()
+    page = p2.GetProblems(0, options)
+    print("Page %d took %d ms" % (len(entries) // 1000 + 1, (time.monotonic() - start) * 1000))
+    if not page:
+        break
+    entries.extend(page)
+    options["after"] = page[-1]
+print("Walk of %d problems took %d ms" % (len(entries), (time.monotonic() - total) * 1000))
+
+start = time.monotonic()
+props = p2.GetProblemsProperties(entries, ["Executable"])
+print("Properties of %d problems took %d ms" % (len(props), (time.monotonic() - start) * 1000))
+PYEOF
+        rlRun "python3 paged_listing.py > paged_listing.log" 0 "Walk the pages and read the properties"
+        rlLog "$(cat paged_listing.log)"
+        rlAssertGrep "Walk of $PROBLEMS problems" paged_listing.log
+        rlAssertGrep "Properties of $PROBLEMS problems" paged_listing.log
+    rlPhaseEnd
+
+    rlPhaseStartTest "entry on demand"
+        dir=$ABRT_CONF_DUMP_LOCATION/ccpp-p2-bench-42
+        entry=$P2_PATH/Entry/$(echo -n $dir | sha1sum | cut -d' ' -f1)
+
+        start=$(date +%s%N)
+        rlRun "busctl --system get-property org.freedesktop.problems $entry org.freedesktop.Problems2.Entry Executable > executable.log"
+        rlLog "The first access to the entry took $(elapsed_ms $start) ms"
+        rlAssertGrep "/usr/bin/p2-bench" executable.log
+
+        rlRun "busctl --system introspect org.freedesktop.problems $entry > introspect.log"
+        rlAssertGrep "org.freedesktop.Problems2.Entry" introspect.log
+
+        rlRun "busctl --system get-property org.freedesktop.problems $P2_PATH/Entry/0000 org.freedesktop.Problems2.Entry Executable" 1 "Unknown entry"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlBundleLogs abrt *.log
+        rm -rf $ABRT_CONF_DUMP_LOCATION/ccpp-p2-bench-*
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,150 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import time
+
+import dbus
+
+import abrt_p2_testing
+from abrt_p2_testing import create_problem, Problems2Entry
+
+
+class TestGetProblemsOptions(abrt_p2_testing.TestCase):
+
+    def setUp(self):
+        self.problems = {}
+        for name in ["foo", "bar", "baz"]:
+            description = {"analyzer": "problems2testsuite_analyzer",
+                           "type": "problems2testsuite_type",
+                           "reason": "Application has been killed",
+                           "backtrace": "die()",
+                           "component": "problems2testsuite-" + name,
+                           "executable": "/usr/bin/" + name}
+
+            self.problems[name] = create_problem(self,
+                                                 self.p2,
+                                                 description=description)
+
+    def tearDown(self):
+        self.p2.DeleteProblems(list(self.problems.values()))
+
+    def test_filter_executable(self):
+        p = self.p2.GetProblems(0, {"executable": dbus.Array(["/usr/bin/foo",
+                                                               "/usr/bin/bar"],
+                                                              signature="s")})
+
+        self.assertIn(self.problems["foo"], p)
+        self.assertIn(self.problems["bar"], p)
+        self.assertNotIn(self.problems["baz"], p)
+
+    def test_filter_component(self):
+        p = self.p2.GetProblems(0, {"component": dbus.Array(["problems2testsuite-baz"],
+                                                             signature="s")})
+
+        self.assertEqual([self.problems["baz"]], p)
+
+    def test_filter_time(self):
+        now = int(time.time())
+
+        p = self.p2.GetProblems(0, {"since": dbus.Int64(now + 3600)})
+        self.assertEqual(0, len(p))
+
+        p = self.p2.GetProblems(0, {"until": dbus.Int64(now - 3600)})
+        for problem in self.problems.values():
+            self.assertNotIn(problem, p)
+
+        p = self.p2.GetProblems(0, {"since": dbus.Int64(now - 3600)})
+        for problem in self.problems.values():
+            self.assertIn(problem, p)
+
+    def test_filter_reported(self):
+        p = self.p2.GetProblems(0, {"reported": dbus.Boolean(False)})
+        for problem in self.problems.values():
+            self.assertIn(problem, p)
+
+        p = self.p2.GetProblems(0, {"reported": dbus.Boolean(True)})
+        for problem in self.problems.values():
+            self.assertNotIn(problem, p)
+
+    def test_filter_reported_changed(self):
+        p2e = Problems2Entry(self.bus, self.problems["foo"])
+        p2e.SaveElements({"reported_to": "ABRT Server: URL=http://localhost\n"},
+                         0)
+        # abrtd updates the catalog shortly after the change
+        time.sleep(1)
+
+        p = self.p2.GetProblems(0, {"reported": dbus.Boolean(True)})
+        self.assertIn(self.problems["foo"], p)
+        self.assertNotIn(self.problems["bar"], p)
+
+        p = self.p2.GetProblems(0, {"reported": dbus.Boolean(False)})
+        self.assertNotIn(self.problems["foo"], p)
+        self.assertIn(self.problems["bar"], p)
+
+    def test_pages(self):
+        everything = self.p2.GetProblems(0, {"order": "newest-first"})
+        self.assertEqual(everything,
+                         self.p2.GetProblems(0, {"limit": dbus.UInt32(10000)}))
+
+        pages = []
+        options = {"limit": dbus.UInt32(1)}
+        while True:
+            page = self.p2.GetProblems(0, options)
+            self.assertLessEqual(len(page), 1)
+            if not page:
+                break
+            pages.extend(page)
+            options["after"] = page[-1]
+
+        self.assertEqual(everything, pages)
+
+        oldest = self.p2.GetProblems(0, {"order": "oldest-first"})
+        self.assertEqual(list(reversed(everything)), oldest)
+
+    def cursor(self, entry):
+        props = self.p2.GetProblemsProperties([entry], ["LastOccurrence"])
+        return dbus.Struct((dbus.Int64(props[entry]["LastOccurrence"]),
+                            dbus.ObjectPath(entry)),
+                           signature="xo")
+
+    def test_pages_deleted_cursor(self):
+        everything = self.p2.GetProblems(0, {"order": "oldest-first"})
+        mine = [e for e in everything if e in self.problems.values()]
+        self.assertEqual(3, len(mine))
+
+        # The page ends with a problem deleted before the next page
+        first = everything[:everything.index(mine[1]) + 1]
+        page = self.p2.GetProblems(0, {"order": "oldest-first",
+                                       "limit": dbus.UInt32(len(first))})
+        self.assertEqual(first, page)
+        cursor = self.cursor(page[-1])
+
+        self.p2.DeleteProblems([page[-1]])
+        for name, entry in list(self.problems.items()):
+            if entry == page[-1]:
+                del self.problems[name]
+
+        rest = self.p2.GetProblems(0, {"order": "oldest-first",
+                                       "after": cursor})
+        self.assertEqual(everything[len(first):], rest)
+
+        # The path alone is not enough once the problem is gone
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: "
+            "The problem '%s' is no longer listed" % page[-1],
+            self.p2.GetProblems, 0, {"order": "oldest-first",
+                                     "after": page[-1]})
+
+    def test_invalid_options(self):
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: Unknown option 'foo'",
+            self.p2.GetProblems, 0, {"foo": "bar"})
+
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: "
+            "Invalid value of option 'order'",
+            self.p2.GetProblems, 0, {"order": "random"})
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestGetProblemsOptions)
@@ -0,0 +1,59 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import abrt_p2_testing
+from abrt_p2_testing import (create_problem, Problems2Entry)
+
+
+PROPERTIES = ["ID", "Type", "Executable", "Count", "Package",
+              "FirstOccurrence", "LastOccurrence", "IsReported"]
+
+
+class TestGetProblemsProperties(abrt_p2_testing.TestCase):
+
+    def setUp(self):
+        # More problems than the service reads in the main loop, root is not
+        # limited by the new problems throttling
+        self.p2_entry_paths = [create_problem(self,
+                                              self.root_p2,
+                                              bus=self.root_bus)
+                               for _ in range(20)]
+
+    def tearDown(self):
+        self.root_p2.DeleteProblems(self.p2_entry_paths)
+
+    def test_properties(self):
+        props = self.root_p2.GetProblemsProperties(self.p2_entry_paths, PROPERTIES)
+
+        self.assertEqual(sorted(self.p2_entry_paths), sorted(props.keys()))
+
+        for path in self.p2_entry_paths:
+            p2e = Problems2Entry(self.root_bus, path)
+            for name in PROPERTIES:
+                self.assertEqual(p2e.getproperty(name), props[path][name],
+                                 "{0} of {1}".format(name, path))
+
+    def test_few_properties(self):
+        props = self.root_p2.GetProblemsProperties(self.p2_entry_paths[:2], ["Type"])
+
+        self.assertEqual(2, len(props))
+        for path in self.p2_entry_paths[:2]:
+            self.assertEqual({"Type": "problems2testsuite_type"}, props[path])
+
+    def test_missing_entry(self):
+        missing = "/org/freedesktop/Problems2/Entry/FAKE"
+        props = self.root_p2.GetProblemsProperties([missing, self.p2_entry_paths[0]],
+                                              ["ID"])
+
+        self.assertNotIn(missing, props)
+        self.assertIn(self.p2_entry_paths[0], props)
+
+    def test_unknown_property(self):
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.UnknownProperty: "
+            "Unknown property 'Foo'",
+            self.root_p2.GetProblemsProperties, self.p2_entry_paths, ["Type", "Foo"])
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestGetProblemsProperties)
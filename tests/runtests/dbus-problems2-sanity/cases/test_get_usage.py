@@ -0,0 +1,72 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import time
+
+import dbus
+
+import abrt_p2_testing
+from abrt_p2_testing import create_problem
+
+
+USAGE_KEYS = ["problems", "problems_limit", "new_problems",
+              "new_problems_batch", "new_problem_throttling_magnitude"]
+
+
+class TestGetUsage(abrt_p2_testing.TestCase):
+
+    def setUp(self):
+        self.p2_entry_path = None
+
+    def tearDown(self):
+        if self.p2_entry_path is not None:
+            self.p2.DeleteProblems([self.p2_entry_path])
+
+    def wait_for_problems(self, count):
+        # The problem is counted when abrtd notifies abrt-dbus
+        for _ in range(50):
+            usage = self.p2.GetUsage(dict())
+            if usage["problems"] == count:
+                return usage
+            time.sleep(0.1)
+
+        return self.p2.GetUsage(dict())
+
+    def test_keys(self):
+        usage = self.p2.GetUsage(dict())
+        self.assertEqual(sorted(USAGE_KEYS), sorted(usage.keys()))
+        self.assertLessEqual(usage["new_problems"], usage["new_problems_batch"])
+
+    def test_counters(self):
+        before = self.p2.GetUsage(dict())
+
+        self.p2_entry_path = create_problem(self, self.p2)
+
+        after = self.wait_for_problems(before["problems"] + 1)
+        self.assertEqual(before["problems"] + 1, after["problems"])
+        self.assertEqual(before["new_problems"] - 1, after["new_problems"])
+
+        self.p2.DeleteProblems([self.p2_entry_path])
+        self.p2_entry_path = None
+
+        self.assertEqual(before["problems"],
+                         self.p2.GetUsage(dict())["problems"])
+
+    def test_other_user(self):
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.AccessDenied: "
+            "You are not authorized to read usage of other users",
+            self.p2.GetUsage, {"uid": dbus.UInt32(0)})
+
+        usage = self.root_p2.GetUsage({"uid": dbus.UInt32(0)})
+        self.assertEqual(0, usage["problems_limit"])
+
+    def test_unknown_option(self):
+        self.assertRaisesDBusError(
+            "org.freedesktop.DBus.Error.InvalidArgs: "
+            "Unknown option 'foo'",
+            self.p2.GetUsage, {"foo": dbus.UInt32(0)})
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestGetUsage)
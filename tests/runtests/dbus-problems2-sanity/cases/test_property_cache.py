@@ -0,0 +1,60 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import os
+import time
+
+import abrt_p2_testing
+from abrt_p2_testing import (create_problem, Problems2Entry)
+
+
+class TestPropertyCache(abrt_p2_testing.TestCase):
+
+    def setUp(self):
+        self.p2_entry_path = create_problem(self, self.p2)
+
+    def tearDown(self):
+        self.p2.DeleteProblems([self.p2_entry_path])
+
+    def cache_counter(self, name):
+        return self.p2_proxy.Get("org.freedesktop.Problems2",
+                                 name,
+                                 dbus_interface="org.freedesktop.DBus.Properties")
+
+    def test_repeated_reads_hit(self):
+        p2e = Problems2Entry(self.bus, self.p2_entry_path)
+
+        first = p2e.getproperty("Type")
+        hits = self.cache_counter("PropertyCacheHits")
+
+        self.assertEqual(first, p2e.getproperty("Type"))
+        self.assertEqual(hits + 1, self.cache_counter("PropertyCacheHits"))
+        self.assertGreater(self.cache_counter("PropertyCacheSize"), 0)
+
+    def test_save_elements_invalidates(self):
+        p2e = Problems2Entry(self.bus, self.p2_entry_path)
+
+        self.assertEqual(1, p2e.getproperty("Count"))
+        p2e.SaveElements({"count": "5"}, 0)
+        self.assertEqual(5, p2e.getproperty("Count"))
+
+    def test_external_change_invalidates(self):
+        p2e = Problems2Entry(self.root_bus, self.p2_entry_path)
+        problem_id = p2e.getproperty("ID")
+
+        self.assertEqual(1, p2e.getproperty("Count"))
+
+        with open(os.path.join(problem_id, "count"), "w") as count_file:
+            count_file.write("7")
+
+        # Give the service a chance to process the inotify event
+        for _ in range(50):
+            if p2e.getproperty("Count") == 7:
+                break
+            time.sleep(0.1)
+
+        self.assertEqual(7, p2e.getproperty("Count"))
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestPropertyCache)
@@ -0,0 +1,108 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of dup-index-benchmark
+#   Description: Measures post-create duplicate detection with 10k problems in the dump location
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="dup-index-benchmark"
+PACKAGE="abrt"
+
+PROBLEMS=10000
+EXECUTABLES=100
+ABRT_HANDLE_EVENT=/usr/libexec/abrt-handle-event
+
+# Problems marked as uploaded run only the dummy post-create event
+function create_problem() {
+    local dir=$1
+    mkdir $dir
+    echo $(date +%s) > $dir/time
+    echo Python3 > $dir/type
+    echo 0 > $dir/uid
+    echo /usr/bin/dup-bench-$2 > $dir/executable
+    echo $3 > $dir/uuid
+    echo 1 > $dir/remote
+}
+
+function elapsed_ms() {
+    echo $(( ($(date +%s%N) - $1) / 1000000 ))
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        TmpDir=$(mktemp -d)
+        DUMP_LOCATION=$TmpDir/spool
+        mkdir -p $TmpDir/conf $DUMP_LOCATION
+        echo "DumpLocation = $DUMP_LOCATION" > $TmpDir/conf/abrt.conf
+        export ABRT_CONF_DIR=$TmpDir/conf
+        pushd $TmpDir
+
+        rlLog "Creating $PROBLEMS problem directories"
+        for i in $(seq $PROBLEMS); do
+            create_problem $DUMP_LOCATION/Python3-bench-$i $((i % EXECUTABLES)) uuid-$i
+            echo 1 > $DUMP_LOCATION/Python3-bench-$i/count
+        done
+    rlPhaseEnd
+
+    rlPhaseStartTest "duplicates"
+        # The first run builds the index
+        for run in 1 2 3 4; do
+            orig=$((run * 1000 + 7))
+            create_problem $DUMP_LOCATION/Python3-dup-$run $((orig % EXECUTABLES)) uuid-$orig
+
+            start=$(date +%s%N)
+            rlRun "$ABRT_HANDLE_EVENT -e post-create -- $DUMP_LOCATION/Python3-dup-$run &> dup-$run.log" 1 "Duplicate found"
+            rlLog "Duplicate detection run $run took $(elapsed_ms $start) ms"
+            rlAssertGrep "DUP_OF_DIR: $DUMP_LOCATION/Python3-bench-$orig" dup-$run.log
+
+            rm -rf $DUMP_LOCATION/Python3-dup-$run
+        done
+
+        rlAssertExists "$DUMP_LOCATION/.dup-index/complete"
+    rlPhaseEnd
+
+    rlPhaseStartTest "new problem"
+        create_problem $DUMP_LOCATION/Python3-new 7 uuid-new
+
+        start=$(date +%s%N)
+        rlRun "$ABRT_HANDLE_EVENT -e post-create -- $DUMP_LOCATION/Python3-new &> new.log" 0 "No duplicate found"
+        rlLog "Processing of a new problem took $(elapsed_ms $start) ms"
+        rlAssertExists "$DUMP_LOCATION/.dup-index/dirs/Python3-new"
+
+        # The new problem is found without scanning the dump location
+        create_problem $DUMP_LOCATION/Python3-new-dup 7 uuid-new
+        rlRun "$ABRT_HANDLE_EVENT -e post-create -- $DUMP_LOCATION/Python3-new-dup &> new-dup.log" 1 "Duplicate found"
+        rlAssertGrep "DUP_OF_DIR: $DUMP_LOCATION/Python3-new$" new-dup.log
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        unset ABRT_CONF_DIR
+        popd # TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,179 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of journal-watch
+#   Description: Verify abrt-journal-watch and compare it with the separate journal dumpers
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This program is free software: you can redistribute it and/or
+#   modify it under the terms of the GNU General Public License as
+#   published by the Free Software Foundation, either version 3 of
+#   the License, or (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE.  See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program. If not, see http://www.gnu.org/licenses/.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="journal-watch"
+PACKAGE="abrt"
+EXAMPLES_PATH="../../examples"
+OOPS_IDENTIFIER="abrt_test"
+XORG_IDENTIFIER="abrt-xorg-test"
+STATE_FILES="/var/lib/abrt/abrt-dump-journal-core.state
+/var/lib/abrt/abrt-dump-journal-oops.state
+/var/lib/abrt/abrt-dump-journal-xorg.state"
+NOISE_MESSAGES=2000
+
+export ABRT_DUMP_JOURNAL_OOPS_DEBUG_FILTER="SYSLOG_IDENTIFIER=${OOPS_IDENTIFIER}"
+export ABRT_DUMP_JOURNAL_XORG_DEBUG_FILTER="SYSLOG_IDENTIFIER=${XORG_IDENTIFIER}"
+
+# Prints VmRSS in kB and the number of context switches of the process
+function process_usage
+{
+    awk '/^VmRSS:/ { rss = $2 }
+         /ctxt_switches:/ { ctxt += $2 }
+         END { print rss, ctxt }' /proc/$1/status
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+
+        TmpDir=$(mktemp -d)
+        cat $EXAMPLES_PATH/oops1.test | cut -d" " -f6- > $TmpDir/oops1.test
+        cat $EXAMPLES_PATH/xorg_journal_crash1.test | cut -d" " -f6- > $TmpDir/xorg1.test
+        pushd $TmpDir
+
+        rlServiceStop abrt-journal-core
+        rlServiceStop abrt-oops
+        rlServiceStop abrt-xorg
+
+        # The stored cursors are not valid in testing configuration.
+        rlRun "rm -f $STATE_FILES"
+    rlPhaseEnd
+
+    rlPhaseStartTest "Problems from all sources"
+        rlRun "setsid abrt-journal-watch -vvv -xD -e >journal-watch.log 2>&1 &"
+        rlRun "ABRT_WATCH_PID=$!"
+        rlRun "sleep 2"
+
+        prepare
+        rlRun "logger -t ${OOPS_IDENTIFIER} -f oops1.test"
+        rlRun "journalctl --flush"
+        rlRun "sleep 3"
+        rlAssertGrep "Found oopses: 1" journal-watch.log
+        wait_for_hooks
+        get_crash_path
+        rlAssertExists "$crash_PATH/kernel"
+        remove_problem_directory
+
+        prepare
+        rlRun "logger -t ${XORG_IDENTIFIER} -f xorg1.test"
+        rlRun "journalctl --flush"
+        rlRun "sleep 3"
+        rlAssertGrep "Found crashes: 1" journal-watch.log
+        wait_for_hooks
+        get_crash_path
+        rlAssertExists "$crash_PATH/backtrace"
+        remove_problem_directory
+
+        prepare
+        generate_crash
+        wait_for_hooks
+        get_crash_path
+        rlAssertGrep "CCpp" "$crash_PATH/type"
+        rlAssertGrep "abrt-journal-core" "$crash_PATH/analyzer"
+        remove_problem_directory
+
+        rlRun "kill -TERM $ABRT_WATCH_PID"
+        rlRun "sleep 2"
+        rlAssertNotExists "/proc/$ABRT_WATCH_PID"
+
+        for f in $STATE_FILES; do
+            rlAssertExists "$f"
+        done
+    rlPhaseEnd
+
+    rlPhaseStartTest "Restart does not process messages again"
+        rlRun "setsid abrt-journal-watch -vvv -xD >journal-watch-restart.log 2>&1 &"
+        rlRun "ABRT_WATCH_PID=$!"
+        rlRun "sleep 3"
+        rlAssertNotGrep "Found oopses" journal-watch-restart.log
+        rlAssertNotGrep "Found crashes" journal-watch-restart.log
+        rlRun "kill -TERM $ABRT_WATCH_PID"
+        rlRun "sleep 2"
+    rlPhaseEnd
+
+    rlPhaseStartTest "Resource usage compared to the separate dumpers"
+        rlRun "setsid abrt-dump-journal-core -f -e -o >dump-core.log 2>&1 &"
+        rlRun "CORE_PID=$!"
+        rlRun "setsid abrt-dump-journal-oops -f -e -o >dump-oops.log 2>&1 &"
+        rlRun "OOPS_PID=$!"
+        rlRun "setsid abrt-dump-journal-xorg -f -e -o >dump-xorg.log 2>&1 &"
+        rlRun "XORG_PID=$!"
+        rlRun "setsid abrt-journal-watch -e -o >journal-watch-usage.log 2>&1 &"
+        rlRun "WATCH_PID=$!"
+        rlRun "sleep 2"
+
+        for pid in $CORE_PID $OOPS_PID $XORG_PID $WATCH_PID; do
+            process_usage $pid > usage-before.$pid
+        done
+
+        for i in $(seq $NOISE_MESSAGES); do
+            echo "abrt journal watch noise $i"
+        done | logger -t abrt-journal-watch-noise
+        rlRun "journalctl --flush"
+        rlRun "sleep 3"
+
+        SEPARATE_RSS=0
+        SEPARATE_CTXT=0
+        for pid in $CORE_PID $OOPS_PID $XORG_PID; do
+            read rss ctxt_before < usage-before.$pid
+            read rss ctxt < <(process_usage $pid)
+            SEPARATE_RSS=$((SEPARATE_RSS + rss))
+            SEPARATE_CTXT=$((SEPARATE_CTXT + ctxt - ctxt_before))
+        done
+
+        read rss ctxt_before < usage-before.$WATCH_PID
+        read WATCH_RSS ctxt < <(process_usage $WATCH_PID)
+        WATCH_CTXT=$((ctxt - ctxt_before))
+
+        rlLog "separate dumpers: VmRSS ${SEPARATE_RSS} kB, ${SEPARATE_CTXT} context switches per ${NOISE_MESSAGES} messages"
+        rlLog "abrt-journal-watch: VmRSS ${WATCH_RSS} kB, ${WATCH_CTXT} context switches per ${NOISE_MESSAGES} messages"
+
+        rlAssertGreater "abrt-journal-watch uses less memory" $SEPARATE_RSS $WATCH_RSS
+        rlAssertGreater "abrt-journal-watch is woken up less often" $SEPARATE_CTXT $WATCH_CTXT
+
+        rlRun "kill -TERM $CORE_PID $OOPS_PID $XORG_PID $WATCH_PID"
+        rlRun "sleep 2"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        # Do not confuse the system dumpers. The stored cursors are invalid in the default configuration.
+        rlRun "rm -f $STATE_FILES"
+
+        rlServiceRestore abrt-journal-core
+        rlServiceRestore abrt-oops
+        rlServiceRestore abrt-xorg
+
+        rlBundleLogs abrt $(echo *.log)
+        rlRun "popd"
+        rlLog "$TmpDir"
+        rlRun "rm -r $TmpDir" 0 "Removing tmp directory"
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
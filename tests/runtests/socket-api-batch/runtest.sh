@@ -0,0 +1,131 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of socket-api-batch
+#   Description: tests if several problems can be sent over one socket connection
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="socket-api-batch"
+PACKAGE="abrt"
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+
+        # Three valid problems and one without reason
+        cat > send_batch.py <<PYEOF
+import socket
+
+def record(reason, executable):
+    data = "type=Python3\0analyzer=Python3\0pid=%d\0executable=%s\0" % (1, executable)
+    if reason:
+        data += "reason=%s\0backtrace=%s\0" % (reason, reason * 1000)
+    data = data.encode()
+    return str(len(data)).encode() + b"\n" + data
+
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect("/var/run/abrt/abrt.socket")
+s.sendall(b"POST /batch HTTP/1.1\r\n\r\n")
+for i, reason in enumerate(["first", "second", None, "third"]):
+    s.sendall(record(reason, "/usr/bin/batch-test-%d" % i))
+s.shutdown(socket.SHUT_WR)
+
+resp = b""
+while True:
+    buf = s.recv(256)
+    if not buf:
+        break
+    resp += buf
+print(" ".join(line.split()[1].decode() for line in resp.split(b"\r\n\r\n") if line))
+PYEOF
+
+        # More data than may be sent in one batch, every record is valid and
+        # smaller than a single problem may be
+        cat > send_big_batch.py <<PYEOF
+import socket
+
+def record(i):
+    reason = "over-limit-%02d" % i
+    data = "type=Python3\0analyzer=Python3\0pid=1\0executable=/usr/bin/batch-big-%d\0" % i
+    data += "reason=%s\0backtrace=%s\0" % (reason, reason * 70000)
+    data = data.encode()
+    return str(len(data)).encode() + b"\n" + data
+
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect("/var/run/abrt/abrt.socket")
+try:
+    s.sendall(b"POST /batch HTTP/1.1\r\n\r\n")
+    for i in range(32):
+        s.sendall(record(i))
+    s.shutdown(socket.SHUT_WR)
+except (BrokenPipeError, ConnectionResetError):
+    pass
+
+resp = b""
+while True:
+    buf = s.recv(256)
+    if not buf:
+        break
+    resp += buf
+print(" ".join(line.split()[1].decode() for line in resp.split(b"\r\n\r\n") if line))
+PYEOF
+    rlPhaseEnd
+
+    rlPhaseStartTest
+        rlRun "python3 send_batch.py > responses.log" 0 "Sent the batch"
+        rlAssertGrep "^201 201 400 201$" responses.log
+
+        wait_for_hooks
+        rlAssertEquals "Three problems were created" "_$(abrt status --bare)" "_3"
+    rlPhaseEnd
+
+    rlPhaseStartTest "batch over limit"
+        load_abrt_conf
+        rlRun "rm -rf $ABRT_CONF_DUMP_LOCATION/Python3-*" 0 "Remove the problem directories"
+
+        # The batch is cut off once it is over the limit of the whole batch,
+        # although none of the records is
+        rlRun "python3 send_big_batch.py > big_responses.log" 0 "Sent the batch"
+        rlAssertGrep "^(201 )+413$" big_responses.log -E
+        created=$(grep -o 201 big_responses.log | wc -l)
+        rlAssertGreater "Not all records were accepted" 32 $created
+
+        wait_for_hooks
+        rlAssertEquals "Only the accepted problems were created" "_$(abrt status --bare)" "_$created"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        load_abrt_conf
+        rlRun "rm -rf $ABRT_CONF_DUMP_LOCATION/Python3-*" 0 "Remove the problem directories"
+        popd #TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
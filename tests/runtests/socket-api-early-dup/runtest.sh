@@ -0,0 +1,139 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of socket-api-early-dup
+#   Description: tests that abrt-server counts known duplicates without
+#                saving them and runs notify-dup
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="socket-api-early-dup"
+PACKAGE="abrt"
+
+EVENT_CONF="/etc/libreport/events.d/socket_api_early_dup_test.conf"
+NOTIFY_DUP_LOG="/tmp/socket-api-early-dup.log"
+
+# Sends the same problem in the way given by $1 ("single" or "batch" of two
+# records) with the line numbers moved by $3 and checks the HTTP codes of the
+# responses
+function send_problem() {
+    rlRun "python3 send_problem.py $1 ${3:-0} > responses.log" 0 "Sent the problem ($1)"
+    rlAssertGrep "^$2$" responses.log
+    wait_for_hooks
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        echo "EVENT=notify-dup type=Python3 executable=/usr/bin/socket-api-early-dup" > $EVENT_CONF
+        echo "        echo \"\$DUMP_DIR\" >> $NOTIFY_DUP_LOG" >> $EVENT_CONF
+        rm -f $NOTIFY_DUP_LOG
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+
+        cat > send_problem.py <<PYEOF
+import socket
+import sys
+
+SHIFT = int(sys.argv[2])
+BACKTRACE = (
+    "socket-api-early-dup:%d:crash:RuntimeError: early dup test\n"
+    "\n"
+    "Traceback (most recent call last):\n"
+    "  File \"/usr/bin/socket-api-early-dup\", line %d, in <module>\n"
+    "    main()\n"
+    "  File \"/usr/bin/socket-api-early-dup\", line %d, in main\n"
+    "    crash()\n"
+    "  File \"/usr/bin/socket-api-early-dup\", line %d, in crash\n"
+    "    raise RuntimeError(\"early dup test\")\n"
+    "RuntimeError: early dup test\n"
+    % (4 + SHIFT, 12 + SHIFT, 8 + SHIFT, 4 + SHIFT))
+
+DATA = ("type=Python3\0analyzer=Python3\0pid=1\0"
+        "executable=/usr/bin/socket-api-early-dup\0reason=early dup test\0"
+        "backtrace=%s\0" % BACKTRACE).encode()
+
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect("/var/run/abrt/abrt.socket")
+if sys.argv[1] == "batch":
+    s.sendall(b"POST /batch HTTP/1.1\r\n\r\n")
+    for i in range(2):
+        s.sendall(str(len(DATA)).encode() + b"\n" + DATA)
+else:
+    s.sendall(b"POST / HTTP/1.1\r\n\r\n" + DATA)
+s.shutdown(socket.SHUT_WR)
+
+resp = b""
+while True:
+    buf = s.recv(256)
+    if not buf:
+        break
+    resp += buf
+print(" ".join(line.split()[1].decode() for line in resp.split(b"\r\n\r\n") if line))
+PYEOF
+    rlPhaseEnd
+
+    rlPhaseStartTest "The first occurrence"
+        send_problem single 201
+        rlAssertEquals "One problem was created" "_$(abrt status --bare)" "_1"
+        crash_PATH=$(ls -d $ABRT_CONF_DUMP_LOCATION/Python3-*)
+        rlAssertEquals "The problem occurred once" "_$(cat $crash_PATH/count)" "_1"
+        rlAssertNotExists $NOTIFY_DUP_LOG
+    rlPhaseEnd
+
+    rlPhaseStartTest "Counted duplicate"
+        send_problem single 303
+        rlAssertEquals "No new problem was created" "_$(abrt status --bare)" "_1"
+        rlAssertEquals "The occurrence was counted" "_$(cat $crash_PATH/count)" "_2"
+        rlAssertEquals "notify-dup ran once" "_$(cat $NOTIFY_DUP_LOG)" "_$crash_PATH"
+    rlPhaseEnd
+
+    rlPhaseStartTest "Counted duplicates in batch"
+        send_problem batch "303 303"
+        rlAssertEquals "No new problem was created" "_$(abrt status --bare)" "_1"
+        rlAssertEquals "The occurrences were counted" "_$(cat $crash_PATH/count)" "_4"
+        rlAssertEquals "notify-dup ran for every occurrence" "_$(grep -c "^$crash_PATH\$" $NOTIFY_DUP_LOG)" "_3"
+    rlPhaseEnd
+
+    rlPhaseStartTest "Counted duplicate at other lines"
+        # The backtraces are compared by their frames, not by the text
+        send_problem single 303 10
+        rlAssertEquals "No new problem was created" "_$(abrt status --bare)" "_1"
+        rlAssertEquals "The occurrence was counted" "_$(cat $crash_PATH/count)" "_5"
+        rlAssertEquals "notify-dup ran for every occurrence" "_$(grep -c "^$crash_PATH\$" $NOTIFY_DUP_LOG)" "_4"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlRun "rm -f $EVENT_CONF $NOTIFY_DUP_LOG" 0 "Remove the test event"
+        rlRun "rm -rf $ABRT_CONF_DUMP_LOCATION/Python3-*" 0 "Remove the problem directories"
+        popd #TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
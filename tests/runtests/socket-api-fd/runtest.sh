@@ -0,0 +1,97 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of socket-api-fd
+#   Description: tests passing contents of elements as file descriptors
+#                over abrt.socket
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="socket-api-fd"
+PACKAGE="abrt"
+
+# Sends a problem of EXECUTABLE and prints the path of the new problem
+# directory, the rest of the arguments are KEY=PATH of the elements passed as
+# file descriptors.
+function send_problem() {
+    local executable=$1
+    shift
+    rlRun "$SEND_AS ./send_fd_problem.py $executable $* > response.log" 0 "Sent a problem of $executable"
+    rlAssertGrep "^201$" response.log
+    wait_for_hooks
+    PROBLEM_DIR=$(grep -l "^$executable\$" $ABRT_CONF_DUMP_LOCATION/Python3-*/executable | xargs dirname)
+    rlAssertNotEquals "The problem directory was created" "_$PROBLEM_DIR" "_"
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        chmod a+rx $TmpDir
+        cp send_fd_problem.py $TmpDir
+        pushd $TmpDir
+
+        head -c 1000000 /dev/urandom > regular.bin
+        # 5MiB, more than MAX_MESSAGE_SIZE of an unprivileged client
+        truncate -s 5M sparse.bin
+        rlRun "mkfifo fifo" 0 "Create a FIFO"
+        SEND_AS=""
+    rlPhaseEnd
+
+    rlPhaseStartTest "Regular file"
+        send_problem /usr/bin/socket-api-fd-regular fd_test=regular.bin
+        rlAssertNotDiffer regular.bin $PROBLEM_DIR/fd_test
+    rlPhaseEnd
+
+    rlPhaseStartTest "Not a regular file"
+        SINCE=$(date +"%Y-%m-%d %T")
+        send_problem /usr/bin/socket-api-fd-fifo fd_test=fifo
+        rlAssertNotExists $PROBLEM_DIR/fd_test
+        journalctl -t abrt-server --since="$SINCE" > abrt-server.log
+        rlAssertGrep "is not a regular file" abrt-server.log
+    rlPhaseEnd
+
+    rlPhaseStartTest "Element not allowed"
+        send_problem /usr/bin/socket-api-fd-pid pid=regular.bin
+        rlAssertEquals "pid was not replaced" "_$(cat $PROBLEM_DIR/pid)" "_1"
+    rlPhaseEnd
+
+    rlPhaseStartTest "Too big file of unprivileged user"
+        SEND_AS="runuser -u nobody --"
+        send_problem /usr/bin/socket-api-fd-big fd_test=sparse.bin
+        rlAssertNotExists $PROBLEM_DIR/fd_test
+        SEND_AS=""
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlRun "rm -rf $ABRT_CONF_DUMP_LOCATION/Python3-*" 0 "Remove the problem directories"
+        popd #TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd
@@ -0,0 +1,51 @@
+#!/usr/bin/python3
+# Sends a problem to abrt.socket with the contents of some elements passed as
+# file descriptors ("KEY:fd=N").
+#
+# usage: send_fd_problem.py EXECUTABLE [KEY=PATH]...
+#
+# Prints the HTTP code of the response.
+
+import array
+import os
+import socket
+import sys
+
+
+def element(key, value):
+    return ("%s=%s\0" % (key, value)).encode()
+
+
+def main(argv):
+    data = (element("type", "Python3") + element("analyzer", "Python3")
+            + element("pid", "1") + element("executable", argv[1])
+            + element("reason", "socket-api-fd test"))
+
+    fds = []
+    for arg in argv[2:]:
+        key, path = arg.split("=", 1)
+        # O_NONBLOCK lets us open a FIFO without a writer
+        fds.append(os.open(path, os.O_RDONLY | os.O_NONBLOCK))
+        data += element("%s:fd" % key, len(fds) - 1)
+
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect("/var/run/abrt/abrt.socket")
+    s.sendall(b"POST / HTTP/1.1\r\n\r\n")
+    # The descriptors must arrive before the elements referring to them
+    ancdata = []
+    if fds:
+        ancdata.append((socket.SOL_SOCKET, socket.SCM_RIGHTS, array.array("i", fds)))
+    s.sendmsg([data], ancdata)
+    s.shutdown(socket.SHUT_WR)
+
+    resp = b""
+    while True:
+        buf = s.recv(256)
+        if not buf:
+            break
+        resp += buf
+    print(resp.split()[1].decode() if resp else "none")
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,150 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of socket-api-streaming
+#   Description: tests that big elements received over abrt.socket are
+#                streamed to the problem directory
+#   Author: ABRT team
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This copyrighted material is made available to anyone wishing
+#   to use, modify, copy, or redistribute it subject to the terms
+#   and conditions of the GNU General Public License version 2.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE. See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public
+#   License along with this program; if not, write to the Free
+#   Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+#   Boston, MA 02110-1301, USA.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="socket-api-streaming"
+PACKAGE="abrt"
+
+# Sends the problem of /usr/bin/socket-api-streaming-$1 the way given by $1
+# and checks the HTTP code of the response
+function send_problem() {
+    rlRun "python3 send_problem.py $1 > response.log" 0 "Sent the problem ($1)"
+    rlAssertGrep "^$2$" response.log
+    wait_for_hooks
+    PROBLEM_DIR=$(grep -l "^/usr/bin/socket-api-streaming-$1\$" $ABRT_CONF_DUMP_LOCATION/Python3-*/executable 2>/dev/null | xargs -r dirname)
+}
+
+function assert_no_new_files() {
+    rlAssertEquals "No incomplete problem directory was left" \
+        "_$(ls -d $ABRT_CONF_DUMP_LOCATION/*.new 2>/dev/null)" "_"
+    if [ -n "$PROBLEM_DIR" ]; then
+        rlAssertEquals "No incomplete element was left" "_$(ls $PROBLEM_DIR | grep '\.new$')" "_"
+    fi
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        check_prior_crashes
+        load_abrt_conf
+
+        TmpDir=$(mktemp -d)
+        pushd $TmpDir
+
+        # Elements bigger than 8KiB are streamed to the problem directory
+        head -c 100000 /dev/urandom | base64 -w 100 > big_element
+        cat > send_problem.py <<PYEOF
+import socket
+import sys
+import time
+
+kind = sys.argv[1]
+
+def element(key, value):
+    return key.encode() + b"=" + value + b"\0"
+
+with open("big_element", "rb") as f:
+    big = f.read()
+
+data = (element("type", b"Python3") + element("analyzer", b"Python3")
+        + element("pid", b"1")
+        + element("executable", b"/usr/bin/socket-api-streaming-" + kind.encode()))
+if kind == "badkey":
+    data += element("bad.key", big)
+else:
+    data += element("big_element", big)
+if kind != "truncated":
+    data += element("reason", b"socket-api-streaming test") + element("backtrace", big)
+else:
+    # the element is never terminated and reason is missing
+    data = data[:-1000]
+
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect("/var/run/abrt/abrt.socket")
+s.sendall(b"POST / HTTP/1.1\r\n\r\n")
+if kind == "split":
+    # split in a key, in a value about the streaming threshold and right
+    # before the terminating NUL of the streamed value
+    start = data.index(b"big_element=")
+    end = start + len("big_element=") + len(big)
+    for piece in (data[:start + 4], data[start + 4:start + 8000],
+                  data[start + 8000:start + 8300], data[start + 8300:end],
+                  data[end:]):
+        s.sendall(piece)
+        time.sleep(0.2)
+else:
+    s.sendall(data)
+s.shutdown(socket.SHUT_WR)
+
+resp = b""
+while True:
+    buf = s.recv(256)
+    if not buf:
+        break
+    resp += buf
+print(resp.split()[1].decode() if resp else "none")
+PYEOF
+    rlPhaseEnd
+
+    rlPhaseStartTest "Body above the threshold"
+        send_problem whole 201
+        rlAssertNotDiffer big_element $PROBLEM_DIR/big_element
+        rlAssertNotDiffer big_element $PROBLEM_DIR/backtrace
+        assert_no_new_files
+    rlPhaseEnd
+
+    rlPhaseStartTest "Body split across reads"
+        send_problem split 201
+        rlAssertNotDiffer big_element $PROBLEM_DIR/big_element
+        rlAssertNotDiffer big_element $PROBLEM_DIR/backtrace
+        assert_no_new_files
+    rlPhaseEnd
+
+    rlPhaseStartTest "Streamed element with invalid key"
+        send_problem badkey 201
+        rlAssertNotExists $PROBLEM_DIR/bad.key
+        rlAssertNotExists $PROBLEM_DIR/bad.key.new
+        rlAssertNotDiffer big_element $PROBLEM_DIR/backtrace
+        assert_no_new_files
+    rlPhaseEnd
+
+    rlPhaseStartTest "Truncated body"
+        send_problem truncated 400
+        rlAssertEquals "No problem directory was created" "_$PROBLEM_DIR" "_"
+        assert_no_new_files
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlRun "rm -rf $ABRT_CONF_DUMP_LOCATION/Python3-*" 0 "Remove the problem directories"
+        popd #TmpDir
+        rm -rf $TmpDir
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd